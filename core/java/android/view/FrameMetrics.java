@@ -219,7 +219,7 @@ public final class FrameMetrics {
         int SWAP_BUFFERS = 12;
         int FRAME_COMPLETED = 13;
 
-        int FRAME_STATS_COUNT = 16; // must always be last
+        int FRAME_STATS_COUNT = 19; // must always be last
     }
 
     /*
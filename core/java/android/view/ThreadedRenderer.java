@@ -526,6 +526,9 @@ public final class ThreadedRenderer {
      * @param surfaceInsets The drawing surface insets to apply
      */
     void setup(int width, int height, AttachInfo attachInfo, Rect surfaceInsets) {
+        // setOpaque(), nSetup() and setLightCenter() each post a task to the RenderThread,
+        // send them as one instead.
+        nBeginBatch(mNativeProxy);
         mWidth = width;
         mHeight = height;
 
@@ -552,6 +555,7 @@ public final class ThreadedRenderer {
                 mAmbientShadowAlpha, mSpotShadowAlpha);
 
         setLightCenter(attachInfo);
+        nEndBatch(mNativeProxy, false);
     }
 
     /**
@@ -995,6 +999,8 @@ public final class ThreadedRenderer {
     private static native void nSetLightCenter(long nativeProxy,
             float lightX, float lightY, float lightZ);
     private static native void nSetOpaque(long nativeProxy, boolean opaque);
+    private static native void nBeginBatch(long nativeProxy);
+    private static native void nEndBatch(long nativeProxy, boolean waitForCompletion);
     private static native int nSyncAndDrawFrame(long nativeProxy, long[] frameInfo, int size);
     private static native void nDestroy(long nativeProxy, long rootRenderNode);
     private static native void nRegisterAnimatingRenderNode(long rootRenderNode, long animatingNode);
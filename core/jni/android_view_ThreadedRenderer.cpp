@@ -693,6 +693,18 @@ static void android_view_ThreadedRenderer_setOpaque(JNIEnv* env, jobject clazz,
     proxy->setOpaque(opaque);
 }
 
+static void android_view_ThreadedRenderer_beginBatch(JNIEnv* env, jobject clazz,
+        jlong proxyPtr) {
+    RenderProxy* proxy = reinterpret_cast<RenderProxy*>(proxyPtr);
+    proxy->beginBatch();
+}
+
+static void android_view_ThreadedRenderer_endBatch(JNIEnv* env, jobject clazz,
+        jlong proxyPtr, jboolean waitForCompletion) {
+    RenderProxy* proxy = reinterpret_cast<RenderProxy*>(proxyPtr);
+    proxy->endBatch(waitForCompletion);
+}
+
 static int android_view_ThreadedRenderer_syncAndDrawFrame(JNIEnv* env, jobject clazz,
         jlong proxyPtr, jlongArray frameInfo, jint frameInfoSize) {
     LOG_ALWAYS_FATAL_IF(frameInfoSize != UI_THREAD_FRAME_INFO_SIZE,
@@ -973,6 +985,10 @@ static void android_view_ThreadedRenderer_setupShadersDiskCache(JNIEnv* env, job
         jstring diskCachePath) {
     const char* cacheArray = env->GetStringUTFChars(diskCachePath, NULL);
     android::egl_set_cache_filename(cacheArray);
+    // Linked program binaries live next to the EGL shader cache
+    std::string programCachePath(cacheArray);
+    programCachePath += ".programs";
+    RenderProxy::setProgramCachePath(programCachePath.c_str());
     env->ReleaseStringUTFChars(diskCachePath, cacheArray);
 }
 
@@ -999,6 +1015,8 @@ static const JNINativeMethod gMethods[] = {
     { "nSetup", "(JFII)V", (void*) android_view_ThreadedRenderer_setup },
     { "nSetLightCenter", "(JFFF)V", (void*) android_view_ThreadedRenderer_setLightCenter },
     { "nSetOpaque", "(JZ)V", (void*) android_view_ThreadedRenderer_setOpaque },
+    { "nBeginBatch", "(J)V", (void*) android_view_ThreadedRenderer_beginBatch },
+    { "nEndBatch", "(JZ)V", (void*) android_view_ThreadedRenderer_endBatch },
     { "nSyncAndDrawFrame", "(J[JI)I", (void*) android_view_ThreadedRenderer_syncAndDrawFrame },
     { "nDestroy", "(JJ)V", (void*) android_view_ThreadedRenderer_destroy },
     { "nRegisterAnimatingRenderNode", "(JJ)V", (void*) android_view_ThreadedRenderer_registerAnimatingRenderNode },
@@ -65,14 +65,6 @@ namespace uirenderer {
 /**
  *  Local utility functions.
  */
-inline Vector2 getNormalFromVertices(const Vector3* vertices, int current, int next) {
-    // Convert from Vector3 to Vector2 first.
-    Vector2 currentVertex = { vertices[current].x, vertices[current].y };
-    Vector2 nextVertex = { vertices[next].x, vertices[next].y };
-
-    return ShadowTessellator::calculateNormal(currentVertex, nextVertex);
-}
-
 // The input z value will be converted to be non-negative inside.
 // The output must be ranged from 0 to 1.
 inline float getAlphaFromFactoredZ(float factoredZ) {
@@ -168,15 +160,32 @@ void AmbientShadow::createAmbientShadow(bool isCasterOpaque,
         float heightFactor, float geomFactor, VertexBuffer& shadowVertexBuffer) {
     shadowVertexBuffer.setMeshFeatureFlags(VertexBuffer::kAlpha | VertexBuffer::kIndices);
 
+    // The per vertex values only depend on the vertex itself (and its neighbor for the
+    // normal), so compute them up front in separate arrays, as loops the compiler can
+    // vectorize, and keep the main loop to emitting the geometry.
+    float innerX[casterVertexCount];
+    float innerY[casterVertexCount];
+    float normalX[casterVertexCount];
+    float normalY[casterVertexCount];
+    float innerAlpha[casterVertexCount];
+    float expansionDist[casterVertexCount];
+    for (int i = 0; i < casterVertexCount; i++) {
+        innerX[i] = casterVertices[i].x;
+        innerY[i] = casterVertices[i].y;
+    }
+    ShadowTessellator::calculateNormals(innerX, innerY, casterVertexCount, normalX, normalY);
+    for (int i = 0; i < casterVertexCount; i++) {
+        float factoredZ = casterVertices[i].z * heightFactor;
+        innerAlpha[i] = getAlphaFromFactoredZ(factoredZ);
+        expansionDist[i] = factoredZ * geomFactor;
+    }
+
     // In order to computer the outer vertices in one loop, we need pre-compute
-    // the normal by the vertex (n - 1) to vertex 0, and the spike and alpha value
-    // for vertex 0.
-    Vector2 previousNormal = getNormalFromVertices(casterVertices,
-            casterVertexCount - 1 , 0);
+    // the normal by the vertex (n - 1) to vertex 0, and the spike for vertex 0.
+    Vector2 previousNormal = {normalX[casterVertexCount - 1], normalY[casterVertexCount - 1]};
     Vector2 currentSpike = {casterVertices[0].x - centroid3d.x,
         casterVertices[0].y - centroid3d.y};
     currentSpike.normalize();
-    float currentAlpha = getAlphaFromFactoredZ(casterVertices[0].z * heightFactor);
 
     // Preparing all the output data.
     int totalVertexCount, totalIndexCount, totalUmbraCount;
@@ -192,14 +201,12 @@ void AmbientShadow::createAmbientShadow(bool isCasterOpaque,
 
     for (int i = 0; i < casterVertexCount; i++)  {
         // Corner: first figure out the extra vertices we need for the corner.
-        const Vector3& innerVertex = casterVertices[i];
-        Vector2 currentNormal = getNormalFromVertices(casterVertices, i,
-                (i + 1) % casterVertexCount);
+        const int next = (i + 1) % casterVertexCount;
+        Vector2 currentNormal = {normalX[i], normalY[i]};
 
         int extraVerticesNumber = ShadowTessellator::getExtraVertexNumber(currentNormal,
                 previousNormal, CORNER_RADIANS_DIVISOR);
 
-        float expansionDist = innerVertex.z * heightFactor * geomFactor;
         const int cornerSlicesNumber = extraVerticesNumber + 1; // Minimal as 1.
 #if DEBUG_SHADOW
         ALOGD("cornerSlicesNumber is %d", cornerSlicesNumber);
@@ -213,8 +220,7 @@ void AmbientShadow::createAmbientShadow(bool isCasterOpaque,
             umbraVertices[umbraIndex++] = vertexBufferIndex;
         }
         AlphaVertex::set(&shadowVertices[vertexBufferIndex++],
-                casterVertices[i].x, casterVertices[i].y,
-                currentAlpha);
+                innerX[i], innerY[i], innerAlpha[i]);
 
         const Vector3& innerStart = casterVertices[i];
 
@@ -230,8 +236,8 @@ void AmbientShadow::createAmbientShadow(bool isCasterOpaque,
             averageNormal /= cornerSlicesNumber;
             averageNormal.normalize();
             Vector2 outerVertex;
-            outerVertex.x = innerVertex.x + averageNormal.x * expansionDist;
-            outerVertex.y = innerVertex.y + averageNormal.y * expansionDist;
+            outerVertex.x = innerX[i] + averageNormal.x * expansionDist[i];
+            outerVertex.y = innerY[i] + averageNormal.y * expansionDist[i];
 
             indexBuffer[indexBufferIndex++] = vertexBufferIndex;
             indexBuffer[indexBufferIndex++] = currentInnerVertexIndex;
@@ -247,14 +253,12 @@ void AmbientShadow::createAmbientShadow(bool isCasterOpaque,
         previousNormal = currentNormal;
 
         // Edge: first figure out the extra vertices needed for the edge.
-        const Vector3& innerNext = casterVertices[(i + 1) % casterVertexCount];
-        float nextAlpha = getAlphaFromFactoredZ(innerNext.z * heightFactor);
-        if (needsExtraForEdge(currentAlpha, nextAlpha)) {
+        const Vector3& innerNext = casterVertices[next];
+        if (needsExtraForEdge(innerAlpha[i], innerAlpha[next])) {
             // TODO: See if we can / should cache this outer vertex across the loop.
             Vector2 outerNext;
-            float expansionDist = innerNext.z * heightFactor * geomFactor;
-            outerNext.x = innerNext.x + currentNormal.x * expansionDist;
-            outerNext.y = innerNext.y + currentNormal.y * expansionDist;
+            outerNext.x = innerX[next] + currentNormal.x * expansionDist[next];
+            outerNext.y = innerY[next] + currentNormal.y * expansionDist[next];
 
             // Compute the angle and see how many extra points we need.
             int extraVerticesNumber = getEdgeExtraAndUpdateSpike(&currentSpike,
@@ -285,7 +289,6 @@ void AmbientShadow::createAmbientShadow(bool isCasterOpaque,
                         getAlphaFromFactoredZ(currentInner.z * heightFactor));
             }
         }
-        currentAlpha = nextAlpha;
     }
 
     indexBuffer[indexBufferIndex++] = 1;
@@ -404,16 +404,12 @@ void BakedOpDispatcher::onArcOp(BakedOpRenderer& renderer, const ArcOp& op, cons
                     *texture, *(op.paint));
         }
     } else {
-        SkRect rect = getBoundsOfFill(op);
-        SkPath path;
-        if (op.useCenter) {
-            path.moveTo(rect.centerX(), rect.centerY());
-        }
-        path.arcTo(rect, op.startAngle, op.sweepAngle, !op.useCenter);
-        if (op.useCenter) {
-            path.close();
-        }
-        renderConvexPath(renderer, state, path, *(op.paint));
+        const VertexBuffer* buffer = renderer.caches().tessellationCache.getArc(
+                state.computedState.transform, *(op.paint),
+                op.unmappedBounds.getWidth(), op.unmappedBounds.getHeight(),
+                op.startAngle, op.sweepAngle, op.useCenter);
+        renderVertexBuffer(renderer, state, *buffer,
+                op.unmappedBounds.left, op.unmappedBounds.top, *(op.paint), 0);
     }
 }
 
@@ -563,17 +559,21 @@ void BakedOpDispatcher::onOvalOp(BakedOpRenderer& renderer, const OvalOp& op, co
             renderPathTexture(renderer, state, op.unmappedBounds.left, op.unmappedBounds.top,
                     *texture, *(op.paint));
         }
-    } else {
+    } else if (state.computedState.localProjectionPathMask != nullptr) {
         SkPath path;
         SkRect rect = getBoundsOfFill(op);
         path.addOval(rect);
 
-        if (state.computedState.localProjectionPathMask != nullptr) {
-            // Mask the ripple path by the local space projection mask in local space.
-            // Note that this can create CCW paths.
-            Op(path, *state.computedState.localProjectionPathMask, kIntersect_SkPathOp, &path);
-        }
+        // Mask the ripple path by the local space projection mask in local space.
+        // Note that this can create CCW paths.
+        Op(path, *state.computedState.localProjectionPathMask, kIntersect_SkPathOp, &path);
         renderConvexPath(renderer, state, path, *(op.paint));
+    } else {
+        const VertexBuffer* buffer = renderer.caches().tessellationCache.getOval(
+                state.computedState.transform, *(op.paint),
+                op.unmappedBounds.getWidth(), op.unmappedBounds.getHeight());
+        renderVertexBuffer(renderer, state, *buffer,
+                op.unmappedBounds.left, op.unmappedBounds.top, *(op.paint), 0);
     }
 }
 
@@ -712,7 +712,8 @@ static void renderShadow(BakedOpRenderer& renderer, const BakedOpState& state, f
 }
 
 void BakedOpDispatcher::onShadowOp(BakedOpRenderer& renderer, const ShadowOp& op, const BakedOpState& state) {
-    TessellationCache::vertexBuffer_pair_t buffers = op.shadowTask->getResult();
+    TessellationCache::vertexBuffer_pair_t buffers =
+            renderer.caches().tessellationCache.getShadowBuffers(op.shadowTask);
     renderShadow(renderer, state, op.casterAlpha, buffers.first, buffers.second);
 }
 
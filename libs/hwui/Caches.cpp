@@ -16,6 +16,7 @@
 
 #include "Caches.h"
 
+#include "DisplayList.h"
 #include "GammaFontRenderer.h"
 #include "GlLayer.h"
 #include "Properties.h"
@@ -60,6 +61,7 @@ Caches::Caches(RenderState& renderState)
     initConstraints();
     initStaticProperties();
     initExtensions();
+    programCache.loadDiskCache(tasks);
 }
 
 bool Caches::init() {
@@ -188,18 +190,33 @@ void Caches::dumpMemoryUsage(String8 &log) {
             gradientCache.getSize(), gradientCache.getMaxSize());
     log.appendFormat("  PathCache            %8d / %8d\n",
             pathCache.getSize(), pathCache.getMaxSize());
+    log.appendFormat("    deferred removals: %u lock acquisitions, %u contended\n",
+            pathCache.getGarbage().lockCount(), pathCache.getGarbage().contendedCount());
     log.appendFormat("  TessellationCache    %8d / %8d\n",
             tessellationCache.getSize(), tessellationCache.getMaxSize());
+    log.appendFormat("    precached: hits %u, misses %u; at draw: hits %u, misses %u\n",
+            tessellationCache.getPrecacheHitCount(), tessellationCache.getPrecacheMissCount(),
+            tessellationCache.getHitCount(), tessellationCache.getMissCount());
+    log.appendFormat("    shadows drawn %u, prefetched %u, waited for %u\n",
+            tessellationCache.getShadowDrawCount(), tessellationCache.getShadowPrefetchHitCount(),
+            tessellationCache.getShadowWaitCount());
     log.appendFormat("  TextDropShadowCache  %8d / %8d\n", dropShadowCache.getSize(),
             dropShadowCache.getMaxSize());
     log.appendFormat("  PatchCache           %8d / %8d\n",
             patchCache.getSize(), patchCache.getMaxSize());
+    log.appendFormat("    deferred removals: %u lock acquisitions, %u contended\n",
+            patchCache.getGarbage().lockCount(), patchCache.getGarbage().contendedCount());
 
     fontRenderer.dumpMemoryUsage(log);
+    DisplayListPool::getInstance().dumpStats(log);
 
     log.appendFormat("Other:\n");
     log.appendFormat("  FboCache             %8d / %8d\n",
             fboCache.getSize(), fboCache.getMaxSize());
+    const ProgramCache::Stats& programStats = programCache.getStats();
+    log.appendFormat("  ProgramCache         %u from binaries (%u rejected), %u compiled, "
+            "%u precompiled\n", programStats.binaryHits, programStats.binaryRejects,
+            programStats.compiles, programStats.precompiled);
 
     total += textureCache.getSize();
     total += renderBufferCache.getSize();
@@ -238,6 +255,7 @@ void Caches::flush(FlushMode mode) {
             gradientCache.clear();
             fontRenderer.clear();
             fboCache.clear();
+            DisplayListPool::getInstance().clear();
             // fall through
         case FlushMode::Moderate:
             fontRenderer.flush();
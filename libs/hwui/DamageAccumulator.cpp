@@ -24,85 +24,74 @@
 namespace android {
 namespace uirenderer {
 
-enum TransformType {
-    TransformInvalid = 0,
-    TransformRenderNode,
-    TransformMatrix4,
-    TransformNone,
-};
-
-struct DirtyStack {
-    TransformType type;
-    union {
-        const RenderNode* renderNode;
-        const Matrix4* matrix4;
-    };
-    // When this frame is pop'd, this rect is mapped through the above transform
-    // and applied to the previous (aka parent) frame
-    SkRect pendingDirty;
-    DirtyStack* prev;
-    DirtyStack* next;
-};
+// Deep enough for typical view hierarchies, so that the stack doesn't have to grow
+// while the first frames are prepared
+static const size_t INITIAL_STACK_DEPTH = 32;
 
 DamageAccumulator::DamageAccumulator() {
-    mHead = mAllocator.create_trivial<DirtyStack>();
-    memset(mHead, 0, sizeof(DirtyStack));
+    mStack.reserve(INITIAL_STACK_DEPTH);
+    mStack.emplace_back();
     // Create a root that we will not pop off
-    mHead->prev = mHead;
-    mHead->type = TransformNone;
+    DirtyStack& root = mStack.back();
+    root.type = TransformNone;
+    root.renderNode = nullptr;
+    root.pendingDirty.setEmpty();
 }
 
-static void computeTransformImpl(const DirtyStack* currentFrame, Matrix4* outMatrix) {
-    if (currentFrame->prev != currentFrame) {
-        computeTransformImpl(currentFrame->prev, outMatrix);
-    }
-    switch (currentFrame->type) {
+static void applyTransform(const DirtyStack& frame, Matrix4* outMatrix) {
+    switch (frame.type) {
     case TransformRenderNode:
-        currentFrame->renderNode->applyViewPropertyTransforms(*outMatrix);
+        frame.renderNode->applyViewPropertyTransforms(*outMatrix);
         break;
     case TransformMatrix4:
-        outMatrix->multiply(*currentFrame->matrix4);
+        outMatrix->multiply(*frame.matrix4);
         break;
     case TransformNone:
         // nothing to be done
         break;
     default:
-        LOG_ALWAYS_FATAL("Tried to compute transform with an invalid type: %d", currentFrame->type);
+        LOG_ALWAYS_FATAL("Tried to compute transform with an invalid type: %d", frame.type);
     }
 }
 
 void DamageAccumulator::computeCurrentTransform(Matrix4* outMatrix) const {
-    outMatrix->loadIdentity();
-    computeTransformImpl(mHead, outMatrix);
+    // Only the frames pushed since the last call need their transform concatenated, and
+    // applyViewPropertyTransforms() already avoids full multiplies for pure translations
+    for (size_t i = mValidTransformDepth; i <= mDepth; i++) {
+        mStack[i].transform = mStack[i - 1].transform;
+        applyTransform(mStack[i], &mStack[i].transform);
+    }
+    mValidTransformDepth = mDepth + 1;
+    *outMatrix = mStack[mDepth].transform;
 }
 
 void DamageAccumulator::pushCommon() {
-    if (!mHead->next) {
-        DirtyStack* nextFrame = mAllocator.create_trivial<DirtyStack>();
-        nextFrame->next = nullptr;
-        nextFrame->prev = mHead;
-        mHead->next = nextFrame;
+    mDepth++;
+    if (CC_UNLIKELY(mDepth == mStack.size())) {
+        mStack.emplace_back();
+    }
+    if (mValidTransformDepth > mDepth) {
+        mValidTransformDepth = mDepth;
     }
-    mHead = mHead->next;
-    mHead->pendingDirty.setEmpty();
+    head()->pendingDirty.setEmpty();
 }
 
 void DamageAccumulator::pushTransform(const RenderNode* transform) {
     pushCommon();
-    mHead->type = TransformRenderNode;
-    mHead->renderNode = transform;
+    head()->type = TransformRenderNode;
+    head()->renderNode = transform;
 }
 
 void DamageAccumulator::pushTransform(const Matrix4* transform) {
     pushCommon();
-    mHead->type = TransformMatrix4;
-    mHead->matrix4 = transform;
+    head()->type = TransformMatrix4;
+    head()->matrix4 = transform;
 }
 
 void DamageAccumulator::popTransform() {
-    LOG_ALWAYS_FATAL_IF(mHead->prev == mHead, "Cannot pop the root frame!");
-    DirtyStack* dirtyFrame = mHead;
-    mHead = mHead->prev;
+    LOG_ALWAYS_FATAL_IF(!mDepth, "Cannot pop the root frame!");
+    DirtyStack* dirtyFrame = head();
+    mDepth--;
     switch (dirtyFrame->type) {
     case TransformRenderNode:
         applyRenderNodeTransform(dirtyFrame);
@@ -111,7 +100,7 @@ void DamageAccumulator::popTransform() {
         applyMatrix4Transform(dirtyFrame);
         break;
     case TransformNone:
-        mHead->pendingDirty.join(dirtyFrame->pendingDirty);
+        head()->pendingDirty.join(dirtyFrame->pendingDirty);
         break;
     default:
         LOG_ALWAYS_FATAL("Tried to pop an invalid type: %d", dirtyFrame->type);
@@ -121,7 +110,9 @@ void DamageAccumulator::popTransform() {
 static inline void mapRect(const Matrix4* matrix, const SkRect& in, SkRect* out) {
     if (in.isEmpty()) return;
     Rect temp(in);
-    if (CC_LIKELY(!matrix->isPerspective())) {
+    if (matrix->isPureTranslate()) {
+        temp.translate(matrix->getTranslateX(), matrix->getTranslateY());
+    } else if (CC_LIKELY(!matrix->isPerspective())) {
         matrix->mapRect(temp);
     } else {
         // Don't attempt to calculate damage for a perspective transform
@@ -133,7 +124,7 @@ static inline void mapRect(const Matrix4* matrix, const SkRect& in, SkRect* out)
 }
 
 void DamageAccumulator::applyMatrix4Transform(DirtyStack* frame) {
-    mapRect(frame->matrix4, frame->pendingDirty, &mHead->pendingDirty);
+    mapRect(frame->matrix4, frame->pendingDirty, &head()->pendingDirty);
 }
 
 static inline void mapRect(const RenderProperties& props, const SkRect& in, SkRect* out) {
@@ -141,7 +132,9 @@ static inline void mapRect(const RenderProperties& props, const SkRect& in, SkRe
     const SkMatrix* transform = props.getTransformMatrix();
     SkRect temp(in);
     if (transform && !transform->isIdentity()) {
-        if (CC_LIKELY(!transform->hasPerspective())) {
+        if (transform->getType() == SkMatrix::kTranslate_Mask) {
+            temp.offset(transform->getTranslateX(), transform->getTranslateY());
+        } else if (CC_LIKELY(!transform->hasPerspective())) {
             transform->mapRect(&temp);
         } else {
             // Don't attempt to calculate damage for a perspective transform
@@ -154,9 +147,10 @@ static inline void mapRect(const RenderProperties& props, const SkRect& in, SkRe
     out->join(temp);
 }
 
-static DirtyStack* findParentRenderNode(DirtyStack* frame) {
-    while (frame->prev != frame) {
-        frame = frame->prev;
+// Frames are contiguous, so walking towards the root is a pointer decrement
+static DirtyStack* findParentRenderNode(DirtyStack* root, DirtyStack* frame) {
+    while (frame != root) {
+        frame--;
         if (frame->type == TransformRenderNode) {
             return frame;
         }
@@ -164,10 +158,10 @@ static DirtyStack* findParentRenderNode(DirtyStack* frame) {
     return nullptr;
 }
 
-static DirtyStack* findProjectionReceiver(DirtyStack* frame) {
+static DirtyStack* findProjectionReceiver(DirtyStack* root, DirtyStack* frame) {
     if (frame) {
-        while (frame->prev != frame) {
-            frame = frame->prev;
+        while (frame != root) {
+            frame--;
             if (frame->type == TransformRenderNode
                     && frame->renderNode->hasProjectionReceiver()) {
                 return frame;
@@ -185,7 +179,7 @@ static void applyTransforms(DirtyStack* frame, DirtyStack* end) {
         } else {
             mapRect(frame->matrix4, *rect, rect);
         }
-        frame = frame->prev;
+        frame--;
     }
 }
 
@@ -207,14 +201,14 @@ void DamageAccumulator::applyRenderNodeTransform(DirtyStack* frame) {
     }
 
     // apply all transforms
-    mapRect(props, frame->pendingDirty, &mHead->pendingDirty);
+    mapRect(props, frame->pendingDirty, &head()->pendingDirty);
 
     // project backwards if necessary
     if (props.getProjectBackwards() && !frame->pendingDirty.isEmpty()) {
         // First, find our parent RenderNode:
-        DirtyStack* parentNode = findParentRenderNode(frame);
+        DirtyStack* parentNode = findParentRenderNode(&mStack[0], frame);
         // Find our parent's projection receiver, which is what we project onto
-        DirtyStack* projectionReceiver = findProjectionReceiver(parentNode);
+        DirtyStack* projectionReceiver = findProjectionReceiver(&mStack[0], parentNode);
         if (projectionReceiver) {
             applyTransforms(frame, projectionReceiver);
             projectionReceiver->pendingDirty.join(frame->pendingDirty);
@@ -225,19 +219,19 @@ void DamageAccumulator::applyRenderNodeTransform(DirtyStack* frame) {
 }
 
 void DamageAccumulator::dirty(float left, float top, float right, float bottom) {
-    mHead->pendingDirty.join(left, top, right, bottom);
+    head()->pendingDirty.join(left, top, right, bottom);
 }
 
 void DamageAccumulator::peekAtDirty(SkRect* dest) const {
-    *dest = mHead->pendingDirty;
+    *dest = mStack[mDepth].pendingDirty;
 }
 
 void DamageAccumulator::finish(SkRect* totalDirty) {
-    LOG_ALWAYS_FATAL_IF(mHead->prev != mHead, "Cannot finish, mismatched push/pop calls! %p vs. %p", mHead->prev, mHead);
+    LOG_ALWAYS_FATAL_IF(mDepth, "Cannot finish, mismatched push/pop calls! depth %zu", mDepth);
     // Root node never has a transform, so this is the fully mapped dirty rect
-    *totalDirty = mHead->pendingDirty;
+    *totalDirty = mStack[0].pendingDirty;
     totalDirty->roundOut(totalDirty);
-    mHead->pendingDirty.setEmpty();
+    mStack[0].pendingDirty.setEmpty();
 }
 
 } /* namespace uirenderer */
@@ -17,13 +17,15 @@
 #define DAMAGEACCUMULATOR_H
 
 #include <cutils/compiler.h>
-#include <utils/LinearAllocator.h>
 
 #include <SkMatrix.h>
 #include <SkRect.h>
 
+#include "Matrix.h"
 #include "utils/Macros.h"
 
+#include <vector>
+
 // Smaller than INT_MIN/INT_MAX because we offset these values
 // and thus don't want to be adding offsets to INT_MAX, that's bad
 #define DIRTY_MIN (-0x7ffffff-1)
@@ -32,15 +34,33 @@
 namespace android {
 namespace uirenderer {
 
-struct DirtyStack;
 class RenderNode;
-class Matrix4;
+
+enum TransformType {
+    TransformInvalid = 0,
+    TransformRenderNode,
+    TransformMatrix4,
+    TransformNone,
+};
+
+struct DirtyStack {
+    TransformType type;
+    union {
+        const RenderNode* renderNode;
+        const Matrix4* matrix4;
+    };
+    // When this frame is pop'd, this rect is mapped through the above transform
+    // and applied to the previous (aka parent) frame
+    SkRect pendingDirty;
+    // This frame's transform concatenated with those of every frame below it. Filled in
+    // lazily by computeCurrentTransform()
+    Matrix4 transform;
+};
 
 class DamageAccumulator {
     PREVENT_COPY_AND_ASSIGN(DamageAccumulator);
 public:
     DamageAccumulator();
-    // mAllocator will clean everything up for us, no need for a dtor
 
     // Push a transform node onto the stack. This should be called prior
     // to any dirty() calls. Subsequent calls to dirty()
@@ -66,8 +86,14 @@ private:
     void applyMatrix4Transform(DirtyStack* frame);
     void applyRenderNodeTransform(DirtyStack* frame);
 
-    LinearAllocator mAllocator;
-    DirtyStack* mHead;
+    DirtyStack* head() { return &mStack[mDepth]; }
+
+    // Contiguous stack of frames, mStack[0] being the root that is never popped. Frames are
+    // reused across pushes and frames, so it only grows while the tree gets deeper.
+    mutable std::vector<DirtyStack> mStack;
+    size_t mDepth = 0;
+    // Frames below this index hold an up to date concatenated transform
+    mutable size_t mValidTransformDepth = 1;
 };
 
 } /* namespace uirenderer */
@@ -19,6 +19,7 @@
 
 #include <utils/Trace.h>
 
+#include "Caches.h"
 #include "DamageAccumulator.h"
 #include "Debug.h"
 #include "DisplayList.h"
@@ -27,6 +28,7 @@
 #include "RenderNode.h"
 #include "VectorDrawable.h"
 #include "renderthread/CanvasContext.h"
+#include "utils/MathUtils.h"
 
 namespace android {
 namespace uirenderer {
@@ -40,8 +42,6 @@ DisplayList::DisplayList()
         , bitmapResources(stdAllocator)
         , pathResources(stdAllocator)
         , patchResources(stdAllocator)
-        , paints(stdAllocator)
-        , regions(stdAllocator)
         , referenceHolders(stdAllocator)
         , functors(stdAllocator)
         , vectorDrawables(stdAllocator) {
@@ -79,8 +79,36 @@ void DisplayList::cleanupResources() {
 
     patchResources.clear();
     pathResources.clear();
-    paints.clear();
-    regions.clear();
+}
+
+// Swaps the vector with an empty one, so its elements are destroyed and its storage is
+// handed back while the allocator that owns it is still intact
+template <class T>
+static void releaseVector(LsaVector<T>& vector, LinearStdAllocator<void*>& allocator) {
+    LsaVector<T> empty(allocator);
+    vector.swap(empty);
+}
+
+void DisplayList::reset() {
+    cleanupResources();
+
+    releaseVector(chunks, stdAllocator);
+    releaseVector(ops, stdAllocator);
+    releaseVector(children, stdAllocator);
+    releaseVector(bitmapResources, stdAllocator);
+    releaseVector(pathResources, stdAllocator);
+    releaseVector(patchResources, stdAllocator);
+    releaseVector(referenceHolders, stdAllocator);
+    releaseVector(functors, stdAllocator);
+    releaseVector(vectorDrawables, stdAllocator);
+
+    projectionReceiveIndex = -1;
+    hasClippedLayers = false;
+    allocator.reset();
+}
+
+bool DisplayList::reuseDisplayList(RenderNode* node, renderthread::CanvasContext* context) {
+    return DisplayListPool::getInstance().recycle(this);
 }
 
 size_t DisplayList::addChild(NodeOpType* op) {
@@ -105,16 +133,61 @@ void DisplayList::updateChildren(std::function<void(RenderNode*)> updateFn) {
     }
 }
 
+// Mirrors the checks FrameBuilder::deferShadow() makes before asking for a shadow, for the
+// simple case where the outline is used as is. Casters clipped by a reveal or by their clip
+// bounds use a path that only exists while the frame is built, and are left to the draw.
+static bool canPrefetchShadow(const RenderProperties& properties) {
+    return properties.getZ() > 0
+            && !MathUtils::isZero(properties.getZ())
+            && properties.getAlpha() > 0.0f
+            && properties.getOutline().getAlpha() > 0.0f
+            && properties.getOutline().getPath()
+            && properties.getScaleX() != 0
+            && properties.getScaleY() != 0
+            && !properties.getRevealClip().getPath()
+            && !(properties.getClippingFlags() & CLIP_TO_CLIP_BOUNDS);
+}
+
+static void prefetchShadow(const TreeInfo& info, const RenderNodeOp& op,
+        const Matrix4& drawTransform) {
+    const RenderNode& node = *op.renderNode;
+    const RenderProperties& properties = node.properties();
+    Matrix4 shadowMatrixXY(op.localMatrix);
+    Matrix4 shadowMatrixZ(op.localMatrix);
+    node.applyViewPropertyTransforms(shadowMatrixXY, false);
+    node.applyViewPropertyTransforms(shadowMatrixZ, true);
+    float casterAlpha = properties.getAlpha() * properties.getOutline().getAlpha();
+    Caches::getInstance().tessellationCache.prefetchShadows(drawTransform,
+            casterAlpha >= 1.0f, properties.getOutline().getPath(),
+            shadowMatrixXY, shadowMatrixZ, *info.lightCenter, info.lightRadius);
+}
+
 bool DisplayList::prepareListAndChildren(TreeObserver& observer, TreeInfo& info, bool functorsNeedLayer,
         std::function<void(RenderNode*, TreeObserver&, TreeInfo&, bool)> childFn) {
     info.prepareTextures = info.canvasContext.pinImages(bitmapResources);
 
+    // The transform this list's children are drawn with, which is what FrameBuilder keys
+    // their shadows on. Only computed if a child casts a shadow. Within a saveLayer, it is
+    // relative to the layer's clipped bounds, which aren't known until the frame is built.
+    Matrix4 drawTransform;
+    bool hasDrawTransform = false;
+    const bool prefetchShadows = info.lightCenter && !hasClippedLayers && Caches::hasInstance();
+
     for (auto&& op : children) {
         RenderNode* childNode = op->renderNode;
         info.damageAccumulator->pushTransform(&op->localMatrix);
         bool childFunctorsNeedLayer = functorsNeedLayer; // TODO! || op->mRecordedWithPotentialStencilClip;
         childFn(childNode, observer, info, childFunctorsNeedLayer);
         info.damageAccumulator->popTransform();
+
+        // The child's properties are final for this frame once it has been prepared
+        if (prefetchShadows && canPrefetchShadow(childNode->properties())) {
+            if (!hasDrawTransform) {
+                info.damageAccumulator->computeCurrentTransform(&drawTransform);
+                hasDrawTransform = true;
+            }
+            prefetchShadow(info, *op, drawTransform);
+        }
     }
 
     bool isDirty = false;
@@ -140,5 +213,72 @@ void DisplayList::output(std::ostream& output, uint32_t level) {
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// DisplayListPool
+///////////////////////////////////////////////////////////////////////////////
+
+// Enough for the content of a few screens' worth of list items
+static const size_t kMaxPooledDisplayLists = 64;
+static const size_t kMaxPooledBytes = 2 * 1024 * 1024;
+
+DisplayListPool& DisplayListPool::getInstance() {
+    // Leaked on purpose, lists may still be recycled while the process is exiting
+    static DisplayListPool* sInstance = new DisplayListPool();
+    return *sInstance;
+}
+
+DisplayList* DisplayListPool::obtain() {
+    {
+        AutoMutex _lock(mLock);
+        mObtainCount++;
+        if (!mAvailable.empty()) {
+            DisplayList* displayList = mAvailable.back();
+            mAvailable.pop_back();
+            mRetainedBytes -= displayList->allocator.allocatedSize();
+            mReuseCount++;
+            return displayList;
+        }
+    }
+    return new DisplayList();
+}
+
+bool DisplayListPool::recycle(DisplayList* displayList) {
+    // Resetting may release the last ref to other RenderNodes, which recycle their own
+    // DisplayLists, so it must happen outside of the lock
+    displayList->reset();
+    size_t size = displayList->allocator.allocatedSize();
+
+    AutoMutex _lock(mLock);
+    if (mAvailable.size() >= kMaxPooledDisplayLists
+            || mRetainedBytes + size > kMaxPooledBytes) {
+        mDropCount++;
+        return false;
+    }
+    mAvailable.push_back(displayList);
+    mRetainedBytes += size;
+    mRecycleCount++;
+    return true;
+}
+
+void DisplayListPool::clear() {
+    std::vector<DisplayList*> available;
+    {
+        AutoMutex _lock(mLock);
+        available.swap(mAvailable);
+        mRetainedBytes = 0;
+    }
+    for (DisplayList* displayList : available) {
+        delete displayList;
+    }
+}
+
+void DisplayListPool::dumpStats(String8& log) {
+    AutoMutex _lock(mLock);
+    log.appendFormat("  DisplayListPool      %8zu / %8zu\n", mRetainedBytes, kMaxPooledBytes);
+    log.appendFormat("    lists %zu, obtained %u, reused %u, recycled %u, dropped %u\n",
+            mAvailable.size(), mObtainCount, mReuseCount, mRecycleCount, mDropCount);
+    log.appendFormat("    pages allocated %zu\n", LinearAllocator::totalPageAllocations());
+}
+
 }; // namespace uirenderer
 }; // namespace android
@@ -24,6 +24,7 @@
 
 #include <utils/KeyedVector.h>
 #include <utils/LinearAllocator.h>
+#include <utils/Mutex.h>
 #include <utils/RefBase.h>
 #include <utils/SortedVector.h>
 #include <utils/String8.h>
@@ -73,6 +74,7 @@ struct FunctorContainer {
  * Data structure that holds the list of commands used in display list stream
  */
 class DisplayList {
+    friend class DisplayListPool;
     friend class RecordingCanvas;
 public:
     struct Chunk {
@@ -97,6 +99,9 @@ public:
     // index of DisplayListOp restore, after which projected descendants should be drawn
     int projectionReceiveIndex;
 
+    // whether a clipped saveLayer was recorded, content within it is drawn layer-relative
+    bool hasClippedLayers = false;
+
     const LsaVector<Chunk>& getChunks() const { return chunks; }
     const LsaVector<BaseOpType*>& getOps() const { return ops; }
 
@@ -119,9 +124,13 @@ public:
     virtual bool hasFunctor() const { return !functors.empty(); }
     virtual bool hasVectorDrawables() const { return !vectorDrawables.empty(); }
     virtual bool isSkiaDL() const { return false; }
-    virtual bool reuseDisplayList(RenderNode* node, renderthread::CanvasContext* context) {
-        return false;
-    }
+    virtual bool reuseDisplayList(RenderNode* node, renderthread::CanvasContext* context);
+
+    /**
+     * Releases all recorded ops and resources so the DisplayList can be recorded into again.
+     * The allocator keeps its pages, see LinearAllocator::reset()
+     */
+    void reset();
 
     virtual void syncContents();
     virtual void updateChildren(std::function<void(RenderNode*)> updateFn);
@@ -146,8 +155,6 @@ private:
     LsaVector<sk_sp<Bitmap>> bitmapResources;
     LsaVector<const SkPath*> pathResources;
     LsaVector<const Res_png_9patch*> patchResources;
-    LsaVector<std::unique_ptr<const SkPaint>> paints;
-    LsaVector<std::unique_ptr<const SkRegion>> regions;
     LsaVector< sp<VirtualLightRefBase> > referenceHolders;
 
     // List of functors
@@ -161,5 +168,45 @@ private:
     void cleanupResources();
 };
 
+/**
+ * Process wide pool of DisplayLists whose contents have been discarded. Recording into a
+ * recycled DisplayList reuses the pages its allocator grew to last time, instead of
+ * malloc'ing them all again for every frame. Lists are recycled on the RenderThread when a
+ * RenderNode drops them and obtained on the UI thread by RecordingCanvas.
+ */
+class DisplayListPool {
+public:
+    static DisplayListPool& getInstance();
+
+    // Returns a recycled DisplayList if there is one, otherwise a new one
+    DisplayList* obtain();
+
+    /**
+     * Resets the DisplayList and keeps it for a later obtain(). Returns false if the pool is
+     * full, in which case the caller still owns the DisplayList and should delete it.
+     */
+    bool recycle(DisplayList* displayList);
+
+    // Deletes every DisplayList in the pool
+    void clear();
+
+    void dumpStats(String8& log);
+
+    uint32_t getObtainCount() const { return mObtainCount; }
+    uint32_t getReuseCount() const { return mReuseCount; }
+
+private:
+    DisplayListPool() {}
+
+    Mutex mLock;
+    std::vector<DisplayList*> mAvailable;
+    size_t mRetainedBytes = 0;
+
+    uint32_t mObtainCount = 0;
+    uint32_t mReuseCount = 0;
+    uint32_t mRecycleCount = 0;
+    uint32_t mDropCount = 0;
+};
+
 }; // namespace uirenderer
 }; // namespace android
@@ -154,21 +154,21 @@ void FontRenderer::flushAllAndInvalidate() {
     }
 
     for (uint32_t i = 0; i < mACacheTextures.size(); i++) {
-        mACacheTextures[i]->init();
-
 #ifdef BUGREPORT_FONT_CACHE_USAGE
         mHistoryTracker.glyphsCleared(mACacheTextures[i]);
 #endif
+        mACacheTextures[i]->init();
     }
 
     for (uint32_t i = 0; i < mRGBACacheTextures.size(); i++) {
-        mRGBACacheTextures[i]->init();
 #ifdef BUGREPORT_FONT_CACHE_USAGE
         mHistoryTracker.glyphsCleared(mRGBACacheTextures[i]);
 #endif
+        mRGBACacheTextures[i]->init();
     }
 
     mDrawn = false;
+    mFlushCount++;
 }
 
 void FontRenderer::flushLargeCaches(std::vector<CacheTexture*>& cacheTextures) {
@@ -176,10 +176,10 @@ void FontRenderer::flushLargeCaches(std::vector<CacheTexture*>& cacheTextures) {
     for (uint32_t i = 1; i < cacheTextures.size(); i++) {
         CacheTexture* cacheTexture = cacheTextures[i];
         if (cacheTexture->getPixelBuffer()) {
-            cacheTexture->init();
 #ifdef BUGREPORT_FONT_CACHE_USAGE
             mHistoryTracker.glyphsCleared(cacheTexture);
 #endif
+            cacheTexture->init();
             LruCache<Font::FontDescription, Font*>::Iterator it(mActiveFonts);
             while (it.next()) {
                 it.value()->invalidateTextureCache(cacheTexture);
@@ -432,7 +432,7 @@ void FontRenderer::checkInit() {
 }
 
 void checkTextureUpdateForCache(Caches& caches, std::vector<CacheTexture*>& cacheTextures,
-        bool& resetPixelStore, GLuint& lastTextureId) {
+        bool& resetPixelStore, GLuint& lastTextureId, uint32_t& bytesUploaded) {
     for (uint32_t i = 0; i < cacheTextures.size(); i++) {
         CacheTexture* cacheTexture = cacheTextures[i];
         if (cacheTexture->isDirty() && cacheTexture->getPixelBuffer()) {
@@ -442,7 +442,7 @@ void checkTextureUpdateForCache(Caches& caches, std::vector<CacheTexture*>& cach
                 caches.textureState().bindTexture(lastTextureId);
             }
 
-            if (cacheTexture->upload()) {
+            if (cacheTexture->upload(&bytesUploaded)) {
                 resetPixelStore = true;
             }
         }
@@ -460,8 +460,10 @@ void FontRenderer::checkTextureUpdate() {
     bool resetPixelStore = false;
 
     // Iterate over all the cache textures and see which ones need to be updated
-    checkTextureUpdateForCache(caches, mACacheTextures, resetPixelStore, lastTextureId);
-    checkTextureUpdateForCache(caches, mRGBACacheTextures, resetPixelStore, lastTextureId);
+    checkTextureUpdateForCache(caches, mACacheTextures, resetPixelStore, lastTextureId,
+            mBytesUploaded);
+    checkTextureUpdateForCache(caches, mRGBACacheTextures, resetPixelStore, lastTextureId,
+            mBytesUploaded);
 
     // Unbind any PBO we might have used to update textures
     caches.pixelBufferState().unbind();
@@ -789,6 +791,7 @@ void FontRenderer::dumpMemoryUsage(String8& log) const {
     log.appendFormat("  FontRenderer RGBA    %8d / %8d\n", usedRGBA, sizeRGBA);
     dumpTextures(log, "RGBA", cacheTexturesForFormat(GL_RGBA));
     log.appendFormat("  FontRenderer total   %8d / %8d\n", usedA8 + usedRGBA, sizeA8 + sizeRGBA);
+    log.appendFormat("  FontRenderer flushes %8d\n", mFlushCount);
 }
 
 uint32_t FontRenderer::getCacheSize(GLenum format) const {
@@ -122,6 +122,18 @@ public:
     uint32_t getSize() const;
     void dumpMemoryUsage(String8& log) const;
 
+    // Returns the number of bytes of glyph data uploaded since the last call, and resets it
+    uint32_t takeBytesUploaded() {
+        uint32_t bytes = mBytesUploaded;
+        mBytesUploaded = 0;
+        return bytes;
+    }
+
+    // Number of times every cache texture had to be cleared because a glyph didn't fit
+    uint32_t getFlushCount() const {
+        return mFlushCount;
+    }
+
 #ifdef BUGREPORT_FONT_CACHE_USAGE
     FontCacheHistoryTracker& historyTracker() { return mHistoryTracker; }
 #endif
@@ -195,6 +207,9 @@ private:
 
     bool mLinearFiltering;
 
+    uint32_t mFlushCount = 0;
+    uint32_t mBytesUploaded = 0;
+
 #ifdef BUGREPORT_FONT_CACHE_USAGE
     FontCacheHistoryTracker mHistoryTracker;
 #endif
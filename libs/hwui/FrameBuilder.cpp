@@ -594,7 +594,14 @@ void FrameBuilder::deferArcOp(const ArcOp& op) {
     // Pass true below since arcs have a tendency to draw outside their expected bounds within
     // their path textures. Passing true makes it more likely that we'll scissor, instead of
     // corrupting the frame by drawing outside of clip bounds.
-    deferStrokeableOp(op, tessBatchId(op), BakedOpState::StrokeBehavior::StyleDefined, true);
+    auto state = deferStrokeableOp(op, tessBatchId(op),
+            BakedOpState::StrokeBehavior::StyleDefined, true);
+    if (CC_LIKELY(state && op.paint->getStyle() == SkPaint::kStroke_Style
+            && !op.paint->getPathEffect() && !op.useCenter)) {
+        mCaches.tessellationCache.precacheArc(state->computedState.transform, *(op.paint),
+                op.unmappedBounds.getWidth(), op.unmappedBounds.getHeight(),
+                op.startAngle, op.sweepAngle, op.useCenter);
+    }
 }
 
 static bool hasMergeableClip(const BakedOpState& state) {
@@ -682,7 +689,12 @@ void FrameBuilder::deferLinesOp(const LinesOp& op) {
 }
 
 void FrameBuilder::deferOvalOp(const OvalOp& op) {
-    deferStrokeableOp(op, tessBatchId(op));
+    auto state = deferStrokeableOp(op, tessBatchId(op));
+    if (CC_LIKELY(state && !op.paint->getPathEffect()
+            && !state->computedState.localProjectionPathMask)) {
+        mCaches.tessellationCache.precacheOval(state->computedState.transform, *(op.paint),
+                op.unmappedBounds.getWidth(), op.unmappedBounds.getHeight());
+    }
 }
 
 void FrameBuilder::deferPatchOp(const PatchOp& op) {
@@ -51,6 +51,12 @@ enum class FrameInfoIndex {
     DequeueBufferDuration,
     QueueBufferDuration,
 
+    GlyphBytesUploaded,
+
+    // Number of RenderNodes prepared, and skipped as part of a clean subtree, during sync
+    NodesPrepared,
+    NodesSkipped,
+
     // Must be the last value!
     // Also must be kept in sync with FrameMetrics.java#FRAME_STATS_COUNT
     NumIndexes
@@ -59,6 +59,10 @@ public:
         return mRenderer ? mRenderer->getSize() : 0;
     }
 
+    uint32_t takeBytesUploaded() {
+        return mRenderer ? mRenderer->takeBytesUploaded() : 0;
+    }
+
     void endPrecaching();
 
 private:
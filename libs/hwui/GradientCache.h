@@ -24,7 +24,6 @@
 #include <SkShader.h>
 
 #include <utils/LruCache.h>
-#include <utils/Mutex.h>
 
 #include "FloatColor.h"
 
@@ -171,8 +170,6 @@ private:
     bool mUseFloatTexture;
     bool mHasNpot;
     bool mHasLinearBlending;
-
-    mutable Mutex mLock;
 }; // class GradientCache
 
 }; // namespace uirenderer
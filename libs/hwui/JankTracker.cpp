@@ -42,6 +42,16 @@ static const char* JANK_TYPE_NAMES[] = {
         "Slow issue draw commands",
 };
 
+static const char* FRAME_STAGE_NAMES[] = {
+        "Sync",
+        "Draw",
+        "Swap",
+        "Completion",
+};
+
+static_assert(sizeof(FRAME_STAGE_NAMES) / sizeof(FRAME_STAGE_NAMES[0]) == NUM_FRAME_STAGES,
+        "FRAME_STAGE_NAMES doesn't match FrameStage");
+
 struct Comparison {
     FrameInfoIndex start;
     FrameInfoIndex end;
@@ -127,6 +137,34 @@ int32_t JankTracker::frameTimeForSlowFrameCountIndex(uint32_t index) {
     return (index * kSlowFrameBucketIntervalMs) + kSlowFrameBucketStartMs;
 }
 
+// Sub-buckets per power of two in the stage histograms, as a shift
+static const uint32_t kStageSubBucketBits = 2;
+static const uint32_t kStageSubBuckets = 1 << kStageSubBucketBits;
+
+// Also called every frame, for each stage
+uint32_t JankTracker::stageIndexForDuration(nsecs_t duration) {
+    uint32_t micros = static_cast<uint32_t>(std::min<nsecs_t>(std::max<nsecs_t>(
+            ns2us(duration), 0), std::numeric_limits<uint32_t>::max()));
+    if (micros < kStageSubBuckets) {
+        return micros;
+    }
+    uint32_t shift = (31 - __builtin_clz(micros)) - kStageSubBucketBits;
+    uint32_t index = (shift + 1) * kStageSubBuckets + ((micros >> shift) & (kStageSubBuckets - 1));
+    return std::min(index, kStageHistogramSize - 1);
+}
+
+uint32_t JankTracker::stageTimeForIndex(uint32_t index) {
+    if (index < kStageSubBuckets) {
+        return index;
+    }
+    uint32_t shift = index / kStageSubBuckets - 1;
+    return (kStageSubBuckets + (index % kStageSubBuckets)) << shift;
+}
+
+const char* JankTracker::stageName(FrameStage stage) {
+    return FRAME_STAGE_NAMES[stage];
+}
+
 JankTracker::JankTracker(const DisplayInfo& displayInfo) {
     // By default this will use malloc memory. It may be moved later to ashmem
     // if there is shared space for it and a request comes in to do that.
@@ -213,6 +251,12 @@ void JankTracker::switchStorageToAshmem(int ashmemfd) {
         newData->frameCounts[i] >>= divider;
         newData->frameCounts[i] += mData->frameCounts[i];
     }
+    for (size_t stage = 0; stage < mData->stageCounts.size(); stage++) {
+        for (size_t i = 0; i < mData->stageCounts[stage].size(); i++) {
+            newData->stageCounts[stage][i] >>= divider;
+            newData->stageCounts[stage][i] += mData->stageCounts[stage][i];
+        }
+    }
     newData->jankFrameCount >>= divider;
     newData->jankFrameCount += mData->jankFrameCount;
     newData->totalFrameCount >>= divider;
@@ -251,9 +295,18 @@ void JankTracker::setFrameInterval(nsecs_t frameInterval) {
 }
 
 void JankTracker::addFrame(const FrameInfo& frame) {
+    mFrameHistory.push(frame);
     mData->totalFrameCount++;
     // Fast-path for jank-free frames
     int64_t totalDuration = frame.duration(sFrameStart, FrameInfoIndex::FrameCompleted);
+
+    mData->stageCounts[kStageSync][stageIndexForDuration(frame.duration(
+            FrameInfoIndex::SyncStart, FrameInfoIndex::IssueDrawCommandsStart))]++;
+    mData->stageCounts[kStageDraw][stageIndexForDuration(frame.duration(
+            FrameInfoIndex::IssueDrawCommandsStart, FrameInfoIndex::SwapBuffers))]++;
+    mData->stageCounts[kStageSwap][stageIndexForDuration(frame.duration(
+            FrameInfoIndex::SwapBuffers, FrameInfoIndex::FrameCompleted))]++;
+    mData->stageCounts[kStageCompletion][stageIndexForDuration(totalDuration)]++;
     if (mDequeueTimeForgiveness
             && frame[FrameInfoIndex::DequeueBufferDuration] > 500_us) {
         nsecs_t expectedDequeueDuration =
@@ -340,6 +393,13 @@ void JankTracker::dumpData(int fd, const ProfileDataDescription* description, co
         dprintf(fd, " %ums=%u", frameTimeForSlowFrameCountIndex(i),
                 data->slowFrameCounts[i]);
     }
+    for (int stage = 0; stage < NUM_FRAME_STAGES; stage++) {
+        FrameStage frameStage = static_cast<FrameStage>(stage);
+        dprintf(fd, "\n%s latency: 50th %uus, 90th %uus, 99th %uus", FRAME_STAGE_NAMES[stage],
+                findStagePercentile(data, frameStage, 50),
+                findStagePercentile(data, frameStage, 90),
+                findStagePercentile(data, frameStage, 99));
+    }
     dprintf(fd, "\n");
 }
 
@@ -347,6 +407,9 @@ void JankTracker::reset() {
     mData->jankTypeCounts.fill(0);
     mData->frameCounts.fill(0);
     mData->slowFrameCounts.fill(0);
+    for (auto& counts : mData->stageCounts) {
+        counts.fill(0);
+    }
     mData->totalFrameCount = 0;
     mData->jankFrameCount = 0;
     mData->statStartTime = systemTime(CLOCK_MONOTONIC);
@@ -373,5 +436,22 @@ uint32_t JankTracker::findPercentile(const ProfileData* data, int percentile) {
     return 0;
 }
 
+uint32_t JankTracker::findStagePercentile(const ProfileData* data, FrameStage stage,
+        int percentile) {
+    const auto& counts = data->stageCounts[stage];
+    uint32_t total = 0;
+    for (uint32_t count : counts) {
+        total += count;
+    }
+    int remaining = total - percentile * total / 100;
+    for (int i = counts.size() - 1; i >= 0; i--) {
+        remaining -= counts[i];
+        if (remaining <= 0) {
+            return stageTimeForIndex(i);
+        }
+    }
+    return 0;
+}
+
 } /* namespace uirenderer */
 } /* namespace android */
@@ -18,6 +18,7 @@
 
 #include "FrameInfo.h"
 #include "renderthread/TimeLord.h"
+#include "utils/ConcurrentRingBuffer.h"
 #include "utils/RingBuffer.h"
 
 #include <cutils/compiler.h>
@@ -40,6 +41,25 @@ enum JankType {
     NUM_BUCKETS,
 };
 
+// RenderThread stages with their own latency histogram
+enum FrameStage {
+    // SyncStart -> IssueDrawCommandsStart
+    kStageSync = 0,
+    // IssueDrawCommandsStart -> SwapBuffers
+    kStageDraw,
+    // SwapBuffers -> FrameCompleted
+    kStageSwap,
+    // Frame start (normally IntendedVsync) -> FrameCompleted
+    kStageCompletion,
+
+    // must be last
+    NUM_FRAME_STAGES,
+};
+
+// Log-linear (HDR histogram style) buckets in microseconds: 4 linear sub-buckets per power of
+// two, which bounds the relative error to 25% from 4us all the way up to ~2s
+static const uint32_t kStageHistogramSize = 80;
+
 // Try to keep as small as possible, should match ASHMEM_SIZE in
 // GraphicsStatsService.java
 struct ProfileData {
@@ -48,6 +68,8 @@ struct ProfileData {
     std::array<uint32_t, 57> frameCounts;
     // Holds a histogram of frame times in 50ms increments from 150ms to 5s
     std::array<uint16_t, 97> slowFrameCounts;
+    // Per-stage latency histograms, see JankTracker::stageTimeForIndex()
+    std::array<std::array<uint32_t, kStageHistogramSize>, NUM_FRAME_STAGES> stageCounts;
 
     uint32_t totalFrameCount;
     uint32_t jankFrameCount;
@@ -91,12 +113,29 @@ public:
     uint32_t findPercentile(int p) { return findPercentile(mData, p); }
     static int32_t frameTimeForFrameCountIndex(uint32_t index);
     static int32_t frameTimeForSlowFrameCountIndex(uint32_t index);
+    static uint32_t stageIndexForDuration(nsecs_t duration);
+    // Lower bound, in microseconds, of the stage histogram bucket at index
+    static uint32_t stageTimeForIndex(uint32_t index);
+    static const char* stageName(FrameStage stage);
+
+    /**
+     * Copies up to maxCount of the most recently added frames into out, oldest first, and
+     * returns the number copied. Never blocks the RenderThread, so it is safe to call from
+     * any thread (e.g. while dumping).
+     */
+    size_t copyRecentFrames(FrameInfo* out, size_t maxCount) const {
+        return mFrameHistory.copyRecent(out, maxCount);
+    }
+    static constexpr size_t kFrameHistorySize = 120;
+    // Must be called on the thread that adds frames
+    void clearFrameHistory() { mFrameHistory.clear(); }
 
 private:
     void freeData();
     void setFrameInterval(nsecs_t frameIntervalNanos);
 
     static uint32_t findPercentile(const ProfileData* data, int p);
+    static uint32_t findStagePercentile(const ProfileData* data, FrameStage stage, int p);
     static void dumpData(int fd, const ProfileDataDescription* description, const ProfileData* data);
 
     std::array<int64_t, NUM_BUCKETS> mThresholds;
@@ -112,6 +151,7 @@ private:
     ProfileData* mData;
     bool mIsMapped = false;
     ProfileDataDescription mDescription;
+    ConcurrentRingBuffer<FrameInfo, kFrameHistorySize> mFrameHistory;
 };
 
 } /* namespace uirenderer */
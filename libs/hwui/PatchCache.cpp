@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
 #include <utils/JenkinsHash.h>
 #include <utils/Log.h>
 
@@ -86,46 +88,36 @@ void PatchCache::clearCache() {
     mFreeBlocks = nullptr;
 }
 
-void PatchCache::remove(Vector<patch_pair_t>& patchesToRemove, Res_png_9patch* patch) {
+void PatchCache::remove(Vector<patch_pair_t>& patchesToRemove,
+        const std::vector<Res_png_9patch*>& sortedPatches) {
     LruCache<PatchDescription, Patch*>::Iterator i(mCache);
     while (i.next()) {
         const PatchDescription& key = i.key();
-        if (key.getPatch() == patch) {
+        if (std::binary_search(sortedPatches.begin(), sortedPatches.end(), key.getPatch())) {
             patchesToRemove.push(patch_pair_t(&key, i.value()));
         }
     }
 }
 
 void PatchCache::removeDeferred(Res_png_9patch* patch) {
-    Mutex::Autolock _l(mLock);
-
-    // Assert that patch is not already garbage
-    size_t count = mGarbage.size();
-    for (size_t i = 0; i < count; i++) {
-        if (patch == mGarbage[i]) {
-            patch = nullptr;
-            break;
-        }
-    }
-    LOG_ALWAYS_FATAL_IF(patch == nullptr);
-
     mGarbage.push(patch);
 }
 
 void PatchCache::clearGarbage() {
-    Vector<patch_pair_t> patchesToRemove;
+    std::vector<Res_png_9patch*> garbage;
+    mGarbage.drain(&garbage);
+    if (garbage.empty()) return;
 
-    { // scope for the mutex
-        Mutex::Autolock _l(mLock);
-        size_t count = mGarbage.size();
-        for (size_t i = 0; i < count; i++) {
-            Res_png_9patch* patch = mGarbage[i];
-            remove(patchesToRemove, patch);
-            // A Res_png_9patch is actually an array of byte that's larger
-            // than sizeof(Res_png_9patch). It must be freed as an array.
-            delete[] (int8_t*) patch;
-        }
-        mGarbage.clear();
+    // Assert that no patch was made garbage twice, it would be freed twice below
+    std::sort(garbage.begin(), garbage.end());
+    LOG_ALWAYS_FATAL_IF(std::adjacent_find(garbage.begin(), garbage.end()) != garbage.end());
+
+    Vector<patch_pair_t> patchesToRemove;
+    remove(patchesToRemove, garbage);
+    for (Res_png_9patch* patch : garbage) {
+        // A Res_png_9patch is actually an array of byte that's larger
+        // than sizeof(Res_png_9patch). It must be freed as an array.
+        delete[] (int8_t*) patch;
     }
 
     // TODO: We could sort patchesToRemove by offset to merge
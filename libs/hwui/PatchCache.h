@@ -24,6 +24,9 @@
 
 #include "Debug.h"
 #include "utils/Pair.h"
+#include "utils/StripedGarbageQueue.h"
+
+#include <vector>
 
 namespace android {
 namespace uirenderer {
@@ -80,7 +83,7 @@ public:
      * Process deferred removals.
      */
     void clearGarbage();
-
+    const StripedGarbageQueue<Res_png_9patch*>& getGarbage() const { return mGarbage; }
 
 private:
     struct PatchDescription {
@@ -155,7 +158,8 @@ private:
 
     void setupMesh(Patch* newMesh);
 
-    void remove(Vector<patch_pair_t>& patchesToRemove, Res_png_9patch* patch);
+    void remove(Vector<patch_pair_t>& patchesToRemove,
+            const std::vector<Res_png_9patch*>& sortedPatches);
 
 #if DEBUG_PATCHES
     void dumpFreeBlocks(const char* prefix);
@@ -172,8 +176,7 @@ private:
     BufferBlock* mFreeBlocks;
 
     // Garbage tracking, required to handle GC events on the VM side
-    Vector<Res_png_9patch*> mGarbage;
-    mutable Mutex mLock;
+    StripedGarbageQueue<Res_png_9patch*> mGarbage;
 }; // class PatchCache
 
 }; // namespace uirenderer
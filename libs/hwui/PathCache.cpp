@@ -35,6 +35,8 @@
 
 #include <cutils/properties.h>
 
+#include <algorithm>
+
 namespace android {
 namespace uirenderer {
 
@@ -336,25 +338,24 @@ void PathCache::PathProcessor::onProcess(const sp<Task<sk_sp<Bitmap> > >& task)
 ///////////////////////////////////////////////////////////////////////////////
 
 void PathCache::removeDeferred(const SkPath* path) {
-    Mutex::Autolock l(mLock);
-    mGarbage.push_back(path->getGenerationID());
+    mGarbage.push(path->getGenerationID());
 }
 
 void PathCache::clearGarbage() {
-    Vector<PathDescription> pathsToRemove;
+    std::vector<uint32_t> garbage;
+    mGarbage.drain(&garbage);
+    if (garbage.empty()) return;
 
-    { // scope for the mutex
-        Mutex::Autolock l(mLock);
-        for (const uint32_t generationID : mGarbage) {
-            LruCache<PathDescription, PathTexture*>::Iterator iter(mCache);
-            while (iter.next()) {
-                const PathDescription& key = iter.key();
-                if (key.type == ShapeType::Path && key.shape.path.mGenerationID == generationID) {
-                    pathsToRemove.push(key);
-                }
-            }
+    // One pass over the cache, rather than one per destroyed path
+    std::sort(garbage.begin(), garbage.end());
+    Vector<PathDescription> pathsToRemove;
+    LruCache<PathDescription, PathTexture*>::Iterator iter(mCache);
+    while (iter.next()) {
+        const PathDescription& key = iter.key();
+        if (key.type == ShapeType::Path && std::binary_search(garbage.begin(), garbage.end(),
+                key.shape.path.mGenerationID)) {
+            pathsToRemove.push(key);
         }
-        mGarbage.clear();
     }
 
     for (size_t i = 0; i < pathsToRemove.size(); i++) {
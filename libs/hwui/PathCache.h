@@ -24,12 +24,12 @@
 #include "thread/TaskProcessor.h"
 #include "utils/Macros.h"
 #include "utils/Pair.h"
+#include "utils/StripedGarbageQueue.h"
 
 #include <GLES2/gl2.h>
 #include <SkPaint.h>
 #include <SkPath.h>
 #include <utils/LruCache.h>
-#include <utils/Mutex.h>
 
 #include <vector>
 
@@ -216,6 +216,7 @@ public:
      * Process deferred removals.
      */
     void clearGarbage();
+    const StripedGarbageQueue<uint32_t>& getGarbage() const { return mGarbage; }
     /**
      * Trims the contents of the cache, removing items until it's under its
      * specified limit.
@@ -279,8 +280,8 @@ private:
 
     sp<PathProcessor> mProcessor;
 
-    std::vector<uint32_t> mGarbage;
-    mutable Mutex mLock;
+    // Generation IDs of paths destroyed on other threads
+    StripedGarbageQueue<uint32_t> mGarbage;
 }; // class PathCache
 
 }; // namespace uirenderer
@@ -26,11 +26,13 @@ namespace uirenderer {
 // Base program
 ///////////////////////////////////////////////////////////////////////////////
 
-Program::Program(const ProgramDescription& description, const char* vertex, const char* fragment) {
+Program::Program(const ProgramDescription& description, const char* vertex, const char* fragment,
+        bool retrievable) {
     mInitialized = false;
     mHasColorUniform = false;
     mHasSampler = false;
     mUse = false;
+    mFragmentShader = 0;
 
     // No need to cache compiled shaders, rely instead on Android's
     // persistent shaders cache
@@ -43,20 +45,16 @@ Program::Program(const ProgramDescription& description, const char* vertex, cons
             glAttachShader(mProgramId, mVertexShader);
             glAttachShader(mProgramId, mFragmentShader);
 
-            bindAttrib("position", kBindingPosition);
-            if (description.hasTexture || description.hasExternalTexture) {
-                texCoords = bindAttrib("texCoords", kBindingTexCoords);
-            } else {
-                texCoords = -1;
+            init(description);
+            if (retrievable) {
+                glProgramParameteri(mProgramId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
             }
 
             ATRACE_BEGIN("linkProgram");
             glLinkProgram(mProgramId);
             ATRACE_END();
 
-            GLint status;
-            glGetProgramiv(mProgramId, GL_LINK_STATUS, &status);
-            if (status != GL_TRUE) {
+            if (!onLinked()) {
                 GLint infoLen = 0;
                 glGetProgramiv(mProgramId, GL_INFO_LOG_LENGTH, &infoLen);
                 if (infoLen > 1) {
@@ -65,35 +63,90 @@ Program::Program(const ProgramDescription& description, const char* vertex, cons
                     ALOGE("%s", log);
                 }
                 LOG_ALWAYS_FATAL("Error while linking shaders");
-            } else {
-                mInitialized = true;
             }
         } else {
             glDeleteShader(mVertexShader);
         }
     }
+}
 
-    if (mInitialized) {
-        transform = addUniform("transform");
-        projection = addUniform("projection");
+Program::Program(const ProgramDescription& description, GLenum binaryFormat,
+        const void* binary, GLsizei length) {
+    mInitialized = false;
+    mHasColorUniform = false;
+    mHasSampler = false;
+    mUse = false;
+    mVertexShader = 0;
+    mFragmentShader = 0;
+
+    mProgramId = glCreateProgram();
+    init(description);
+
+    ATRACE_BEGIN("programBinary");
+    glProgramBinary(mProgramId, binaryFormat, binary, length);
+    ATRACE_END();
+
+    if (!onLinked()) {
+        // Drivers are free to reject binaries at any time, e.g. after an update,
+        // the caller falls back to building the program from sources
+        glDeleteProgram(mProgramId);
     }
 }
 
 Program::~Program() {
     if (mInitialized) {
-        // This would ideally happen after linking the program
-        // but Tegra drivers, especially when perfhud is enabled,
-        // sometimes crash if we do so
-        glDetachShader(mProgramId, mVertexShader);
-        glDetachShader(mProgramId, mFragmentShader);
+        if (mVertexShader) {
+            // This would ideally happen after linking the program
+            // but Tegra drivers, especially when perfhud is enabled,
+            // sometimes crash if we do so
+            glDetachShader(mProgramId, mVertexShader);
+            glDetachShader(mProgramId, mFragmentShader);
 
-        glDeleteShader(mVertexShader);
-        glDeleteShader(mFragmentShader);
+            glDeleteShader(mVertexShader);
+            glDeleteShader(mFragmentShader);
+        }
 
         glDeleteProgram(mProgramId);
     }
 }
 
+void Program::init(const ProgramDescription& description) {
+    bindAttrib("position", kBindingPosition);
+    if (description.hasTexture || description.hasExternalTexture) {
+        texCoords = bindAttrib("texCoords", kBindingTexCoords);
+    } else {
+        texCoords = -1;
+    }
+}
+
+bool Program::onLinked() {
+    GLint status;
+    glGetProgramiv(mProgramId, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        return false;
+    }
+
+    mInitialized = true;
+    transform = addUniform("transform");
+    projection = addUniform("projection");
+    return true;
+}
+
+bool Program::getBinary(GLenum* outFormat, std::vector<uint8_t>* outBinary) const {
+    if (!mInitialized) return false;
+
+    GLint length = 0;
+    glGetProgramiv(mProgramId, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return false;
+
+    outBinary->resize(length);
+    GLsizei written = 0;
+    glGetProgramBinary(mProgramId, length, &written, outFormat, outBinary->data());
+    if (written <= 0) return false;
+    outBinary->resize(written);
+    return true;
+}
+
 int Program::addAttrib(const char* name) {
     int slot = glGetAttribLocation(mProgramId, name);
     mAttributes.add(name, slot);
@@ -21,6 +21,7 @@
 
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#include <GLES3/gl3.h>
 
 #include <SkBlendMode.h>
 
@@ -30,6 +31,8 @@
 #include "Properties.h"
 #include "utils/Color.h"
 
+#include <vector>
+
 namespace android {
 namespace uirenderer {
 
@@ -301,6 +304,19 @@ struct ProgramDescription {
         return key;
     }
 
+    /**
+     * Computes the key the program is cached under, which is shared by equivalent programs.
+     */
+    programid cacheKey() const {
+        programid k = key();
+        if (k == (PROGRAM_KEY_TEXTURE | PROGRAM_KEY_A8_TEXTURE)) {
+            // program for A8, unmodulated, texture w/o shader (black text/path textures) is
+            // equivalent to standard texture program (bitmaps, patches).
+            return PROGRAM_KEY_TEXTURE;
+        }
+        return k;
+    }
+
     /**
      * Logs the specified message followed by the key identifying this program.
      */
@@ -340,11 +356,27 @@ public:
 
     /**
      * Creates a new program with the specified vertex and fragment
-     * shaders sources.
+     * shaders sources. When retrievable is set, the driver is asked to
+     * keep the linked binary around for getBinary().
+     */
+    Program(const ProgramDescription& description, const char* vertex, const char* fragment,
+            bool retrievable = false);
+
+    /**
+     * Creates a new program from a binary previously returned by getBinary(),
+     * without compiling any shader. The program is left uninitialized if the
+     * driver rejects the binary.
      */
-    Program(const ProgramDescription& description, const char* vertex, const char* fragment);
+    Program(const ProgramDescription& description, GLenum binaryFormat,
+            const void* binary, GLsizei length);
     virtual ~Program();
 
+    /**
+     * Reads back the linked program. Returns false if the driver could not
+     * provide it.
+     */
+    bool getBinary(GLenum* outFormat, std::vector<uint8_t>* outBinary) const;
+
     /**
      * Binds this program to the GL context.
      */
@@ -429,6 +461,18 @@ protected:
     int addUniform(const char* name);
 
 private:
+    /**
+     * Sets the state shared by both constructors and binds the
+     * attributes, which must happen before linking.
+     */
+    void init(const ProgramDescription& description);
+
+    /**
+     * Initializes the uniforms once the program is linked, if linking
+     * succeeded. Returns the link status.
+     */
+    bool onLinked();
+
     /**
      * Compiles the specified shader of the specified type.
      *
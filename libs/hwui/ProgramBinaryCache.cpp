@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ProgramBinaryCache.h"
+
+#include <utils/JenkinsHash.h>
+#include <utils/Log.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace android {
+namespace uirenderer {
+
+// "HWPB", bump kFileVersion whenever the layout below or ProgramDescription changes
+static const uint32_t kFileMagic = 0x42505748;
+static const uint32_t kFileVersion = 2;
+
+///////////////////////////////////////////////////////////////////////////////
+// Serialization helpers
+///////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+static void writeValue(std::vector<uint8_t>* data, const T& value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    data->insert(data->end(), bytes, bytes + sizeof(T));
+}
+
+static void writeBytes(std::vector<uint8_t>* data, const void* bytes, uint32_t size) {
+    writeValue(data, size);
+    const uint8_t* start = reinterpret_cast<const uint8_t*>(bytes);
+    data->insert(data->end(), start, start + size);
+}
+
+// Fields are written one at a time, so that padding never makes it into the file
+static void writeDescription(std::vector<uint8_t>* data, const ProgramDescription& description) {
+    const bool flags[] = {
+            description.hasTexture, description.hasAlpha8Texture,
+            description.hasExternalTexture, description.hasTextureTransform,
+            description.hasColors, description.modulate,
+            description.hasBitmap, description.isShaderBitmapExternal,
+            description.useShaderBasedWrap, description.hasVertexAlpha,
+            description.useShadowAlphaInterp, description.hasGradient,
+            description.isSimpleGradient, description.isBitmapFirst,
+            description.swapSrcDst, description.hasDebugHighlight,
+            description.hasRoundRectClip, description.hasGammaCorrection,
+            description.hasLinearTexture, description.hasColorSpaceConversion,
+            description.hasTranslucentConversion,
+    };
+    for (bool flag : flags) {
+        writeValue(data, static_cast<uint8_t>(flag));
+    }
+    writeValue(data, static_cast<int32_t>(description.gradientType));
+    writeValue(data, static_cast<int32_t>(description.shadersMode));
+    writeValue(data, static_cast<uint32_t>(description.bitmapWrapS));
+    writeValue(data, static_cast<uint32_t>(description.bitmapWrapT));
+    writeValue(data, static_cast<int32_t>(description.colorOp));
+    writeValue(data, static_cast<int32_t>(description.colorMode));
+    writeValue(data, static_cast<int32_t>(description.framebufferMode));
+    writeValue(data, static_cast<int32_t>(description.transferFunction));
+}
+
+class BinaryReader {
+public:
+    BinaryReader(const uint8_t* data, size_t size) : mData(data), mRemaining(size) {}
+
+    template<typename T>
+    bool read(T* outValue) {
+        if (mRemaining < sizeof(T)) return false;
+        memcpy(outValue, mData, sizeof(T));
+        advance(sizeof(T));
+        return true;
+    }
+
+    bool readDescription(ProgramDescription* outDescription) {
+        bool* flags[] = {
+                &outDescription->hasTexture, &outDescription->hasAlpha8Texture,
+                &outDescription->hasExternalTexture, &outDescription->hasTextureTransform,
+                &outDescription->hasColors, &outDescription->modulate,
+                &outDescription->hasBitmap, &outDescription->isShaderBitmapExternal,
+                &outDescription->useShaderBasedWrap, &outDescription->hasVertexAlpha,
+                &outDescription->useShadowAlphaInterp, &outDescription->hasGradient,
+                &outDescription->isSimpleGradient, &outDescription->isBitmapFirst,
+                &outDescription->swapSrcDst, &outDescription->hasDebugHighlight,
+                &outDescription->hasRoundRectClip, &outDescription->hasGammaCorrection,
+                &outDescription->hasLinearTexture, &outDescription->hasColorSpaceConversion,
+                &outDescription->hasTranslucentConversion,
+        };
+        for (bool* flag : flags) {
+            uint8_t value;
+            if (!read(&value)) return false;
+            *flag = value != 0;
+        }
+        int32_t gradientType, shadersMode, colorOp, colorMode, framebufferMode, transferFunction;
+        uint32_t bitmapWrapS, bitmapWrapT;
+        if (!read(&gradientType) || !read(&shadersMode) || !read(&bitmapWrapS)
+                || !read(&bitmapWrapT) || !read(&colorOp) || !read(&colorMode)
+                || !read(&framebufferMode) || !read(&transferFunction)) {
+            return false;
+        }
+        outDescription->gradientType = static_cast<ProgramDescription::Gradient>(gradientType);
+        outDescription->shadersMode = static_cast<SkBlendMode>(shadersMode);
+        outDescription->bitmapWrapS = bitmapWrapS;
+        outDescription->bitmapWrapT = bitmapWrapT;
+        outDescription->colorOp = static_cast<ProgramDescription::ColorFilterMode>(colorOp);
+        outDescription->colorMode = static_cast<SkBlendMode>(colorMode);
+        outDescription->framebufferMode = static_cast<SkBlendMode>(framebufferMode);
+        outDescription->transferFunction = static_cast<TransferFunctionType>(transferFunction);
+        return true;
+    }
+
+    bool readBytes(const uint8_t** outBytes, uint32_t* outSize) {
+        if (!read(outSize) || mRemaining < *outSize) return false;
+        *outBytes = mData;
+        advance(*outSize);
+        return true;
+    }
+
+private:
+    void advance(size_t size) {
+        mData += size;
+        mRemaining -= size;
+    }
+
+    const uint8_t* mData;
+    size_t mRemaining;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Entries
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t ProgramBinaryCache::hashSources(const char* vertexShader, const char* fragmentShader) {
+    uint32_t hash = JenkinsHashMixBytes(0,
+            reinterpret_cast<const uint8_t*>(vertexShader), strlen(vertexShader));
+    hash = JenkinsHashMixBytes(hash,
+            reinterpret_cast<const uint8_t*>(fragmentShader), strlen(fragmentShader));
+    return JenkinsHashWhiten(hash);
+}
+
+const ProgramBinaryCache::Entry* ProgramBinaryCache::find(programid key) const {
+    auto iter = mEntries.find(key);
+    return iter == mEntries.end() ? nullptr : &iter->second;
+}
+
+void ProgramBinaryCache::put(programid key, Entry&& entry) {
+    auto iter = mEntries.find(key);
+    if (iter != mEntries.end()) {
+        // Keep the history of a program whose binary is being replaced
+        entry.useCount = std::max(entry.useCount, iter->second.useCount);
+    }
+    mEntries[key] = std::move(entry);
+}
+
+bool ProgramBinaryCache::recordUse(programid key) {
+    auto iter = mEntries.find(key);
+    if (iter == mEntries.end()) return false;
+    iter->second.useCount++;
+    return true;
+}
+
+std::vector<programid> ProgramBinaryCache::mostUsed(size_t maxCount) const {
+    std::vector<std::pair<uint32_t, programid>> counts;
+    counts.reserve(mEntries.size());
+    for (const auto& entry : mEntries) {
+        counts.emplace_back(entry.second.useCount, entry.first);
+    }
+    // Most used first, ties broken by key so the order is stable across runs
+    std::sort(counts.begin(), counts.end(),
+            [](const std::pair<uint32_t, programid>& lhs, const std::pair<uint32_t, programid>& rhs) {
+        return lhs.first != rhs.first ? lhs.first > rhs.first : lhs.second < rhs.second;
+    });
+    std::vector<programid> keys;
+    for (size_t i = 0; i < counts.size() && i < maxCount; i++) {
+        keys.push_back(counts[i].second);
+    }
+    return keys;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Serialization
+///////////////////////////////////////////////////////////////////////////////
+
+void ProgramBinaryCache::serialize(const std::string& driverId,
+        std::vector<uint8_t>* outData) const {
+    std::vector<programid> keys = mostUsed(kMaxEntries);
+
+    outData->clear();
+    writeValue(outData, kFileMagic);
+    writeValue(outData, kFileVersion);
+    writeBytes(outData, driverId.c_str(), driverId.size());
+    writeValue(outData, static_cast<uint32_t>(keys.size()));
+    for (programid key : keys) {
+        const Entry& entry = mEntries.at(key);
+        writeValue(outData, key);
+        writeDescription(outData, entry.description);
+        writeValue(outData, entry.sourceHash);
+        writeValue(outData, entry.useCount);
+        writeValue(outData, entry.binaryFormat);
+        writeBytes(outData, entry.binary.data(), entry.binary.size());
+    }
+}
+
+bool ProgramBinaryCache::parse(const std::string& driverId, const uint8_t* data, size_t size) {
+    BinaryReader reader(data, size);
+    uint32_t magic, version;
+    const uint8_t* savedDriverId;
+    uint32_t savedDriverIdLength;
+    if (!reader.read(&magic) || magic != kFileMagic
+            || !reader.read(&version) || version != kFileVersion
+            || !reader.readBytes(&savedDriverId, &savedDriverIdLength)) {
+        return false;
+    }
+    if (driverId.size() != savedDriverIdLength
+            || memcmp(driverId.c_str(), savedDriverId, savedDriverIdLength)) {
+        // Binaries from another driver (e.g. after an update) would be rejected anyway
+        return false;
+    }
+
+    uint32_t entryCount;
+    if (!reader.read(&entryCount)) return false;
+
+    std::map<programid, Entry> entries;
+    for (uint32_t i = 0; i < entryCount; i++) {
+        programid key;
+        Entry entry;
+        const uint8_t* binary;
+        uint32_t binaryLength;
+        if (!reader.read(&key) || !reader.readDescription(&entry.description)
+                || !reader.read(&entry.sourceHash) || !reader.read(&entry.useCount)
+                || !reader.read(&entry.binaryFormat)
+                || !reader.readBytes(&binary, &binaryLength)) {
+            return false;
+        }
+        if (binaryLength > kMaxBinarySize) return false;
+        // precompile() builds the program of a key from its description, so they must agree
+        if (entry.description.cacheKey() != key) {
+            ALOGW("Dropping cached program binary, key 0x%" PRIx64 " doesn't match its description",
+                    key);
+            continue;
+        }
+        entry.binary.assign(binary, binary + binaryLength);
+        entries[key] = std::move(entry);
+    }
+    mEntries.swap(entries);
+    return true;
+}
+
+bool ProgramBinaryCache::load(const std::string& path, const std::string& driverId) {
+    ATRACE_NAME("ProgramBinaryCache::load");
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        int err = errno;
+        // The file not existing is normal for the first run
+        if (err != ENOENT) {
+            ALOGW("Failed to open '%s', errno=%d (%s)", path.c_str(), err, strerror(err));
+        }
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0
+            || st.st_size > static_cast<off_t>(kMaxEntries * (kMaxBinarySize + 1024))) {
+        close(fd);
+        return false;
+    }
+    std::vector<uint8_t> data(st.st_size);
+    ssize_t bytesRead = TEMP_FAILURE_RETRY(read(fd, data.data(), data.size()));
+    close(fd);
+    if (bytesRead != static_cast<ssize_t>(data.size())) {
+        ALOGW("Failed to read '%s', bytesRead=%zd", path.c_str(), bytesRead);
+        return false;
+    }
+    return parse(driverId, data.data(), data.size());
+}
+
+bool ProgramBinaryCache::save(const std::string& path, const std::string& driverId) const {
+    ATRACE_NAME("ProgramBinaryCache::save");
+    std::vector<uint8_t> data;
+    serialize(driverId, &data);
+
+    // Write to the side and rename, so a reader never sees a partially written file
+    std::string tempPath = path + ".tmp";
+    int outFd = open(tempPath.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0600);
+    if (outFd == -1) {
+        int err = errno;
+        ALOGW("Failed to open '%s', error=%d (%s)", tempPath.c_str(), err, strerror(err));
+        return false;
+    }
+    ssize_t wrote = TEMP_FAILURE_RETRY(write(outFd, data.data(), data.size()));
+    close(outFd);
+    if (wrote != static_cast<ssize_t>(data.size())
+            || rename(tempPath.c_str(), path.c_str()) != 0) {
+        int err = errno;
+        ALOGW("Failed to write '%s', wrote=%zd errno=%d (%s)",
+                path.c_str(), wrote, err, strerror(err));
+        unlink(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+}; // namespace uirenderer
+}; // namespace android
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "Program.h"
+
+#include <GLES2/gl2.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace android {
+namespace uirenderer {
+
+/**
+ * Linked program binaries, keyed by program key, that outlive the process. ProgramCache
+ * uses them to skip compiling and linking the shaders of programs it has seen before, and
+ * the use counts to pick which programs to warm up at startup.
+ *
+ * Binaries are only valid for the driver that produced them, so the cache is tagged with a
+ * driver id (vendor, renderer and version strings) and parse() drops the whole content when
+ * that doesn't match. Each entry also remembers a hash of the shader sources it was built
+ * from, which catches programs whose generated source changed for an unchanged key.
+ *
+ * This class does no GL work, so loading and saving can happen on any thread as long as
+ * a single instance isn't shared between threads.
+ */
+class ProgramBinaryCache {
+public:
+    struct Entry {
+        ProgramDescription description;
+        uint32_t sourceHash = 0;
+        // Number of processes that needed this program
+        uint32_t useCount = 0;
+        GLenum binaryFormat = 0;
+        std::vector<uint8_t> binary;
+    };
+
+    // Entries beyond this, least used first, are dropped when serializing
+    static constexpr size_t kMaxEntries = 128;
+    static constexpr size_t kMaxBinarySize = 256 * 1024;
+
+    ProgramBinaryCache() {}
+
+    static uint32_t hashSources(const char* vertexShader, const char* fragmentShader);
+
+    const Entry* find(programid key) const;
+    void put(programid key, Entry&& entry);
+    // Returns true if the key has an entry, whose use count changed
+    bool recordUse(programid key);
+
+    /**
+     * Returns up to maxCount keys, most used first.
+     */
+    std::vector<programid> mostUsed(size_t maxCount) const;
+
+    size_t size() const { return mEntries.size(); }
+    void clear() { mEntries.clear(); }
+
+    void serialize(const std::string& driverId, std::vector<uint8_t>* outData) const;
+    // Entries whose description isn't for their key are dropped
+    bool parse(const std::string& driverId, const uint8_t* data, size_t size);
+
+    bool load(const std::string& path, const std::string& driverId);
+    bool save(const std::string& path, const std::string& driverId) const;
+
+private:
+    std::map<programid, Entry> mEntries;
+};
+
+}; // namespace uirenderer
+}; // namespace android
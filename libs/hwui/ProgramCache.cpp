@@ -14,7 +14,11 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
+#include <utils/Mutex.h>
 #include <utils/String8.h>
+#include <utils/Trace.h>
 
 #include "Caches.h"
 #include "ProgramCache.h"
@@ -34,6 +38,13 @@ namespace uirenderer {
 #define STR(x) STR1(x)
 #define STR1(x) #x
 
+// Number of the programs previous runs used most that are warmed up
+#define PRECOMPILE_PROGRAM_COUNT 32
+// Programs warmed up after each frame, a binary load is well under a millisecond
+#define PRECOMPILE_PROGRAMS_PER_FRAME 2
+// Frames without any new program before new binaries are written to disk
+#define DISK_CACHE_SAVE_DELAY_FRAMES 120
+
 ///////////////////////////////////////////////////////////////////////////////
 // Vertex shaders snippets
 ///////////////////////////////////////////////////////////////////////////////
@@ -501,6 +512,58 @@ const char* gBlendOps[18] = {
                 "max(src.rgb * dst.a, dst.rgb * src.a), src.a + dst.a - src.a * dst.a);\n",
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// Disk cache
+///////////////////////////////////////////////////////////////////////////////
+
+static Mutex sDiskCachePathLock;
+static std::string sDiskCachePath;
+
+class ProgramCache::DiskCacheTask : public Task<bool> {
+public:
+    enum class Op {
+        Load,
+        Save
+    };
+
+    DiskCacheTask(Op op, const std::string& path, const std::string& driverId)
+            : op(op)
+            , path(path)
+            , driverId(driverId) {}
+
+    const Op op;
+    const std::string path;
+    const std::string driverId;
+    // Filled in by a load, or a snapshot of the cache to save
+    ProgramBinaryCache cache;
+};
+
+class ProgramCache::DiskCacheProcessor : public TaskProcessor<bool> {
+public:
+    explicit DiskCacheProcessor(TaskManager* manager)
+            : TaskProcessor<bool>(manager) {}
+    ~DiskCacheProcessor() {}
+
+    virtual void onProcess(const sp<Task<bool> >& task) override {
+        DiskCacheTask* t = static_cast<DiskCacheTask*>(task.get());
+        if (t->op == DiskCacheTask::Op::Load) {
+            t->setResult(t->cache.load(t->path, t->driverId));
+        } else {
+            t->setResult(t->cache.save(t->path, t->driverId));
+        }
+    }
+};
+
+void ProgramCache::setDiskCachePath(const std::string& path) {
+    AutoMutex _lock(sDiskCachePathLock);
+    sDiskCachePath = path;
+}
+
+static std::string getGlString(GLenum name) {
+    const char* value = reinterpret_cast<const char*>(glGetString(name));
+    return value ? value : "";
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Constructors/destructors
 ///////////////////////////////////////////////////////////////////////////////
@@ -508,10 +571,52 @@ const char* gBlendOps[18] = {
 ProgramCache::ProgramCache(Extensions& extensions)
         : mHasES3(extensions.getMajorGlVersion() >= 3)
         , mHasLinearBlending(extensions.hasLinearBlending()) {
+    GLint binaryFormatCount = 0;
+    if (mHasES3) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormatCount);
+    }
+    if (binaryFormatCount > 0) {
+        AutoMutex _lock(sDiskCachePathLock);
+        mDiskCachePath = sDiskCachePath;
+    }
+    if (!mDiskCachePath.empty()) {
+        mDriverId = getGlString(GL_VENDOR) + "/" + getGlString(GL_RENDERER) + "/"
+                + getGlString(GL_VERSION);
+    }
 }
 
 ProgramCache::~ProgramCache() {
-    clear();
+    // Not clear(), the task manager may already be gone, Caches::terminate() saves instead
+    mCache.clear();
+}
+
+void ProgramCache::loadDiskCache(TaskManager& tasks) {
+    if (mDiskCachePath.empty() || mLoadTask.get()) return;
+    mDiskCacheProcessor = new DiskCacheProcessor(&tasks);
+    mLoadTask = new DiskCacheTask(DiskCacheTask::Op::Load, mDiskCachePath, mDriverId);
+    mDiskCacheProcessor->add(mLoadTask);
+}
+
+void ProgramCache::waitForDiskCache() {
+    if (!mLoadTask.get()) return;
+    if (!mLoadTask->isFinished()) {
+        ATRACE_NAME("waitForProgramDiskCache");
+        mLoadTask->getResult();
+    }
+    if (mLoadTask->getResult()) {
+        mBinaryCache = std::move(mLoadTask->cache);
+    }
+    mLoadTask.clear();
+}
+
+void ProgramCache::saveDiskCache() {
+    if (!mBinaryCacheDirty || !mDiskCacheProcessor.get()) return;
+    // The task writes its own copy, the render thread keeps using this one
+    sp<DiskCacheTask> task = new DiskCacheTask(DiskCacheTask::Op::Save,
+            mDiskCachePath, mDriverId);
+    task->cache = mBinaryCache;
+    mDiskCacheProcessor->add(task);
+    mBinaryCacheDirty = false;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -520,16 +625,13 @@ ProgramCache::~ProgramCache() {
 
 void ProgramCache::clear() {
     PROGRAM_LOGD("Clearing program cache");
+    saveDiskCache();
     mCache.clear();
+    mUnusedPrecompiled.clear();
 }
 
 Program* ProgramCache::get(const ProgramDescription& description) {
-    programid key = description.key();
-    if (key == (PROGRAM_KEY_TEXTURE | PROGRAM_KEY_A8_TEXTURE)) {
-        // program for A8, unmodulated, texture w/o shader (black text/path textures) is equivalent
-        // to standard texture program (bitmaps, patches). Consider them equivalent.
-        key = PROGRAM_KEY_TEXTURE;
-    }
+    programid key = description.cacheKey();
 
     auto iter = mCache.find(key);
     Program* program = nullptr;
@@ -537,12 +639,78 @@ Program* ProgramCache::get(const ProgramDescription& description) {
         description.log("Could not find program");
         program = generateProgram(description, key);
         mCache[key] = std::unique_ptr<Program>(program);
+        recordUse(key);
+        mFramesSinceNewProgram = 0;
     } else {
         program = iter->second.get();
+        if (CC_UNLIKELY(!mUnusedPrecompiled.empty()) && mUnusedPrecompiled.erase(key)) {
+            recordUse(key);
+        }
     }
     return program;
 }
 
+void ProgramCache::recordUse(programid key) {
+    // Every process uses about the same programs, rewriting the file for their counts alone
+    // would happen on every launch. The counts are saved along with the next new binary,
+    // unless they change which programs the next process warms up.
+    std::vector<programid> warmed = mBinaryCache.mostUsed(PRECOMPILE_PROGRAM_COUNT);
+    if (!mBinaryCache.recordUse(key)) return;
+    std::vector<programid> nowWarmed = mBinaryCache.mostUsed(PRECOMPILE_PROGRAM_COUNT);
+    std::sort(warmed.begin(), warmed.end());
+    std::sort(nowWarmed.begin(), nowWarmed.end());
+    if (warmed != nowWarmed) {
+        mBinaryCacheDirty = true;
+    }
+}
+
+int ProgramCache::precompile(int maxCount) {
+    if (mDiskCachePath.empty()) return 0;
+    waitForDiskCache();
+
+    int created = 0;
+    for (programid key : mBinaryCache.mostUsed(PRECOMPILE_PROGRAM_COUNT)) {
+        if (created >= maxCount) break;
+        if (mCache.find(key) != mCache.end()) continue;
+
+        // Copy, generating the program may update the binary cache
+        ProgramDescription description = mBinaryCache.find(key)->description;
+        mCache[key] = std::unique_ptr<Program>(generateProgram(description, key));
+        mUnusedPrecompiled.insert(key);
+        mStats.precompiled++;
+        created++;
+    }
+    return created;
+}
+
+bool ProgramCache::isPrecompilePending() const {
+    // Don't hold up the first frames on the disk cache, warming starts once it's loaded
+    return !mDiskCachePath.empty() && !mPrecompileDone
+            && (!mLoadTask.get() || mLoadTask->isFinished());
+}
+
+void ProgramCache::onFrameCompleted() {
+    if (mBinaryCacheDirty && mFramesSinceNewProgram < DISK_CACHE_SAVE_DELAY_FRAMES) {
+        mFramesSinceNewProgram++;
+    }
+}
+
+bool ProgramCache::hasIdleWork() const {
+    return isPrecompilePending()
+            || (mBinaryCacheDirty && mFramesSinceNewProgram >= DISK_CACHE_SAVE_DELAY_FRAMES);
+}
+
+void ProgramCache::doIdleWork() {
+    if (isPrecompilePending()) {
+        ATRACE_NAME("precompilePrograms");
+        mPrecompileDone = precompile(PRECOMPILE_PROGRAMS_PER_FRAME) == 0;
+    }
+
+    if (mBinaryCacheDirty && mFramesSinceNewProgram >= DISK_CACHE_SAVE_DELAY_FRAMES) {
+        saveDiskCache();
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Program generation
 ///////////////////////////////////////////////////////////////////////////////
@@ -551,7 +719,38 @@ Program* ProgramCache::generateProgram(const ProgramDescription& description, pr
     String8 vertexShader = generateVertexShader(description);
     String8 fragmentShader = generateFragmentShader(description);
 
-    return new Program(description, vertexShader.string(), fragmentShader.string());
+    if (mDiskCachePath.empty()) {
+        return new Program(description, vertexShader.string(), fragmentShader.string());
+    }
+
+    waitForDiskCache();
+    uint32_t sourceHash = ProgramBinaryCache::hashSources(vertexShader.string(),
+            fragmentShader.string());
+    const ProgramBinaryCache::Entry* entry = mBinaryCache.find(key);
+    if (entry && entry->sourceHash == sourceHash) {
+        Program* program = new Program(description, entry->binaryFormat,
+                entry->binary.data(), entry->binary.size());
+        if (program->isInitialized()) {
+            mStats.binaryHits++;
+            return program;
+        }
+        delete program;
+        mStats.binaryRejects++;
+    }
+
+    Program* program = new Program(description, vertexShader.string(),
+            fragmentShader.string(), true);
+    mStats.compiles++;
+
+    ProgramBinaryCache::Entry newEntry;
+    if (program->getBinary(&newEntry.binaryFormat, &newEntry.binary)
+            && newEntry.binary.size() <= ProgramBinaryCache::kMaxBinarySize) {
+        newEntry.description = description;
+        newEntry.sourceHash = sourceHash;
+        mBinaryCache.put(key, std::move(newEntry));
+        mBinaryCacheDirty = true;
+    }
+    return program;
 }
 
 static inline size_t gradientIndex(const ProgramDescription& description) {
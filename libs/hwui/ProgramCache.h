@@ -21,11 +21,16 @@
 #include <utils/Log.h>
 #include <utils/String8.h>
 #include <map>
+#include <set>
+#include <string>
 
 #include <GLES2/gl2.h>
 
 #include "Debug.h"
 #include "Program.h"
+#include "ProgramBinaryCache.h"
+#include "thread/Task.h"
+#include "thread/TaskProcessor.h"
 
 namespace android {
 namespace uirenderer {
@@ -37,17 +42,79 @@ namespace uirenderer {
 /**
  * Generates and caches program. Programs are generated based on
  * ProgramDescriptions.
+ *
+ * When the driver supports program binaries and a disk cache path is set,
+ * the linked binaries are also persisted across processes. A later process
+ * loads them instead of compiling the shaders again, and warms up the
+ * programs previous runs used most a few at a time after each frame.
  */
 class ProgramCache {
 public:
+    struct Stats {
+        // Programs created from a binary of the disk cache
+        uint32_t binaryHits = 0;
+        // Binaries the driver refused, usually after a driver update
+        uint32_t binaryRejects = 0;
+        // Programs compiled from sources
+        uint32_t compiles = 0;
+        // Programs created ahead of use by precompile()
+        uint32_t precompiled = 0;
+    };
+
     explicit ProgramCache(Extensions& extensions);
     ~ProgramCache();
 
+    /**
+     * Sets the file program binaries are persisted to, an empty path disables
+     * the disk cache. Only applies to caches created afterwards.
+     */
+    static void setDiskCachePath(const std::string& path);
+
+    /**
+     * Starts reading the disk cache on a background thread of tasks.
+     */
+    void loadDiskCache(TaskManager& tasks);
+
     Program* get(const ProgramDescription& description);
 
+    /**
+     * Creates up to maxCount of the programs previous runs used most that
+     * have not been created yet, and returns how many were created.
+     */
+    int precompile(int maxCount);
+
+    /**
+     * Called on the render thread after each frame, only does the bookkeeping
+     * for doIdleWork().
+     */
+    void onFrameCompleted();
+
+    bool hasIdleWork() const;
+
+    /**
+     * Warms up a couple of programs, and persists new binaries once no new
+     * program has been needed for a while. Linking programs is expensive, so
+     * this is meant to run once the frame is swapped, when the RenderThread
+     * is idle.
+     */
+    void doIdleWork();
+
     void clear();
 
+    const Stats& getStats() const { return mStats; }
+
+    // Visible for testing
+    const ProgramBinaryCache& getBinaryCache() const { return mBinaryCache; }
+
 private:
+    class DiskCacheTask;
+    class DiskCacheProcessor;
+
+    void waitForDiskCache();
+    bool isPrecompilePending() const;
+    void recordUse(programid key);
+    void saveDiskCache();
+
     Program* generateProgram(const ProgramDescription& description, programid key);
     String8 generateVertexShader(const ProgramDescription& description);
     String8 generateFragmentShader(const ProgramDescription& description);
@@ -60,6 +127,21 @@ private:
 
     const bool mHasES3;
     const bool mHasLinearBlending;
+
+    // Empty when program binaries can't be persisted
+    std::string mDiskCachePath;
+    std::string mDriverId;
+    ProgramBinaryCache mBinaryCache;
+    bool mBinaryCacheDirty = false;
+    sp<DiskCacheTask> mLoadTask;
+    sp<TaskProcessor<bool>> mDiskCacheProcessor;
+
+    // Precompiled programs that get() has not been asked for yet
+    std::set<programid> mUnusedPrecompiled;
+    bool mPrecompileDone = false;
+    int mFramesSinceNewProgram = 0;
+
+    Stats mStats;
 }; // class ProgramCache
 
 }; // namespace uirenderer
@@ -35,6 +35,7 @@ bool Properties::showDirtyRegions = false;
 bool Properties::skipEmptyFrames = true;
 bool Properties::useBufferAge = true;
 bool Properties::enablePartialUpdates = true;
+bool Properties::skipCleanSubtrees = true;
 
 float Properties::textGamma = DEFAULT_TEXT_GAMMA;
 
@@ -146,6 +147,7 @@ bool Properties::load() {
     skipEmptyFrames = property_get_bool(PROPERTY_SKIP_EMPTY_DAMAGE, true);
     useBufferAge = property_get_bool(PROPERTY_USE_BUFFER_AGE, true);
     enablePartialUpdates = property_get_bool(PROPERTY_ENABLE_PARTIAL_UPDATES, true);
+    skipCleanSubtrees = property_get_bool(PROPERTY_SKIP_CLEAN_SUBTREES, true);
 
     textGamma = property_get_float(PROPERTY_TEXT_GAMMA, DEFAULT_TEXT_GAMMA);
 
@@ -152,6 +152,13 @@ enum DebugLevel {
 
 #define PROPERTY_FILTER_TEST_OVERHEAD "debug.hwui.filter_test_overhead"
 
+/**
+ * Setting this to "false" makes prepareTree visit every RenderNode each frame, instead of
+ * skipping subtrees that have no pending changes, animators or per-frame work.
+ * Default is "true"
+ */
+#define PROPERTY_SKIP_CLEAN_SUBTREES "debug.hwui.skip_clean_subtrees"
+
 /**
  * Allows to set rendering pipeline mode to OpenGL (default), Skia OpenGL
  * or Vulkan.
@@ -278,6 +285,7 @@ public:
     static bool skipEmptyFrames;
     static bool useBufferAge;
     static bool enablePartialUpdates;
+    static bool skipCleanSubtrees;
 
     static float textGamma;
 
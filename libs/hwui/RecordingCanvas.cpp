@@ -39,7 +39,8 @@ RecordingCanvas::~RecordingCanvas() {
 void RecordingCanvas::resetRecording(int width, int height, RenderNode* node) {
     LOG_ALWAYS_FATAL_IF(mDisplayList,
             "prepareDirty called a second time during a recording!");
-    mDisplayList = new DisplayList();
+    mDisplayList = DisplayListPool::getInstance().obtain();
+    mDedupStats = DedupStats();
 
     mState.initializeRecordingSaveStack(width, height);
 
@@ -48,9 +49,9 @@ void RecordingCanvas::resetRecording(int width, int height, RenderNode* node) {
 
 DisplayList* RecordingCanvas::finishRecording() {
     restoreToCount(1);
-    mPaintMap.clear();
-    mRegionMap.clear();
-    mPathMap.clear();
+    mPaintTable.clear();
+    mRegionTable.clear();
+    mPathTable.clear();
     DisplayList* displayList = mDisplayList;
     mDisplayList = nullptr;
     mSkiaCanvasProxy.reset(nullptr);
@@ -170,6 +171,7 @@ int RecordingCanvas::saveLayer(float left, float top, float right, float bottom,
                     previousClip, // clip to *draw* with
                     refPaint(paint))) >= 0) {
                 snapshot.flags |= Snapshot::kFlagIsLayer | Snapshot::kFlagIsFboLayer;
+                mDisplayList->hasClippedLayers = true;
                 snapshot.initializeViewport(unmappedBounds.getWidth(), unmappedBounds.getHeight());
                 snapshot.transform->loadTranslate(-unmappedBounds.left, -unmappedBounds.top, 0.0f);
 
@@ -24,6 +24,7 @@
 #include "Snapshot.h"
 #include "hwui/Bitmap.h"
 #include "hwui/Canvas.h"
+#include "utils/DedupTable.h"
 #include "utils/LinearAllocator.h"
 #include "utils/Macros.h"
 
@@ -52,6 +53,17 @@ public:
 
     virtual void resetRecording(int width, int height, RenderNode* node = nullptr) override;
     virtual WARN_UNUSED_RESULT DisplayList* finishRecording() override;
+
+    // How many objects the current (or last) recording copied, and how many it deduped
+    struct DedupStats {
+        uint32_t uniquePaints = 0;
+        uint32_t dedupedPaints = 0;
+        uint32_t uniquePaths = 0;
+        uint32_t dedupedPaths = 0;
+        uint32_t uniqueRegions = 0;
+        uint32_t dedupedRegions = 0;
+    };
+    const DedupStats& getDedupStats() const { return mDedupStats; }
 // ----------------------------------------------------------------------------
 // MISC HWUI OPERATIONS - TODO: CATEGORIZE
 // ----------------------------------------------------------------------------
@@ -227,10 +239,22 @@ private:
     inline const SkPath* refPath(const SkPath* path) {
         if (!path) return nullptr;
 
+        // Copies keep the generationID of the original path, so an unmodified path drawn
+        // again finds its earlier copy. The equality check covers reused generationIDs.
+        const uint32_t key = path->getGenerationID();
+        const SkPath* cachedPath = mPathTable.find(key,
+                [path](const SkPath* cached) { return *cached == *path; });
+        if (cachedPath) {
+            mDedupStats.dedupedPaths++;
+            return cachedPath;
+        }
+
         // The points/verbs within the path are refcounted so this copy operation
         // is inexpensive and maintains the generationID of the original path.
-        const SkPath* cachedPath = new SkPath(*path);
+        cachedPath = new SkPath(*path);
         mDisplayList->pathResources.push_back(cachedPath);
+        mPathTable.insert(key, cachedPath, cachedPath);
+        mDedupStats.uniquePaths++;
         return cachedPath;
     }
 
@@ -252,17 +276,20 @@ private:
 
         // compute the hash key for the paint and check the cache.
         const uint32_t key = paint->getHash();
-        const SkPaint* cachedPaint = mPaintMap.valueFor(key);
         // In the unlikely event that 2 unique paints have the same hash we do a
         // object equality check to ensure we don't erroneously dedup them.
-        if (cachedPaint == nullptr || *cachedPaint != *paint) {
-            cachedPaint = new SkPaint(*paint);
-            mDisplayList->paints.emplace_back(cachedPaint);
-            // replaceValueFor() performs an add if the entry doesn't exist
-            mPaintMap.replaceValueFor(key, cachedPaint);
-            refBitmapsInShader(cachedPaint->getShader());
+        const SkPaint* cachedPaint = mPaintTable.find(key,
+                [paint](const SkPaint* cached) { return *cached == *paint; });
+        if (cachedPaint) {
+            mDedupStats.dedupedPaints++;
+            return cachedPaint;
         }
 
+        // The copy lives in the DisplayList's allocator, which destroys it along with the ops
+        cachedPaint = alloc().create<SkPaint>(*paint);
+        mPaintTable.insert(key, cachedPaint, cachedPaint);
+        mDedupStats.uniquePaints++;
+        refBitmapsInShader(cachedPaint->getShader());
         return cachedPaint;
     }
 
@@ -271,17 +298,18 @@ private:
             return region;
         }
 
-        const SkRegion* cachedRegion = mRegionMap.valueFor(region);
         // TODO: Add generation ID to SkRegion
-        if (cachedRegion == nullptr) {
-            std::unique_ptr<const SkRegion> copy(new SkRegion(*region));
-            cachedRegion = copy.get();
-            mDisplayList->regions.push_back(std::move(copy));
-
-            // replaceValueFor() performs an add if the entry doesn't exist
-            mRegionMap.replaceValueFor(region, cachedRegion);
+        const uint32_t key = RegionTable::hashPointer(region);
+        const SkRegion* cachedRegion = mRegionTable.find(key,
+                [region](const SkRegion* source) { return source == region; });
+        if (cachedRegion) {
+            mDedupStats.dedupedRegions++;
+            return cachedRegion;
         }
 
+        cachedRegion = alloc().create<SkRegion>(*region);
+        mRegionTable.insert(key, region, cachedRegion);
+        mDedupStats.uniqueRegions++;
         return cachedRegion;
     }
 
@@ -304,9 +332,12 @@ private:
         return patch;
     }
 
-    DefaultKeyedVector<uint32_t, const SkPaint*> mPaintMap;
-    DefaultKeyedVector<const SkPath*, const SkPath*> mPathMap;
-    DefaultKeyedVector<const SkRegion*, const SkRegion*> mRegionMap;
+    // Paints and paths are keyed by their copies, regions by the caller's pointer
+    typedef DedupTable<SkRegion, SkRegion> RegionTable;
+    DedupTable<SkPaint, SkPaint> mPaintTable;
+    DedupTable<SkPath, SkPath> mPathTable;
+    RegionTable mRegionTable;
+    DedupStats mDedupStats;
 
     CanvasState mState;
     std::unique_ptr<SkiaCanvasProxy> mSkiaCanvasProxy;
@@ -29,12 +29,15 @@
 #include "renderstate/RenderState.h"
 #include "renderthread/CanvasContext.h"
 
+#include <utils/Mutex.h>
+
 #include "protos/hwui.pb.h"
 #include "protos/ProtoHelpers.h"
 
 #include <algorithm>
 #include <sstream>
 #include <string>
+#include <vector>
 
 namespace android {
 namespace uirenderer {
@@ -53,6 +56,12 @@ private:
     TreeInfo* mTreeInfo;
 };
 
+// RenderNodes whose staging state changed since the last MODE_FULL prepareTree. Nodes are
+// queued from the UI thread, which doesn't know their parents, and the RenderThread walks up
+// from them before the next traversal so that the path down to them isn't skipped.
+static Mutex sNeedsPrepareLock;
+static std::vector<RenderNode*> sNeedsPrepareQueue;
+
 RenderNode::RenderNode()
         : mDirtyPropertyFields(0)
         , mNeedsDisplayListSync(false)
@@ -63,6 +72,15 @@ RenderNode::RenderNode()
 }
 
 RenderNode::~RenderNode() {
+    {
+        // Unqueue before tearing anything down, so that a RenderThread draining the queue
+        // never sees a half destroyed node. Leaving the flag set keeps it from being queued again.
+        AutoMutex _lock(sNeedsPrepareLock);
+        if (mQueuedForPrepare.exchange(true)) {
+            sNeedsPrepareQueue.erase(std::remove(sNeedsPrepareQueue.begin(),
+                    sNeedsPrepareQueue.end(), this), sNeedsPrepareQueue.end());
+        }
+    }
     ImmediateRemoved observer(nullptr);
     deleteDisplayList(observer);
     delete mStagingDisplayList;
@@ -74,6 +92,7 @@ void RenderNode::setStagingDisplayList(DisplayList* displayList) {
     mNeedsDisplayListSync = true;
     delete mStagingDisplayList;
     mStagingDisplayList = displayList;
+    markNeedsPrepare();
 }
 
 /**
@@ -196,15 +215,71 @@ void RenderNode::prepareTree(TreeInfo& info) {
     // will need to be drawn in a layer.
     bool functorsNeedLayer = Properties::debugOverdraw && !Properties::isSkiaEnabled();
 
+    if (info.mode == TreeInfo::MODE_FULL) {
+        propagateNeedsPrepare();
+    }
     prepareTreeImpl(observer, info, functorsNeedLayer);
 }
 
 void RenderNode::addAnimator(const sp<BaseRenderNodeAnimator>& animator) {
     mAnimatorManager.addAnimator(animator);
+    markNeedsPrepare();
 }
 
 void RenderNode::removeAnimator(const sp<BaseRenderNodeAnimator>& animator) {
     mAnimatorManager.removeAnimator(animator);
+    markNeedsPrepare();
+}
+
+void RenderNode::markNeedsPrepare() {
+    if (!mQueuedForPrepare.exchange(true)) {
+        AutoMutex _lock(sNeedsPrepareLock);
+        sNeedsPrepareQueue.push_back(this);
+    }
+}
+
+void RenderNode::propagateNeedsPrepare() {
+    AutoMutex _lock(sNeedsPrepareLock);
+    for (RenderNode* node : sNeedsPrepareQueue) {
+        node->mQueuedForPrepare = false;
+        node->markSubtreeNeedsPrepare();
+    }
+    sNeedsPrepareQueue.clear();
+}
+
+void RenderNode::markSubtreeNeedsPrepare() {
+    // A node that is already marked was either never prepared or had a child that needed
+    // preparing, and in both cases its ancestors are marked as well
+    if (mSubtreeNeedsPrepare) return;
+    mSubtreeNeedsPrepare = true;
+    for (RenderNode* parent : mParents) {
+        parent->markSubtreeNeedsPrepare();
+    }
+}
+
+bool RenderNode::canSkipPrepare(const TreeInfo& info, bool functorsNeedLayer) const {
+    // The Skia pipeline pins images and collects projection receivers during prepare, and
+    // functors may have to be moved onto a layer, so only skip in the simple case
+    return Properties::skipCleanSubtrees
+            && !mSubtreeNeedsPrepare
+            && !functorsNeedLayer
+            && !Properties::isSkiaEnabled();
+}
+
+bool RenderNode::needsPrepareEveryFrame() {
+    // Animators and position listeners run from prepareTree, and layers must be re-queued
+    // for update every frame
+    if (mAnimatorManager.hasAnimators() || mPositionListener.get()) return true;
+    if (hasLayer() || properties().effectiveLayerType() == LayerType::RenderLayer) return true;
+    return mDisplayList && (mDisplayList->hasFunctor() || mDisplayList->hasVectorDrawables());
+}
+
+bool RenderNode::drawsChildrenIntoLayer() const {
+    // Matches FrameBuilder::deferNodePropsAndOps(): a RenderLayer, or a saveLayer for alpha
+    LayerType layerType = properties().effectiveLayerType();
+    return layerType == LayerType::RenderLayer
+            || (layerType == LayerType::None && properties().getAlpha() < 1
+                    && properties().getHasOverlappingRendering());
 }
 
 void RenderNode::damageSelf(TreeInfo& info) {
@@ -288,6 +363,7 @@ void RenderNode::pushLayerUpdate(TreeInfo& info) {
  * stencil buffer may be needed. Views that use a functor to draw will be forced onto a layer.
  */
 void RenderNode::prepareTreeImpl(TreeObserver& observer, TreeInfo& info, bool functorsNeedLayer) {
+    info.out.nodesPrepared++;
     info.damageAccumulator->pushTransform(this);
 
     if (info.mode == TreeInfo::MODE_FULL) {
@@ -316,18 +392,41 @@ void RenderNode::prepareTreeImpl(TreeObserver& observer, TreeInfo& info, bool fu
         pushStagingDisplayListChanges(observer, info);
     }
 
+    // FrameBuilder draws the children of a layer with a layer-relative transform and light
+    // center, so the shadows DisplayList would prefetch for them with the window's wouldn't match
+    const Vector3* lightCenter = info.lightCenter;
+    if (CC_UNLIKELY(lightCenter && drawsChildrenIntoLayer())) {
+        info.lightCenter = nullptr;
+    }
+
+    bool childrenNeedPrepare = false;
+    uint32_t subtreeSize = 1;
     if (mDisplayList) {
         info.out.hasFunctors |= mDisplayList->hasFunctor();
         bool isDirty = mDisplayList->prepareListAndChildren(observer, info, childFunctorsNeedLayer,
-                [](RenderNode* child, TreeObserver& observer, TreeInfo& info, bool functorsNeedLayer) {
-            child->prepareTreeImpl(observer, info, functorsNeedLayer);
+                [&childrenNeedPrepare, &subtreeSize](RenderNode* child, TreeObserver& observer,
+                        TreeInfo& info, bool functorsNeedLayer) {
+            if (child->canSkipPrepare(info, functorsNeedLayer)) {
+                // Nothing below the child changed, so it would produce no damage
+                info.out.nodesSkipped += child->mSubtreeSize;
+            } else {
+                child->prepareTreeImpl(observer, info, functorsNeedLayer);
+            }
+            childrenNeedPrepare |= child->mSubtreeNeedsPrepare;
+            subtreeSize += child->mSubtreeSize;
         });
         if (isDirty) {
             damageSelf(info);
         }
     }
+    info.lightCenter = lightCenter;
     pushLayerUpdate(info);
 
+    // RT-driven traversals don't push staging changes, so they must not clear the flag
+    mSubtreeNeedsPrepare = childrenNeedPrepare || needsPrepareEveryFrame()
+            || (info.mode != TreeInfo::MODE_FULL && mSubtreeNeedsPrepare);
+    mSubtreeSize = subtreeSize;
+
     info.damageAccumulator->popTransform();
 }
 
@@ -361,8 +460,8 @@ void RenderNode::syncDisplayList(TreeObserver& observer, TreeInfo* info) {
     // Make sure we inc first so that we don't fluctuate between 0 and 1,
     // which would thrash the layer cache
     if (mStagingDisplayList) {
-        mStagingDisplayList->updateChildren([](RenderNode* child) {
-            child->incParentRefCount();
+        mStagingDisplayList->updateChildren([this](RenderNode* child) {
+            child->incParentRefCount(this);
         });
     }
     deleteDisplayList(observer, info);
@@ -386,8 +485,8 @@ void RenderNode::pushStagingDisplayListChanges(TreeObserver& observer, TreeInfo&
 
 void RenderNode::deleteDisplayList(TreeObserver& observer, TreeInfo* info) {
     if (mDisplayList) {
-        mDisplayList->updateChildren([&observer, info](RenderNode* child) {
-            child->decParentRefCount(observer, info);
+        mDisplayList->updateChildren([this, &observer, info](RenderNode* child) {
+            child->decParentRefCount(observer, info, this);
         });
         if (!mDisplayList->reuseDisplayList(this, info ? &info->canvasContext : nullptr)) {
             delete mDisplayList;
@@ -417,9 +516,22 @@ void RenderNode::destroyLayers() {
     }
 }
 
-void RenderNode::decParentRefCount(TreeObserver& observer, TreeInfo* info) {
+void RenderNode::incParentRefCount(RenderNode* parent) {
+    mParentCount++;
+    if (parent) {
+        mParents.push_back(parent);
+    }
+}
+
+void RenderNode::decParentRefCount(TreeObserver& observer, TreeInfo* info, RenderNode* parent) {
     LOG_ALWAYS_FATAL_IF(!mParentCount, "already 0!");
     mParentCount--;
+    if (parent) {
+        auto it = std::find(mParents.begin(), mParents.end(), parent);
+        if (it != mParents.end()) {
+            mParents.erase(it);
+        }
+    }
     if (!mParentCount) {
         observer.onMaybeRemovedFromTree(this);
         if (CC_UNLIKELY(mPositionListener.get())) {
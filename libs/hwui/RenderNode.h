@@ -36,6 +36,7 @@
 #include "pipeline/skia/SkiaLayer.h"
 #include "utils/FatVector.h"
 
+#include <atomic>
 #include <vector>
 
 class SkBitmap;
@@ -147,6 +148,7 @@ public:
 
     void setPropertyFieldsDirty(uint32_t fields) {
         mDirtyPropertyFields |= fields;
+        markNeedsPrepare();
     }
 
     const RenderProperties& properties() const {
@@ -230,6 +232,7 @@ public:
     // RenderNode takes ownership of the pointer
     ANDROID_API void setPositionListener(PositionListener* listener) {
         mPositionListener = listener;
+        markNeedsPrepare();
     }
 
     // This is only modified in MODE_FULL, so it can be safely accessed
@@ -266,8 +269,17 @@ private:
     void deleteDisplayList(TreeObserver& observer, TreeInfo* info = nullptr);
     void damageSelf(TreeInfo& info);
 
-    void incParentRefCount() { mParentCount++; }
-    void decParentRefCount(TreeObserver& observer, TreeInfo* info = nullptr);
+    void incParentRefCount(RenderNode* parent = nullptr);
+    void decParentRefCount(TreeObserver& observer, TreeInfo* info = nullptr,
+            RenderNode* parent = nullptr);
+
+    // Queues this node so the next MODE_FULL prepareTree visits it and its ancestors
+    void markNeedsPrepare();
+    static void propagateNeedsPrepare();
+    void markSubtreeNeedsPrepare();
+    bool canSkipPrepare(const TreeInfo& info, bool functorsNeedLayer) const;
+    bool needsPrepareEveryFrame();
+    bool drawsChildrenIntoLayer() const;
 
     String8 mName;
     sp<VirtualLightRefBase> mUserContext;
@@ -307,6 +319,19 @@ private:
     // mDisplayList, not mStagingDisplayList.
     uint32_t mParentCount;
 
+    // The RenderNodes whose synced display lists draw this one. Follows the same threading
+    // rules as mParentCount.
+    FatVector<RenderNode*, 1> mParents;
+
+    // Set when this node or something below it has to be prepared in the next frame. Set by
+    // propagateNeedsPrepare() for nodes with pending staging changes and their ancestors, and
+    // recomputed when the node is prepared. Only MODE_FULL traversals may clear it.
+    bool mSubtreeNeedsPrepare = true;
+    // Number of nodes in this subtree the last time it was prepared
+    uint32_t mSubtreeSize = 1;
+    // Whether this node is waiting in the queue drained by propagateNeedsPrepare()
+    std::atomic<bool> mQueuedForPrepare{false};
+
     sp<PositionListener> mPositionListener;
 
 // METHODS & FIELDS ONLY USED BY THE SKIA RENDERER
@@ -161,6 +161,23 @@ Vector2 ShadowTessellator::calculateNormal(const Vector2& p1, const Vector2& p2)
     return result;
 }
 
+// Branch free version of calculateNormal(), for a delta of (dx, dy)
+static inline void normalFromDelta(float dx, float dy, float* outNormalX, float* outNormalY) {
+    float length = sqrtf(dx * dx + dy * dy);
+    float scale = length != 0 ? 1.0f / length : 0.0f;
+    *outNormalX = -dy * scale;
+    *outNormalY = dx * scale;
+}
+
+void ShadowTessellator::calculateNormals(const float* x, const float* y, int count,
+        float* outNormalX, float* outNormalY) {
+    for (int i = 0; i < count - 1; i++) {
+        normalFromDelta(x[i + 1] - x[i], y[i + 1] - y[i], &outNormalX[i], &outNormalY[i]);
+    }
+    normalFromDelta(x[0] - x[count - 1], y[0] - y[count - 1],
+            &outNormalX[count - 1], &outNormalY[count - 1]);
+}
+
 int ShadowTessellator::getExtraVertexNumber(const Vector2& vector1,
         const Vector2& vector2, float divisor) {
     // When there is no distance difference, there is no need for extra vertices.
@@ -82,6 +82,14 @@ public:
 
     static Vector2 calculateNormal(const Vector2& p1, const Vector2& p2);
 
+    /**
+     * Same as calculateNormal() for every edge (i, i + 1) of a closed polygon, with the
+     * coordinates and the results kept in separate arrays. There is no state carried
+     * between iterations, so the loop can be vectorized by the compiler.
+     */
+    static void calculateNormals(const float* x, const float* y, int count,
+            float* outNormalX, float* outNormalY);
+
     static int getExtraVertexNumber(const Vector2& vector1, const Vector2& vector2,
             float divisor);
 
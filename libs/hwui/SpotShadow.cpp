@@ -65,18 +65,6 @@ namespace uirenderer {
 
 static const float EPSILON = 1e-7;
 
-/**
- * For each polygon's vertex, the light center will project it to the receiver
- * as one of the outline vertex.
- * For each outline vertex, we need to store the position and normal.
- * Normal here is defined against the edge by the current vertex and the next vertex.
- */
-struct OutlineData {
-    Vector2 position;
-    Vector2 normal;
-    float radius;
-};
-
 /**
  * For each vertex, we need to keep track of its angle, whether it is penumbra or
  * umbra, and its corresponding vertex index.
@@ -361,6 +349,25 @@ float SpotShadow::projectCasterToOutline(Vector2& outline,
     return ratioZ;
 }
 
+/**
+ * Same as projectCasterToOutline() for every vertex of the caster, writing the outline
+ * coordinates and the outline radius into separate arrays. The cap on the ratio is
+ * applied with selects instead of a branch so the loop can be vectorized.
+ */
+void SpotShadow::projectCasterToOutlines(const Vector3& lightCenter, float lightSize,
+        const Vector3* poly, int polyLength,
+        float* outlineX, float* outlineY, float* outlineRadius) {
+    for (int i = 0; i < polyLength; i++) {
+        float lightToPolyZ = lightCenter.z - poly[i].z;
+        float ratioZ = MathUtils::clamp(poly[i].z / lightToPolyZ, 0.0f, CASTER_Z_CAP_RATIO);
+        ratioZ = lightToPolyZ != 0 ? ratioZ : CASTER_Z_CAP_RATIO;
+
+        outlineX[i] = poly[i].x - ratioZ * (lightCenter.x - poly[i].x);
+        outlineY[i] = poly[i].y - ratioZ * (lightCenter.y - poly[i].y);
+        outlineRadius[i] = ratioZ * lightSize;
+    }
+}
+
 /**
  * Generate the shadow spot light of shape lightPoly and a object poly
  *
@@ -385,7 +392,13 @@ void SpotShadow::createSpotShadow(bool isCasterOpaque, const Vector3& lightCente
 #endif
         return;
     }
-    OutlineData outlineData[polyLength];
+    // The outline is kept as separate coordinate arrays, so the per vertex passes
+    // below have no cross-iteration state and can be vectorized.
+    float outlineX[polyLength];
+    float outlineY[polyLength];
+    float outlineRadius[polyLength];
+    float normalX[polyLength];
+    float normalY[polyLength];
     Vector2 outlineCentroid;
     // Calculate the projected outline for each polygon's vertices from the light center.
     //
@@ -400,29 +413,85 @@ void SpotShadow::createSpotShadow(bool isCasterOpaque, const Vector3& lightCente
     // Ratio = (Poly - Outline) / (Light - Poly)
     // Outline.x = Poly.x - Ratio * (Light.x - Poly.x)
     // Outline's radius / Light's radius = Ratio
-
-    // Compute the last outline vertex to make sure we can get the normal and outline
-    // in one single loop.
-    projectCasterToOutline(outlineData[polyLength - 1].position, lightCenter,
-            poly[polyLength - 1]);
+    projectCasterToOutlines(lightCenter, lightSize, poly, polyLength,
+            outlineX, outlineY, outlineRadius);
 
     // Take the outline's polygon, calculate the normal for each outline edge.
-    int currentNormalIndex = polyLength - 1;
-    int nextNormalIndex = 0;
+    ShadowTessellator::calculateNormals(outlineX, outlineY, polyLength, normalX, normalY);
+
+    projectCasterToOutline(outlineCentroid, lightCenter, polyCentroid);
 
+    // Compute the umbra by the intersection from the outline's centroid!
+    //
+    //       (V) ------------------------------------
+    //           |          '                       |
+    //           |         '                        |
+    //           |       ' (I)                      |
+    //           |    '                             |
+    //           | '             (C)                |
+    //           |                                  |
+    //           |                                  |
+    //           |                                  |
+    //           |                                  |
+    //           ------------------------------------
+    //
+    // Connect a line b/t the outline vertex (V) and the centroid (C), it will
+    // intersect with the outline vertex's circle at point (I).
+    // Now, ratioVI = VI / VC, ratioIC = IC / VC
+    // Then the intersetion point can be computed as Ixy = Vxy * ratioIC + Cxy * ratioVI;
+    //
+    // When all of the outline circles cover the the outline centroid, (like I is
+    // on the other side of C), there is no real umbra any more, so we just fake
+    // a small area around the centroid as the umbra, and tune down the spot
+    // shadow's umbra strength to simulate the effect the whole shadow will
+    // become lighter in this case.
+    // The ratio can be simulated by using the inverse of maximum of ratioVI for
+    // all (V).
+    float ratioVI[polyLength];
+    bool hasZeroDistance = false;
     for (int i = 0; i < polyLength; i++) {
-        float ratioZ = projectCasterToOutline(outlineData[i].position,
-                lightCenter, poly[i]);
-        outlineData[i].radius = ratioZ * lightSize;
-
-        outlineData[currentNormalIndex].normal = ShadowTessellator::calculateNormal(
-                outlineData[currentNormalIndex].position,
-                outlineData[nextNormalIndex].position);
-        currentNormalIndex = (currentNormalIndex + 1) % polyLength;
-        nextNormalIndex++;
+        float dx = outlineX[i] - outlineCentroid.x;
+        float dy = outlineY[i] - outlineCentroid.y;
+        float distOutline = sqrtf(dx * dx + dy * dy);
+        hasZeroDistance |= (distOutline == 0);
+        ratioVI[i] = outlineRadius[i] / distOutline;
+    }
+    if (CC_UNLIKELY(hasZeroDistance)) {
+        // If the outline has 0 area, then there is no spot shadow anyway.
+        ALOGW("Outline has 0 area, no spot shadow!");
+        return;
     }
 
-    projectCasterToOutline(outlineCentroid, lightCenter, polyCentroid);
+    // We need the minimal of RaitoVI to decrease the spot shadow strength accordingly.
+    float minRaitoVI = FLT_MAX;
+    for (int i = 0; i < polyLength; i++) {
+        minRaitoVI = std::min(minRaitoVI, ratioVI[i]);
+    }
+
+    // When centroid is covered by all circles from outline, then we consider
+    // the umbra is invalid, and we will tune down the shadow strength.
+    bool hasValidUmbra = (minRaitoVI <= 1.0);
+    float shadowStrengthScale = 1.0;
+    Vector2 umbra[polyLength];
+    if (hasValidUmbra) {
+        for (int i = 0; i < polyLength; i++) {
+            float clampedRatioVI = std::min(ratioVI[i], 1 - FAKE_UMBRA_SIZE_RATIO);
+            float ratioIC = 1 - clampedRatioVI;
+            umbra[i].x = outlineX[i] * ratioIC + outlineCentroid.x * clampedRatioVI;
+            umbra[i].y = outlineY[i] * ratioIC + outlineCentroid.y * clampedRatioVI;
+        }
+    } else {
+#if DEBUG_SHADOW
+        ALOGW("The object is too close to the light or too small, no real umbra!");
+#endif
+        for (int i = 0; i < polyLength; i++) {
+            umbra[i].x = outlineX[i] * FAKE_UMBRA_SIZE_RATIO +
+                    outlineCentroid.x * (1 - FAKE_UMBRA_SIZE_RATIO);
+            umbra[i].y = outlineY[i] * FAKE_UMBRA_SIZE_RATIO +
+                    outlineCentroid.y * (1 - FAKE_UMBRA_SIZE_RATIO);
+        }
+        shadowStrengthScale = 1.0 / minRaitoVI;
+    }
 
     int penumbraIndex = 0;
     // Then each polygon's vertex produce at minmal 2 penumbra vertices.
@@ -432,14 +501,6 @@ void SpotShadow::createSpotShadow(bool isCasterOpaque, const Vector3& lightCente
     Vector2 penumbra[allocatedPenumbraLength];
     int totalExtraCornerSliceNumber = 0;
 
-    Vector2 umbra[polyLength];
-
-    // When centroid is covered by all circles from outline, then we consider
-    // the umbra is invalid, and we will tune down the shadow strength.
-    bool hasValidUmbra = true;
-    // We need the minimal of RaitoVI to decrease the spot shadow strength accordingly.
-    float minRaitoVI = FLT_MAX;
-
     for (int i = 0; i < polyLength; i++) {
         // Generate all the penumbra's vertices only using the (outline vertex + normal * radius)
         // There is no guarantee that the penumbra is still convex, but for
@@ -465,8 +526,9 @@ void SpotShadow::createSpotShadow(bool isCasterOpaque, const Vector3& lightCente
         //       (V3)-----------------------------------(V2)
         int preNormalIndex = (i + polyLength - 1) % polyLength;
 
-        const Vector2& previousNormal = outlineData[preNormalIndex].normal;
-        const Vector2& currentNormal = outlineData[i].normal;
+        const Vector2 previousNormal = {normalX[preNormalIndex], normalY[preNormalIndex]};
+        const Vector2 currentNormal = {normalX[i], normalY[i]};
+        const Vector2 outlinePosition = {outlineX[i], outlineY[i]};
 
         // Depending on how roundness we want for each corner, we can subdivide
         // further here and/or introduce some heuristic to decide how much the
@@ -489,67 +551,8 @@ void SpotShadow::createSpotShadow(bool isCasterOpaque, const Vector3& lightCente
                     (previousNormal * (currentCornerSliceNumber - k) + currentNormal * k) /
                     currentCornerSliceNumber;
             avgNormal.normalize();
-            penumbra[penumbraIndex++] = outlineData[i].position +
-                    avgNormal * outlineData[i].radius;
+            penumbra[penumbraIndex++] = outlinePosition + avgNormal * outlineRadius[i];
         }
-
-
-        // Compute the umbra by the intersection from the outline's centroid!
-        //
-        //       (V) ------------------------------------
-        //           |          '                       |
-        //           |         '                        |
-        //           |       ' (I)                      |
-        //           |    '                             |
-        //           | '             (C)                |
-        //           |                                  |
-        //           |                                  |
-        //           |                                  |
-        //           |                                  |
-        //           ------------------------------------
-        //
-        // Connect a line b/t the outline vertex (V) and the centroid (C), it will
-        // intersect with the outline vertex's circle at point (I).
-        // Now, ratioVI = VI / VC, ratioIC = IC / VC
-        // Then the intersetion point can be computed as Ixy = Vxy * ratioIC + Cxy * ratioVI;
-        //
-        // When all of the outline circles cover the the outline centroid, (like I is
-        // on the other side of C), there is no real umbra any more, so we just fake
-        // a small area around the centroid as the umbra, and tune down the spot
-        // shadow's umbra strength to simulate the effect the whole shadow will
-        // become lighter in this case.
-        // The ratio can be simulated by using the inverse of maximum of ratioVI for
-        // all (V).
-        float distOutline = (outlineData[i].position - outlineCentroid).length();
-        if (CC_UNLIKELY(distOutline == 0)) {
-            // If the outline has 0 area, then there is no spot shadow anyway.
-            ALOGW("Outline has 0 area, no spot shadow!");
-            return;
-        }
-
-        float ratioVI = outlineData[i].radius / distOutline;
-        minRaitoVI = std::min(minRaitoVI, ratioVI);
-        if (ratioVI >= (1 - FAKE_UMBRA_SIZE_RATIO)) {
-            ratioVI = (1 - FAKE_UMBRA_SIZE_RATIO);
-        }
-        // When we know we don't have valid umbra, don't bother to compute the
-        // values below. But we can't skip the loop yet since we want to know the
-        // maximum ratio.
-        float ratioIC = 1 - ratioVI;
-        umbra[i] = outlineData[i].position * ratioIC + outlineCentroid * ratioVI;
-    }
-
-    hasValidUmbra = (minRaitoVI <= 1.0);
-    float shadowStrengthScale = 1.0;
-    if (!hasValidUmbra) {
-#if DEBUG_SHADOW
-        ALOGW("The object is too close to the light or too small, no real umbra!");
-#endif
-        for (int i = 0; i < polyLength; i++) {
-            umbra[i] = outlineData[i].position * FAKE_UMBRA_SIZE_RATIO +
-                    outlineCentroid * (1 - FAKE_UMBRA_SIZE_RATIO);
-        }
-        shadowStrengthScale = 1.0 / minRaitoVI;
     }
 
     int penumbraLength = penumbraIndex;
@@ -794,39 +797,52 @@ inline bool genPolyToCentroid(const Vector2* poly2d, int polyLength,
     return refCrossProduct > 0;
 }
 
-// For one umbra vertex, shoot an ray from centroid to it.
-// If the ray hit the polygon first, then return the intersection point as the
-// closer vertex.
-inline Vector2 getCloserVertex(const Vector2& umbraVertex, const Vector2& centroid,
+// For every umbra vertex, shoot a ray from the centroid to it. If the ray hits the
+// polygon first, then the intersection point is the closer vertex.
+//
+// Finding the edge each ray hits walks the polygon from the previous ray's edge, so
+// that part stays sequential. The ray setup and the intersections themselves have no
+// cross-iteration state and run as separate passes over the umbra.
+inline void getCloserVertices(const Vector2* umbra, int umbraLength, const Vector2& centroid,
         const Vector2* poly2d, int polyLength, const Vector2* polyToCentroid,
-        bool isPositiveCross, int& previousPolyIndex) {
-    Vector2 umbraToCentroid = umbraVertex - centroid;
-    float distanceToUmbra = umbraToCentroid.length();
-    umbraToCentroid = umbraToCentroid / distanceToUmbra;
-
-    // previousPolyIndex is updated for each item such that we can minimize the
-    // looping inside findPolyIndex();
-    previousPolyIndex = findPolyIndex(isPositiveCross, previousPolyIndex,
-            umbraToCentroid, polyToCentroid, polyLength);
-
-    float dx = umbraToCentroid.x;
-    float dy = umbraToCentroid.y;
-    float distanceToIntersectPoly = rayIntersectPoints(centroid, dx, dy,
-            poly2d[previousPolyIndex], poly2d[(previousPolyIndex + 1) % polyLength]);
-    if (distanceToIntersectPoly < 0) {
-        distanceToIntersectPoly = 0;
+        bool isPositiveCross, Vector2* outCloserVertices) {
+    float rayDx[umbraLength];
+    float rayDy[umbraLength];
+    float distanceToUmbra[umbraLength];
+    for (int i = 0; i < umbraLength; i++) {
+        float dx = umbra[i].x - centroid.x;
+        float dy = umbra[i].y - centroid.y;
+        float distance = sqrtf(dx * dx + dy * dy);
+        rayDx[i] = dx / distance;
+        rayDy[i] = dy / distance;
+        distanceToUmbra[i] = distance;
     }
 
-    // Pick the closer one as the occluded area vertex.
-    Vector2 closerVertex;
-    if (distanceToIntersectPoly < distanceToUmbra) {
-        closerVertex.x = centroid.x + dx * distanceToIntersectPoly;
-        closerVertex.y = centroid.y + dy * distanceToIntersectPoly;
-    } else {
-        closerVertex = umbraVertex;
+    // Because both the umbra and polygon are going in the same direction,
+    // we can save the previous polygon index to make sure we have less polygon
+    // vertex to compute for each ray.
+    int edgeStart[umbraLength];
+    int edgeEnd[umbraLength];
+    int previousPolyIndex = 0;
+    for (int i = 0; i < umbraLength; i++) {
+        const Vector2 umbraDir = {rayDx[i], rayDy[i]};
+        previousPolyIndex = findPolyIndex(isPositiveCross, previousPolyIndex,
+                umbraDir, polyToCentroid, polyLength);
+        edgeStart[i] = previousPolyIndex;
+        edgeEnd[i] = (previousPolyIndex + 1) % polyLength;
     }
 
-    return closerVertex;
+    for (int i = 0; i < umbraLength; i++) {
+        float distanceToIntersectPoly = std::max(rayIntersectPoints(centroid,
+                rayDx[i], rayDy[i], poly2d[edgeStart[i]], poly2d[edgeEnd[i]]), 0.0f);
+
+        // Pick the closer one as the occluded area vertex.
+        bool hitsPoly = distanceToIntersectPoly < distanceToUmbra[i];
+        outCloserVertices[i].x = hitsPoly
+                ? centroid.x + rayDx[i] * distanceToIntersectPoly : umbra[i].x;
+        outCloserVertices[i].y = hitsPoly
+                ? centroid.y + rayDy[i] * distanceToIntersectPoly : umbra[i].y;
+    }
 }
 
 /**
@@ -959,21 +975,18 @@ void SpotShadow::generateTriangleStrip(bool isCasterOpaque, float shadowStrength
         Vector2 polyToCentroid[polyLength];
         bool isPositiveCross = genPolyToCentroid(poly2d, polyLength, centroid, polyToCentroid);
 
-        // Because both the umbra and polygon are going in the same direction,
-        // we can save the previous polygon index to make sure we have less polygon
-        // vertex to compute for each ray.
-        int previousPolyIndex = 0;
-        for (int i = 0; i < umbraLength; i++) {
-            // Shoot a ray from centroid to each umbra vertices and pick the one with
-            // shorter distance to the centroid, b/t the umbra vertex or the intersection point.
-            Vector2 closerVertex = getCloserVertex(umbra[i], centroid, poly2d, polyLength,
-                    polyToCentroid, isPositiveCross, previousPolyIndex);
+        // Shoot a ray from centroid to each umbra vertices and pick the one with
+        // shorter distance to the centroid, b/t the umbra vertex or the intersection point.
+        Vector2 closerVertices[umbraLength];
+        getCloserVertices(umbra, umbraLength, centroid, poly2d, polyLength,
+                polyToCentroid, isPositiveCross, closerVertices);
 
+        for (int i = 0; i < umbraLength; i++) {
             // We already stored the umbra vertices, just need to add the occlued umbra's ones.
             indexBuffer[indexBufferIndex++] = newPenumbraLength + i;
             indexBuffer[indexBufferIndex++] = vertexBufferIndex;
             AlphaVertex::set(&shadowVertices[vertexBufferIndex++],
-                    closerVertex.x, closerVertex.y, scaledUmbraAlpha);
+                    closerVertices[i].x, closerVertices[i].y, scaledUmbraAlpha);
         }
     } else {
         // If there is no occluded umbra at all, then draw the triangle fan
@@ -64,14 +64,33 @@ bool TessellationCache::Description::operator==(const TessellationCache::Descrip
     if (cap != rhs.cap) return false;
     if (style != rhs.style) return false;
     if (strokeWidth != rhs.strokeWidth) return false;
-    if (type == Type::None) return true;
-    const Shape::RoundRect& lRect = shape.roundRect;
-    const Shape::RoundRect& rRect = rhs.shape.roundRect;
-
-    if (lRect.width != rRect.width) return false;
-    if (lRect.height != rRect.height) return false;
-    if (lRect.rx != rRect.rx) return false;
-    return lRect.ry == rRect.ry;
+    switch (type) {
+        case Type::None:
+            return true;
+        case Type::RoundRect: {
+            const Shape::RoundRect& lRect = shape.roundRect;
+            const Shape::RoundRect& rRect = rhs.shape.roundRect;
+
+            if (lRect.width != rRect.width) return false;
+            if (lRect.height != rRect.height) return false;
+            if (lRect.rx != rRect.rx) return false;
+            return lRect.ry == rRect.ry;
+        }
+        case Type::Oval:
+            return shape.oval.width == rhs.shape.oval.width
+                    && shape.oval.height == rhs.shape.oval.height;
+        case Type::Arc: {
+            const Shape::Arc& lArc = shape.arc;
+            const Shape::Arc& rArc = rhs.shape.arc;
+
+            if (lArc.width != rArc.width) return false;
+            if (lArc.height != rArc.height) return false;
+            if (lArc.startAngle != rArc.startAngle) return false;
+            if (lArc.sweepAngle != rArc.sweepAngle) return false;
+            return lArc.useCenter == rArc.useCenter;
+        }
+    }
+    return false;
 }
 
 hash_t TessellationCache::Description::hash() const {
@@ -94,25 +113,44 @@ void TessellationCache::Description::setupMatrixAndPaint(Matrix4* matrix, SkPain
     paint->setStrokeWidth(strokeWidth);
 }
 
+void TessellationCache::Description::bucketScales() {
+    // AA fringes and hairlines are sized in device pixels from the scales, so they would come
+    // out up to a bucket too thin. Only the subdivision of a non-AA fill depends on them.
+    if (aa || style != SkPaint::kFill_Style) return;
+    scaleX = bucketScale(scaleX);
+    scaleY = bucketScale(scaleY);
+}
+
+float TessellationCache::bucketScale(float scale) {
+    // 8 buckets per doubling of scale, i.e. at most ~9% over-tessellation
+    const float kBucketsPerOctave = 8.0f;
+    return powf(2.0f, ceilf(log2f(scale) * kBucketsPerOctave) / kBucketsPerOctave);
+}
+
 TessellationCache::ShadowDescription::ShadowDescription()
-        : nodeKey(nullptr) {
+        : nodeKey(nullptr)
+        , lightCenter{0, 0, 0} {
     memset(&matrixData, 0, sizeof(matrixData));
 }
 
-TessellationCache::ShadowDescription::ShadowDescription(const SkPath* nodeKey, const Matrix4* drawTransform)
-        : nodeKey(nodeKey) {
+TessellationCache::ShadowDescription::ShadowDescription(const SkPath* nodeKey,
+        const Matrix4* drawTransform, const Vector3& lightCenter)
+        : nodeKey(nodeKey)
+        , lightCenter(lightCenter) {
     memcpy(&matrixData, drawTransform->data, sizeof(matrixData));
 }
 
 bool TessellationCache::ShadowDescription::operator==(
         const TessellationCache::ShadowDescription& rhs) const {
     return nodeKey == rhs.nodeKey
-            && memcmp(&matrixData, &rhs.matrixData, sizeof(matrixData)) == 0;
+            && memcmp(&matrixData, &rhs.matrixData, sizeof(matrixData)) == 0
+            && memcmp(&lightCenter, &rhs.lightCenter, sizeof(lightCenter)) == 0;
 }
 
 hash_t TessellationCache::ShadowDescription::hash() const {
     uint32_t hash = JenkinsHashMixBytes(0, (uint8_t*) &nodeKey, sizeof(const void*));
     hash = JenkinsHashMixBytes(hash, (uint8_t*) &matrixData, sizeof(matrixData));
+    hash = JenkinsHashMixBytes(hash, (uint8_t*) &lightCenter, sizeof(lightCenter));
     return JenkinsHashWhiten(hash);
 }
 
@@ -351,13 +389,15 @@ void TessellationCache::BufferRemovedListener::operator()(Description& descripti
 // Shadows
 ///////////////////////////////////////////////////////////////////////////////
 
-void TessellationCache::precacheShadows(const Matrix4* drawTransform, const Rect& localClip,
+TessellationCache::ShadowTask* TessellationCache::precacheShadows(
+        const Matrix4* drawTransform, const Rect& localClip,
         bool opaque, const SkPath* casterPerimeter,
         const Matrix4* transformXY, const Matrix4* transformZ,
         const Vector3& lightCenter, float lightRadius) {
-    ShadowDescription key(casterPerimeter, drawTransform);
+    ShadowDescription key(casterPerimeter, drawTransform, lightCenter);
 
-    if (mShadowCache.get(key)) return;
+    ShadowTask* existing = static_cast<ShadowTask*>(mShadowCache.get(key));
+    if (existing) return existing;
     sp<ShadowTask> task = new ShadowTask(drawTransform, localClip, opaque,
             casterPerimeter, transformXY, transformZ, lightCenter, lightRadius);
     if (mShadowProcessor == nullptr) {
@@ -366,6 +406,7 @@ void TessellationCache::precacheShadows(const Matrix4* drawTransform, const Rect
     mShadowProcessor->add(task);
     task->incStrong(nullptr); // not using sp<>s, so manually ref while in the cache
     mShadowCache.put(key, task.get());
+    return task.get();
 }
 
 sp<TessellationCache::ShadowTask> TessellationCache::getShadowTask(
@@ -373,25 +414,49 @@ sp<TessellationCache::ShadowTask> TessellationCache::getShadowTask(
         bool opaque, const SkPath* casterPerimeter,
         const Matrix4* transformXY, const Matrix4* transformZ,
         const Vector3& lightCenter, float lightRadius) {
-    ShadowDescription key(casterPerimeter, drawTransform);
+    ShadowDescription key(casterPerimeter, drawTransform, lightCenter);
     ShadowTask* task = static_cast<ShadowTask*>(mShadowCache.get(key));
     if (!task) {
-        precacheShadows(drawTransform, localClip, opaque, casterPerimeter,
+        task = precacheShadows(drawTransform, localClip, opaque, casterPerimeter,
                 transformXY, transformZ, lightCenter, lightRadius);
-        task = static_cast<ShadowTask*>(mShadowCache.get(key));
+    } else if (task->prefetched) {
+        mShadowPrefetchHitCount++;
     }
     LOG_ALWAYS_FATAL_IF(task == nullptr, "shadow not precached");
     return task;
 }
 
+void TessellationCache::prefetchShadows(const Matrix4& drawTransform, bool opaque,
+        const SkPath* casterPerimeter, const Matrix4& transformXY,
+        const Matrix4& transformZ, const Vector3& lightCenter, float lightRadius) {
+    const Rect unclipped(-FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX);
+    ShadowTask* task = precacheShadows(&drawTransform, unclipped, opaque, casterPerimeter,
+            &transformXY, &transformZ, lightCenter, lightRadius);
+    task->prefetched = true;
+    mShadowPrefetchCount++;
+}
+
+TessellationCache::vertexBuffer_pair_t TessellationCache::getShadowBuffers(
+        const sp<ShadowTask>& task) {
+    mShadowDrawCount++;
+    if (CC_UNLIKELY(!task->isFinished())) {
+        ATRACE_NAME("waitForShadowTessellation");
+        mShadowWaitCount++;
+    }
+    return task->getResult();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Tessellation precaching
 ///////////////////////////////////////////////////////////////////////////////
 
 TessellationCache::Buffer* TessellationCache::getOrCreateBuffer(
-        const Description& entry, Tessellator tessellator) {
+        const Description& entry, Tessellator tessellator, bool precache) {
     Buffer* buffer = mCache.get(entry);
-    if (!buffer) {
+    if (buffer) {
+        (precache ? mPrecacheHitCount : mHitCount)++;
+    } else {
+        (precache ? mPrecacheMissCount : mMissCount)++;
         // not cached, enqueue a task to fill the buffer
         sp<TessellationTask> task = new TessellationTask(tessellator, entry);
         buffer = new Buffer(task);
@@ -439,17 +504,89 @@ static VertexBuffer* tessellateRoundRect(const TessellationCache::Description& d
 
 TessellationCache::Buffer* TessellationCache::getRoundRectBuffer(
         const Matrix4& transform, const SkPaint& paint,
-        float width, float height, float rx, float ry) {
+        float width, float height, float rx, float ry, bool precache) {
     Description entry(Description::Type::RoundRect, transform, paint);
     entry.shape.roundRect.width = width;
     entry.shape.roundRect.height = height;
     entry.shape.roundRect.rx = rx;
     entry.shape.roundRect.ry = ry;
-    return getOrCreateBuffer(entry, &tessellateRoundRect);
+    return getOrCreateBuffer(entry, &tessellateRoundRect, precache);
 }
 const VertexBuffer* TessellationCache::getRoundRect(const Matrix4& transform, const SkPaint& paint,
         float width, float height, float rx, float ry) {
-    return getRoundRectBuffer(transform, paint, width, height, rx, ry)->getVertexBuffer();
+    return getRoundRectBuffer(transform, paint, width, height, rx, ry, false)->getVertexBuffer();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Oval
+///////////////////////////////////////////////////////////////////////////////
+
+static VertexBuffer* tessellateOval(const TessellationCache::Description& description) {
+    SkRect rect = SkRect::MakeWH(description.shape.oval.width, description.shape.oval.height);
+    if (description.style == SkPaint::kStrokeAndFill_Style) {
+        float outset = description.strokeWidth / 2;
+        rect.outset(outset, outset);
+    }
+    SkPath path;
+    path.addOval(rect);
+    return tessellatePath(description, path);
+}
+
+TessellationCache::Buffer* TessellationCache::getOvalBuffer(
+        const Matrix4& transform, const SkPaint& paint,
+        float width, float height, bool precache) {
+    Description entry(Description::Type::Oval, transform, paint);
+    entry.bucketScales();
+    entry.shape.oval.width = width;
+    entry.shape.oval.height = height;
+    return getOrCreateBuffer(entry, &tessellateOval, precache);
+}
+
+const VertexBuffer* TessellationCache::getOval(const Matrix4& transform, const SkPaint& paint,
+        float width, float height) {
+    return getOvalBuffer(transform, paint, width, height, false)->getVertexBuffer();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Arc
+///////////////////////////////////////////////////////////////////////////////
+
+static VertexBuffer* tessellateArc(const TessellationCache::Description& description) {
+    const TessellationCache::Description::Shape::Arc& arc = description.shape.arc;
+    SkRect rect = SkRect::MakeWH(arc.width, arc.height);
+    if (description.style == SkPaint::kStrokeAndFill_Style) {
+        float outset = description.strokeWidth / 2;
+        rect.outset(outset, outset);
+    }
+    SkPath path;
+    if (arc.useCenter) {
+        path.moveTo(rect.centerX(), rect.centerY());
+    }
+    path.arcTo(rect, arc.startAngle, arc.sweepAngle, !arc.useCenter);
+    if (arc.useCenter) {
+        path.close();
+    }
+    return tessellatePath(description, path);
+}
+
+TessellationCache::Buffer* TessellationCache::getArcBuffer(
+        const Matrix4& transform, const SkPaint& paint,
+        float width, float height, float startAngle, float sweepAngle, bool useCenter,
+        bool precache) {
+    Description entry(Description::Type::Arc, transform, paint);
+    entry.bucketScales();
+    entry.shape.arc.width = width;
+    entry.shape.arc.height = height;
+    entry.shape.arc.startAngle = startAngle;
+    entry.shape.arc.sweepAngle = sweepAngle;
+    entry.shape.arc.useCenter = useCenter;
+    return getOrCreateBuffer(entry, &tessellateArc, precache);
+}
+
+const VertexBuffer* TessellationCache::getArc(const Matrix4& transform, const SkPaint& paint,
+        float width, float height, float startAngle, float sweepAngle, bool useCenter) {
+    return getArcBuffer(transform, paint, width, height, startAngle, sweepAngle, useCenter,
+            false)->getVertexBuffer();
 }
 
 }; // namespace uirenderer
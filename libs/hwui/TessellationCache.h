@@ -29,7 +29,6 @@
 #include <SkPath.h>
 
 #include <utils/LruCache.h>
-#include <utils/Mutex.h>
 #include <utils/StrongPointer.h>
 
 class SkBitmap;
@@ -55,6 +54,8 @@ public:
         enum class Type {
             None,
             RoundRect,
+            Oval,
+            Arc,
         };
 
         Type type;
@@ -71,20 +72,46 @@ public:
                 float rx;
                 float ry;
             } roundRect;
+            struct Oval {
+                float width;
+                float height;
+            } oval;
+            struct Arc {
+                float width;
+                float height;
+                float startAngle;
+                float sweepAngle;
+                bool useCenter;
+            } arc;
         } shape;
 
         Description();
         Description(Type type, const Matrix4& transform, const SkPaint& paint);
         void setupMatrixAndPaint(Matrix4* matrix, SkPaint* paint) const;
+        /**
+         * Replaces the scales by their bucket, for shapes whose geometry tolerates it.
+         */
+        void bucketScales();
     };
 
+    /**
+     * Rounds a tessellation scale up to the nearest scale bucket, so that slowly animating
+     * transforms can share tessellated geometry. Rounding up guarantees the tessellation is
+     * never coarser than what the actual scale requires, but only suits non-AA fills.
+     */
+    static float bucketScale(float scale);
+
     struct ShadowDescription {
         HASHABLE_TYPE(ShadowDescription);
         const SkPath* nodeKey;
         float matrixData[16];
+        // Prefetched shadows are computed before the draw knows which render target they end
+        // up in, so the light is part of the key to keep them from matching a different one
+        Vector3 lightCenter;
 
         ShadowDescription();
-        ShadowDescription(const SkPath* nodeKey, const Matrix4* drawTransform);
+        ShadowDescription(const SkPath* nodeKey, const Matrix4* drawTransform,
+                const Vector3& lightCenter);
     };
 
     class ShadowTask : public Task<vertexBuffer_pair_t> {
@@ -119,6 +146,8 @@ public:
         const float lightRadius;
         VertexBuffer ambientBuffer;
         VertexBuffer spotBuffer;
+        // Set if the task was started by prefetchShadows()
+        bool prefetched = false;
     };
 
     TessellationCache();
@@ -136,6 +165,27 @@ public:
      * Returns the current size of the cache in bytes.
      */
     uint32_t getSize();
+    /**
+     * Returns the number of draw time lookups that found an existing buffer in the cache, and
+     * the number that had to enqueue a new tessellation because the shape wasn't precached.
+     */
+    uint32_t getHitCount() const { return mHitCount; }
+    uint32_t getMissCount() const { return mMissCount; }
+    /**
+     * Returns the same counts for the precache lookups made while deferring a frame. A hit there
+     * reuses a tessellation from an earlier frame.
+     */
+    uint32_t getPrecacheHitCount() const { return mPrecacheHitCount; }
+    uint32_t getPrecacheMissCount() const { return mPrecacheMissCount; }
+    /**
+     * Returns the number of shadows prefetched while preparing the tree, the number of shadows
+     * drawn, how many of those were prefetched, and how many the draw had to wait for because
+     * tessellation wasn't finished.
+     */
+    uint32_t getShadowPrefetchCount() const { return mShadowPrefetchCount; }
+    uint32_t getShadowDrawCount() const { return mShadowDrawCount; }
+    uint32_t getShadowPrefetchHitCount() const { return mShadowPrefetchHitCount; }
+    uint32_t getShadowWaitCount() const { return mShadowWaitCount; }
 
     /**
      * Trims the contents of the cache, removing items until it's under its
@@ -151,20 +201,54 @@ public:
      */
     void trim();
 
-    // TODO: precache/get for Oval, Lines, Points, etc.
+    // TODO: precache/get for Lines, Points, etc.
 
     void precacheRoundRect(const Matrix4& transform, const SkPaint& paint,
             float width, float height, float rx, float ry) {
-        getRoundRectBuffer(transform, paint, width, height, rx, ry);
+        getRoundRectBuffer(transform, paint, width, height, rx, ry, true);
     }
     const VertexBuffer* getRoundRect(const Matrix4& transform, const SkPaint& paint,
             float width, float height, float rx, float ry);
 
+    void precacheOval(const Matrix4& transform, const SkPaint& paint,
+            float width, float height) {
+        getOvalBuffer(transform, paint, width, height, true);
+    }
+    const VertexBuffer* getOval(const Matrix4& transform, const SkPaint& paint,
+            float width, float height);
+
+    void precacheArc(const Matrix4& transform, const SkPaint& paint,
+            float width, float height, float startAngle, float sweepAngle, bool useCenter) {
+        getArcBuffer(transform, paint, width, height, startAngle, sweepAngle, useCenter, true);
+    }
+    const VertexBuffer* getArc(const Matrix4& transform, const SkPaint& paint,
+            float width, float height, float startAngle, float sweepAngle, bool useCenter);
+
     sp<ShadowTask> getShadowTask(const Matrix4* drawTransform, const Rect& localClip,
             bool opaque, const SkPath* casterPerimeter,
             const Matrix4* transformXY, const Matrix4* transformZ,
             const Vector3& lightCenter, float lightRadius);
 
+    /**
+     * Starts tessellating a shadow before the draw asks for it, from RenderNode::prepareTree.
+     * The local clip isn't known yet, so the shadow is computed unclipped, which is a superset
+     * of what any later getShadowTask() call with the same key would produce.
+     */
+    void prefetchShadows(const Matrix4& drawTransform, bool opaque,
+            const SkPath* casterPerimeter, const Matrix4& transformXY,
+            const Matrix4& transformZ, const Vector3& lightCenter, float lightRadius);
+
+    /**
+     * Returns the tessellated shadow of the task, blocking until it is finished.
+     */
+    vertexBuffer_pair_t getShadowBuffers(const sp<ShadowTask>& task);
+
+    /**
+     * Drops the shadow tasks of the current frame. Shadows are only cached for one frame, so
+     * anything prefetched by a prepare that wasn't followed by a draw is stale.
+     */
+    void clearShadows() { mShadowCache.clear(); }
+
 private:
     class Buffer;
     class TessellationTask;
@@ -172,7 +256,7 @@ private:
 
     typedef VertexBuffer* (*Tessellator)(const Description&);
 
-    void precacheShadows(const Matrix4* drawTransform, const Rect& localClip,
+    ShadowTask* precacheShadows(const Matrix4* drawTransform, const Rect& localClip,
                 bool opaque, const SkPath* casterPerimeter,
                 const Matrix4* transformXY, const Matrix4* transformZ,
                 const Vector3& lightCenter, float lightRadius);
@@ -180,15 +264,28 @@ private:
     Buffer* getRectBuffer(const Matrix4& transform, const SkPaint& paint,
             float width, float height);
     Buffer* getRoundRectBuffer(const Matrix4& transform, const SkPaint& paint,
-            float width, float height, float rx, float ry);
+            float width, float height, float rx, float ry, bool precache);
+    Buffer* getOvalBuffer(const Matrix4& transform, const SkPaint& paint,
+            float width, float height, bool precache);
+    Buffer* getArcBuffer(const Matrix4& transform, const SkPaint& paint,
+            float width, float height, float startAngle, float sweepAngle, bool useCenter,
+            bool precache);
 
-    Buffer* getOrCreateBuffer(const Description& entry, Tessellator tessellator);
+    Buffer* getOrCreateBuffer(const Description& entry, Tessellator tessellator, bool precache);
 
     const uint32_t mMaxSize;
 
     bool mDebugEnabled;
 
-    mutable Mutex mLock;
+    uint32_t mHitCount = 0;
+    uint32_t mMissCount = 0;
+    uint32_t mPrecacheHitCount = 0;
+    uint32_t mPrecacheMissCount = 0;
+
+    uint32_t mShadowPrefetchCount = 0;
+    uint32_t mShadowDrawCount = 0;
+    uint32_t mShadowPrefetchHitCount = 0;
+    uint32_t mShadowWaitCount = 0;
 
     ///////////////////////////////////////////////////////////////////////////////
     // General tessellation caching
@@ -33,6 +33,7 @@ class DamageAccumulator;
 class LayerUpdateQueue;
 class RenderNode;
 class RenderState;
+class Vector3;
 
 class ErrorHandler {
 public:
@@ -93,6 +94,11 @@ public:
 
     bool updateWindowPositions = false;
 
+    // Light to tessellate shadows with while preparing, so that the draw doesn't have to wait
+    // for them. Null if shadows aren't prefetched.
+    const Vector3* lightCenter = nullptr;
+    float lightRadius = 0;
+
     struct Out {
         bool hasFunctors = false;
         // This is only updated if evaluateAnimations is true
@@ -108,6 +114,10 @@ public:
         // *OR* will post itself for the next vsync automatically, use this
         // only to avoid calling draw()
         bool canDrawThisFrame = true;
+        // Number of RenderNodes prepared, and the number left out because nothing in
+        // their subtree needed it, see RenderNode::canSkipPrepare()
+        uint32_t nodesPrepared = 0;
+        uint32_t nodesSkipped = 0;
     } out;
 
     // This flag helps to disable projection for receiver nodes that do not have any backward
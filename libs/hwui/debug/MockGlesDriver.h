@@ -29,6 +29,15 @@ public:
     MOCK_METHOD2(glBindBuffer_, void(GLenum target, GLuint buffer));
     MOCK_METHOD4(glBufferData_, void(GLenum target, GLsizeiptr size, const void *data, GLenum usage));
     MOCK_METHOD2(glGenBuffers_, void(GLsizei n, GLuint *buffers));
+    MOCK_METHOD3(glBindAttribLocation_, void(GLuint program, GLuint index, const GLchar *name));
+    MOCK_METHOD0(glCreateProgram_, GLuint());
+    MOCK_METHOD1(glDeleteProgram_, void(GLuint program));
+    MOCK_METHOD3(glGetProgramiv_, void(GLuint program, GLenum pname, GLint *params));
+    MOCK_METHOD2(glGetUniformLocation_, GLint(GLuint program, const GLchar *name));
+    MOCK_METHOD5(glGetProgramBinary_, void(GLuint program, GLsizei bufSize, GLsizei *length,
+            GLenum *binaryFormat, void *binary));
+    MOCK_METHOD4(glProgramBinary_, void(GLuint program, GLenum binaryFormat, const void *binary,
+            GLsizei length));
 };
 
 } // namespace debug
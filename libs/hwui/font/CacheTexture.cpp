@@ -16,6 +16,8 @@
 
 #include <SkGlyph.h>
 
+#include <algorithm>
+
 #include "CacheTexture.h"
 #include "FontUtil.h"
 #include "../Caches.h"
@@ -26,85 +28,6 @@
 namespace android {
 namespace uirenderer {
 
-///////////////////////////////////////////////////////////////////////////////
-// CacheBlock
-///////////////////////////////////////////////////////////////////////////////
-
-/**
- * Insert new block into existing linked list of blocks. Blocks are sorted in increasing-width
- * order, except for the final block (the remainder space at the right, since we fill from the
- * left).
- */
-CacheBlock* CacheBlock::insertBlock(CacheBlock* head, CacheBlock* newBlock) {
-#if DEBUG_FONT_RENDERER
-    ALOGD("insertBlock: this, x, y, w, h = %p, %d, %d, %d, %d",
-            newBlock, newBlock->mX, newBlock->mY,
-            newBlock->mWidth, newBlock->mHeight);
-#endif
-
-    CacheBlock* currBlock = head;
-    CacheBlock* prevBlock = nullptr;
-
-    while (currBlock && currBlock->mY != TEXTURE_BORDER_SIZE) {
-        if (newBlock->mWidth < currBlock->mWidth) {
-            newBlock->mNext = currBlock;
-            newBlock->mPrev = prevBlock;
-            currBlock->mPrev = newBlock;
-
-            if (prevBlock) {
-                prevBlock->mNext = newBlock;
-                return head;
-            } else {
-                return newBlock;
-            }
-        }
-
-        prevBlock = currBlock;
-        currBlock = currBlock->mNext;
-    }
-
-    // new block larger than all others - insert at end (but before the remainder space, if there)
-    newBlock->mNext = currBlock;
-    newBlock->mPrev = prevBlock;
-
-    if (currBlock) {
-        currBlock->mPrev = newBlock;
-    }
-
-    if (prevBlock) {
-        prevBlock->mNext = newBlock;
-        return head;
-    } else {
-        return newBlock;
-    }
-}
-
-CacheBlock* CacheBlock::removeBlock(CacheBlock* head, CacheBlock* blockToRemove) {
-#if DEBUG_FONT_RENDERER
-    ALOGD("removeBlock: this, x, y, w, h = %p, %d, %d, %d, %d",
-            blockToRemove, blockToRemove->mX, blockToRemove->mY,
-            blockToRemove->mWidth, blockToRemove->mHeight);
-#endif
-
-    CacheBlock* newHead = head;
-    CacheBlock* nextBlock = blockToRemove->mNext;
-    CacheBlock* prevBlock = blockToRemove->mPrev;
-
-    if (prevBlock) {
-        prevBlock->mNext = nextBlock;
-    } else {
-        newHead = nextBlock;
-    }
-
-    if (nextBlock) {
-        nextBlock->mPrev = prevBlock;
-    }
-
-    delete blockToRemove;
-
-    return newHead;
-}
-
 ///////////////////////////////////////////////////////////////////////////////
 // CacheTexture
 ///////////////////////////////////////////////////////////////////////////////
@@ -118,8 +41,7 @@ CacheTexture::CacheTexture(uint16_t width, uint16_t height, GLenum format, uint3
         , mCaches(Caches::getInstance()) {
     mTexture.blend = true;
 
-    mCacheBlocks = new CacheBlock(TEXTURE_BORDER_SIZE, TEXTURE_BORDER_SIZE,
-            getWidth() - TEXTURE_BORDER_SIZE, getHeight() - TEXTURE_BORDER_SIZE);
+    init();
 
     // OpenGL ES 3.0+ lets us specify the row length for unpack operations such
     // as glTexSubImage2D(). This allows us to upload a sub-rectangle of a texture.
@@ -134,21 +56,18 @@ CacheTexture::~CacheTexture() {
 }
 
 void CacheTexture::reset() {
-    // Delete existing cache blocks
-    while (mCacheBlocks != nullptr) {
-        CacheBlock* tmpBlock = mCacheBlocks;
-        mCacheBlocks = mCacheBlocks->mNext;
-        delete tmpBlock;
-    }
+    mSkyline.clear();
+    mUsedArea = 0;
+    mWastedArea = 0;
     mNumGlyphs = 0;
     mCurrentQuad = 0;
 }
 
 void CacheTexture::init() {
-    // reset, then create a new remainder space to start again
+    // reset, then create a flat skyline spanning the texture to start again
     reset();
-    mCacheBlocks = new CacheBlock(TEXTURE_BORDER_SIZE, TEXTURE_BORDER_SIZE,
-            getWidth() - TEXTURE_BORDER_SIZE, getHeight() - TEXTURE_BORDER_SIZE);
+    mSkyline.push_back({TEXTURE_BORDER_SIZE, TEXTURE_BORDER_SIZE,
+            (uint16_t) (getWidth() - TEXTURE_BORDER_SIZE)});
 }
 
 void CacheTexture::releaseMesh() {
@@ -190,27 +109,53 @@ void CacheTexture::allocatePixelBuffer() {
     mTexture.setWrap(GL_CLAMP_TO_EDGE);
 }
 
-bool CacheTexture::upload() {
-    const Rect& dirtyRect = mDirtyRect;
+// Upper bound on the number of separate uploads issued per texture per frame
+static const size_t kMaxDirtyRects = 8;
+
+static uint32_t area(const Rect& rect) {
+    return rect.getWidth() * rect.getHeight();
+}
 
-    // align the x direction to 32 and y direction to 4 for better performance
-    uint32_t x = (((uint32_t)dirtyRect.left) & (~0x1F));
-    uint32_t y = (((uint32_t)dirtyRect.top) & (~0x3));
-    uint32_t r = ((((uint32_t)dirtyRect.right) + 0x1F) & (~0x1F)) - x;
-    uint32_t b = ((((uint32_t)dirtyRect.bottom) + 0x3) & (~0x3)) - y;
-    uint32_t width = (r > getWidth() ? getWidth() : r);
-    uint32_t height = (b > getHeight() ? getHeight() : b);
+bool CacheTexture::upload(uint32_t* bytesUploaded) {
+    const uint32_t bpp = PixelBuffer::formatSize(mFormat);
 
     // The unpack row length only needs to be specified when a new
     // texture is bound
     if (mHasUnpackRowLength) {
         glPixelStorei(GL_UNPACK_ROW_LENGTH, getWidth());
     } else {
-        x = 0;
-        width = getWidth();
+        // Without it only entire stripes can be uploaded, so merge regions that
+        // share rows to avoid uploading the same stripe twice
+        for (Rect& rect : mDirtyRects) {
+            rect.left = 0;
+            rect.right = getWidth();
+        }
+        std::sort(mDirtyRects.begin(), mDirtyRects.end(),
+                [](const Rect& a, const Rect& b) { return a.top < b.top; });
+        size_t last = 0;
+        for (size_t i = 1; i < mDirtyRects.size(); i++) {
+            if (mDirtyRects[i].top <= mDirtyRects[last].bottom) {
+                mDirtyRects[last].bottom = std::max(mDirtyRects[last].bottom,
+                        mDirtyRects[i].bottom);
+            } else {
+                mDirtyRects[++last] = mDirtyRects[i];
+            }
+        }
+        mDirtyRects.resize(std::min(mDirtyRects.size(), last + 1));
     }
 
-    mPixelBuffer->upload(x, y, width, height);
+    for (const Rect& dirtyRect : mDirtyRects) {
+        // align the x direction to 32 and y direction to 4 for better performance
+        uint32_t x = (((uint32_t)dirtyRect.left) & (~0x1F));
+        uint32_t y = (((uint32_t)dirtyRect.top) & (~0x3));
+        uint32_t r = ((((uint32_t)dirtyRect.right) + 0x1F) & (~0x1F)) - x;
+        uint32_t b = ((((uint32_t)dirtyRect.bottom) + 0x3) & (~0x3)) - y;
+        uint32_t width = (x + r > getWidth() ? getWidth() - x : r);
+        uint32_t height = (y + b > getHeight() ? getHeight() - y : b);
+
+        mPixelBuffer->upload(x, y, width, height);
+        *bytesUploaded += width * height * bpp;
+    }
     setDirty(false);
 
     return mHasUnpackRowLength;
@@ -219,10 +164,44 @@ bool CacheTexture::upload() {
 void CacheTexture::setDirty(bool dirty) {
     mDirty = dirty;
     if (!dirty) {
-        mDirtyRect.setEmpty();
+        mDirtyRects.clear();
     }
 }
 
+void CacheTexture::addDirtyRect(const Rect& rect) {
+    mDirty = true;
+
+    // Coalesce with an existing region when the union costs no more than uploading both
+    // separately; glyphs packed next to each other collapse into a single region this way
+    for (Rect& dirtyRect : mDirtyRects) {
+        Rect merged(dirtyRect);
+        merged.unionWith(rect);
+        if (area(merged) <= area(dirtyRect) + area(rect)) {
+            dirtyRect = merged;
+            return;
+        }
+    }
+
+    if (mDirtyRects.size() < kMaxDirtyRects) {
+        mDirtyRects.push_back(rect);
+        return;
+    }
+
+    // Out of regions, grow whichever one gets the least bigger
+    Rect* best = nullptr;
+    uint32_t bestGrowth = UINT32_MAX;
+    for (Rect& dirtyRect : mDirtyRects) {
+        Rect merged(dirtyRect);
+        merged.unionWith(rect);
+        uint32_t growth = area(merged) - area(dirtyRect);
+        if (growth < bestGrowth) {
+            best = &dirtyRect;
+            bestGrowth = growth;
+        }
+    }
+    best->unionWith(rect);
+}
+
 bool CacheTexture::fitBitmap(const SkGlyph& glyph, uint32_t* retOriginX, uint32_t* retOriginY) {
     switch (glyph.fMaskFormat) {
         case SkMask::kA8_Format:
@@ -257,92 +236,102 @@ bool CacheTexture::fitBitmap(const SkGlyph& glyph, uint32_t* retOriginX, uint32_
     uint16_t glyphW = glyph.fWidth + TEXTURE_BORDER_SIZE;
     uint16_t glyphH = glyph.fHeight + TEXTURE_BORDER_SIZE;
 
-    // roundedUpW equals glyphW to the next multiple of CACHE_BLOCK_ROUNDING_SIZE.
-    // This columns for glyphs that are close but not necessarily exactly the same size. It trades
-    // off the loss of a few pixels for some glyphs against the ability to store more glyphs
-    // of varying sizes in one block.
-    uint16_t roundedUpW = (glyphW + CACHE_BLOCK_ROUNDING_SIZE - 1) & -CACHE_BLOCK_ROUNDING_SIZE;
-
-    CacheBlock* cacheBlock = mCacheBlocks;
-    while (cacheBlock) {
-        // Store glyph in this block iff: it fits the block's remaining space and:
-        // it's the remainder space (mY == 0) or there's only enough height for this one glyph
-        // or it's within ROUNDING_SIZE of the block width
-        if (roundedUpW <= cacheBlock->mWidth && glyphH <= cacheBlock->mHeight &&
-                (cacheBlock->mY == TEXTURE_BORDER_SIZE ||
-                        (cacheBlock->mWidth - roundedUpW < CACHE_BLOCK_ROUNDING_SIZE))) {
-            if (cacheBlock->mHeight - glyphH < glyphH) {
-                // Only enough space for this glyph - don't bother rounding up the width
-                roundedUpW = glyphW;
-            }
+    // Bottom-left skyline packing: place the glyph where its bottom edge ends up lowest,
+    // breaking ties by preferring the left-most position
+    int bestIndex = -1;
+    int bestY = 0;
+    for (size_t i = 0; i < mSkyline.size(); i++) {
+        int y = skylineFitY(i, glyphW, glyphH);
+        if (y >= 0 && (bestIndex < 0 || y < bestY)) {
+            bestIndex = i;
+            bestY = y;
+        }
+    }
 
-            *retOriginX = cacheBlock->mX;
-            *retOriginY = cacheBlock->mY;
-
-            // If this is the remainder space, create a new cache block for this column. Otherwise,
-            // adjust the info about this column.
-            if (cacheBlock->mY == TEXTURE_BORDER_SIZE) {
-                uint16_t oldX = cacheBlock->mX;
-                // Adjust remainder space dimensions
-                cacheBlock->mWidth -= roundedUpW;
-                cacheBlock->mX += roundedUpW;
-
-                if (getHeight() - glyphH >= glyphH) {
-                    // There's enough height left over to create a new CacheBlock
-                    CacheBlock* newBlock = new CacheBlock(oldX, glyphH + TEXTURE_BORDER_SIZE,
-                            roundedUpW, getHeight() - glyphH - TEXTURE_BORDER_SIZE);
+    if (bestIndex < 0) {
 #if DEBUG_FONT_RENDERER
-                    ALOGD("fitBitmap: Created new block: this, x, y, w, h = %p, %d, %d, %d, %d",
-                            newBlock, newBlock->mX, newBlock->mY,
-                            newBlock->mWidth, newBlock->mHeight);
+        ALOGD("fitBitmap: returning false for glyph of size %d, %d", glyphW, glyphH);
 #endif
-                    mCacheBlocks = CacheBlock::insertBlock(mCacheBlocks, newBlock);
-                }
-            } else {
-                // Insert into current column and adjust column dimensions
-                cacheBlock->mY += glyphH;
-                cacheBlock->mHeight -= glyphH;
-#if DEBUG_FONT_RENDERER
-                ALOGD("fitBitmap: Added to existing block: this, x, y, w, h = %p, %d, %d, %d, %d",
-                        cacheBlock, cacheBlock->mX, cacheBlock->mY,
-                        cacheBlock->mWidth, cacheBlock->mHeight);
-#endif
-            }
+        return false;
+    }
 
-            if (cacheBlock->mHeight < std::min(glyphH, glyphW)) {
-                // If remaining space in this block is too small to be useful, remove it
-                mCacheBlocks = CacheBlock::removeBlock(mCacheBlocks, cacheBlock);
-            }
+    *retOriginX = mSkyline[bestIndex].x;
+    *retOriginY = bestY;
+    skylineAdd(bestIndex, glyphW, glyphH, bestY);
 
-            mDirty = true;
-            const Rect r(*retOriginX - TEXTURE_BORDER_SIZE, *retOriginY - TEXTURE_BORDER_SIZE,
-                    *retOriginX + glyphW, *retOriginY + glyphH);
-            mDirtyRect.unionWith(r);
-            mNumGlyphs++;
+    addDirtyRect(Rect(*retOriginX - TEXTURE_BORDER_SIZE, *retOriginY - TEXTURE_BORDER_SIZE,
+            *retOriginX + glyphW, *retOriginY + glyphH));
+    mNumGlyphs++;
 
 #if DEBUG_FONT_RENDERER
-            ALOGD("fitBitmap: current block list:");
-            mCacheBlocks->output();
+    ALOGD("fitBitmap: placed glyph of size %d, %d at %d, %d (%zu skyline segments)",
+            glyphW, glyphH, *retOriginX, *retOriginY, mSkyline.size());
 #endif
+    return true;
+}
+
+int CacheTexture::skylineFitY(size_t index, uint16_t w, uint16_t h) const {
+    const uint32_t x = mSkyline[index].x;
+    if (x + w > getWidth()) return -1;
+
+    int y = 0;
+    int remaining = w;
+    for (size_t i = index; remaining > 0; i++) {
+        // segments span the texture width, so the bounds check above keeps i in range
+        y = std::max(y, (int) mSkyline[i].y);
+        if (y + h > (int) getHeight()) return -1;
+        remaining -= mSkyline[i].width;
+    }
+    return y;
+}
+
+void CacheTexture::skylineAdd(size_t index, uint16_t w, uint16_t h, uint16_t y) {
+    const uint16_t x = mSkyline[index].x;
+    const uint16_t right = x + w;
 
-            return true;
+    // Texels between the old skyline and the bottom of the new glyph can never be reached
+    // again by a bottom-left packer, so account for them as wasted
+    for (size_t i = index; i < mSkyline.size() && mSkyline[i].x < right; i++) {
+        uint16_t segmentRight = std::min((uint16_t) (mSkyline[i].x + mSkyline[i].width), right);
+        mWastedArea += (y - mSkyline[i].y) * (segmentRight - mSkyline[i].x);
+    }
+    mUsedArea += w * h;
+
+    mSkyline.insert(mSkyline.begin() + index, {x, (uint16_t) (y + h), w});
+
+    // Trim or remove the segments now shadowed by the new one
+    size_t i = index + 1;
+    while (i < mSkyline.size() && mSkyline[i].x < right) {
+        SkylineSegment& segment = mSkyline[i];
+        uint16_t segmentRight = segment.x + segment.width;
+        if (segmentRight <= right) {
+            mSkyline.erase(mSkyline.begin() + i);
+        } else {
+            segment.width = segmentRight - right;
+            segment.x = right;
+            break;
+        }
+    }
+
+    // Merge neighbors at the same height to keep the skyline (and fit queries) short
+    size_t j = index > 0 ? index - 1 : 0;
+    while (j <= index && j + 1 < mSkyline.size()) {
+        if (mSkyline[j].y == mSkyline[j + 1].y) {
+            mSkyline[j].width += mSkyline[j + 1].width;
+            mSkyline.erase(mSkyline.begin() + j + 1);
+            if (j < index) index--;
+        } else {
+            j++;
         }
-        cacheBlock = cacheBlock->mNext;
     }
-#if DEBUG_FONT_RENDERER
-    ALOGD("fitBitmap: returning false for glyph of size %d, %d", glyphW, glyphH);
-#endif
-    return false;
 }
 
 uint32_t CacheTexture::calculateFreeMemory() const {
-    CacheBlock* cacheBlock = mCacheBlocks;
     uint32_t free = 0;
     // currently only two formats are supported: GL_ALPHA or GL_RGBA;
     uint32_t bpp = mFormat == GL_RGBA ? 4 : 1;
-    while (cacheBlock) {
-        free += bpp * cacheBlock->mWidth * cacheBlock->mHeight;
-        cacheBlock = cacheBlock->mNext;
+    for (const SkylineSegment& segment : mSkyline) {
+        free += bpp * segment.width * (getHeight() - segment.y);
     }
     return free;
 }
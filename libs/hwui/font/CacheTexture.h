@@ -26,6 +26,7 @@
 #include <SkGlyph.h>
 #include <utils/Log.h>
 
+#include <vector>
 
 namespace android {
 namespace uirenderer {
@@ -33,44 +34,11 @@ namespace uirenderer {
 class Caches;
 
 /**
- * CacheBlock is a node in a linked list of current free space areas in a CacheTexture.
- * Using CacheBlocks enables us to pack the cache from top to bottom as well as left to right.
- * When we add a glyph to the cache, we see if it fits within one of the existing columns that
- * have already been started (this is the case if the glyph fits vertically as well as
- * horizontally, and if its width is sufficiently close to the column width to avoid
- * sub-optimal packing of small glyphs into wide columns). If there is no column in which the
- * glyph fits, we check the final node, which is the remaining space in the cache, creating
- * a new column as appropriate.
- *
- * As columns fill up, we remove their CacheBlock from the list to avoid having to check
- * small blocks in the future.
+ * A glyph atlas. Glyphs are packed with a bottom-left skyline allocator: the texture keeps the
+ * outline of its allocated space as a list of horizontal segments, and each new glyph is placed
+ * where its bottom edge is lowest. Unlike fixed-width columns, this packs glyphs of mixed sizes
+ * tightly, so the atlas has to be flushed less often.
  */
-struct CacheBlock {
-    uint16_t mX;
-    uint16_t mY;
-    uint16_t mWidth;
-    uint16_t mHeight;
-    CacheBlock* mNext;
-    CacheBlock* mPrev;
-
-    CacheBlock(uint16_t x, uint16_t y, uint16_t width, uint16_t height):
-            mX(x), mY(y), mWidth(width), mHeight(height), mNext(nullptr), mPrev(nullptr) {
-    }
-
-    static CacheBlock* insertBlock(CacheBlock* head, CacheBlock* newBlock);
-    static CacheBlock* removeBlock(CacheBlock* head, CacheBlock* blockToRemove);
-
-    void output() {
-        CacheBlock* currBlock = this;
-        while (currBlock) {
-            ALOGD("Block: this, x, y, w, h = %p, %d, %d, %d, %d",
-                    currBlock, currBlock->mX, currBlock->mY,
-                    currBlock->mWidth, currBlock->mHeight);
-            currBlock = currBlock->mNext;
-        }
-    }
-};
-
 class CacheTexture {
 public:
     CacheTexture(uint16_t width, uint16_t height, GLenum format, uint32_t maxQuadCount);
@@ -85,9 +53,10 @@ public:
     void allocatePixelBuffer();
     void allocateMesh();
 
+    // Uploads each dirty region and adds the number of bytes transferred to bytesUploaded
     // Returns true if glPixelStorei(GL_UNPACK_ROW_LENGTH) must be reset
     // This method will also call setDirty(false)
-    bool upload();
+    bool upload(uint32_t* bytesUploaded);
 
     bool fitBitmap(const SkGlyph& glyph, uint32_t* retOriginX, uint32_t* retOriginY);
 
@@ -107,8 +76,8 @@ public:
         return (y * getWidth() + x) * PixelBuffer::formatSize(mFormat);
     }
 
-    inline const Rect* getDirtyRect() const {
-        return &mDirtyRect;
+    inline const std::vector<Rect>& getDirtyRects() const {
+        return mDirtyRects;
     }
 
     inline PixelBuffer* getPixelBuffer() const {
@@ -180,8 +149,39 @@ public:
 
     uint32_t calculateFreeMemory() const;
 
+    /**
+     * Returns the number of texels covered by glyphs (including their borders).
+     */
+    uint32_t getUsedArea() const {
+        return mUsedArea;
+    }
+
+    /**
+     * Returns the number of texels trapped below the skyline that can no longer be
+     * allocated until the texture is reset.
+     */
+    uint32_t getWastedArea() const {
+        return mWastedArea;
+    }
+
 private:
+    /**
+     * A horizontal run of the skyline: every texel in [x, x + width) at or below y is allocated.
+     * Segments are kept sorted by x, are contiguous, and together span the usable texture width.
+     */
+    struct SkylineSegment {
+        uint16_t x;
+        uint16_t y;
+        uint16_t width;
+    };
+
     void setDirty(bool dirty);
+    void addDirtyRect(const Rect& rect);
+
+    // Returns the y at which a w x h rect would be placed starting at segment index,
+    // or -1 if it does not fit there
+    int skylineFitY(size_t index, uint16_t w, uint16_t h) const;
+    void skylineAdd(size_t index, uint16_t w, uint16_t h, uint16_t y);
 
     PixelBuffer* mPixelBuffer = nullptr;
     Texture mTexture;
@@ -194,9 +194,13 @@ private:
     uint32_t mCurrentQuad = 0;
     uint32_t mMaxQuadCount;
     Caches& mCaches;
-    CacheBlock* mCacheBlocks;
+    std::vector<SkylineSegment> mSkyline;
+    uint32_t mUsedArea = 0;
+    uint32_t mWastedArea = 0;
     bool mHasUnpackRowLength;
-    Rect mDirtyRect;
+    // Disjoint-ish regions written since the last upload. Kept short by coalescing, so that
+    // glyphs added at opposite ends of the atlas don't force uploading everything in between
+    std::vector<Rect> mDirtyRects;
 };
 
 }; // namespace uirenderer
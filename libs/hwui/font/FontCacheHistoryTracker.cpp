@@ -48,6 +48,15 @@ void FontCacheHistoryTracker::dumpUploadEntry(String8& log, const CachedGlyph& g
     }
 }
 
+void FontCacheHistoryTracker::dumpClearEntry(String8& log, const ClearEntry& entry) {
+    float fragmentation = entry.usedArea + entry.wastedArea
+            ? entry.wastedArea / (float) (entry.usedArea + entry.wastedArea) : 0.0f;
+    log.appendFormat("      cachetexture %p in gen %d: %d glyphs, used %d / %d texels, "
+            "wasted %d (%.1f%% fragmentation)\n", entry.texture, entry.generation,
+            entry.glyphCount, entry.usedArea, entry.totalArea, entry.wastedArea,
+            fragmentation * 100.0f);
+}
+
 void FontCacheHistoryTracker::dump(String8& log) const {
     log.appendFormat("FontCacheHistory: \n");
     log.appendFormat("  Upload history: \n");
@@ -58,6 +67,10 @@ void FontCacheHistoryTracker::dump(String8& log) const {
     for (size_t i = 0; i < mRenderHistory.size(); i++) {
         dumpRenderEntry(log, mRenderHistory[i]);
     }
+    log.appendFormat("  Clear history: \n");
+    for (size_t i = 0; i < mClearHistory.size(); i++) {
+        dumpClearEntry(log, mClearHistory[i]);
+    }
 }
 
 void FontCacheHistoryTracker::glyphRendered(CachedGlyphInfo* glyphInfo, int penX, int penY) {
@@ -91,6 +104,14 @@ void FontCacheHistoryTracker::glyphsCleared(CacheTexture* texture) {
     glyph.startY = 0;
     glyph.bitmapW = 0;
     glyph.bitmapH = 0;
+
+    ClearEntry& entry = mClearHistory.next();
+    entry.texture = texture;
+    entry.generation = generation;
+    entry.glyphCount = texture->getGlyphCount();
+    entry.usedArea = texture->getUsedArea();
+    entry.wastedArea = texture->getWastedArea();
+    entry.totalArea = texture->getWidth() * texture->getHeight();
 }
 
 void FontCacheHistoryTracker::frameCompleted() {
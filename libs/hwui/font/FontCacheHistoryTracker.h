@@ -31,6 +31,7 @@ class FontCacheHistoryTracker {
 public:
     void glyphRendered(CachedGlyphInfo*, int penX, int penY);
     void glyphUploaded(CacheTexture*, uint32_t x, uint32_t y, uint16_t glyphW, uint16_t glyphH);
+    // Should be called before the texture is reset, so its packing efficiency can be recorded
     void glyphsCleared(CacheTexture*);
     void frameCompleted();
 
@@ -55,8 +56,21 @@ private:
     static void dumpRenderEntry(String8& log, const RenderEntry& entry);
     static void dumpUploadEntry(String8& log, const CachedGlyph& glyph);
 
+    // Packing state of a cache texture at the moment it was cleared
+    struct ClearEntry {
+        void* texture;
+        uint16_t generation;
+        uint16_t glyphCount;
+        uint32_t usedArea;
+        uint32_t wastedArea;
+        uint32_t totalArea;
+    };
+
+    static void dumpClearEntry(String8& log, const ClearEntry& entry);
+
     RingBuffer<RenderEntry, 300> mRenderHistory;
     RingBuffer<CachedGlyph, 120> mUploadHistory;
+    RingBuffer<ClearEntry, 30> mClearHistory;
     uint16_t generation = 0;
 };
 
@@ -109,8 +109,7 @@ void SkiaDisplayList::reset() {
     mChildNodes.clear();
 
     projectionReceiveIndex = -1;
-    allocator.~LinearAllocator();
-    new (&allocator) LinearAllocator();
+    allocator.reset();
 }
 
 void SkiaDisplayList::output(std::ostream& output, uint32_t level) {
@@ -27,6 +27,9 @@
 
 #include <GLES2/gl2.h>
 
+#include <algorithm>
+#include <inttypes.h>
+
 namespace android {
 namespace uirenderer {
 
@@ -115,6 +118,13 @@ OffscreenBuffer::~OffscreenBuffer() {
 // OffscreenBufferPool
 ///////////////////////////////////////////////////////////////////////////////
 
+// Layers that change size by more than this between frames aren't animating smoothly, so
+// their next size isn't worth predicting
+static const uint32_t MAX_PREDICTED_GROWTH = 4 * LAYER_SIZE;
+static const size_t MAX_PREWARMS_PER_FRAME = 2;
+// Forget about the last misses after this many frames without any
+static const int MISS_HISTORY_FRAMES = 8;
+
 OffscreenBufferPool::OffscreenBufferPool()
     : mMaxSize(Properties::layerPoolSize) {
 }
@@ -123,38 +133,91 @@ OffscreenBufferPool::~OffscreenBufferPool() {
     clear(); // TODO: unique_ptr?
 }
 
-int OffscreenBufferPool::Entry::compare(const Entry& lhs, const Entry& rhs) {
-    int deltaInt = int(lhs.width) - int(rhs.width);
-    if (deltaInt != 0) return deltaInt;
+int OffscreenBufferPool::sizeClass(uint32_t idealWidth, uint32_t idealHeight) {
+    uint32_t tiles = (idealWidth / LAYER_SIZE) * (idealHeight / LAYER_SIZE);
+    if (!tiles) return 0;
+    int sizeClass = 31 - __builtin_clz(tiles);
+    return std::min(sizeClass, kSizeClassCount - 1);
+}
 
-    return int(lhs.height) - int(rhs.height);
+bool OffscreenBufferPool::isAcceptable(uint32_t textureWidth, uint32_t textureHeight,
+        uint32_t idealWidth, uint32_t idealHeight) {
+    return textureWidth >= idealWidth && textureHeight >= idealHeight
+            && uint64_t(textureWidth) * textureHeight <= 2 * uint64_t(idealWidth) * idealHeight;
 }
 
 void OffscreenBufferPool::clear() {
-    for (auto& entry : mPool) {
-        delete entry.layer;
+    for (auto& bucket : mBuckets) {
+        for (auto& entry : bucket) {
+            delete entry.layer;
+        }
+        bucket.clear();
     }
-    mPool.clear();
+    mCount = 0;
     mSize = 0;
+    // The pool is cleared to free memory, don't allocate guesses right back
+    mPendingPrewarms.clear();
+}
+
+bool OffscreenBufferPool::hasAcceptable(uint32_t idealWidth, uint32_t idealHeight) const {
+    const int firstClass = sizeClass(idealWidth, idealHeight);
+    const int lastClass = std::min(firstClass + 1, kSizeClassCount - 1);
+    for (int i = firstClass; i <= lastClass; i++) {
+        for (auto& entry : mBuckets[i]) {
+            if (isAcceptable(entry.width, entry.height, idealWidth, idealHeight)) {
+                return true;
+            }
+        }
+    }
+    return false;
 }
 
 OffscreenBuffer* OffscreenBufferPool::get(RenderState& renderState,
         const uint32_t width, const uint32_t height) {
-    OffscreenBuffer* layer = nullptr;
-
-    Entry entry(width, height);
-    auto iter = mPool.find(entry);
+    const uint32_t idealWidth = OffscreenBuffer::computeIdealDimension(width);
+    const uint32_t idealHeight = OffscreenBuffer::computeIdealDimension(height);
+
+    // Acceptable buffers are at most twice the ideal area, so they can only be in the ideal
+    // size class or the one above it
+    const int firstClass = sizeClass(idealWidth, idealHeight);
+    const int lastClass = std::min(firstClass + 1, kSizeClassCount - 1);
+    std::vector<Entry>* bestBucket = nullptr;
+    size_t bestIndex = 0;
+    uint64_t bestArea = 0;
+    for (int i = firstClass; i <= lastClass; i++) {
+        std::vector<Entry>& bucket = mBuckets[i];
+        for (size_t j = 0; j < bucket.size(); j++) {
+            const Entry& entry = bucket[j];
+            uint64_t area = uint64_t(entry.width) * entry.height;
+            if (isAcceptable(entry.width, entry.height, idealWidth, idealHeight)
+                    && (!bestBucket || area < bestArea)) {
+                bestBucket = &bucket;
+                bestIndex = j;
+                bestArea = area;
+            }
+        }
+    }
 
-    if (iter != mPool.end()) {
-        entry = *iter;
-        mPool.erase(iter);
+    OffscreenBuffer* layer = nullptr;
+    if (bestBucket) {
+        Entry entry = (*bestBucket)[bestIndex];
+        (*bestBucket)[bestIndex] = bestBucket->back();
+        bestBucket->pop_back();
+        mCount--;
 
         layer = entry.layer;
         layer->viewportWidth = width;
         layer->viewportHeight = height;
         mSize -= layer->getSizeInBytes();
+        mStats.hits++;
+        if (entry.prewarmed) {
+            mStats.prewarmHits++;
+        }
     } else {
         layer = new OffscreenBuffer(renderState, Caches::getInstance(), width, height);
+        mStats.misses++;
+        mStats.bytesAllocated += layer->getSizeInBytes();
+        mFrameMisses.push_back({idealWidth, idealHeight});
     }
 
     return layer;
@@ -163,8 +226,9 @@ OffscreenBuffer* OffscreenBufferPool::get(RenderState& renderState,
 OffscreenBuffer* OffscreenBufferPool::resize(OffscreenBuffer* layer,
         const uint32_t width, const uint32_t height) {
     RenderState& renderState = layer->renderState;
-    if (layer->texture.width() == OffscreenBuffer::computeIdealDimension(width)
-            && layer->texture.height() == OffscreenBuffer::computeIdealDimension(height)) {
+    if (isAcceptable(layer->texture.width(), layer->texture.height(),
+            OffscreenBuffer::computeIdealDimension(width),
+            OffscreenBuffer::computeIdealDimension(height))) {
         // resize in place
         layer->viewportWidth = width;
         layer->viewportHeight = height;
@@ -177,31 +241,114 @@ OffscreenBuffer* OffscreenBufferPool::resize(OffscreenBuffer* layer,
     return get(renderState, width, height);
 }
 
+void OffscreenBufferPool::onFrameCompleted() {
+    if (mFrameMisses.empty()) {
+        if (++mFramesSinceMiss > MISS_HISTORY_FRAMES) {
+            mLastMisses.clear();
+        }
+        return;
+    }
+
+    // Replaces guesses from an earlier frame that weren't allocated yet
+    mPendingPrewarms.clear();
+    for (const Size& miss : mFrameMisses) {
+        // Pair the miss with the closest smaller one from the last frame that missed, and
+        // assume the layer keeps growing at the same rate
+        const Size* previous = nullptr;
+        uint32_t previousDistance = 0;
+        for (const Size& candidate : mLastMisses) {
+            if (candidate.width > miss.width || candidate.height > miss.height) continue;
+            uint32_t distance = (miss.width - candidate.width) + (miss.height - candidate.height);
+            if (distance && (!previous || distance < previousDistance)) {
+                previous = &candidate;
+                previousDistance = distance;
+            }
+        }
+        if (!previous) continue;
+
+        const uint32_t growthWidth = miss.width - previous->width;
+        const uint32_t growthHeight = miss.height - previous->height;
+        if (growthWidth > MAX_PREDICTED_GROWTH || growthHeight > MAX_PREDICTED_GROWTH) continue;
+
+        const uint32_t width = miss.width + growthWidth;
+        const uint32_t height = miss.height + growthHeight;
+        if (hasAcceptable(width, height)) continue;
+        mPendingPrewarms.push_back({width, height});
+        if (mPendingPrewarms.size() == MAX_PREWARMS_PER_FRAME) break;
+    }
+
+    mLastMisses.swap(mFrameMisses);
+    mFrameMisses.clear();
+    mFramesSinceMiss = 0;
+}
+
+void OffscreenBufferPool::prewarm(RenderState& renderState) {
+    for (const Size& size : mPendingPrewarms) {
+        // A layer may have been put back with that size since the guess was made
+        if (hasAcceptable(size.width, size.height)) continue;
+        // Never evict to make room for a guess
+        if (mSize + size.width * size.height * 4 > mMaxSize) break;
+
+        ATRACE_FORMAT("Prewarm %ux%u HW Layer", size.width, size.height);
+        OffscreenBuffer* layer = new OffscreenBuffer(renderState, Caches::getInstance(),
+                size.width, size.height);
+        mStats.prewarmed++;
+        mStats.bytesAllocated += layer->getSizeInBytes();
+        put(layer, true);
+    }
+    mPendingPrewarms.clear();
+}
+
 void OffscreenBufferPool::dump() {
-    for (auto entry : mPool) {
-        ALOGD("  Layer size %dx%d", entry.width, entry.height);
+    for (auto& bucket : mBuckets) {
+        for (auto& entry : bucket) {
+            ALOGD("  Layer size %dx%d", entry.width, entry.height);
+        }
     }
+    ALOGD("  Pool hits %u, misses %u, prewarmed %u (%u used), evictions %u, "
+            "%" PRIu64 " bytes allocated", mStats.hits, mStats.misses, mStats.prewarmed,
+            mStats.prewarmHits, mStats.evictions, mStats.bytesAllocated);
 }
 
-void OffscreenBufferPool::putOrDelete(OffscreenBuffer* layer) {
-    const uint32_t size = layer->getSizeInBytes();
-    // Don't even try to cache a layer that's bigger than the cache
-    if (size < mMaxSize) {
-        // TODO: Use an LRU
-        while (mSize + size > mMaxSize) {
-            OffscreenBuffer* victim = mPool.begin()->layer;
-            mSize -= victim->getSizeInBytes();
-            delete victim;
-            mPool.erase(mPool.begin());
+void OffscreenBufferPool::evictOldest() {
+    std::vector<Entry>* oldestBucket = nullptr;
+    size_t oldestIndex = 0;
+    for (auto& bucket : mBuckets) {
+        for (size_t i = 0; i < bucket.size(); i++) {
+            if (!oldestBucket || bucket[i].stamp < (*oldestBucket)[oldestIndex].stamp) {
+                oldestBucket = &bucket;
+                oldestIndex = i;
+            }
         }
+    }
+    OffscreenBuffer* victim = (*oldestBucket)[oldestIndex].layer;
+    (*oldestBucket)[oldestIndex] = oldestBucket->back();
+    oldestBucket->pop_back();
+    mCount--;
+    mSize -= victim->getSizeInBytes();
+    mStats.evictions++;
+    delete victim;
+}
 
-        // clear region, since it's no longer valid
-        layer->region.clear();
+void OffscreenBufferPool::put(OffscreenBuffer* layer, bool prewarmed) {
+    const uint32_t size = layer->getSizeInBytes();
+    while (mSize + size > mMaxSize) {
+        evictOldest();
+    }
+
+    // clear region, since it's no longer valid
+    layer->region.clear();
 
-        Entry entry(layer);
+    Entry entry(layer, mNextStamp++, prewarmed);
+    mBuckets[sizeClass(entry.width, entry.height)].push_back(entry);
+    mCount++;
+    mSize += size;
+}
 
-        mPool.insert(entry);
-        mSize += size;
+void OffscreenBufferPool::putOrDelete(OffscreenBuffer* layer) {
+    // Don't even try to cache a layer that's bigger than the cache
+    if (layer->getSizeInBytes() < mMaxSize) {
+        put(layer, false);
     } else {
         delete layer;
     }
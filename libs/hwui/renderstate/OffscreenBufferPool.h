@@ -23,7 +23,7 @@
 #include "utils/Macros.h"
 #include <ui/Region.h>
 
-#include <set>
+#include <vector>
 
 namespace android {
 namespace uirenderer {
@@ -83,9 +83,24 @@ public:
 
 /**
  * Pool of OffscreenBuffers allocated, but not currently in use.
+ *
+ * Buffers are bucketed by size class, the log2 of their area in LAYER_SIZE tiles, and get()
+ * returns the smallest pooled buffer that fits as long as it is at most twice the ideal area.
+ * At the end of each frame the pool also allocates ahead for layers that kept growing across
+ * frames, as during size animations, so that the next resize finds a buffer waiting.
  */
 class OffscreenBufferPool {
 public:
+    struct Stats {
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+        uint32_t prewarmed = 0;
+        // Prewarmed buffers that were handed out before being evicted
+        uint32_t prewarmHits = 0;
+        uint32_t evictions = 0;
+        uint64_t bytesAllocated = 0;
+    };
+
     OffscreenBufferPool();
     ~OffscreenBufferPool();
 
@@ -97,6 +112,20 @@ public:
 
     void putOrDelete(OffscreenBuffer* layer);
 
+    /**
+     * Called once the layers of a frame have been drawn. Predicts the sizes that growing layers
+     * are expected to need next frame, without allocating anything.
+     */
+    void onFrameCompleted();
+
+    bool hasPendingPrewarms() const { return !mPendingPrewarms.empty(); }
+
+    /**
+     * Allocates buffers for the sizes predicted by onFrameCompleted(). Creating the textures is
+     * expensive, so this is meant to run once the frame is swapped, when the RenderThread is idle.
+     */
+    void prewarm(RenderState& renderState);
+
     /**
      * Clears the pool. This causes all layers to be deleted.
      */
@@ -112,46 +141,61 @@ public:
      */
     uint32_t getSize() { return mSize; }
 
-    size_t getCount() { return mPool.size(); }
+    size_t getCount() { return mCount; }
+
+    const Stats& getStats() const { return mStats; }
 
     /**
      * Prints out the content of the pool.
      */
     void dump();
 private:
+    static const int kSizeClassCount = 16;
+
     struct Entry {
         Entry() {}
 
-        Entry(const uint32_t layerWidth, const uint32_t layerHeight)
-                : width(OffscreenBuffer::computeIdealDimension(layerWidth))
-                , height(OffscreenBuffer::computeIdealDimension(layerHeight)) {}
-
-        explicit Entry(OffscreenBuffer* layer)
+        Entry(OffscreenBuffer* layer, uint64_t stamp, bool prewarmed)
                 : layer(layer)
                 , width(layer->texture.width())
-                , height(layer->texture.height()) {
-        }
-
-        static int compare(const Entry& lhs, const Entry& rhs);
-
-        bool operator==(const Entry& other) const {
-            return compare(*this, other) == 0;
-        }
-
-        bool operator!=(const Entry& other) const {
-            return compare(*this, other) != 0;
-        }
-
-        bool operator<(const Entry& other) const {
-            return Entry::compare(*this, other) < 0;
+                , height(layer->texture.height())
+                , stamp(stamp)
+                , prewarmed(prewarmed) {
         }
 
         OffscreenBuffer* layer = nullptr;
         uint32_t width = 0;
         uint32_t height = 0;
+        // Order in which entries were put in the pool, oldest ones are evicted first
+        uint64_t stamp = 0;
+        bool prewarmed = false;
     }; // struct Entry
 
-    std::multiset<Entry> mPool;
+    struct Size {
+        uint32_t width;
+        uint32_t height;
+    };
+
+    static int sizeClass(uint32_t idealWidth, uint32_t idealHeight);
+    static bool isAcceptable(uint32_t textureWidth, uint32_t textureHeight,
+            uint32_t idealWidth, uint32_t idealHeight);
+
+    bool hasAcceptable(uint32_t idealWidth, uint32_t idealHeight) const;
+    void put(OffscreenBuffer* layer, bool prewarmed);
+    void evictOldest();
+
+    std::vector<Entry> mBuckets[kSizeClassCount];
+    size_t mCount = 0;
+    uint64_t mNextStamp = 0;
+
+    // Ideal sizes that missed this frame, and in the last frame that had misses
+    std::vector<Size> mFrameMisses;
+    std::vector<Size> mLastMisses;
+    int mFramesSinceMiss = 0;
+    // Sizes predicted by onFrameCompleted() that prewarm() hasn't allocated yet
+    std::vector<Size> mPendingPrewarms;
+
+    Stats mStats;
 
     uint32_t mSize = 0;
     uint32_t mMaxSize;
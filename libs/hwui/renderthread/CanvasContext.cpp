@@ -45,6 +45,7 @@
 #include <sys/stat.h>
 
 #include <cstdlib>
+#include <memory>
 
 #define TRIM_MEMORY_COMPLETE 80
 #define TRIM_MEMORY_UI_HIDDEN 20
@@ -324,6 +325,14 @@ void CanvasContext::prepareTree(TreeInfo& info, int64_t* uiFrameInfo,
 
     info.damageAccumulator = &mDamageAccumulator;
     info.layerUpdateQueue = &mLayerUpdateQueue;
+    if (Properties::getRenderPipelineType() == RenderPipelineType::OpenGL
+            && Caches::hasInstance()) {
+        // Shadows are only cached for the frame they were requested in, and anything
+        // prefetched by a prepare that didn't lead to a draw may no longer match its caster
+        Caches::getInstance().tessellationCache.clearShadows();
+        info.lightCenter = &mLightGeometry.center;
+        info.lightRadius = mLightGeometry.radius;
+    }
 
     mAnimationContext->startFrame(info.mode);
     for (const sp<RenderNode>& node : mRenderNodes) {
@@ -337,6 +346,9 @@ void CanvasContext::prepareTree(TreeInfo& info, int64_t* uiFrameInfo,
     mAnimationContext->runRemainingAnimations(info);
     GL_CHECKPOINT(MODERATE);
 
+    mCurrentFrameInfo->set(FrameInfoIndex::NodesPrepared) = info.out.nodesPrepared;
+    mCurrentFrameInfo->set(FrameInfoIndex::NodesSkipped) = info.out.nodesSkipped;
+
     freePrefetchedLayers();
     GL_CHECKPOINT(MODERATE);
 
@@ -462,6 +474,13 @@ void CanvasContext::draw() {
         mCurrentFrameInfo->set(FrameInfoIndex::QueueBufferDuration) = 0;
     }
 
+    if (Properties::getRenderPipelineType() == RenderPipelineType::OpenGL) {
+        mCurrentFrameInfo->set(FrameInfoIndex::GlyphBytesUploaded) =
+                Caches::getInstance().fontRenderer.takeBytesUploaded();
+    } else {
+        mCurrentFrameInfo->set(FrameInfoIndex::GlyphBytesUploaded) = 0;
+    }
+
     // TODO: Use a fence for real completion?
     mCurrentFrameInfo->markFrameCompleted();
 
@@ -604,8 +623,12 @@ void CanvasContext::dumpFrames(int fd) {
         fprintf(file, "%s", FrameInfoNames[i].c_str());
         fprintf(file, ",");
     }
-    for (size_t i = 0; i < mFrames.size(); i++) {
-        FrameInfo& frame = mFrames[i];
+    // Completed frames, from the history other threads can also read without blocking
+    std::unique_ptr<FrameInfo[]> frames(new FrameInfo[JankTracker::kFrameHistorySize]);
+    size_t frameCount = mJankTracker.copyRecentFrames(frames.get(),
+            JankTracker::kFrameHistorySize);
+    for (size_t i = 0; i < frameCount; i++) {
+        const FrameInfo& frame = frames[i];
         if (frame[FrameInfoIndex::SyncStart] == 0) {
             continue;
         }
@@ -620,6 +643,7 @@ void CanvasContext::dumpFrames(int fd) {
 
 void CanvasContext::resetFrameStats() {
     mFrames.clear();
+    mJankTracker.clearFrameHistory();
     mRenderThread.jankTracker().reset();
 }
 
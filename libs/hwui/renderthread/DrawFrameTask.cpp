@@ -33,6 +33,7 @@ DrawFrameTask::DrawFrameTask()
         : mRenderThread(nullptr)
         , mContext(nullptr)
         , mSyncResult(SyncResult::OK) {
+    mTaskClass = TaskClass::Frame;
 }
 
 DrawFrameTask::~DrawFrameTask() {
@@ -23,14 +23,46 @@
 #include "ProfileRenderer.h"
 #include "renderstate/RenderState.h"
 #include "OpenGLReadback.h"
+#include "RenderTask.h"
 
 #include <cutils/properties.h>
 #include <strings.h>
+#include <utils/Trace.h>
 
 namespace android {
 namespace uirenderer {
 namespace renderthread {
 
+// Whether an IdleWorkTask is queued. It serves every OpenGLPipeline, as they share the caches
+static bool sIdleWorkQueued = false;
+
+/**
+ * Runs the GL work that frames leave for later, such as allocating layers the next frames are
+ * expected to need and warming up programs. It is a background task, so it only takes time no
+ * frame is waiting for.
+ */
+class OpenGLPipeline::IdleWorkTask : public RenderTask {
+public:
+    explicit IdleWorkTask(RenderThread& thread) : mRenderThread(thread) {}
+
+    virtual void run() override {
+        sIdleWorkQueued = false;
+        // The context may have been destroyed while the task waited
+        if (mRenderThread.eglManager().hasEglContext()) {
+            ATRACE_NAME("OpenGLPipeline idle work");
+            RenderState& renderState = mRenderThread.renderState();
+            renderState.layerPool().prewarm(renderState);
+            if (Caches::hasInstance()) {
+                Caches::getInstance().programCache.doIdleWork();
+            }
+        }
+        delete this;
+    }
+
+private:
+    RenderThread& mRenderThread;
+};
+
 OpenGLPipeline::OpenGLPipeline(RenderThread& thread)
         :  mEglManager(thread.eglManager())
         , mRenderThread(thread) {
@@ -87,6 +119,8 @@ bool OpenGLPipeline::draw(const Frame& frame, const SkRect& screenDirty, const S
     caches.clearGarbage();
     caches.pathCache.trim();
     caches.tessellationCache.trim();
+    mRenderThread.renderState().layerPool().onFrameCompleted();
+    caches.programCache.onFrameCompleted();
 
 #if DEBUG_MEMORY_USAGE
     caches.dumpMemoryUsage();
@@ -114,9 +148,20 @@ bool OpenGLPipeline::swapBuffers(const Frame& frame, bool drew, const SkRect& sc
         return false;
     }
 
+    queueIdleWork();
     return *requireSwap;
 }
 
+void OpenGLPipeline::queueIdleWork() {
+    if (sIdleWorkQueued) return;
+    if (!mRenderThread.renderState().layerPool().hasPendingPrewarms()
+            && !Caches::getInstance().programCache.hasIdleWork()) {
+        return;
+    }
+    sIdleWorkQueued = true;
+    mRenderThread.queueBackground(new IdleWorkTask(mRenderThread));
+}
+
 bool OpenGLPipeline::copyLayerInto(DeferredLayerUpdater* layer, SkBitmap* bitmap) {
     ATRACE_CALL();
     // acquire most recent buffer for drawing
@@ -63,6 +63,11 @@ public:
     static void invokeFunctor(const RenderThread& thread, Functor* functor);
 
 private:
+    class IdleWorkTask;
+
+    // Queues the GL work frames leave for later as a background task, unless it is already
+    void queueIdleWork();
+
     EglManager& mEglManager;
     EGLSurface mEglSurface = EGL_NO_SURFACE;
     bool mBufferPreserved = false;
@@ -18,6 +18,7 @@
 
 #include "DeferredLayerUpdater.h"
 #include "DisplayList.h"
+#include "ProgramCache.h"
 #include "Properties.h"
 #include "Readback.h"
 #include "Rect.h"
@@ -27,7 +28,6 @@
 #include "renderthread/RenderThread.h"
 #include "renderstate/RenderState.h"
 #include "utils/Macros.h"
-#include "utils/TimeUtils.h"
 
 #include <ui/GraphicBuffer.h>
 
@@ -79,6 +79,7 @@ RenderProxy::RenderProxy(bool translucent, RenderNode* rootRenderNode, IContextF
 }
 
 RenderProxy::~RenderProxy() {
+    mBatching = false;
     destroyContext();
 }
 
@@ -233,6 +234,7 @@ int64_t* RenderProxy::frameInfo() {
 }
 
 int RenderProxy::syncAndDrawFrame() {
+    flushBatch();
     return mDrawFrameTask.drawFrame();
 }
 
@@ -351,7 +353,7 @@ void RenderProxy::trimMemory(int level) {
         SETUP_TASK(trimMemory);
         args->thread = &thread;
         args->level = level;
-        thread.queue(task);
+        thread.queueBackground(task);
     }
 }
 
@@ -461,6 +463,7 @@ CREATE_BRIDGE2(dumpGraphicsMemory, int fd, RenderThread* thread) {
     args->thread->jankTracker().dump(args->fd);
 
     FILE *file = fdopen(args->fd, "a");
+    args->thread->dumpTaskStats(file);
     if (Caches::hasInstance()) {
         String8 cachesLog;
         Caches::getInstance().dumpMemoryUsage(cachesLog);
@@ -545,6 +548,7 @@ void RenderProxy::drawRenderNode(RenderNode* node) {
     SETUP_TASK(drawRenderNode);
     args->context = mContext;
     args->node = node;
+    flushBatch();
     // Be pseudo-thread-safe and don't use any member variables
     staticPostAndWait(task);
 }
@@ -562,6 +566,7 @@ void RenderProxy::setContentDrawBounds(int left, int top, int right, int bottom)
     args->top = top;
     args->right = right;
     args->bottom = bottom;
+    flushBatch();
     staticPostAndWait(task);
 }
 
@@ -649,19 +654,8 @@ void RenderProxy::prepareToDraw(Bitmap& bitmap) {
     args->thread = renderThread;
     bitmap.ref();
     args->bitmap = &bitmap;
-    nsecs_t lastVsync = renderThread->timeLord().latestVsync();
-    nsecs_t estimatedNextVsync = lastVsync + renderThread->timeLord().frameIntervalNanos();
-    nsecs_t timeToNextVsync = estimatedNextVsync - systemTime(CLOCK_MONOTONIC);
-    // We expect the UI thread to take 4ms and for RT to be active from VSYNC+4ms to
-    // VSYNC+12ms or so, so aim for the gap during which RT is expected to
-    // be idle
-    // TODO: Make this concept a first-class supported thing? RT could use
-    // knowledge of pending draws to better schedule this task
-    if (timeToNextVsync > -6_ms && timeToNextVsync < 1_ms) {
-        renderThread->queueAt(task, estimatedNextVsync + 8_ms);
-    } else {
-        renderThread->queue(task);
-    }
+    // The upload can wait for RT to be idle between frames
+    renderThread->queueBackground(task);
 }
 
 CREATE_BRIDGE2(allocateHardwareBitmap, RenderThread* thread, SkBitmap* bitmap) {
@@ -706,27 +700,75 @@ void RenderProxy::onBitmapDestroyed(uint32_t pixelRefId) {
     RenderThread& thread = RenderThread::getInstance();
     args->thread = &thread;
     args->pixelRefId = pixelRefId;
-    thread.queue(task);
+    thread.queueBackground(task);
 }
 
 void RenderProxy::disableVsync() {
     Properties::disableVsync = true;
 }
 
+void RenderProxy::setProgramCachePath(const char* path) {
+    ProgramCache::setDiskCachePath(path);
+}
+
+void RenderProxy::beginBatch() {
+    mBatching = true;
+}
+
+void RenderProxy::endBatch(bool waitForCompletion) {
+    mBatching = false;
+    if (!mBatch) return;
+    BatchRenderTask* batch = mBatch;
+    mBatch = nullptr;
+    if (waitForCompletion) {
+        waitForTask(batch);
+    } else {
+        post(batch);
+    }
+}
+
+void RenderProxy::flushBatch() {
+    if (mBatch) {
+        BatchRenderTask* batch = mBatch;
+        mBatch = nullptr;
+        mThreadHopCount++;
+        mRenderThread.queue(batch);
+    }
+}
+
 void RenderProxy::post(RenderTask* task) {
+    if (mBatching) {
+        if (!mBatch) mBatch = new BatchRenderTask();
+        mBatch->append(task);
+        return;
+    }
+    mThreadHopCount++;
     mRenderThread.queue(task);
 }
 
 void* RenderProxy::postAndWait(MethodInvokeRenderTask* task) {
     void* retval;
     task->setReturnPtr(&retval);
+    if (mBatch) {
+        // Send everything batched so far along with this task
+        mBatch->append(task);
+        BatchRenderTask* batch = mBatch;
+        mBatch = nullptr;
+        waitForTask(batch);
+    } else {
+        waitForTask(task);
+    }
+    return retval;
+}
+
+void RenderProxy::waitForTask(RenderTask* task) {
     SignalingRenderTask syncTask(task, &mSyncMutex, &mSyncCondition);
     AutoMutex _lock(mSyncMutex);
+    mThreadHopCount++;
     mRenderThread.queue(&syncTask);
     while (!syncTask.hasRun()) {
         mSyncCondition.wait(mSyncMutex);
     }
-    return retval;
 }
 
 void* RenderProxy::staticPostAndWait(MethodInvokeRenderTask* task) {
@@ -139,6 +139,25 @@ public:
     static void onBitmapDestroyed(uint32_t pixelRefId);
 
     ANDROID_API static void disableVsync();
+
+    // Sets the file the OpenGL pipeline persists linked program binaries to
+    ANDROID_API static void setProgramCachePath(const char* path);
+
+    /*
+     * Between beginBatch() and endBatch(), calls that would post() a task are instead
+     * collected and sent to the RenderThread as one task. A call that has to wait for
+     * the RenderThread sends the pending batch along with it, so it still costs a
+     * single round trip. endBatch() posts whatever is left, optionally waiting for it
+     * to run. Calls that bypass post(), such as syncAndDrawFrame(), send the pending
+     * batch first so ordering is preserved. Static entry points aren't tied to a proxy
+     * and aren't batched, so they may run before the pending batch; don't rely on their
+     * order relative to batched calls.
+     */
+    ANDROID_API void beginBatch();
+    ANDROID_API void endBatch(bool waitForCompletion);
+
+    // Number of times this proxy has queued work on the RenderThread
+    uint32_t getThreadHopCount() const { return mThreadHopCount; }
 private:
     RenderThread& mRenderThread;
     CanvasContext* mContext;
@@ -148,10 +167,16 @@ private:
     Mutex mSyncMutex;
     Condition mSyncCondition;
 
+    bool mBatching = false;
+    BatchRenderTask* mBatch = nullptr;
+    uint32_t mThreadHopCount = 0;
+
     void destroyContext();
 
     void post(RenderTask* task);
     void* postAndWait(MethodInvokeRenderTask* task);
+    void waitForTask(RenderTask* task);
+    void flushBatch();
 
     static void* staticPostAndWait(MethodInvokeRenderTask* task);
 
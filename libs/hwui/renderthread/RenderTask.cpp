@@ -31,6 +31,29 @@ void SignalingRenderTask::run() {
     mLock->unlock();
 }
 
+void BatchRenderTask::append(RenderTask* task) {
+    task->mNext = nullptr;
+    if (mTail) {
+        mTail->mNext = task;
+    } else {
+        mHead = task;
+    }
+    mTail = task;
+    mSize++;
+}
+
+void BatchRenderTask::run() {
+    RenderTask* task = mHead;
+    while (task) {
+        // Grab the next pointer first, as the task may suicide in run()
+        RenderTask* next = task->mNext;
+        task->run();
+        task = next;
+    }
+    // Commit suicide
+    delete this;
+}
+
 } /* namespace renderthread */
 } /* namespace uirenderer */
 } /* namespace android */
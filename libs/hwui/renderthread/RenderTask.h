@@ -20,6 +20,8 @@
 #include <cutils/compiler.h>
 #include <utils/Timers.h>
 
+#include <stddef.h>
+
 namespace android {
 class Mutex;
 class Condition;
@@ -45,15 +47,31 @@ namespace renderthread {
  * malloc/free churn of small objects?
  */
 
+/*
+ * How RenderThread schedules a task relative to the frames it draws, see
+ * RenderThread::nextTask()
+ */
+enum class TaskClass {
+    // Draws a frame. Background tasks wait while one of these is queued
+    Frame,
+    // Runs in order as soon as it is due
+    Normal,
+    // Work nothing is waiting on, such as trims and texture uploads. Runs after any
+    // due Frame or Normal task, and is held back while a frame is expected
+    Background,
+};
+
 class ANDROID_API RenderTask {
 public:
-    ANDROID_API RenderTask() : mNext(nullptr), mRunAt(0) {}
+    ANDROID_API RenderTask() : mNext(nullptr), mRunAt(0), mQueuedAt(0) {}
     ANDROID_API virtual ~RenderTask() {}
 
     ANDROID_API virtual void run() = 0;
 
     RenderTask* mNext;
     nsecs_t mRunAt; // nano-seconds on the SYSTEM_TIME_MONOTONIC clock
+    nsecs_t mQueuedAt; // when the task was queued, used for latency accounting
+    TaskClass mTaskClass = TaskClass::Normal;
 };
 
 class SignalingRenderTask : public RenderTask {
@@ -71,6 +89,26 @@ private:
     bool mHasRun;
 };
 
+/*
+ * Runs a sequence of tasks, in the order they were appended, as a single RenderThread
+ * task. The appended tasks are chained through their mNext fields, so a task must not
+ * be appended while it is also queued elsewhere. Allocated with new and suicides at the
+ * end of run(), along with any appended tasks that also do.
+ */
+class BatchRenderTask : public RenderTask {
+public:
+    BatchRenderTask() {}
+    void append(RenderTask* task);
+    bool isEmpty() const { return mHead == nullptr; }
+    size_t size() const { return mSize; }
+    virtual void run() override;
+
+private:
+    RenderTask* mHead = nullptr;
+    RenderTask* mTail = nullptr;
+    size_t mSize = 0;
+};
+
 typedef void* (*RunnableMethod)(void* data);
 
 class MethodInvokeRenderTask : public RenderTask {
@@ -25,6 +25,7 @@
 #include "VulkanManager.h"
 #include "utils/FatVector.h"
 
+#include <algorithm>
 #include <gui/DisplayEventReceiver.h>
 #include <gui/ISurfaceComposer.h>
 #include <gui/SurfaceComposerClient.h>
@@ -45,95 +46,170 @@ static const size_t EVENT_BUFFER_SIZE = 100;
 // Slight delay to give the UI time to push us a new frame before we replay
 static const nsecs_t DISPATCH_FRAME_CALLBACKS_DELAY = milliseconds_to_nanoseconds(4);
 
-TaskQueue::TaskQueue() : mHead(nullptr), mTail(nullptr) {}
+// Background tasks that have waited this long run even if a frame is expected, so a
+// steady stream of frames can't starve them
+static const nsecs_t MAX_BACKGROUND_TASK_DELAY = milliseconds_to_nanoseconds(100);
 
-RenderTask* TaskQueue::next() {
-    RenderTask* ret = mHead;
+TaskQueue::TaskQueue() {}
+
+RenderTask* TaskQueue::pop(TaskList& list, nsecs_t now) {
+    RenderTask* ret = list.head;
     if (ret) {
-        mHead = ret->mNext;
-        if (!mHead) {
-            mTail = nullptr;
+        list.head = ret->mNext;
+        if (!list.head) {
+            list.tail = nullptr;
         }
         ret->mNext = nullptr;
+        if (ret->mTaskClass == TaskClass::Frame) {
+            mPendingFrameCount--;
+        }
+        LatencyStats& stats = mLatencyStats[static_cast<int>(ret->mTaskClass)];
+        nsecs_t latency = std::max(nsecs_t(0), now - std::max(ret->mQueuedAt, ret->mRunAt));
+        stats.count++;
+        stats.total += latency;
+        stats.max = std::max(stats.max, latency);
     }
     return ret;
 }
 
+RenderTask* TaskQueue::next(nsecs_t now) {
+    return pop(mForeground, now);
+}
+
 RenderTask* TaskQueue::peek() {
-    return mHead;
+    return mForeground.head;
+}
+
+RenderTask* TaskQueue::nextBackground(nsecs_t now) {
+    return pop(mBackground, now);
+}
+
+RenderTask* TaskQueue::peekBackground() {
+    return mBackground.head;
+}
+
+RenderTask* TaskQueue::nextDue(nsecs_t now, TimeLord& timeLord, nsecs_t* nextWakeup) {
+    RenderTask* task = peek();
+    *nextWakeup = task ? task->mRunAt : LLONG_MAX;
+    if (task && task->mRunAt <= now) {
+        task = next(now);
+        if (task->mTaskClass == TaskClass::Frame) {
+            timeLord.frameStarted(now);
+        }
+    } else if ((task = peekBackground())) {
+        // Hold background work back while a frame is queued or expected, but not forever
+        nsecs_t idleAt = hasPendingFrame() ? LLONG_MAX : timeLord.nextIdleTime(now);
+        nsecs_t runAt = std::max(task->mRunAt,
+                std::min(idleAt, task->mQueuedAt + MAX_BACKGROUND_TASK_DELAY));
+        if (runAt <= now) {
+            task = nextBackground(now);
+        } else {
+            *nextWakeup = std::min(*nextWakeup, runAt);
+            task = nullptr;
+        }
+    }
+    return task;
 }
 
 void TaskQueue::queue(RenderTask* task) {
     // Since the RenderTask itself forms the linked list it is not allowed
     // to have the same task queued twice
-    LOG_ALWAYS_FATAL_IF(task->mNext || mTail == task, "Task is already in the queue!");
-    if (mTail) {
+    LOG_ALWAYS_FATAL_IF(task->mNext || mForeground.tail == task || mBackground.tail == task,
+            "Task is already in the queue!");
+    if (task->mTaskClass == TaskClass::Frame) {
+        mPendingFrameCount++;
+    }
+    TaskList& list = listFor(task);
+    if (list.tail) {
         // Fast path if we can just append
-        if (mTail->mRunAt <= task->mRunAt) {
-            mTail->mNext = task;
-            mTail = task;
+        if (list.tail->mRunAt <= task->mRunAt) {
+            list.tail->mNext = task;
+            list.tail = task;
         } else {
             // Need to find the proper insertion point
             RenderTask* previous = nullptr;
-            RenderTask* next = mHead;
+            RenderTask* next = list.head;
             while (next && next->mRunAt <= task->mRunAt) {
                 previous = next;
                 next = next->mNext;
             }
             if (!previous) {
-                task->mNext = mHead;
-                mHead = task;
+                task->mNext = list.head;
+                list.head = task;
             } else {
                 previous->mNext = task;
                 if (next) {
                     task->mNext = next;
                 } else {
-                    mTail = task;
+                    list.tail = task;
                 }
             }
         }
     } else {
-        mTail = mHead = task;
+        list.tail = list.head = task;
     }
 }
 
 void TaskQueue::queueAtFront(RenderTask* task) {
-    LOG_ALWAYS_FATAL_IF(task->mNext || mHead == task, "Task is already in the queue!");
-    if (mTail) {
-        task->mNext = mHead;
-        mHead = task;
+    TaskList& list = listFor(task);
+    LOG_ALWAYS_FATAL_IF(task->mNext || list.head == task, "Task is already in the queue!");
+    if (task->mTaskClass == TaskClass::Frame) {
+        mPendingFrameCount++;
+    }
+    if (list.tail) {
+        task->mNext = list.head;
+        list.head = task;
     } else {
-        mTail = mHead = task;
+        list.tail = list.head = task;
     }
 }
 
 void TaskQueue::remove(RenderTask* task) {
+    TaskList& list = listFor(task);
     // TaskQueue is strict here to enforce that users are keeping track of
     // their RenderTasks due to how their memory is managed
-    LOG_ALWAYS_FATAL_IF(!task->mNext && mTail != task,
+    LOG_ALWAYS_FATAL_IF(!task->mNext && list.tail != task,
             "Cannot remove a task that isn't in the queue!");
 
-    // If task is the head we can just call next() to pop it off
-    // Otherwise we need to scan through to find the task before it
-    if (peek() == task) {
-        next();
+    if (list.head == task) {
+        list.head = task->mNext;
+        if (!list.head) {
+            list.tail = nullptr;
+        }
     } else {
-        RenderTask* previous = mHead;
+        // Need to scan through to find the task before it
+        RenderTask* previous = list.head;
         while (previous->mNext != task) {
             previous = previous->mNext;
         }
         previous->mNext = task->mNext;
-        if (mTail == task) {
-            mTail = previous;
+        if (list.tail == task) {
+            list.tail = previous;
         }
     }
+    task->mNext = nullptr;
+    if (task->mTaskClass == TaskClass::Frame) {
+        mPendingFrameCount--;
+    }
+}
+
+void TaskQueue::dumpLatencyStats(FILE* file) const {
+    static const char* kClassNames[] = { "Frame", "Normal", "Background" };
+    for (int i = 0; i <= static_cast<int>(TaskClass::Background); i++) {
+        const LatencyStats& stats = mLatencyStats[i];
+        double avgMs = stats.count ? stats.total / 1000000.0 / stats.count : 0;
+        fprintf(file, "  %s: %u tasks, latency avg %.2fms max %.2fms\n", kClassNames[i],
+                stats.count, avgMs, stats.max / 1000000.0);
+    }
 }
 
 class DispatchFrameCallbacks : public RenderTask {
 private:
     RenderThread* mRenderThread;
 public:
-    explicit DispatchFrameCallbacks(RenderThread* rt) : mRenderThread(rt) {}
+    explicit DispatchFrameCallbacks(RenderThread* rt) : mRenderThread(rt) {
+        mTaskClass = TaskClass::Frame;
+    }
 
     virtual void run() override {
         mRenderThread->dispatchFrameCallbacks();
@@ -358,6 +434,7 @@ bool RenderThread::threadLoop() {
 
 void RenderThread::queue(RenderTask* task) {
     AutoMutex _lock(mLock);
+    task->mQueuedAt = systemTime(SYSTEM_TIME_MONOTONIC);
     mQueue.queue(task);
     if (mNextWakeup && task->mRunAt < mNextWakeup) {
         mNextWakeup = 0;
@@ -382,6 +459,7 @@ void RenderThread::queueAndWait(RenderTask* task) {
 
 void RenderThread::queueAtFront(RenderTask* task) {
     AutoMutex _lock(mLock);
+    task->mQueuedAt = systemTime(SYSTEM_TIME_MONOTONIC);
     mQueue.queueAtFront(task);
     mLooper->wake();
 }
@@ -391,6 +469,11 @@ void RenderThread::queueAt(RenderTask* task, nsecs_t runAtNs) {
     queue(task);
 }
 
+void RenderThread::queueBackground(RenderTask* task) {
+    task->mTaskClass = TaskClass::Background;
+    queue(task);
+}
+
 void RenderThread::remove(RenderTask* task) {
     AutoMutex _lock(mLock);
     mQueue.remove(task);
@@ -415,24 +498,20 @@ void RenderThread::pushBackFrameCallback(IFrameCallback* callback) {
 
 RenderTask* RenderThread::nextTask(nsecs_t* nextWakeup) {
     AutoMutex _lock(mLock);
-    RenderTask* next = mQueue.peek();
-    if (!next) {
-        mNextWakeup = LLONG_MAX;
-    } else {
-        mNextWakeup = next->mRunAt;
-        // Most tasks won't be delayed, so avoid unnecessary systemTime() calls
-        if (next->mRunAt <= 0 || next->mRunAt <= systemTime(SYSTEM_TIME_MONOTONIC)) {
-            next = mQueue.next();
-        } else {
-            next = nullptr;
-        }
-    }
+    nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+    RenderTask* next = mQueue.nextDue(now, mTimeLord, &mNextWakeup);
     if (nextWakeup) {
         *nextWakeup = mNextWakeup;
     }
     return next;
 }
 
+void RenderThread::dumpTaskStats(FILE* file) {
+    AutoMutex _lock(mLock);
+    fprintf(file, "\nRenderThread task latency:\n");
+    mQueue.dumpLatencyStats(file);
+}
+
 } /* namespace renderthread */
 } /* namespace uirenderer */
 } /* namespace android */
@@ -30,6 +30,7 @@
 
 #include <memory>
 #include <set>
+#include <stdio.h>
 
 namespace android {
 
@@ -49,19 +50,58 @@ class EglManager;
 class RenderProxy;
 class VulkanManager;
 
+/*
+ * Frame and Normal tasks share one list ordered by mRunAt, Background tasks are kept in
+ * a second one so they can be held back without blocking anything queued after them.
+ * Tracks how long tasks of each class waited to be dequeued past the time they were due.
+ */
 class TaskQueue {
 public:
+    struct LatencyStats {
+        uint32_t count = 0;
+        nsecs_t total = 0;
+        nsecs_t max = 0;
+    };
+
     TaskQueue();
 
-    RenderTask* next();
+    RenderTask* next(nsecs_t now);
     void queue(RenderTask* task);
     void queueAtFront(RenderTask* task);
     RenderTask* peek();
     void remove(RenderTask* task);
 
+    RenderTask* nextBackground(nsecs_t now);
+    RenderTask* peekBackground();
+
+    // Returns the task to run at now. If there is none, nextWakeup is set to the time
+    // to ask again. Background tasks are held back while a frame is queued or timeLord
+    // expects one to start, but only for so long
+    RenderTask* nextDue(nsecs_t now, TimeLord& timeLord, nsecs_t* nextWakeup);
+
+    // True while a Frame task is queued, even if it is not due yet
+    bool hasPendingFrame() const { return mPendingFrameCount > 0; }
+
+    const LatencyStats& latencyStats(TaskClass taskClass) const {
+        return mLatencyStats[static_cast<int>(taskClass)];
+    }
+    void dumpLatencyStats(FILE* file) const;
+
 private:
-    RenderTask* mHead;
-    RenderTask* mTail;
+    struct TaskList {
+        RenderTask* head = nullptr;
+        RenderTask* tail = nullptr;
+    };
+
+    TaskList& listFor(RenderTask* task) {
+        return task->mTaskClass == TaskClass::Background ? mBackground : mForeground;
+    }
+    RenderTask* pop(TaskList& list, nsecs_t now);
+
+    TaskList mForeground;
+    TaskList mBackground;
+    int mPendingFrameCount = 0;
+    LatencyStats mLatencyStats[static_cast<int>(TaskClass::Background) + 1];
 };
 
 // Mimics android.view.Choreographer.FrameCallback
@@ -82,6 +122,8 @@ public:
     ANDROID_API void queueAndWait(RenderTask* task);
     ANDROID_API void queueAtFront(RenderTask* task);
     void queueAt(RenderTask* task, nsecs_t runAtNs);
+    // Queues a task as TaskClass::Background
+    void queueBackground(RenderTask* task);
     void remove(RenderTask* task);
 
     // Mimics android.view.Choreographer
@@ -97,6 +139,8 @@ public:
     JankTracker& jankTracker() { return *mJankTracker; }
     Readback& readback();
 
+    void dumpTaskStats(FILE* file);
+
     const DisplayInfo& mainDisplayInfo() { return mDisplayInfo; }
 
     GrContext* getGrContext() const { return mGrContext.get(); }
@@ -125,9 +169,9 @@ private:
     void dispatchFrameCallbacks();
     void requestVsync();
 
-    // Returns the next task to be run. If this returns NULL nextWakeup is set
-    // to the time to requery for the nextTask to run. mNextWakeup is also
-    // set to this time
+    // Returns the next task to be run, see TaskQueue::nextDue(). If this returns
+    // NULL nextWakeup is set to the time to requery for the nextTask to run.
+    // mNextWakeup is also set to this time.
     RenderTask* nextTask(nsecs_t* nextWakeup);
 
     sp<Looper> mLooper;
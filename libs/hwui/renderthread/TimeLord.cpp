@@ -21,7 +21,8 @@ namespace renderthread {
 
 TimeLord::TimeLord()
         : mFrameIntervalNanos(milliseconds_to_nanoseconds(16))
-        , mFrameTimeNanos(0) {
+        , mFrameTimeNanos(0)
+        , mLastFrameIntervalStart(0) {
 }
 
 bool TimeLord::vsyncReceived(nsecs_t vsync) {
@@ -43,6 +44,28 @@ nsecs_t TimeLord::computeFrameTimeNanos() {
     return mFrameTimeNanos;
 }
 
+void TimeLord::frameStarted(nsecs_t now) {
+    // Unlike computeFrameTimeNanos() this must not move mFrameTimeNanos, the frame
+    // reports its own vsync once it syncs
+    if (now > mFrameTimeNanos) {
+        mLastFrameIntervalStart = now - (now - mFrameTimeNanos) % mFrameIntervalNanos;
+    } else {
+        mLastFrameIntervalStart = mFrameTimeNanos;
+    }
+}
+
+nsecs_t TimeLord::nextIdleTime(nsecs_t now) const {
+    if (!mLastFrameIntervalStart) return now;
+    nsecs_t expectedFrame = mLastFrameIntervalStart + mFrameIntervalNanos;
+    if (now < expectedFrame) {
+        // This interval's frame already started
+        return now;
+    }
+    nsecs_t expectedFrameDeadline = expectedFrame + mFrameIntervalNanos;
+    // Past the deadline no frame came for a whole interval, so drawing stopped
+    return now < expectedFrameDeadline ? expectedFrameDeadline : now;
+}
+
 } /* namespace renderthread */
 } /* namespace uirenderer */
 } /* namespace android */
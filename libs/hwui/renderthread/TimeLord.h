@@ -22,12 +22,12 @@ namespace android {
 namespace uirenderer {
 namespace renderthread {
 
-class RenderThread;
-
 // This class serves as a helper to filter & manage frame times from multiple sources
 // ensuring that time flows linearly and smoothly
 class TimeLord {
 public:
+    TimeLord();
+
     void setFrameInterval(nsecs_t intervalNanos) { mFrameIntervalNanos = intervalNanos; }
     nsecs_t frameIntervalNanos() const { return mFrameIntervalNanos; }
 
@@ -36,14 +36,19 @@ public:
     nsecs_t latestVsync() { return mFrameTimeNanos; }
     nsecs_t computeFrameTimeNanos();
 
-private:
-    friend class RenderThread;
-
-    TimeLord();
-    ~TimeLord() {}
+    // Called when the RenderThread starts working on a frame
+    void frameStarted(nsecs_t now);
+    // Returns the earliest time, at or after now, at which work that isn't urgent won't
+    // delay a frame. While frames are being drawn one is expected every interval, so
+    // the rest of the interval after a frame is idle, and the interval after that is
+    // reserved for the next frame until it starts or the interval ends without one
+    nsecs_t nextIdleTime(nsecs_t now) const;
 
+private:
     nsecs_t mFrameIntervalNanos;
     nsecs_t mFrameTimeNanos;
+    // Start of the vsync interval in which the last frame started
+    nsecs_t mLastFrameIntervalStart;
 };
 
 } /* namespace renderthread */
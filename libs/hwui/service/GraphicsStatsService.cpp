@@ -41,6 +41,16 @@ constexpr int sHistogramSize =
         std::tuple_size<decltype(ProfileData::frameCounts)>::value +
         std::tuple_size<decltype(ProfileData::slowFrameCounts)>::value;
 
+static const service::GraphicsStatsStageHistogramProto::Stage sStageProtoValues[] = {
+        service::GraphicsStatsStageHistogramProto::SYNC,
+        service::GraphicsStatsStageHistogramProto::DRAW,
+        service::GraphicsStatsStageHistogramProto::SWAP,
+        service::GraphicsStatsStageHistogramProto::COMPLETION,
+};
+
+static_assert(sizeof(sStageProtoValues) / sizeof(sStageProtoValues[0]) == NUM_FRAME_STAGES,
+        "sStageProtoValues doesn't match FrameStage");
+
 static void mergeProfileDataIntoProto(service::GraphicsStatsProto* proto,
         const std::string& package, int versionCode, int64_t startTime, int64_t endTime,
         const ProfileData* data);
@@ -140,6 +150,40 @@ void mergeProfileDataIntoProto(service::GraphicsStatsProto* proto, const std::st
         }
         bucket->set_frame_count(bucket->frame_count() + data->slowFrameCounts[i]);
     }
+
+    bool creatingStageHistograms = false;
+    if (proto->stage_histograms_size() == 0) {
+        creatingStageHistograms = true;
+    } else if (proto->stage_histograms_size() != NUM_FRAME_STAGES) {
+        LOG_ALWAYS_FATAL("Stage histogram count mismatch, proto is %d expected %d",
+                proto->stage_histograms_size(), NUM_FRAME_STAGES);
+    }
+    for (int stage = 0; stage < NUM_FRAME_STAGES; stage++) {
+        service::GraphicsStatsStageHistogramProto* histogram;
+        if (creatingStageHistograms) {
+            histogram = proto->add_stage_histograms();
+            histogram->set_stage(sStageProtoValues[stage]);
+            histogram->mutable_buckets()->Reserve(kStageHistogramSize);
+        } else {
+            histogram = proto->mutable_stage_histograms(stage);
+            LOG_ALWAYS_FATAL_IF(histogram->stage() != sStageProtoValues[stage],
+                    "Stage mismatch %d vs. %d", histogram->stage(), sStageProtoValues[stage]);
+        }
+        const auto& counts = data->stageCounts[stage];
+        for (size_t i = 0; i < counts.size(); i++) {
+            service::GraphicsStatsStageBucketProto* bucket;
+            int32_t latency = JankTracker::stageTimeForIndex(i);
+            if (creatingStageHistograms) {
+                bucket = histogram->add_buckets();
+                bucket->set_latency_micros(latency);
+            } else {
+                bucket = histogram->mutable_buckets(i);
+                LOG_ALWAYS_FATAL_IF(bucket->latency_micros() != latency,
+                        "Stage latency mismatch %d vs. %d", bucket->latency_micros(), latency);
+            }
+            bucket->set_frame_count(bucket->frame_count() + counts[i]);
+        }
+    }
 }
 
 static int32_t findPercentile(service::GraphicsStatsProto* proto, int percentile) {
@@ -180,6 +224,15 @@ void dumpAsTextToFd(service::GraphicsStatsProto* proto, int fd) {
     for (const auto& it : proto->histogram()) {
         dprintf(fd, " %dms=%d", it.render_millis(), it.frame_count());
     }
+    for (const auto& histogram : proto->stage_histograms()) {
+        dprintf(fd, "\n%s STAGE HISTOGRAM:",
+                service::GraphicsStatsStageHistogramProto::Stage_Name(histogram.stage()).c_str());
+        for (const auto& it : histogram.buckets()) {
+            if (it.frame_count()) {
+                dprintf(fd, " %dus=%d", it.latency_micros(), it.frame_count());
+            }
+        }
+    }
     dprintf(fd, "\n");
 }
 
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "DamageAccumulator.h"
+#include "Matrix.h"
+#include "RenderNode.h"
+
+#include <SkRect.h>
+
+#include <vector>
+
+using namespace android;
+using namespace android::uirenderer;
+
+// A chain of nested views, each offset a little from its parent like a typical layout
+static std::vector<sp<RenderNode>> createHierarchy(int depth) {
+    std::vector<sp<RenderNode>> nodes;
+    for (int i = 0; i < depth; i++) {
+        sp<RenderNode> node = new RenderNode();
+        node->animatorProperties().setLeftTopRightBottom(4, 4, 1000 - 4 * i, 1000 - 4 * i);
+        if (i % 8 == 7) {
+            // Throw in the occasional non translating view
+            node->animatorProperties().setScaleX(0.99f);
+        }
+        node->animatorProperties().updateMatrix();
+        nodes.push_back(node);
+    }
+    return nodes;
+}
+
+void BM_DamageAccumulator_deepHierarchy(benchmark::State& state) {
+    std::vector<sp<RenderNode>> nodes = createHierarchy(state.range(0));
+    DamageAccumulator damageAccumulator;
+    SkRect dirty;
+    while (state.KeepRunning()) {
+        for (auto& node : nodes) {
+            damageAccumulator.pushTransform(node.get());
+        }
+        damageAccumulator.dirty(0, 0, 10, 10);
+        for (size_t i = 0; i < nodes.size(); i++) {
+            damageAccumulator.popTransform();
+        }
+        damageAccumulator.finish(&dirty);
+        benchmark::DoNotOptimize(&dirty);
+    }
+}
+BENCHMARK(BM_DamageAccumulator_deepHierarchy)->Arg(8)->Arg(32)->Arg(128);
+
+// Layers at every level of the hierarchy each need the transform to the window
+void BM_DamageAccumulator_computeTransformPerLevel(benchmark::State& state) {
+    std::vector<sp<RenderNode>> nodes = createHierarchy(state.range(0));
+    DamageAccumulator damageAccumulator;
+    Matrix4 transform;
+    SkRect dirty;
+    while (state.KeepRunning()) {
+        for (auto& node : nodes) {
+            damageAccumulator.pushTransform(node.get());
+            damageAccumulator.computeCurrentTransform(&transform);
+            benchmark::DoNotOptimize(&transform);
+        }
+        for (size_t i = 0; i < nodes.size(); i++) {
+            damageAccumulator.popTransform();
+        }
+        damageAccumulator.finish(&dirty);
+    }
+}
+BENCHMARK(BM_DamageAccumulator_computeTransformPerLevel)->Arg(8)->Arg(32)->Arg(128);
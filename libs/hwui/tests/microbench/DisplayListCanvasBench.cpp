@@ -114,6 +114,65 @@ void BM_DisplayListCanvas_record_simpleBitmapView(benchmark::State& benchState)
 }
 BENCHMARK(BM_DisplayListCanvas_record_simpleBitmapView);
 
+/**
+ * Same as above, but hands each DisplayList back to the DisplayListPool the way RenderNode
+ * does once it is done with it, so recording reuses its allocator pages.
+ */
+void BM_DisplayListCanvas_record_simpleBitmapView_recycled(benchmark::State& benchState) {
+    std::unique_ptr<Canvas> canvas(Canvas::create_recording_canvas(100, 100));
+    delete canvas->finishRecording();
+
+    SkPaint rectPaint;
+    sk_sp<Bitmap> iconBitmap(TestUtils::createBitmap(80, 80));
+
+    size_t pageAllocations = LinearAllocator::totalPageAllocations();
+    while (benchState.KeepRunning()) {
+        canvas->resetRecording(100, 100);
+        {
+            canvas->save(SaveFlags::MatrixClip);
+            canvas->drawRect(0, 0, 100, 100, rectPaint);
+            canvas->restore();
+        }
+        {
+            canvas->save(SaveFlags::MatrixClip);
+            canvas->translate(10, 10);
+            canvas->drawBitmap(*iconBitmap, 0, 0, nullptr);
+            canvas->restore();
+        }
+        benchmark::DoNotOptimize(canvas.get());
+        DisplayList* displayList = canvas->finishRecording();
+        if (displayList->isSkiaDL() || !DisplayListPool::getInstance().recycle(displayList)) {
+            delete displayList;
+        }
+    }
+    pageAllocations = LinearAllocator::totalPageAllocations() - pageAllocations;
+    benchState.SetLabel(std::to_string(pageAllocations / (float) benchState.iterations())
+            + " page allocations per recording");
+}
+BENCHMARK(BM_DisplayListCanvas_record_simpleBitmapView_recycled);
+
+/**
+ * Records a large list of rects that each use a different paint, so every paint is copied and
+ * added to the dedup table.
+ */
+void BM_DisplayListCanvas_record_uniquePaints(benchmark::State& benchState) {
+    std::unique_ptr<Canvas> canvas(Canvas::create_recording_canvas(100, 100));
+    delete canvas->finishRecording();
+
+    const int count = benchState.range(0);
+    SkPaint paint;
+    while (benchState.KeepRunning()) {
+        canvas->resetRecording(100, 100);
+        for (int i = 0; i < count; i++) {
+            paint.setColor(0xFF000000 | i);
+            canvas->drawRect(0, 0, 100, 100, paint);
+        }
+        benchmark::DoNotOptimize(canvas.get());
+        delete canvas->finishRecording();
+    }
+}
+BENCHMARK(BM_DisplayListCanvas_record_uniquePaints)->Arg(100)->Arg(1000)->Arg(10000);
+
 class NullClient: public CanvasStateClient {
     void onViewportInitialized() override {}
     void onSnapshotRestored(const Snapshot& removed, const Snapshot& restored) {}
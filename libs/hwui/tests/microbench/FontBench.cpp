@@ -17,10 +17,17 @@
 #include <benchmark/benchmark.h>
 
 #include "GammaFontRenderer.h"
+#include "font/CacheTexture.h"
+#include "font/FontUtil.h"
 #include "tests/common/TestUtils.h"
 
+#include <SkGlyphCache.h>
 #include <SkPaint.h>
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 using namespace android;
 using namespace android::uirenderer;
 
@@ -48,3 +55,143 @@ void BM_FontRenderer_precache_cachehits(benchmark::State& state) {
     });
 }
 BENCHMARK(BM_FontRenderer_precache_cachehits);
+
+// Returns the metrics of the glyphs drawn by the GlyphStressAnimation macrobench scene
+static std::vector<SkGlyph> getGlyphStressGlyphs() {
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    paint.setTextEncoding(SkPaint::kGlyphID_TextEncoding);
+    SkSurfaceProps surfaceProps(0, kUnknown_SkPixelGeometry);
+    const char* text = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+    // Same text sizes as the scene cycles through
+    std::vector<SkGlyph> glyphs;
+    for (int frameNr = 0; frameNr < 20; frameNr++) {
+        for (int i = 0; i < 5; i++) {
+            paint.setTextSize(10 + frameNr + i * 20);
+            SkAutoGlyphCacheNoGamma autoCache(paint, &surfaceProps, &SkMatrix::I());
+            for (const char* c = text; *c; c++) {
+                glyphs.push_back(autoCache.getCache()->getUnicharMetrics(*c));
+            }
+        }
+    }
+    return glyphs;
+}
+
+/**
+ * Packs the glyphs drawn by the GlyphStressAnimation macrobench scene into a single atlas,
+ * resetting it whenever a glyph doesn't fit, as FontRenderer would. The label reports how many
+ * atlas flushes the packer needed, which is what drives re-uploads in real rendering. Compare
+ * with BM_CacheTexture_fitBitmap_glyphStress_columns.
+ */
+void BM_CacheTexture_fitBitmap_glyphStress(benchmark::State& state) {
+    TestUtils::runOnRenderThread([&state](renderthread::RenderThread& thread) {
+        std::vector<SkGlyph> glyphs = getGlyphStressGlyphs();
+        CacheTexture cacheTexture(DEFAULT_TEXT_LARGE_CACHE_WIDTH,
+                DEFAULT_TEXT_LARGE_CACHE_HEIGHT, GL_ALPHA, kMaxNumberOfQuads);
+        int flushes = 0;
+        uint32_t x, y;
+        while (state.KeepRunning()) {
+            for (const SkGlyph& glyph : glyphs) {
+                if (!cacheTexture.fitBitmap(glyph, &x, &y)) {
+                    cacheTexture.init();
+                    flushes++;
+                    cacheTexture.fitBitmap(glyph, &x, &y);
+                }
+            }
+        }
+        state.SetLabel(std::to_string(flushes / std::max(1, (int) state.iterations()))
+                + " flushes per pass");
+    });
+}
+BENCHMARK(BM_CacheTexture_fitBitmap_glyphStress);
+
+/**
+ * The column packing CacheTexture used before the skyline: glyphs go into the first column whose
+ * width is within 4 texels of theirs, and otherwise start a new column at the left of the
+ * remaining space. Kept here as the baseline for the flush count of the skyline packer.
+ */
+class ColumnPacker {
+public:
+    ColumnPacker(uint16_t width, uint16_t height)
+            : mWidth(width)
+            , mHeight(height) {
+        reset();
+    }
+
+    void reset() {
+        mColumns.clear();
+        mRemainder = { (uint16_t) (mWidth - TEXTURE_BORDER_SIZE),
+                (uint16_t) (mHeight - TEXTURE_BORDER_SIZE) };
+    }
+
+    bool fit(const SkGlyph& glyph) {
+        if (glyph.fHeight + TEXTURE_BORDER_SIZE * 2 > mHeight) {
+            return false;
+        }
+        uint16_t glyphW = glyph.fWidth + TEXTURE_BORDER_SIZE;
+        uint16_t glyphH = glyph.fHeight + TEXTURE_BORDER_SIZE;
+        uint16_t roundedUpW = (glyphW + kRoundingSize - 1) & -kRoundingSize;
+
+        // Columns are sorted by increasing width
+        for (auto it = mColumns.begin(); it != mColumns.end(); it++) {
+            if (roundedUpW <= it->width && glyphH <= it->height
+                    && it->width - roundedUpW < kRoundingSize) {
+                it->height -= glyphH;
+                if (it->height < std::min(glyphH, glyphW)) {
+                    mColumns.erase(it);
+                }
+                return true;
+            }
+        }
+
+        if (roundedUpW > mRemainder.width || glyphH > mRemainder.height) {
+            return false;
+        }
+        if (mRemainder.height - glyphH < glyphH) {
+            // Only enough space for this glyph - don't bother rounding up the width
+            roundedUpW = glyphW;
+        }
+        mRemainder.width -= roundedUpW;
+        if (mHeight - glyphH >= glyphH) {
+            Block column = { roundedUpW, (uint16_t) (mHeight - glyphH - TEXTURE_BORDER_SIZE) };
+            auto it = mColumns.begin();
+            while (it != mColumns.end() && it->width <= column.width) it++;
+            mColumns.insert(it, column);
+        }
+        return true;
+    }
+
+private:
+    static const uint16_t kRoundingSize = 4;
+
+    struct Block {
+        uint16_t width;
+        uint16_t height;
+    };
+
+    const uint16_t mWidth;
+    const uint16_t mHeight;
+    std::vector<Block> mColumns;
+    Block mRemainder;
+};
+
+void BM_CacheTexture_fitBitmap_glyphStress_columns(benchmark::State& state) {
+    TestUtils::runOnRenderThread([&state](renderthread::RenderThread& thread) {
+        std::vector<SkGlyph> glyphs = getGlyphStressGlyphs();
+        ColumnPacker packer(DEFAULT_TEXT_LARGE_CACHE_WIDTH, DEFAULT_TEXT_LARGE_CACHE_HEIGHT);
+        int flushes = 0;
+        while (state.KeepRunning()) {
+            for (const SkGlyph& glyph : glyphs) {
+                if (!packer.fit(glyph)) {
+                    packer.reset();
+                    flushes++;
+                    packer.fit(glyph);
+                }
+            }
+        }
+        state.SetLabel(std::to_string(flushes / std::max(1, (int) state.iterations()))
+                + " flushes per pass");
+    });
+}
+BENCHMARK(BM_CacheTexture_fitBitmap_glyphStress_columns);
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "AnimationContext.h"
+#include "IContextFactory.h"
+#include "RenderNode.h"
+#include "renderthread/RenderProxy.h"
+#include "tests/common/TestUtils.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+using namespace android;
+using namespace android::uirenderer;
+using namespace android::uirenderer::renderthread;
+
+class ContextFactory : public IContextFactory {
+public:
+    virtual AnimationContext* createAnimationContext(renderthread::TimeLord& clock) override {
+        return new AnimationContext(clock);
+    }
+};
+
+static long voluntaryContextSwitches() {
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_nvcsw;
+}
+
+// The property updates a view root typically pushes to the RenderThread before a frame
+static void pushFrameState(RenderProxy& proxy, int frame) {
+    proxy.setup(800.0f, 255 * 0.075, 255 * 0.15);
+    proxy.setLightCenter((Vector3){540.0f, -200.0f, 800.0f});
+    proxy.setOpaque(frame & 1);
+}
+
+static void runProxyBench(benchmark::State& state, bool batched) {
+    sp<RenderNode> rootNode = TestUtils::createNode(0, 0, 1080, 1920, nullptr);
+    ContextFactory factory;
+    std::unique_ptr<RenderProxy> proxy(new RenderProxy(false, rootNode.get(), &factory));
+
+    const uint32_t startHops = proxy->getThreadHopCount();
+    const long startSwitches = voluntaryContextSwitches();
+    int frame = 0;
+    while (state.KeepRunning()) {
+        if (batched) {
+            proxy->beginBatch();
+            pushFrameState(*proxy, frame++);
+            proxy->endBatch(true);
+        } else {
+            pushFrameState(*proxy, frame++);
+            proxy->fence();
+        }
+    }
+    const int frames = std::max(1, frame);
+    const uint32_t hops = proxy->getThreadHopCount() - startHops;
+    const long switches = voluntaryContextSwitches() - startSwitches;
+    state.SetLabel(std::to_string(hops / (float) frames) + " hops, "
+            + std::to_string(switches / (float) frames) + " context switches per frame");
+}
+
+void BM_RenderProxy_individualCalls(benchmark::State& state) {
+    runProxyBench(state, false);
+}
+BENCHMARK(BM_RenderProxy_individualCalls);
+
+void BM_RenderProxy_batchedCalls(benchmark::State& state) {
+    runProxyBench(state, true);
+}
+BENCHMARK(BM_RenderProxy_batchedCalls);
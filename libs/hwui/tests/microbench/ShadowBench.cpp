@@ -109,3 +109,21 @@ void BM_TessellateShadows_roundrect_translucent(benchmark::State& state) {
     }
 }
 BENCHMARK(BM_TessellateShadows_roundrect_translucent);
+
+// Large circles are tessellated into many caster vertices, which is where the per vertex
+// passes of the shadow tessellators dominate
+void BM_TessellateShadows_circle_translucent(benchmark::State& state) {
+    ShadowTestData shadowData;
+    createShadowTestData(&shadowData);
+    SkPath path;
+    path.addCircle(400, 400, 400);
+
+    while (state.KeepRunning()) {
+        VertexBuffer ambient;
+        VertexBuffer spot;
+        tessellateShadows(shadowData, false, path, &ambient, &spot);
+        benchmark::DoNotOptimize(&ambient);
+        benchmark::DoNotOptimize(&spot);
+    }
+}
+BENCHMARK(BM_TessellateShadows_circle_translucent);
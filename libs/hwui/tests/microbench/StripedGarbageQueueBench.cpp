@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "utils/StripedGarbageQueue.h"
+
+#include <string>
+#include <vector>
+
+using namespace android;
+using namespace android::uirenderer;
+
+/**
+ * Every thread pushes garbage, as the UI thread and finalizers do, while thread 0 also
+ * drains it every few pushes the way the RenderThread does once per frame. One stripe is
+ * the single mutex the caches used before.
+ */
+template <size_t STRIPES>
+static void runGarbageQueueBench(benchmark::State& state) {
+    typedef StripedGarbageQueue<uint32_t, STRIPES> Queue;
+    static Queue* sQueue = nullptr;
+    if (state.thread_index == 0) {
+        sQueue = new Queue();
+    }
+    std::vector<uint32_t> drained;
+    uint32_t pushes = 0;
+    while (state.KeepRunning()) {
+        sQueue->push(pushes++);
+        if (state.thread_index == 0 && pushes % 16 == 0) {
+            drained.clear();
+            sQueue->drain(&drained);
+            benchmark::DoNotOptimize(drained.data());
+        }
+    }
+    if (state.thread_index == 0) {
+        state.SetLabel(std::to_string(sQueue->contendedCount()) + " of "
+                + std::to_string(sQueue->lockCount()) + " locks contended");
+        delete sQueue;
+        sQueue = nullptr;
+    }
+}
+
+void BM_StripedGarbageQueue_singleLock(benchmark::State& state) {
+    runGarbageQueueBench<1>(state);
+}
+BENCHMARK(BM_StripedGarbageQueue_singleLock)->Threads(1)->Threads(2)->Threads(4);
+
+void BM_StripedGarbageQueue_striped(benchmark::State& state) {
+    runGarbageQueueBench<4>(state);
+}
+BENCHMARK(BM_StripedGarbageQueue_striped)->Threads(1)->Threads(2)->Threads(4);
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "font/CacheTexture.h"
+#include "tests/common/TestUtils.h"
+
+#include <SkGlyphCache.h>
+
+using namespace android;
+using namespace android::uirenderer;
+
+static SkGlyph getGlyphMetrics(float textSize, SkUnichar unichar) {
+    SkPaint paint;
+    paint.setTextSize(textSize);
+    SkSurfaceProps surfaceProps(0, kUnknown_SkPixelGeometry);
+    SkAutoGlyphCacheNoGamma autoCache(paint, &surfaceProps, &SkMatrix::I());
+    return autoCache.getCache()->getUnicharMetrics(unichar);
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(CacheTexture, fitBitmap_coalescesAdjacentGlyphs) {
+    CacheTexture cacheTexture(1024, 512, GL_ALPHA, kMaxNumberOfQuads);
+    SkGlyph glyph = getGlyphMetrics(20, 'a');
+    uint32_t x, y;
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(cacheTexture.fitBitmap(glyph, &x, &y));
+    }
+    EXPECT_EQ(10, cacheTexture.getGlyphCount());
+    EXPECT_TRUE(cacheTexture.isDirty());
+    EXPECT_EQ(1u, cacheTexture.getDirtyRects().size());
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(CacheTexture, upload_onlyDirtyRegions) {
+    CacheTexture cacheTexture(1024, 512, GL_ALPHA, kMaxNumberOfQuads);
+    cacheTexture.getTexture(); // allocates the pixel buffer and texture
+    SkGlyph glyph = getGlyphMetrics(20, 'a');
+    uint32_t x, y;
+    ASSERT_TRUE(cacheTexture.fitBitmap(glyph, &x, &y));
+
+    uint32_t bytesUploaded = 0;
+    cacheTexture.upload(&bytesUploaded);
+    EXPECT_FALSE(cacheTexture.isDirty());
+    EXPECT_TRUE(cacheTexture.getDirtyRects().empty());
+    EXPECT_LT(0u, bytesUploaded);
+    EXPECT_LT(bytesUploaded, cacheTexture.getPixelBuffer()->getSize());
+
+    // nothing new, nothing to upload
+    bytesUploaded = 0;
+    cacheTexture.upload(&bytesUploaded);
+    EXPECT_EQ(0u, bytesUploaded);
+}
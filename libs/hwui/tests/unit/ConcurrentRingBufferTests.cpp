@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "utils/ConcurrentRingBuffer.h"
+
+#include <thread>
+
+using namespace android;
+using namespace android::uirenderer;
+
+TEST(ConcurrentRingBuffer, copyRecent_wraps) {
+    ConcurrentRingBuffer<int, 4> buffer;
+    int out[4];
+    EXPECT_EQ(0u, buffer.copyRecent(out, 4));
+
+    for (int i = 0; i < 6; i++) {
+        buffer.push(i);
+    }
+    EXPECT_EQ(6u, buffer.writeCount());
+    ASSERT_EQ(4u, buffer.copyRecent(out, 4));
+    EXPECT_EQ(2, out[0]);
+    EXPECT_EQ(5, out[3]);
+
+    ASSERT_EQ(2u, buffer.copyRecent(out, 2));
+    EXPECT_EQ(4, out[0]);
+    EXPECT_EQ(5, out[1]);
+}
+
+TEST(ConcurrentRingBuffer, clear) {
+    ConcurrentRingBuffer<int, 4> buffer;
+    int out[4];
+    buffer.push(1);
+    buffer.push(2);
+    buffer.clear();
+    EXPECT_EQ(0u, buffer.copyRecent(out, 4));
+
+    buffer.push(3);
+    ASSERT_EQ(1u, buffer.copyRecent(out, 4));
+    EXPECT_EQ(3, out[0]);
+}
+
+struct Record {
+    int64_t a;
+    int64_t b;
+};
+
+TEST(ConcurrentRingBuffer, concurrentReadsAreConsistent) {
+    ConcurrentRingBuffer<Record, 16> buffer;
+    std::atomic<bool> done{false};
+    std::thread writer([&buffer, &done]() {
+        for (int64_t i = 0; i < 100000; i++) {
+            buffer.push(Record{i, -i});
+        }
+        done = true;
+    });
+
+    Record out[16];
+    while (!done) {
+        size_t count = buffer.copyRecent(out, 16);
+        for (size_t i = 0; i < count; i++) {
+            ASSERT_EQ(out[i].a, -out[i].b) << "torn read";
+            if (i > 0) {
+                ASSERT_LT(out[i - 1].a, out[i].a) << "out of order";
+            }
+        }
+    }
+    writer.join();
+}
+
+TEST(ConcurrentRingBuffer, lappedReadsStayInOrder) {
+    // Small enough that the writer laps readers all the time
+    ConcurrentRingBuffer<uint64_t, 4> buffer;
+    std::atomic<bool> done{false};
+    std::thread writer([&buffer, &done]() {
+        for (uint64_t i = 0; i < 1000000; i++) {
+            buffer.push(i);
+        }
+        done = true;
+    });
+
+    uint64_t out[4];
+    while (!done) {
+        size_t count = buffer.copyRecent(out, 4);
+        for (size_t i = 1; i < count; i++) {
+            ASSERT_LT(out[i - 1], out[i]) << "entry from a newer lap returned as an older one";
+        }
+    }
+    writer.join();
+}
@@ -127,3 +127,44 @@ TEST(DamageAccumulator, perspectiveTransform) {
     da.finish(&dirty);
     ASSERT_EQ(SkRect::MakeLTRB(50, 50, 500, 500), dirty);
 }
+
+TEST(DamageAccumulator, computeCurrentTransform) {
+    DamageAccumulator da;
+    RenderNode parent;
+    parent.animatorProperties().setLeftTopRightBottom(10, 20, 500, 500);
+    parent.animatorProperties().updateMatrix();
+    RenderNode child;
+    child.animatorProperties().setLeftTopRightBottom(50, 0, 100, 100);
+    child.animatorProperties().setScaleX(2.0f);
+    child.animatorProperties().setPivotX(0);
+    child.animatorProperties().updateMatrix();
+    RenderNode sibling;
+    sibling.animatorProperties().setLeftTopRightBottom(5, 5, 100, 100);
+    sibling.animatorProperties().updateMatrix();
+
+    Matrix4 transform;
+    Matrix4 expected;
+    da.pushTransform(&parent);
+    da.computeCurrentTransform(&transform);
+    expected.loadTranslate(10, 20, 0);
+    EXPECT_EQ(expected, transform);
+    {
+        da.pushTransform(&child);
+        da.computeCurrentTransform(&transform);
+        expected.loadTranslate(60, 20, 0);
+        expected.scale(2, 1, 1);
+        EXPECT_EQ(expected, transform);
+        da.popTransform();
+    }
+    {
+        // The cached transform of the popped child must not leak into its sibling
+        da.pushTransform(&sibling);
+        da.computeCurrentTransform(&transform);
+        expected.loadTranslate(15, 25, 0);
+        EXPECT_EQ(expected, transform);
+        da.popTransform();
+    }
+    da.popTransform();
+    da.computeCurrentTransform(&transform);
+    EXPECT_TRUE(transform.isIdentity());
+}
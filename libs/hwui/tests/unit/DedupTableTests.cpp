@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "utils/DedupTable.h"
+
+using namespace android;
+using namespace android::uirenderer;
+
+TEST(DedupTable, findInserted) {
+    DedupTable<int, int> table;
+    std::vector<int> values(1000);
+    for (int i = 0; i < 1000; i++) {
+        values[i] = i;
+        table.insert(i, &values[i], &values[i]);
+    }
+    EXPECT_EQ(1000u, table.size());
+    EXPECT_LE(1000u * 4 / 3, table.capacity());
+    for (int i = 0; i < 1000; i++) {
+        const int* found = table.find(i, [i](const int* key) { return *key == i; });
+        ASSERT_NE(nullptr, found);
+        EXPECT_EQ(&values[i], found);
+    }
+    EXPECT_EQ(nullptr, table.find(1000, [](const int*) { return true; }));
+}
+
+TEST(DedupTable, sharedHash) {
+    DedupTable<int, int> table;
+    int a = 1, b = 2;
+    table.insert(42, &a, &a);
+    table.insert(42, &b, &b);
+    EXPECT_EQ(&a, table.find(42, [](const int* key) { return *key == 1; }));
+    EXPECT_EQ(&b, table.find(42, [](const int* key) { return *key == 2; }));
+    EXPECT_EQ(nullptr, table.find(42, [](const int* key) { return *key == 3; }));
+}
+
+TEST(DedupTable, clearKeepsCapacity) {
+    DedupTable<int, int> table;
+    int value = 0;
+    for (int i = 0; i < 100; i++) {
+        table.insert(i, &value, &value);
+    }
+    size_t capacity = table.capacity();
+    table.clear();
+    EXPECT_EQ(0u, table.size());
+    EXPECT_EQ(capacity, table.capacity());
+    EXPECT_EQ(nullptr, table.find(5, [](const int*) { return true; }));
+}
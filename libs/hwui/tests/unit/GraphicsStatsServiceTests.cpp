@@ -17,6 +17,7 @@
 #include <gtest/gtest.h>
 
 #include "service/GraphicsStatsService.h"
+#include "utils/TimeUtils.h"
 
 #include <frameworks/base/core/proto/android/service/graphicsstats.pb.h>
 
@@ -156,4 +157,41 @@ TEST(GraphicsStats, merge) {
         EXPECT_EQ(expectedCount, loadedProto.histogram().Get(i).frame_count());
         EXPECT_EQ(expectedBucket, loadedProto.histogram().Get(i).render_millis());
     }
-}
\ No newline at end of file
+}
+
+TEST(GraphicsStats, stageIndexForDuration) {
+    EXPECT_EQ(0u, JankTracker::stageIndexForDuration(0));
+    EXPECT_EQ(0u, JankTracker::stageIndexForDuration(-5));
+    EXPECT_EQ(kStageHistogramSize - 1, JankTracker::stageIndexForDuration(10_s));
+    for (uint32_t i = 0; i < kStageHistogramSize; i++) {
+        // Every bucket's lower bound must map back to that bucket
+        uint32_t micros = JankTracker::stageTimeForIndex(i);
+        EXPECT_EQ(i, JankTracker::stageIndexForDuration(us2ns(micros)));
+    }
+}
+
+TEST(GraphicsStats, saveLoad_stageHistograms) {
+    std::string path = findRootPath() + "/test_saveLoad_stageHistograms";
+    std::string packageName = "com.test.stageHistograms";
+    ProfileData mockData;
+    memset(&mockData, 0, sizeof(ProfileData));
+    mockData.totalFrameCount = 10;
+    mockData.stageCounts[kStageDraw][JankTracker::stageIndexForDuration(3_ms)] = 7;
+    mockData.stageCounts[kStageDraw][JankTracker::stageIndexForDuration(12_ms)] = 3;
+    GraphicsStatsService::saveBuffer(path, packageName, 5, 3000, 7000, &mockData);
+    GraphicsStatsService::saveBuffer(path, packageName, 5, 7000, 9000, &mockData);
+    service::GraphicsStatsProto loadedProto;
+    EXPECT_TRUE(GraphicsStatsService::parseFromFile(path, &loadedProto));
+    unlink(path.c_str());
+
+    ASSERT_EQ(NUM_FRAME_STAGES, loadedProto.stage_histograms_size());
+    const auto& draw = loadedProto.stage_histograms(kStageDraw);
+    EXPECT_EQ(service::GraphicsStatsStageHistogramProto::DRAW, draw.stage());
+    ASSERT_EQ((int) kStageHistogramSize, draw.buckets_size());
+    int total = 0;
+    for (const auto& bucket : draw.buckets()) {
+        total += bucket.frame_count();
+    }
+    EXPECT_EQ(20, total);
+    EXPECT_EQ(14, draw.buckets(JankTracker::stageIndexForDuration(3_ms)).frame_count());
+}
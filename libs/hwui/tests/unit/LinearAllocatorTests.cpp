@@ -86,6 +86,54 @@ TEST(LinearAllocator, rewind) {
     EXPECT_EQ(1, destroyed);
 }
 
+TEST(LinearAllocator, reset) {
+    int destroyed = 0;
+    LinearAllocator la;
+    la.create<TestUtils::SignalingDtor>()->setSignal(&destroyed);
+    for (int i = 0; i < 200; i++) {
+        la.alloc<char>(64);
+    }
+    size_t allocatedSize = la.allocatedSize();
+    la.reset();
+    EXPECT_EQ(1, destroyed);
+    EXPECT_EQ(0u, la.usedSize());
+    EXPECT_EQ(allocatedSize, la.allocatedSize());
+
+    // The same allocations again must fit in the retained pages
+    size_t pageAllocations = LinearAllocator::totalPageAllocations();
+    for (int i = 0; i < 200; i++) {
+        la.alloc<char>(64);
+    }
+    EXPECT_EQ(pageAllocations, LinearAllocator::totalPageAllocations());
+    EXPECT_EQ(allocatedSize, la.allocatedSize());
+}
+
+TEST(LinearAllocator, resetShrinksToPeakUsage) {
+    LinearAllocator la;
+    for (int i = 0; i < 200; i++) {
+        la.alloc<char>(64);
+    }
+    size_t allocatedSize = la.allocatedSize();
+    // The first window of resets still covers the large round above, the second one
+    // only ever uses the first page
+    for (int i = 0; i < 32; i++) {
+        la.reset();
+        la.alloc<char>(64);
+    }
+    EXPECT_LT(la.allocatedSize(), allocatedSize);
+    EXPECT_LE(64u, la.usedSize());
+}
+
+TEST(LinearAllocator, resetFreesDedicatedPages) {
+    LinearAllocator la;
+    la.alloc<char>(64);
+    size_t allocatedSize = la.allocatedSize();
+    la.alloc<char>(64 * 1024);
+    EXPECT_LT(allocatedSize, la.allocatedSize());
+    la.reset();
+    EXPECT_EQ(allocatedSize, la.allocatedSize());
+}
+
 TEST(LinearStdAllocator, simpleAllocate) {
     LinearAllocator la;
     LinearStdAllocator<void*> stdAllocator(la);
@@ -153,3 +153,60 @@ RENDERTHREAD_OPENGL_PIPELINE_TEST(OffscreenBufferPool, clear) {
 
     EXPECT_EQ(0, GpuMemoryTracker::getInstanceCount(GpuObjectType::OffscreenBuffer));
 }
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(OffscreenBufferPool, getBestFit) {
+    OffscreenBufferPool pool;
+    auto large = pool.get(renderThread.renderState(), 256u, 256u);
+    auto small = pool.get(renderThread.renderState(), 128u, 128u);
+    pool.putOrDelete(large);
+    pool.putOrDelete(small);
+    EXPECT_EQ(2u, pool.getStats().misses);
+
+    // 100x100 fits both, but the 128x128 buffer wastes the least
+    auto layer = pool.get(renderThread.renderState(), 100u, 100u);
+    EXPECT_EQ(small, layer);
+    EXPECT_EQ(100u, layer->viewportWidth);
+    pool.putOrDelete(layer);
+
+    // 192x192 fits in the 256x256 buffer, which is less than twice its area
+    layer = pool.get(renderThread.renderState(), 190u, 190u);
+    EXPECT_EQ(large, layer);
+    pool.putOrDelete(layer);
+
+    // The 256x256 buffer would waste too much for a 64x192 layer
+    layer = pool.get(renderThread.renderState(), 64u, 192u);
+    EXPECT_NE(large, layer);
+    EXPECT_EQ(64u, layer->texture.width());
+    pool.putOrDelete(layer);
+
+    EXPECT_EQ(2u, pool.getStats().hits);
+    EXPECT_EQ(3u, pool.getStats().misses);
+    pool.clear();
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(OffscreenBufferPool, prewarmGrowingLayer) {
+    OffscreenBufferPool pool;
+    RenderState& renderState = renderThread.renderState();
+
+    // A layer growing by one LAYER_SIZE step per frame, as in a size animation
+    auto layer = pool.get(renderState, 128u, 128u);
+    pool.onFrameCompleted();
+    EXPECT_FALSE(pool.hasPendingPrewarms());
+    layer = pool.resize(layer, 192u, 192u);
+    pool.onFrameCompleted();
+    EXPECT_EQ(2u, pool.getStats().misses);
+    EXPECT_TRUE(pool.hasPendingPrewarms()) << "Should have predicted the next size";
+    EXPECT_EQ(0u, pool.getStats().prewarmed) << "Allocating waits for prewarm()";
+
+    pool.prewarm(renderState);
+    EXPECT_FALSE(pool.hasPendingPrewarms());
+    EXPECT_EQ(1u, pool.getStats().prewarmed);
+
+    layer = pool.resize(layer, 256u, 256u);
+    EXPECT_EQ(256u, layer->texture.width());
+    EXPECT_EQ(2u, pool.getStats().misses) << "Prewarmed buffer should have been used";
+    EXPECT_EQ(1u, pool.getStats().prewarmHits);
+
+    pool.putOrDelete(layer);
+    pool.clear();
+}
@@ -0,0 +1,376 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <debug/MockGlesDriver.h>
+#include <debug/NullGlesDriver.h>
+#include <debug/ScopedReplaceDriver.h>
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <Extensions.h>
+#include <Program.h>
+#include <ProgramBinaryCache.h>
+#include <ProgramCache.h>
+#include <thread/TaskManager.h>
+
+#include <set>
+#include <string.h>
+#include <unistd.h>
+
+using namespace android::uirenderer;
+using namespace testing;
+
+static const std::string sDriverId = "vendor/renderer/OpenGL ES 3.2";
+
+// Only the texture, bitmap and gradient bits are supported
+static ProgramBinaryCache::Entry createEntry(programid key, uint32_t useCount, uint8_t fill) {
+    ProgramBinaryCache::Entry entry;
+    entry.description.hasTexture = key & PROGRAM_KEY_TEXTURE;
+    entry.description.hasBitmap = key & PROGRAM_KEY_BITMAP;
+    entry.description.hasGradient = key & PROGRAM_KEY_GRADIENT;
+    entry.sourceHash = ProgramBinaryCache::hashSources("vertex", "fragment");
+    entry.useCount = useCount;
+    entry.binaryFormat = 0x1234;
+    entry.binary.assign(16, fill);
+    return entry;
+}
+
+TEST(ProgramBinaryCache, serialize) {
+    ProgramBinaryCache cache;
+    cache.put(PROGRAM_KEY_TEXTURE, createEntry(PROGRAM_KEY_TEXTURE, 3, 0xAA));
+    cache.put(PROGRAM_KEY_BITMAP, createEntry(PROGRAM_KEY_BITMAP, 1, 0xBB));
+    std::vector<uint8_t> data;
+    cache.serialize(sDriverId, &data);
+
+    ProgramBinaryCache loaded;
+    ASSERT_TRUE(loaded.parse(sDriverId, data.data(), data.size()));
+    ASSERT_EQ(2u, loaded.size());
+    const ProgramBinaryCache::Entry* entry = loaded.find(PROGRAM_KEY_TEXTURE);
+    ASSERT_NE(nullptr, entry);
+    EXPECT_TRUE(entry->description.hasTexture);
+    EXPECT_EQ(PROGRAM_KEY_TEXTURE, entry->description.key());
+    EXPECT_EQ(ProgramBinaryCache::hashSources("vertex", "fragment"), entry->sourceHash);
+    EXPECT_EQ(3u, entry->useCount);
+    EXPECT_EQ(0x1234u, entry->binaryFormat);
+    EXPECT_EQ(std::vector<uint8_t>(16, 0xAA), entry->binary);
+    entry = loaded.find(PROGRAM_KEY_BITMAP);
+    ASSERT_NE(nullptr, entry);
+    EXPECT_FALSE(entry->description.hasTexture);
+    EXPECT_TRUE(entry->description.hasBitmap);
+
+    EXPECT_NE(ProgramBinaryCache::hashSources("vertex", "fragment"),
+            ProgramBinaryCache::hashSources("vertex", "fragment2"));
+}
+
+TEST(ProgramBinaryCache, parse_rejectsOtherDriver) {
+    ProgramBinaryCache cache;
+    cache.put(PROGRAM_KEY_TEXTURE, createEntry(PROGRAM_KEY_TEXTURE, 1, 0xAA));
+    std::vector<uint8_t> data;
+    cache.serialize(sDriverId, &data);
+
+    ProgramBinaryCache loaded;
+    EXPECT_FALSE(loaded.parse("vendor/renderer/OpenGL ES 3.1", data.data(), data.size()));
+    EXPECT_EQ(0u, loaded.size());
+}
+
+TEST(ProgramBinaryCache, parse_rejectsTruncated) {
+    ProgramBinaryCache cache;
+    cache.put(PROGRAM_KEY_TEXTURE, createEntry(PROGRAM_KEY_TEXTURE, 1, 0xAA));
+    std::vector<uint8_t> data;
+    cache.serialize(sDriverId, &data);
+
+    for (size_t size = 0; size < data.size(); size += 7) {
+        ProgramBinaryCache loaded;
+        EXPECT_FALSE(loaded.parse(sDriverId, data.data(), size)) << "size " << size;
+        EXPECT_EQ(0u, loaded.size());
+    }
+}
+
+TEST(ProgramBinaryCache, parse_dropsMismatchedKey) {
+    ProgramBinaryCache cache;
+    // A8 texture programs are cached as plain texture ones
+    ProgramBinaryCache::Entry a8Entry = createEntry(PROGRAM_KEY_TEXTURE, 1, 0xAA);
+    a8Entry.description.hasAlpha8Texture = true;
+    cache.put(PROGRAM_KEY_TEXTURE, std::move(a8Entry));
+    cache.put(PROGRAM_KEY_BITMAP, createEntry(PROGRAM_KEY_GRADIENT, 1, 0xBB));
+    std::vector<uint8_t> data;
+    cache.serialize(sDriverId, &data);
+
+    ProgramBinaryCache loaded;
+    ASSERT_TRUE(loaded.parse(sDriverId, data.data(), data.size()));
+    EXPECT_EQ(1u, loaded.size());
+    const ProgramBinaryCache::Entry* entry = loaded.find(PROGRAM_KEY_TEXTURE);
+    ASSERT_NE(nullptr, entry);
+    EXPECT_TRUE(entry->description.hasAlpha8Texture);
+    EXPECT_EQ(nullptr, loaded.find(PROGRAM_KEY_BITMAP));
+}
+
+TEST(ProgramBinaryCache, recordUse) {
+    ProgramBinaryCache cache;
+    cache.put(PROGRAM_KEY_TEXTURE, createEntry(PROGRAM_KEY_TEXTURE, 1, 0));
+    EXPECT_TRUE(cache.recordUse(PROGRAM_KEY_TEXTURE));
+    EXPECT_FALSE(cache.recordUse(PROGRAM_KEY_BITMAP));
+    EXPECT_EQ(2u, cache.find(PROGRAM_KEY_TEXTURE)->useCount);
+}
+
+TEST(ProgramBinaryCache, mostUsed) {
+    ProgramBinaryCache cache;
+    cache.put(PROGRAM_KEY_TEXTURE, createEntry(PROGRAM_KEY_TEXTURE, 1, 0));
+    cache.put(PROGRAM_KEY_BITMAP, createEntry(PROGRAM_KEY_BITMAP, 5, 0));
+    cache.put(PROGRAM_KEY_GRADIENT, createEntry(PROGRAM_KEY_GRADIENT, 2, 0));
+    cache.recordUse(PROGRAM_KEY_TEXTURE);
+    cache.recordUse(PROGRAM_KEY_TEXTURE);
+    cache.recordUse(PROGRAM_KEY_TEXTURE);
+
+    std::vector<programid> expected = { PROGRAM_KEY_BITMAP, PROGRAM_KEY_TEXTURE };
+    EXPECT_EQ(expected, cache.mostUsed(2));
+    EXPECT_EQ(3u, cache.mostUsed(10).size());
+
+    // Replacing a binary keeps the history
+    cache.put(PROGRAM_KEY_BITMAP, createEntry(PROGRAM_KEY_BITMAP, 0, 1));
+    EXPECT_EQ(5u, cache.find(PROGRAM_KEY_BITMAP)->useCount);
+}
+
+TEST(Program, createFromBinary) {
+    debug::ScopedReplaceDriver<debug::MockGlesDriver> driverRef;
+    auto& mockGlDriver = driverRef.get();
+    const uint8_t binary[] = { 1, 2, 3, 4 };
+    ProgramDescription description;
+    description.hasTexture = true;
+
+    // No shader is compiled, the fatal base driver would abort on glCreateShader
+    EXPECT_CALL(mockGlDriver, glCreateProgram_()).WillOnce(Return(7));
+    EXPECT_CALL(mockGlDriver, glBindAttribLocation_(7, _, _)).Times(2);
+    EXPECT_CALL(mockGlDriver, glProgramBinary_(7, 0x1234, binary, 4));
+    EXPECT_CALL(mockGlDriver, glGetProgramiv_(7, GL_LINK_STATUS, _))
+            .WillOnce(SetArgPointee<2>(GL_TRUE));
+    EXPECT_CALL(mockGlDriver, glGetUniformLocation_(7, _)).Times(2).WillRepeatedly(Return(1));
+    EXPECT_CALL(mockGlDriver, glGetProgramiv_(7, GL_PROGRAM_BINARY_LENGTH, _))
+            .WillOnce(SetArgPointee<2>(4));
+    EXPECT_CALL(mockGlDriver, glGetProgramBinary_(7, 4, _, _, _))
+            .WillOnce(Invoke([](GLuint, GLsizei bufSize, GLsizei* length, GLenum* format,
+                    void* out) {
+                memset(out, 9, bufSize);
+                *length = bufSize;
+                *format = 0x1234;
+            }));
+    EXPECT_CALL(mockGlDriver, glDeleteProgram_(7));
+
+    Program program(description, 0x1234, binary, 4);
+    EXPECT_TRUE(program.isInitialized());
+    EXPECT_EQ(Program::kBindingTexCoords, program.texCoords);
+
+    GLenum format = 0;
+    std::vector<uint8_t> readBack;
+    EXPECT_TRUE(program.getBinary(&format, &readBack));
+    EXPECT_EQ(0x1234u, format);
+    EXPECT_EQ(std::vector<uint8_t>(4, 9), readBack);
+}
+
+TEST(Program, createFromBinary_rejected) {
+    debug::ScopedReplaceDriver<debug::MockGlesDriver> driverRef;
+    auto& mockGlDriver = driverRef.get();
+    const uint8_t binary[] = { 1, 2, 3, 4 };
+    ProgramDescription description;
+
+    EXPECT_CALL(mockGlDriver, glCreateProgram_()).WillOnce(Return(7));
+    EXPECT_CALL(mockGlDriver, glBindAttribLocation_(7, _, _));
+    EXPECT_CALL(mockGlDriver, glProgramBinary_(7, 0x1234, binary, 4));
+    EXPECT_CALL(mockGlDriver, glGetProgramiv_(7, GL_LINK_STATUS, _))
+            .WillOnce(SetArgPointee<2>(GL_FALSE));
+    // Deleted right away, and not again by the destructor
+    EXPECT_CALL(mockGlDriver, glDeleteProgram_(7)).Times(1);
+
+    Program program(description, 0x1234, binary, 4);
+    EXPECT_FALSE(program.isInitialized());
+
+    GLenum format = 0;
+    std::vector<uint8_t> readBack;
+    EXPECT_FALSE(program.getBinary(&format, &readBack));
+}
+
+static const char* sDiskCachePath = "/data/local/tmp/hwui_program_cache_test";
+// The vendor and renderer of the null driver, with an ES 3 version
+static const std::string sNullDriverId = "android/null/OpenGL ES 3.2";
+
+// Null driver that supports program binaries, and counts how programs get created
+class BinaryGlesDriver : public debug::NullGlesDriver {
+public:
+    int shadersCreated = 0;
+    int binariesLoaded = 0;
+    bool rejectBinaries = false;
+
+    virtual GLuint glCreateShader_(GLenum type) override {
+        shadersCreated++;
+        return NullGlesDriver::glCreateShader_(type);
+    }
+
+    virtual void glGetIntegerv_(GLenum pname, GLint* data) override {
+        if (pname == GL_NUM_PROGRAM_BINARY_FORMATS) {
+            *data = 1;
+        } else {
+            NullGlesDriver::glGetIntegerv_(pname, data);
+        }
+    }
+
+    virtual const GLubyte* glGetString_(GLenum name) override {
+        if (name == GL_VERSION) return (const GLubyte*) "OpenGL ES 3.2";
+        return NullGlesDriver::glGetString_(name);
+    }
+
+    virtual void glProgramParameteri_(GLuint program, GLenum pname, GLint value) override {}
+
+    virtual void glProgramBinary_(GLuint program, GLenum binaryFormat, const void* binary,
+            GLsizei length) override {
+        binariesLoaded++;
+        if (rejectBinaries) mRejected.insert(program);
+    }
+
+    virtual void glGetProgramiv_(GLuint program, GLenum pname, GLint* params) override {
+        if (pname == GL_PROGRAM_BINARY_LENGTH) {
+            *params = 4;
+        } else if (pname == GL_LINK_STATUS && mRejected.count(program)) {
+            *params = GL_FALSE;
+        } else {
+            NullGlesDriver::glGetProgramiv_(program, pname, params);
+        }
+    }
+
+    virtual void glGetProgramBinary_(GLuint program, GLsizei bufSize, GLsizei* length,
+            GLenum* binaryFormat, void* binary) override {
+        memset(binary, 9, bufSize);
+        *length = bufSize;
+        *binaryFormat = 0x1234;
+    }
+
+private:
+    std::set<GLuint> mRejected;
+};
+
+class ScopedDiskCachePath {
+public:
+    ScopedDiskCachePath() {
+        unlink(sDiskCachePath);
+        ProgramCache::setDiskCachePath(sDiskCachePath);
+    }
+    ~ScopedDiskCachePath() {
+        ProgramCache::setDiskCachePath("");
+        unlink(sDiskCachePath);
+    }
+};
+
+// Compiles the program of description with a new cache, and saves its binary to the disk cache
+static void saveCompiledProgram(const ProgramDescription& description) {
+    Extensions extensions;
+    ProgramCache cache(extensions);
+    ASSERT_TRUE(cache.get(description)->isInitialized());
+    ASSERT_TRUE(cache.getBinaryCache().save(sDiskCachePath, sNullDriverId));
+}
+
+TEST(ProgramCache, generateProgram_keepsBinary) {
+    ScopedDiskCachePath diskCachePath;
+    debug::ScopedReplaceDriver<BinaryGlesDriver> driverRef;
+    auto& driver = driverRef.get();
+    Extensions extensions;
+    ProgramCache cache(extensions);
+    ProgramDescription description;
+    description.hasTexture = true;
+
+    Program* program = cache.get(description);
+    EXPECT_TRUE(program->isInitialized());
+    EXPECT_EQ(2, driver.shadersCreated);
+    EXPECT_EQ(1u, cache.getStats().compiles);
+    EXPECT_EQ(0u, cache.getStats().binaryHits);
+
+    const ProgramBinaryCache::Entry* entry = cache.getBinaryCache().find(description.cacheKey());
+    ASSERT_NE(nullptr, entry);
+    EXPECT_EQ(0x1234u, entry->binaryFormat);
+    EXPECT_EQ(std::vector<uint8_t>(4, 9), entry->binary);
+    EXPECT_EQ(1u, entry->useCount);
+
+    EXPECT_EQ(program, cache.get(description));
+    EXPECT_EQ(1u, cache.getStats().compiles);
+
+    // New binaries are only written once no new program was needed for a while
+    cache.doIdleWork();
+    EXPECT_FALSE(cache.hasIdleWork());
+    for (int i = 0; i < 120; i++) {
+        cache.onFrameCompleted();
+    }
+    EXPECT_TRUE(cache.hasIdleWork());
+}
+
+TEST(ProgramCache, precompile_loadsBinary) {
+    ScopedDiskCachePath diskCachePath;
+    debug::ScopedReplaceDriver<BinaryGlesDriver> driverRef;
+    auto& driver = driverRef.get();
+    ProgramDescription description;
+    description.hasTexture = true;
+    saveCompiledProgram(description);
+    driver.shadersCreated = 0;
+
+    TaskManager tasks;
+    Extensions extensions;
+    ProgramCache cache(extensions);
+    cache.loadDiskCache(tasks);
+    EXPECT_EQ(1, cache.precompile(2));
+    EXPECT_EQ(0, driver.shadersCreated);
+    EXPECT_EQ(1, driver.binariesLoaded);
+    EXPECT_EQ(1u, cache.getStats().precompiled);
+    EXPECT_EQ(1u, cache.getStats().binaryHits);
+    EXPECT_EQ(0u, cache.getStats().compiles);
+
+    // The precompiled program is handed out without any more GL work
+    EXPECT_TRUE(cache.get(description)->isInitialized());
+    EXPECT_EQ(0, driver.shadersCreated);
+    EXPECT_EQ(1, driver.binariesLoaded);
+    EXPECT_EQ(2u, cache.getBinaryCache().find(description.cacheKey())->useCount);
+
+    // Nothing left to warm up, and a use count alone doesn't rewrite the file
+    cache.doIdleWork();
+    for (int i = 0; i < 120; i++) {
+        cache.onFrameCompleted();
+    }
+    EXPECT_FALSE(cache.hasIdleWork());
+}
+
+TEST(ProgramCache, generateProgram_rejectedBinary) {
+    ScopedDiskCachePath diskCachePath;
+    debug::ScopedReplaceDriver<BinaryGlesDriver> driverRef;
+    auto& driver = driverRef.get();
+    ProgramDescription description;
+    description.hasTexture = true;
+    saveCompiledProgram(description);
+    driver.shadersCreated = 0;
+    driver.rejectBinaries = true;
+
+    TaskManager tasks;
+    Extensions extensions;
+    ProgramCache cache(extensions);
+    cache.loadDiskCache(tasks);
+    EXPECT_TRUE(cache.get(description)->isInitialized());
+    EXPECT_EQ(1, driver.binariesLoaded);
+    EXPECT_EQ(2, driver.shadersCreated);
+    EXPECT_EQ(1u, cache.getStats().binaryRejects);
+    EXPECT_EQ(1u, cache.getStats().compiles);
+
+    // The binary of the new compile replaces the rejected one
+    cache.doIdleWork();
+    EXPECT_FALSE(cache.hasIdleWork());
+    for (int i = 0; i < 120; i++) {
+        cache.onFrameCompleted();
+    }
+    EXPECT_TRUE(cache.hasIdleWork());
+}
@@ -743,6 +743,36 @@ OPENGL_PIPELINE_TEST(RecordingCanvas, refPaint) {
     EXPECT_NE(&paint, ops[2]->paint);
 }
 
+OPENGL_PIPELINE_TEST(RecordingCanvas, refPath_dedupStats) {
+    SkPath path;
+    path.addCircle(50, 50, 40);
+    SkPath otherPath;
+    otherPath.addRect(0, 0, 20, 20);
+    RecordingCanvas::DedupStats stats;
+
+    auto dl = TestUtils::createDisplayList<RecordingCanvas>(200, 200,
+            [&path, &otherPath, &stats](RecordingCanvas& canvas) {
+        SkPaint paint;
+        canvas.drawPath(path, paint);
+        canvas.drawPath(path, paint);
+        canvas.drawPath(otherPath, paint);
+        stats = canvas.getDedupStats();
+    });
+    auto ops = dl->getOps();
+    ASSERT_EQ(3u, ops.size());
+    auto pathOp = [](const RecordedOp* op) {
+        return static_cast<const PathOp*>(op)->path;
+    };
+    EXPECT_EQ(pathOp(ops[0]), pathOp(ops[1]));
+    EXPECT_NE(pathOp(ops[0]), pathOp(ops[2]));
+    EXPECT_NE(&path, pathOp(ops[0]));
+
+    EXPECT_EQ(2u, stats.uniquePaths);
+    EXPECT_EQ(1u, stats.dedupedPaths);
+    EXPECT_EQ(1u, stats.uniquePaints);
+    EXPECT_EQ(2u, stats.dedupedPaints);
+}
+
 OPENGL_PIPELINE_TEST(RecordingCanvas, refBitmap) {
     sk_sp<Bitmap> bitmap(TestUtils::createBitmap(100, 100));
     auto dl = TestUtils::createDisplayList<RecordingCanvas>(100, 100, [&bitmap](RecordingCanvas& canvas) {
@@ -848,5 +878,29 @@ OPENGL_PIPELINE_TEST(RecordingCanvas, drawTextInHighContrast) {
     ASSERT_EQ(2, count);
 }
 
+OPENGL_PIPELINE_TEST(RecordingCanvas, recycledDisplayList) {
+    DisplayListPool& pool = DisplayListPool::getInstance();
+    pool.clear();
+    auto dl = TestUtils::createDisplayList<RecordingCanvas>(100, 100, [](RecordingCanvas& canvas) {
+        canvas.drawRect(0, 0, 100, 100, SkPaint());
+        canvas.drawRect(0, 0, 50, 50, SkPaint());
+    });
+    ASSERT_EQ(2u, dl->getOps().size());
+    DisplayList* recycled = dl.release();
+    ASSERT_TRUE(pool.recycle(recycled));
+    EXPECT_TRUE(recycled->isEmpty());
+    EXPECT_EQ(0u, recycled->getUsedSize());
+
+    // The next recording picks the recycled list back up, pages and all
+    size_t pageAllocations = LinearAllocator::totalPageAllocations();
+    dl = TestUtils::createDisplayList<RecordingCanvas>(100, 100, [](RecordingCanvas& canvas) {
+        canvas.drawRect(0, 0, 100, 100, SkPaint());
+    });
+    EXPECT_EQ(recycled, dl.get());
+    ASSERT_EQ(1u, dl->getOps().size());
+    EXPECT_EQ(RecordedOpId::RectOp, dl->getOps()[0]->opId);
+    EXPECT_EQ(pageAllocations, LinearAllocator::totalPageAllocations());
+}
+
 } // namespace uirenderer
 } // namespace android
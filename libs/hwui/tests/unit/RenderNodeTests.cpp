@@ -19,7 +19,9 @@
 
 #include "AnimationContext.h"
 #include "DamageAccumulator.h"
+#include "FrameBuilder.h"
 #include "IContextFactory.h"
+#include "RecordingCanvas.h"
 #include "RenderNode.h"
 #include "TreeInfo.h"
 #include "renderthread/CanvasContext.h"
@@ -335,3 +337,133 @@ RENDERTHREAD_TEST(RenderNode, prepareTree_HwLayer_AVD_enqueueDamage) {
     EXPECT_EQ(uirenderer::Rect(0, 0, 200, 400), info.layerUpdateQueue->entries().at(0).damage);
     canvasContext->destroy();
 }
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(RenderNode, prepareTree_skipsCleanSubtrees) {
+    auto leftChild = TestUtils::createNode(0, 0, 100, 100,
+            [](RenderProperties& props, Canvas& canvas) {
+        canvas.drawColor(Color::Red_500, SkBlendMode::kSrcOver);
+    });
+    auto rightChild = TestUtils::createNode(100, 0, 200, 100,
+            [](RenderProperties& props, Canvas& canvas) {
+        canvas.drawColor(Color::Blue_500, SkBlendMode::kSrcOver);
+    });
+    auto rootNode = TestUtils::createNode(0, 0, 200, 100,
+            [&](RenderProperties& props, Canvas& canvas) {
+        canvas.drawRenderNode(leftChild.get());
+        canvas.drawRenderNode(rightChild.get());
+    });
+    ContextFactory contextFactory;
+    std::unique_ptr<CanvasContext> canvasContext(CanvasContext::create(
+            renderThread, false, rootNode.get(), &contextFactory));
+    TestUtils::syncHierarchyPropertiesAndDisplayList(rootNode);
+
+    auto prepareFrame = [&]() {
+        TreeInfo info(TreeInfo::MODE_FULL, *canvasContext.get());
+        DamageAccumulator damageAccumulator;
+        LayerUpdateQueue layerUpdateQueue;
+        info.damageAccumulator = &damageAccumulator;
+        info.layerUpdateQueue = &layerUpdateQueue;
+        rootNode->prepareTree(info);
+        return std::make_pair(info.out.nodesPrepared, info.out.nodesSkipped);
+    };
+
+    // Nothing has been prepared yet, so every node is visited
+    EXPECT_EQ(std::make_pair(3u, 0u), prepareFrame());
+
+    // Nothing changed, so both children are skipped
+    EXPECT_EQ(std::make_pair(1u, 2u), prepareFrame());
+
+    // A staging change on one child must still reach it
+    leftChild->mutateStagingProperties().setAlpha(0.5f);
+    leftChild->setPropertyFieldsDirty(RenderNode::ALPHA);
+    EXPECT_EQ(std::make_pair(2u, 1u), prepareFrame());
+    EXPECT_EQ(0.5f, leftChild->properties().getAlpha());
+
+    EXPECT_EQ(std::make_pair(1u, 2u), prepareFrame());
+    canvasContext->destroy();
+}
+
+// A 100x100 node casting a shadow
+static sp<RenderNode> createShadowCaster() {
+    return TestUtils::createNode<RecordingCanvas>(0, 0, 100, 100,
+            [](RenderProperties& props, RecordingCanvas& canvas) {
+        props.setTranslationZ(5.0f);
+        props.mutableOutline().setRoundRect(0, 0, 100, 100, 0.0f, 1.0f);
+        canvas.drawColor(Color::White, SkBlendMode::kSrcOver);
+    });
+}
+
+// Prepares the tree of rootNode with shadow prefetching, and returns how many were prefetched
+static uint32_t prepareWithShadowPrefetch(renderthread::RenderThread& renderThread,
+        sp<RenderNode>& rootNode, const FrameBuilder::LightGeometry& lightGeometry) {
+    auto& tessellationCache = Caches::getInstance().tessellationCache;
+    uint32_t prefetchCount = tessellationCache.getShadowPrefetchCount();
+    ContextFactory contextFactory;
+    std::unique_ptr<CanvasContext> canvasContext(CanvasContext::create(
+            renderThread, false, rootNode.get(), &contextFactory));
+    TreeInfo info(TreeInfo::MODE_RT_ONLY, *canvasContext.get());
+    DamageAccumulator damageAccumulator;
+    LayerUpdateQueue layerUpdateQueue;
+    info.damageAccumulator = &damageAccumulator;
+    info.layerUpdateQueue = &layerUpdateQueue;
+    info.lightCenter = &lightGeometry.center;
+    info.lightRadius = lightGeometry.radius;
+    rootNode->prepareTree(info);
+    canvasContext->destroy();
+    return tessellationCache.getShadowPrefetchCount() - prefetchCount;
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(RenderNode, prepareTree_shadowPrefetchMatchesDraw) {
+    const FrameBuilder::LightGeometry lightGeometry = { {100, 100, 100}, 50 };
+    auto parent = TestUtils::createNode<RecordingCanvas>(10, 20, 190, 190,
+            [](RenderProperties& props, RecordingCanvas& canvas) {
+        canvas.translate(5, 5);
+        canvas.insertReorderBarrier(true);
+        canvas.drawRenderNode(createShadowCaster().get());
+        canvas.insertReorderBarrier(false);
+    });
+    auto rootNode = TestUtils::createNode<RecordingCanvas>(0, 0, 200, 200,
+            [&parent](RenderProperties& props, RecordingCanvas& canvas) {
+        canvas.drawRenderNode(parent.get());
+    });
+
+    auto& tessellationCache = Caches::getInstance().tessellationCache;
+    tessellationCache.clearShadows();
+    EXPECT_EQ(1u, prepareWithShadowPrefetch(renderThread, rootNode, lightGeometry));
+
+    // deferShadow() must look up the key the prepare used
+    uint32_t hitCount = tessellationCache.getShadowPrefetchHitCount();
+    FrameBuilder frameBuilder(SkRect::MakeWH(200, 200), 200, 200,
+            lightGeometry, Caches::getInstance());
+    frameBuilder.deferRenderNode(*rootNode);
+    EXPECT_EQ(hitCount + 1, tessellationCache.getShadowPrefetchHitCount());
+    tessellationCache.clearShadows();
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(RenderNode, prepareTree_noShadowPrefetchInLayers) {
+    const FrameBuilder::LightGeometry lightGeometry = { {100, 100, 100}, 50 };
+    auto& tessellationCache = Caches::getInstance().tessellationCache;
+    tessellationCache.clearShadows();
+
+    // Within a clipped saveLayer, the transform depends on the clipped layer bounds
+    auto saveLayerNode = TestUtils::createNode<RecordingCanvas>(0, 0, 200, 200,
+            [](RenderProperties& props, RecordingCanvas& canvas) {
+        int count = canvas.saveLayerAlpha(30, 50, 130, 150, 128, SaveFlags::ClipToLayer);
+        canvas.insertReorderBarrier(true);
+        canvas.drawRenderNode(createShadowCaster().get());
+        canvas.insertReorderBarrier(false);
+        canvas.restoreToCount(count);
+    });
+    EXPECT_EQ(0u, prepareWithShadowPrefetch(renderThread, saveLayerNode, lightGeometry));
+
+    // Within a HW layer, the transform and light center are relative to the layer
+    auto layerNode = TestUtils::createNode<RecordingCanvas>(0, 0, 200, 200,
+            [](RenderProperties& props, RecordingCanvas& canvas) {
+        props.mutateLayerProperties().setType(LayerType::RenderLayer);
+        canvas.insertReorderBarrier(true);
+        canvas.drawRenderNode(createShadowCaster().get());
+        canvas.insertReorderBarrier(false);
+    });
+    EXPECT_EQ(0u, prepareWithShadowPrefetch(renderThread, layerNode, lightGeometry));
+    tessellationCache.clearShadows();
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "AmbientShadow.h"
+#include "ShadowTessellator.h"
+#include "SpotShadow.h"
+#include "Vertex.h"
+#include "VertexBuffer.h"
+
+#include <cmath>
+#include <float.h>
+
+using namespace android;
+using namespace android::uirenderer;
+
+// Counter clockwise, as TessellationCache hands casters to the shadow tessellators
+static const Vector3 sSquareCaster[] = {
+        {0, 0, 10}, {0, 100, 10}, {100, 100, 10}, {100, 0, 10} };
+static const Vector3 sSquareCentroid = {50, 50, 10};
+
+TEST(ShadowTessellator, calculateNormals) {
+    const float x[] = { 0, 100, 100, 0 };
+    const float y[] = { 0, 0, 100, 100 };
+    float normalX[4];
+    float normalY[4];
+    ShadowTessellator::calculateNormals(x, y, 4, normalX, normalY);
+    for (int i = 0; i < 4; i++) {
+        Vector2 expected = ShadowTessellator::calculateNormal(
+                {x[i], y[i]}, {x[(i + 1) % 4], y[(i + 1) % 4]});
+        EXPECT_EQ(expected.x, normalX[i]);
+        EXPECT_EQ(expected.y, normalY[i]);
+    }
+
+    // Repeated vertices produce a zero normal instead of a NaN
+    const float repeatedX[] = { 0, 0, 100 };
+    const float repeatedY[] = { 0, 0, 100 };
+    ShadowTessellator::calculateNormals(repeatedX, repeatedY, 3, normalX, normalY);
+    EXPECT_EQ(0, normalX[0]);
+    EXPECT_EQ(0, normalY[0]);
+}
+
+TEST(AmbientShadow, squareCaster) {
+    const float heightFactor = 1.0f / 128;
+    const float geomFactor = 64;
+    VertexBuffer buffer;
+    AmbientShadow::createAmbientShadow(true, sSquareCaster, 4, sSquareCentroid,
+            heightFactor, geomFactor, buffer);
+    ASSERT_GT(buffer.getVertexCount(), 8u);
+
+    const float expectedAlpha = 1.0 / (1 + 10 * heightFactor);
+    const float expansionDist = 10 * heightFactor * geomFactor;
+    const AlphaVertex* vertices = static_cast<const AlphaVertex*>(buffer.getBuffer());
+    int innerCount = 0;
+    for (unsigned int i = 0; i < buffer.getVertexCount(); i++) {
+        const AlphaVertex& vertex = vertices[i];
+        if (vertex.alpha > 0) {
+            // Inner vertices are the caster's own vertices
+            EXPECT_FLOAT_EQ(expectedAlpha, vertex.alpha);
+            innerCount++;
+            continue;
+        }
+        // Outer vertices fan out around a corner at the expansion distance
+        float minDistance = FLT_MAX;
+        for (const Vector3& corner : sSquareCaster) {
+            minDistance = std::min(minDistance,
+                    (Vector2{vertex.x - corner.x, vertex.y - corner.y}).length());
+        }
+        EXPECT_NEAR(expansionDist, minDistance, 0.001f);
+    }
+    EXPECT_EQ(4, innerCount);
+
+    const Rect& bounds = buffer.getBounds();
+    EXPECT_NEAR(-expansionDist, bounds.left, 0.001f);
+    EXPECT_NEAR(100 + expansionDist, bounds.right, 0.001f);
+}
+
+TEST(SpotShadow, squareCaster) {
+    const Vector3 lightCenter = {50, 50, 500};
+    const float lightSize = 50;
+    for (bool opaque : { true, false }) {
+        VertexBuffer buffer;
+        SpotShadow::createSpotShadow(opaque, lightCenter, lightSize, sSquareCaster, 4,
+                sSquareCentroid, buffer);
+        ASSERT_GT(buffer.getVertexCount(), 0u);
+
+        const AlphaVertex* vertices = static_cast<const AlphaVertex*>(buffer.getBuffer());
+        for (unsigned int i = 0; i < buffer.getVertexCount(); i++) {
+            EXPECT_FALSE(std::isnan(vertices[i].x) || std::isnan(vertices[i].y));
+            EXPECT_GE(vertices[i].alpha, 0.0f);
+            EXPECT_LE(vertices[i].alpha, 1.0f);
+        }
+
+        // The outline is the caster projected away from the light, and the penumbra
+        // extends past it by the outline's radius, both by the same ratio of 10 / 490
+        const float ratio = 10.0f / 490;
+        const float extent = 2 * ratio * lightSize;
+        const Rect& bounds = buffer.getBounds();
+        EXPECT_NEAR(-extent, bounds.left, 0.01f);
+        EXPECT_NEAR(-extent, bounds.top, 0.01f);
+        EXPECT_NEAR(100 + extent, bounds.right, 0.01f);
+        EXPECT_NEAR(100 + extent, bounds.bottom, 0.01f);
+    }
+}
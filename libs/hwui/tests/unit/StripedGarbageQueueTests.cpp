@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "utils/StripedGarbageQueue.h"
+
+#include <thread>
+#include <vector>
+
+using namespace android;
+using namespace android::uirenderer;
+
+TEST(StripedGarbageQueue, drain) {
+    StripedGarbageQueue<int> queue;
+    std::vector<int> drained;
+    queue.drain(&drained);
+    EXPECT_TRUE(drained.empty());
+
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+    drained.push_back(0);
+    queue.drain(&drained);
+    // Appended, in the order they were pushed by this thread
+    EXPECT_EQ(std::vector<int>({0, 1, 2, 3}), drained);
+
+    drained.clear();
+    queue.drain(&drained);
+    EXPECT_TRUE(drained.empty());
+    EXPECT_EQ(0u, queue.contendedCount());
+}
+
+TEST(StripedGarbageQueue, multipleThreads) {
+    static const int kThreadCount = 4;
+    static const int kPushesPerThread = 10000;
+    StripedGarbageQueue<int> queue;
+    std::vector<int> drained;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreadCount; i++) {
+        threads.emplace_back([&queue, i]() {
+            for (int j = 0; j < kPushesPerThread; j++) {
+                queue.push(i * kPushesPerThread + j);
+            }
+        });
+    }
+    // Drain concurrently, the way the RenderThread does while other threads keep pushing
+    for (int i = 0; i < 100; i++) {
+        queue.drain(&drained);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    queue.drain(&drained);
+
+    ASSERT_EQ(static_cast<size_t>(kThreadCount * kPushesPerThread), drained.size());
+    // Each thread's items come out in order, and none is lost or duplicated
+    std::vector<int> nextExpected(kThreadCount);
+    for (int item : drained) {
+        int thread = item / kPushesPerThread;
+        ASSERT_EQ(thread * kPushesPerThread + nextExpected[thread], item);
+        nextExpected[thread]++;
+    }
+    EXPECT_GE(queue.lockCount(), static_cast<uint32_t>(kThreadCount * kPushesPerThread));
+}
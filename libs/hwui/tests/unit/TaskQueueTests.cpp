@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "renderthread/RenderThread.h"
+
+#include <climits>
+
+using namespace android;
+using namespace android::uirenderer;
+using namespace android::uirenderer::renderthread;
+
+class TestTask : public RenderTask {
+public:
+    TestTask(TaskClass taskClass, nsecs_t queuedAt, nsecs_t runAt = 0) {
+        mTaskClass = taskClass;
+        mQueuedAt = queuedAt;
+        mRunAt = runAt;
+    }
+    virtual void run() override {}
+};
+
+TEST(TaskQueue, backgroundTasksAreSeparate) {
+    TaskQueue queue;
+    TestTask background(TaskClass::Background, 0);
+    TestTask normal(TaskClass::Normal, 0);
+    TestTask frame(TaskClass::Frame, 0);
+
+    queue.queue(&background);
+    queue.queue(&normal);
+    EXPECT_FALSE(queue.hasPendingFrame());
+    queue.queue(&frame);
+    EXPECT_TRUE(queue.hasPendingFrame());
+
+    EXPECT_EQ(&normal, queue.next(0));
+    EXPECT_EQ(&frame, queue.next(0));
+    EXPECT_FALSE(queue.hasPendingFrame());
+    EXPECT_EQ(nullptr, queue.next(0));
+
+    EXPECT_EQ(&background, queue.peekBackground());
+    EXPECT_EQ(&background, queue.nextBackground(0));
+    EXPECT_EQ(nullptr, queue.peekBackground());
+}
+
+TEST(TaskQueue, backgroundTasksOrderedByRunAt) {
+    TaskQueue queue;
+    TestTask late(TaskClass::Background, 0, 20);
+    TestTask early(TaskClass::Background, 0, 10);
+    TestTask now(TaskClass::Background, 0);
+
+    queue.queue(&late);
+    queue.queue(&early);
+    queue.queue(&now);
+    EXPECT_EQ(&now, queue.nextBackground(0));
+    EXPECT_EQ(&early, queue.nextBackground(10));
+    EXPECT_EQ(&late, queue.nextBackground(20));
+}
+
+TEST(TaskQueue, remove) {
+    TaskQueue queue;
+    TestTask frame(TaskClass::Frame, 0);
+    TestTask background1(TaskClass::Background, 0);
+    TestTask background2(TaskClass::Background, 0);
+
+    queue.queue(&frame);
+    queue.queue(&background1);
+    queue.queue(&background2);
+    queue.remove(&frame);
+    EXPECT_FALSE(queue.hasPendingFrame());
+    EXPECT_EQ(nullptr, queue.peek());
+
+    queue.remove(&background1);
+    EXPECT_EQ(&background2, queue.peekBackground());
+    // Removed tasks can be queued again
+    queue.queue(&background1);
+    EXPECT_EQ(&background2, queue.nextBackground(0));
+    EXPECT_EQ(&background1, queue.nextBackground(0));
+}
+
+TEST(TaskQueue, latencyStats) {
+    TaskQueue queue;
+    TestTask normal1(TaskClass::Normal, 100);
+    TestTask normal2(TaskClass::Normal, 100);
+    // Latency counts from when the task was due, not when it was queued
+    TestTask delayed(TaskClass::Background, 100, 1000);
+
+    queue.queue(&normal1);
+    queue.queue(&normal2);
+    queue.queue(&delayed);
+    queue.next(110);
+    queue.next(130);
+    queue.nextBackground(1500);
+
+    const TaskQueue::LatencyStats& normalStats = queue.latencyStats(TaskClass::Normal);
+    EXPECT_EQ(2u, normalStats.count);
+    EXPECT_EQ(40, normalStats.total);
+    EXPECT_EQ(30, normalStats.max);
+
+    const TaskQueue::LatencyStats& backgroundStats = queue.latencyStats(TaskClass::Background);
+    EXPECT_EQ(1u, backgroundStats.count);
+    EXPECT_EQ(500, backgroundStats.max);
+
+    EXPECT_EQ(0u, queue.latencyStats(TaskClass::Frame).count);
+}
+
+TEST(TimeLord, nextIdleTime) {
+    TimeLord timeLord;
+    timeLord.setFrameInterval(10);
+    // Nothing to hold back for before the first frame
+    EXPECT_EQ(5, timeLord.nextIdleTime(5));
+
+    timeLord.vsyncReceived(100);
+    timeLord.frameStarted(103);
+    // The rest of the frame's interval is idle
+    EXPECT_EQ(105, timeLord.nextIdleTime(105));
+    // The next interval is reserved for the next frame
+    EXPECT_EQ(120, timeLord.nextIdleTime(110));
+    EXPECT_EQ(120, timeLord.nextIdleTime(119));
+    // No frame came for a whole interval, so drawing stopped
+    EXPECT_EQ(125, timeLord.nextIdleTime(125));
+
+    // A late frame counts for the interval it started in, not its vsync's
+    timeLord.frameStarted(127);
+    EXPECT_EQ(129, timeLord.nextIdleTime(129));
+    EXPECT_EQ(140, timeLord.nextIdleTime(131));
+}
+
+TEST(TaskQueue, nextDue_holdsBackgroundUntilIdle) {
+    TaskQueue queue;
+    TimeLord timeLord;
+    timeLord.setFrameInterval(10);
+    timeLord.vsyncReceived(100);
+    nsecs_t nextWakeup = 0;
+
+    TestTask frame(TaskClass::Frame, 100);
+    queue.queue(&frame);
+    EXPECT_EQ(&frame, queue.nextDue(103, timeLord, &nextWakeup));
+
+    // Right after the frame, background work runs
+    TestTask background(TaskClass::Background, 104);
+    queue.queue(&background);
+    EXPECT_EQ(&background, queue.nextDue(105, timeLord, &nextWakeup));
+
+    // Once the next frame is expected it waits for the end of that interval...
+    queue.queue(&background);
+    EXPECT_EQ(nullptr, queue.nextDue(112, timeLord, &nextWakeup));
+    EXPECT_EQ(120, nextWakeup);
+
+    // ...while urgent work still runs right away
+    TestTask normal(TaskClass::Normal, 112);
+    queue.queue(&normal);
+    EXPECT_EQ(&normal, queue.nextDue(112, timeLord, &nextWakeup));
+    EXPECT_EQ(nullptr, queue.nextDue(113, timeLord, &nextWakeup));
+    EXPECT_EQ(120, nextWakeup);
+
+    // A queued frame holds it back past that, until the frame started
+    TestTask lateFrame(TaskClass::Frame, 112, 125);
+    queue.queue(&lateFrame);
+    EXPECT_EQ(nullptr, queue.nextDue(121, timeLord, &nextWakeup));
+    EXPECT_EQ(125, nextWakeup);
+    EXPECT_EQ(&lateFrame, queue.nextDue(125, timeLord, &nextWakeup));
+    EXPECT_EQ(&background, queue.nextDue(126, timeLord, &nextWakeup));
+    EXPECT_EQ(nullptr, queue.nextDue(126, timeLord, &nextWakeup));
+    EXPECT_EQ(LLONG_MAX, nextWakeup);
+}
+
+TEST(TaskQueue, nextDue_backgroundNotStarved) {
+    TaskQueue queue;
+    TimeLord timeLord;
+    timeLord.setFrameInterval(milliseconds_to_nanoseconds(10));
+    TestTask background(TaskClass::Background, 0);
+    TestTask frame(TaskClass::Frame, 0, milliseconds_to_nanoseconds(500));
+    nsecs_t nextWakeup = 0;
+
+    // A frame always pending would hold the task back forever
+    queue.queue(&frame);
+    queue.queue(&background);
+    EXPECT_EQ(nullptr, queue.nextDue(milliseconds_to_nanoseconds(50), timeLord, &nextWakeup));
+    EXPECT_EQ(milliseconds_to_nanoseconds(100), nextWakeup);
+    EXPECT_EQ(&background,
+            queue.nextDue(milliseconds_to_nanoseconds(100), timeLord, &nextWakeup));
+    EXPECT_TRUE(queue.hasPendingFrame());
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "TessellationCache.h"
+#include "tests/common/TestUtils.h"
+
+using namespace android;
+using namespace android::uirenderer;
+
+TEST(TessellationCache, bucketScale) {
+    EXPECT_EQ(1.0f, TessellationCache::bucketScale(1.0f));
+    EXPECT_EQ(2.0f, TessellationCache::bucketScale(2.0f));
+    // never rounds down, and nearby scales share a bucket
+    EXPECT_LE(1.01f, TessellationCache::bucketScale(1.01f));
+    EXPECT_EQ(TessellationCache::bucketScale(1.01f), TessellationCache::bucketScale(1.02f));
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(TessellationCache, oval_bucketsOnlyNonAAFills) {
+    TessellationCache cache;
+    SkPaint paint;
+    Matrix4 scaled;
+    scaled.loadScale(1.01f, 1.01f, 1);
+    Matrix4 scaledMore;
+    scaledMore.loadScale(1.02f, 1.02f, 1);
+
+    cache.getOval(scaled, paint, 100, 50);
+    cache.getOval(scaledMore, paint, 100, 50);
+    EXPECT_EQ(1u, cache.getHitCount());
+
+    // AA fringes must match the actual scale
+    paint.setAntiAlias(true);
+    cache.getOval(scaled, paint, 100, 50);
+    cache.getOval(scaledMore, paint, 100, 50);
+    EXPECT_EQ(1u, cache.getHitCount());
+
+    // So do hairlines
+    paint.setAntiAlias(false);
+    paint.setStyle(SkPaint::kStroke_Style);
+    paint.setStrokeWidth(0);
+    cache.getOval(scaled, paint, 100, 50);
+    cache.getOval(scaledMore, paint, 100, 50);
+    EXPECT_EQ(1u, cache.getHitCount());
+    EXPECT_EQ(5u, cache.getMissCount());
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(TessellationCache, oval_hitMiss) {
+    TessellationCache cache;
+    SkPaint paint;
+    paint.setAntiAlias(true);
+
+    const VertexBuffer* first = cache.getOval(Matrix4::identity(), paint, 100, 50);
+    ASSERT_NE(nullptr, first);
+    EXPECT_LT(0u, first->getVertexCount());
+    EXPECT_EQ(0u, cache.getHitCount());
+    EXPECT_EQ(1u, cache.getMissCount());
+
+    EXPECT_EQ(first, cache.getOval(Matrix4::identity(), paint, 100, 50));
+    EXPECT_EQ(1u, cache.getHitCount());
+
+    cache.getOval(Matrix4::identity(), paint, 100, 51);
+    EXPECT_EQ(2u, cache.getMissCount());
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(TessellationCache, precache_countedSeparately) {
+    TessellationCache cache;
+    SkPaint paint;
+    paint.setAntiAlias(true);
+
+    cache.precacheOval(Matrix4::identity(), paint, 100, 50);
+    EXPECT_EQ(0u, cache.getPrecacheHitCount());
+    EXPECT_EQ(1u, cache.getPrecacheMissCount());
+
+    // The draw finds the precached buffer, which isn't reuse across frames
+    cache.getOval(Matrix4::identity(), paint, 100, 50);
+    EXPECT_EQ(1u, cache.getHitCount());
+    EXPECT_EQ(0u, cache.getMissCount());
+
+    // Next frame
+    cache.precacheOval(Matrix4::identity(), paint, 100, 50);
+    EXPECT_EQ(1u, cache.getPrecacheHitCount());
+    EXPECT_EQ(1u, cache.getPrecacheMissCount());
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(TessellationCache, shadow_prefetch) {
+    TessellationCache cache;
+    SkPath outline;
+    outline.addRect(0, 0, 100, 100);
+    Matrix4 drawTransform;
+    drawTransform.loadTranslate(10, 20, 0);
+    Matrix4 transformXY;
+    Matrix4 transformZ;
+    transformZ.loadTranslate(0, 0, 8);
+    const Vector3 lightCenter = {540, -200, 800};
+    const Rect localClip(200, 200);
+
+    cache.prefetchShadows(drawTransform, true, &outline, transformXY, transformZ,
+            lightCenter, 50);
+    auto task = cache.getShadowTask(&drawTransform, localClip, true, &outline,
+            &transformXY, &transformZ, lightCenter, 50);
+    EXPECT_TRUE(task->prefetched) << "draw should pick up the prefetched shadow";
+    EXPECT_EQ(1u, cache.getShadowPrefetchHitCount());
+
+    auto buffers = cache.getShadowBuffers(task);
+    EXPECT_LT(0u, buffers.first->getVertexCount());
+    EXPECT_EQ(1u, cache.getShadowDrawCount());
+    EXPECT_LE(cache.getShadowWaitCount(), 1u);
+
+    // A different light, as in a layer, must not match the prefetched shadow
+    const Vector3 otherLightCenter = {0, -200, 800};
+    auto otherTask = cache.getShadowTask(&drawTransform, localClip, true, &outline,
+            &transformXY, &transformZ, otherLightCenter, 50);
+    EXPECT_FALSE(otherTask->prefetched);
+    EXPECT_EQ(1u, cache.getShadowPrefetchHitCount());
+    cache.getShadowBuffers(otherTask);
+
+    cache.clearShadows();
+}
@@ -33,6 +33,11 @@ public:
         mCondition.signal(mType);
     }
 
+    bool isOpened() const {
+        Mutex::Autolock l(mLock);
+        return mOpened;
+    }
+
     void wait() const {
         Mutex::Autolock l(mLock);
         while (!mOpened) {
@@ -39,6 +39,13 @@ public:
         return mResult;
     }
 
+    /**
+     * Returns whether get() would return without blocking.
+     */
+    bool isReady() const {
+        return mBarrier.isOpened();
+    }
+
     /**
      * This method must be called only once.
      */
@@ -41,6 +41,10 @@ public:
         return mFuture->get();
     }
 
+    bool isFinished() const {
+        return mFuture->isReady();
+    }
+
     void setResult(T result) {
         mFuture->produce(result);
     }
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "utils/Macros.h"
+
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+namespace android {
+namespace uirenderer {
+
+/**
+ * Fixed size ring buffer with a single writer and any number of readers, where neither side
+ * ever blocks. Each slot is guarded by a sequence counter (a seqlock): the writer makes it odd
+ * while the slot is being overwritten, and readers discard any slot whose counter changed
+ * while they were copying it out. Slots also record the index of the entry they hold, so a
+ * reader that was lapped by the writer discards the newer entry instead of taking it for the
+ * one it asked for.
+ *
+ * Readers may therefore see fewer than the requested number of entries if the writer laps
+ * them, but never a torn or out of order one. T must be trivially copyable.
+ */
+template<class T, size_t SIZE>
+class ConcurrentRingBuffer {
+    PREVENT_COPY_AND_ASSIGN(ConcurrentRingBuffer);
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+public:
+    ConcurrentRingBuffer() {}
+    ~ConcurrentRingBuffer() {}
+
+    constexpr size_t capacity() const { return SIZE; }
+
+    // Must only be called from the single writer thread
+    void push(const T& value) {
+        uint64_t index = mWriteCount.load(std::memory_order_relaxed);
+        Slot& slot = mSlots[index % SIZE];
+        uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.index.store(index, std::memory_order_relaxed);
+        memcpy(&slot.value, &value, sizeof(T));
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+        mWriteCount.store(index + 1, std::memory_order_release);
+    }
+
+    // Makes the entries pushed so far invisible to readers. Must only be called from the
+    // single writer thread
+    void clear() {
+        mStartCount.store(mWriteCount.load(std::memory_order_relaxed),
+                std::memory_order_release);
+    }
+
+    // Total number of entries ever pushed
+    uint64_t writeCount() const {
+        return mWriteCount.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Copies up to maxCount of the most recent entries into out, oldest first, and returns
+     * the number copied. Safe to call from any thread.
+     */
+    size_t copyRecent(T* out, size_t maxCount) const {
+        const uint64_t start = mStartCount.load(std::memory_order_acquire);
+        const uint64_t end = mWriteCount.load(std::memory_order_acquire);
+        // start was loaded first, so it can't be past end
+        const uint64_t count = std::min<uint64_t>(std::min<uint64_t>(end - start, SIZE), maxCount);
+        size_t copied = 0;
+        for (uint64_t index = end - count; index < end; index++) {
+            const Slot& slot = mSlots[index % SIZE];
+            uint32_t before = slot.sequence.load(std::memory_order_acquire);
+            if (before & 1) continue; // being written right now
+            uint64_t slotIndex = slot.index.load(std::memory_order_relaxed);
+            memcpy(&out[copied], &slot.value, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != before) continue;
+            // The slot was consistent, but may already hold a newer lap's entry
+            if (slotIndex != index) continue;
+            copied++;
+        }
+        return copied;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> sequence{0};
+        std::atomic<uint64_t> index{0};
+        T value;
+    };
+
+    Slot mSlots[SIZE];
+    std::atomic<uint64_t> mWriteCount{0};
+    std::atomic<uint64_t> mStartCount{0};
+};
+
+}; // namespace uirenderer
+}; // namespace android
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "utils/Macros.h"
+
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace android {
+namespace uirenderer {
+
+/**
+ * Insert-only open addressing hash table with linear probing, used to dedup the objects
+ * copied into a DisplayList while recording. Keys and values are stored by pointer and
+ * owned elsewhere, typically by the DisplayList's allocator.
+ *
+ * Several entries may share a hash, so lookups take a predicate that decides whether a
+ * stored key is the one being looked for. clear() keeps the slot storage, so a table that is
+ * refilled for every recording stops allocating once it reaches its working size.
+ */
+template <class Key, class Value>
+class DedupTable {
+    PREVENT_COPY_AND_ASSIGN(DedupTable);
+public:
+    DedupTable() {}
+
+    template <class Matches>
+    const Value* find(uint32_t hash, Matches matches) const {
+        if (mSlots.empty()) return nullptr;
+        const size_t mask = mSlots.size() - 1;
+        for (size_t i = mix(hash) & mask; mSlots[i].value; i = (i + 1) & mask) {
+            const Slot& slot = mSlots[i];
+            if (slot.hash == hash && matches(slot.key)) {
+                return slot.value;
+            }
+        }
+        return nullptr;
+    }
+
+    void insert(uint32_t hash, const Key* key, const Value* value) {
+        // Keep the load factor at or below 3/4
+        if ((mCount + 1) * 4 > mSlots.size() * 3) {
+            grow();
+        }
+        place({hash, key, value});
+        mCount++;
+    }
+
+    void clear() {
+        if (mCount) {
+            std::fill(mSlots.begin(), mSlots.end(), Slot());
+            mCount = 0;
+        }
+    }
+
+    size_t size() const { return mCount; }
+    size_t capacity() const { return mSlots.size(); }
+
+    static uint32_t hashPointer(const void* ptr) {
+        uintptr_t bits = reinterpret_cast<uintptr_t>(ptr);
+        return static_cast<uint32_t>(bits ^ (static_cast<uint64_t>(bits) >> 32));
+    }
+
+private:
+    static constexpr size_t kMinCapacity = 16;
+
+    struct Slot {
+        uint32_t hash;
+        const Key* key;
+        const Value* value;
+    };
+
+    // Paint hashes are well distributed, but generation IDs are sequential and pointers are
+    // aligned, so spread every hash over the low bits used for indexing
+    static uint32_t mix(uint32_t hash) {
+        hash ^= hash >> 16;
+        hash *= 0x85ebca6b;
+        hash ^= hash >> 13;
+        hash *= 0xc2b2ae35;
+        hash ^= hash >> 16;
+        return hash;
+    }
+
+    void place(const Slot& slot) {
+        const size_t mask = mSlots.size() - 1;
+        size_t i = mix(slot.hash) & mask;
+        while (mSlots[i].value) {
+            i = (i + 1) & mask;
+        }
+        mSlots[i] = slot;
+    }
+
+    void grow() {
+        size_t capacity = mSlots.empty() ? kMinCapacity : mSlots.size() * 2;
+        std::vector<Slot> oldSlots(capacity, Slot());
+        mSlots.swap(oldSlots);
+        for (const Slot& slot : oldSlots) {
+            if (slot.value) {
+                place(slot);
+            }
+        }
+    }
+
+    std::vector<Slot> mSlots;
+    size_t mCount = 0;
+};
+
+}; // namespace uirenderer
+}; // namespace android
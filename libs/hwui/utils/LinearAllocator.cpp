@@ -30,6 +30,9 @@
 #include <stdlib.h>
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <atomic>
+
 
 // The ideal size of a page allocation (these need to be multiples of 8)
 #define INITIAL_PAGE_SIZE ((size_t)512) // 512b
@@ -42,6 +45,10 @@
 // Must be smaller than INITIAL_PAGE_SIZE
 #define MAX_WASTE_RATIO (0.5f)
 
+// How many calls to reset() make up one window when tracking the peak number of pages used.
+// At the end of each window, retained pages beyond that peak are freed.
+#define RESET_SHRINK_INTERVAL 16
+
 #if ALIGN_DOUBLE
 #define ALIGN_SZ (sizeof(double))
 #else
@@ -84,15 +91,22 @@ static void _addAllocation(int count) {
 namespace android {
 namespace uirenderer {
 
+static std::atomic<size_t> sPageAllocations(0);
+
 class LinearAllocator::Page {
 public:
     Page* next() { return mNextPage; }
     void setNext(Page* next) { mNextPage = next; }
 
-    Page()
+    Page(size_t pageSize, bool dedicated)
         : mNextPage(0)
+        , mPageSize(pageSize)
+        , mDedicated(dedicated)
     {}
 
+    size_t pageSize() const { return mPageSize; }
+    bool isDedicated() const { return mDedicated; }
+
     void* operator new(size_t /*size*/, void* buf) { return buf; }
 
     void* start() {
@@ -106,6 +120,8 @@ public:
 private:
     Page(const Page& /*other*/) {}
     Page* mNextPage;
+    size_t mPageSize;
+    bool mDedicated;
 };
 
 LinearAllocator::LinearAllocator()
@@ -140,7 +156,7 @@ void* LinearAllocator::start(Page* p) {
 }
 
 void* LinearAllocator::end(Page* p) {
-    return ((char*)p) + mPageSize;
+    return ((char*)p) + p->pageSize();
 }
 
 bool LinearAllocator::fitsInCurrentPage(size_t size) {
@@ -150,6 +166,17 @@ bool LinearAllocator::fitsInCurrentPage(size_t size) {
 void LinearAllocator::ensureNext(size_t size) {
     if (fitsInCurrentPage(size)) return;
 
+    // Move on to a page kept by reset() if there is one left. These were already counted
+    // as wasted space when they were retained.
+    Page* retained = mCurrentPage ? mCurrentPage->next() : mPages;
+    if (retained) {
+        mPageSize = retained->pageSize();
+        mMaxAllocSize = mPageSize * MAX_WASTE_RATIO;
+        mCurrentPage = retained;
+        mNext = start(mCurrentPage);
+        return;
+    }
+
     if (mCurrentPage && mPageSize < MAX_PAGE_SIZE) {
         mPageSize = min(MAX_PAGE_SIZE, mPageSize * 2);
         mMaxAllocSize = mPageSize * MAX_WASTE_RATIO;
@@ -172,7 +199,7 @@ void* LinearAllocator::allocImpl(size_t size) {
     if (size > mMaxAllocSize && !fitsInCurrentPage(size)) {
         ALOGV("Exceeded max size %zu > %zu", size, mMaxAllocSize);
         // Allocation is too large, create a dedicated page for the allocation
-        Page* page = newPage(size);
+        Page* page = newPage(size, true);
         mDedicatedPageCount++;
         page->setNext(mPages);
         mPages = page;
@@ -232,13 +259,85 @@ void LinearAllocator::rewindIfLastAlloc(void* ptr, size_t allocSize) {
     }
 }
 
-LinearAllocator::Page* LinearAllocator::newPage(size_t pageSize) {
-    pageSize = ALIGN(pageSize + sizeof(LinearAllocator::Page));
+LinearAllocator::Page* LinearAllocator::newPage(size_t pageSize, bool dedicated) {
+    size_t allocSize = ALIGN(pageSize + sizeof(LinearAllocator::Page));
     ADD_ALLOCATION();
-    mTotalAllocated += pageSize;
+    sPageAllocations.fetch_add(1, std::memory_order_relaxed);
+    mTotalAllocated += allocSize;
     mPageCount++;
-    void* buf = malloc(pageSize);
-    return new (buf) Page();
+    void* buf = malloc(allocSize);
+    return new (buf) Page(pageSize, dedicated);
+}
+
+void LinearAllocator::freePage(Page* page) {
+    mTotalAllocated -= ALIGN(page->pageSize() + sizeof(LinearAllocator::Page));
+    mPageCount--;
+    if (page->isDedicated()) {
+        mDedicatedPageCount--;
+    }
+    page->~Page();
+    free(page);
+    RM_ALLOCATION();
+}
+
+void LinearAllocator::reset() {
+    while (mDtorList) {
+        auto node = mDtorList;
+        mDtorList = node->next;
+        node->dtor(node->addr);
+    }
+
+    // Regular pages appear in mPages in the order they were allocated, with dedicated pages
+    // mixed in ahead of them. Count how many regular pages this round got through.
+    size_t regularCount = 0;
+    size_t pagesUsed = 0;
+    for (Page* p = mPages; p; p = p->next()) {
+        if (p->isDedicated()) continue;
+        regularCount++;
+        if (p == mCurrentPage) {
+            pagesUsed = regularCount;
+        }
+    }
+
+    size_t pagesToKeep = regularCount;
+    mPeakPagesUsed = std::max(mPeakPagesUsed, pagesUsed);
+    if (++mResetCount % RESET_SHRINK_INTERVAL == 0) {
+        pagesToKeep = mPeakPagesUsed;
+        mPeakPagesUsed = 0;
+    }
+
+    Page* head = nullptr;
+    Page* tail = nullptr;
+    size_t kept = 0;
+    Page* p = mPages;
+    while (p) {
+        Page* next = p->next();
+        if (p->isDedicated() || kept >= pagesToKeep) {
+            freePage(p);
+        } else {
+            p->setNext(nullptr);
+            if (tail) {
+                tail->setNext(p);
+            } else {
+                head = p;
+            }
+            tail = p;
+            kept++;
+        }
+        p = next;
+    }
+
+    mPages = head;
+    mCurrentPage = nullptr;
+    mNext = nullptr;
+    mPageSize = head ? head->pageSize() : INITIAL_PAGE_SIZE;
+    mMaxAllocSize = mPageSize * MAX_WASTE_RATIO;
+    // Everything still held is unused until ensureNext() hands it out again
+    mWastedSpace = mTotalAllocated;
+}
+
+size_t LinearAllocator::totalPageAllocations() {
+    return sPageAllocations.load(std::memory_order_relaxed);
 }
 
 static const char* toSize(size_t value, float& result) {
@@ -105,6 +105,14 @@ public:
         rewindIfLastAlloc((void*)ptr, sizeof(T));
     }
 
+    /**
+     * Runs all pending destructors and forgets every allocation, but keeps the regular pages
+     * around so that the next round of allocations doesn't have to malloc them again. Pages
+     * beyond the peak usage seen over the last few resets are freed, so a single large
+     * recording doesn't pin its memory forever. Dedicated pages are always freed.
+     */
+    void reset();
+
     /**
      * Dump memory usage statistics to the log (allocated and wasted space)
      */
@@ -116,6 +124,17 @@ public:
      */
     size_t usedSize() const { return mTotalAllocated - mWastedSpace; }
 
+    /**
+     * The number of bytes of pages currently held by the LinearAllocator, including pages
+     * retained across reset()
+     */
+    size_t allocatedSize() const { return mTotalAllocated; }
+
+    /**
+     * The number of pages malloc'd by all LinearAllocators in the process since it started
+     */
+    static size_t totalPageAllocations();
+
 private:
     LinearAllocator(const LinearAllocator& other);
 
@@ -131,7 +150,8 @@ private:
 
     void addToDestructionList(Destructor, void* addr);
     void runDestructorFor(void* addr);
-    Page* newPage(size_t pageSize);
+    Page* newPage(size_t pageSize, bool dedicated = false);
+    void freePage(Page* page);
     bool fitsInCurrentPage(size_t size);
     void ensureNext(size_t size);
     void* start(Page *p);
@@ -149,6 +169,10 @@ private:
     size_t mWastedSpace;
     size_t mPageCount;
     size_t mDedicatedPageCount;
+
+    // High water mark of regular pages used between resets, see reset()
+    size_t mPeakPagesUsed = 0;
+    size_t mResetCount = 0;
 };
 
 template <class T>
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "utils/Macros.h"
+
+#include <utils/Errors.h>
+#include <utils/Mutex.h>
+
+#include <atomic>
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace uirenderer {
+
+/**
+ * Hands items released on any thread (the UI thread tearing down display lists, finalizers)
+ * over to a cache that is only touched on the RenderThread, which drops them at its next
+ * frame.
+ *
+ * Each pushing thread maps to one of STRIPES lists, each with its own lock, so producers
+ * rarely wait on each other. drain() only holds a stripe's lock long enough to swap its
+ * list out, so the owner's work on the items never blocks a producer. Items pushed by one
+ * thread keep their order, there is no order between threads.
+ *
+ * Lock acquisitions that had to wait are counted, to tell whether striping is paying off.
+ */
+template <class T, size_t STRIPES = 4>
+class StripedGarbageQueue {
+    PREVENT_COPY_AND_ASSIGN(StripedGarbageQueue);
+public:
+    StripedGarbageQueue() {}
+
+    void push(const T& item) {
+        Stripe& stripe = mStripes[std::hash<std::thread::id>()(std::this_thread::get_id())
+                % STRIPES];
+        lock(stripe);
+        stripe.items.push_back(item);
+        stripe.lock.unlock();
+    }
+
+    // Appends every pending item to outItems
+    void drain(std::vector<T>* outItems) {
+        std::vector<T> items;
+        for (Stripe& stripe : mStripes) {
+            lock(stripe);
+            items.swap(stripe.items);
+            stripe.lock.unlock();
+            outItems->insert(outItems->end(), items.begin(), items.end());
+            items.clear();
+        }
+    }
+
+    uint32_t lockCount() const {
+        uint32_t count = 0;
+        for (const Stripe& stripe : mStripes) {
+            count += stripe.lockCount.load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+    uint32_t contendedCount() const {
+        uint32_t count = 0;
+        for (const Stripe& stripe : mStripes) {
+            count += stripe.contendedCount.load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+private:
+    // Each stripe gets its own cache line, so that producers on different stripes don't
+    // bounce a shared line between cores. The counters are only written with the lock held.
+    struct alignas(64) Stripe {
+        Mutex lock;
+        std::vector<T> items;
+        std::atomic<uint32_t> lockCount{0};
+        std::atomic<uint32_t> contendedCount{0};
+    };
+
+    void lock(Stripe& stripe) {
+        bool contended = stripe.lock.tryLock() != NO_ERROR;
+        if (contended) {
+            stripe.lock.lock();
+        }
+        increment(stripe.lockCount);
+        if (contended) {
+            increment(stripe.contendedCount);
+        }
+    }
+
+    // Not an atomic read-modify-write, the stripe's lock already serializes writers
+    static void increment(std::atomic<uint32_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    Stripe mStripes[STRIPES];
+};
+
+}; // namespace uirenderer
+}; // namespace android
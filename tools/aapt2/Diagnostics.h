@@ -20,6 +20,8 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "android-base/macros.h"
 #include "androidfw/StringPiece.h"
@@ -142,6 +144,38 @@ class SourcePathDiagnostics : public IDiagnostics {
   DISALLOW_COPY_AND_ASSIGN(SourcePathDiagnostics);
 };
 
+// Holds on to every message until Replay(), so that work done on another thread can report
+// its messages later, in a deterministic order.
+class BufferedDiagnostics : public IDiagnostics {
+ public:
+  BufferedDiagnostics() = default;
+
+  void Log(Level level, DiagMessageActual& actual_msg) override {
+    if (level == Level::Error) {
+      had_error_ = true;
+    }
+    messages_.push_back(std::make_pair(level, actual_msg));
+  }
+
+  bool HadError() const {
+    return had_error_;
+  }
+
+  // Logs the buffered messages to diag, in the order they were received, and forgets them.
+  void Replay(IDiagnostics* diag) {
+    for (auto& message : messages_) {
+      diag->Log(message.first, message.second);
+    }
+    messages_.clear();
+  }
+
+ private:
+  std::vector<std::pair<Level, DiagMessageActual>> messages_;
+  bool had_error_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(BufferedDiagnostics);
+};
+
 }  // namespace aapt
 
 #endif /* AAPT_DIAGNOSTICS_H */
@@ -107,7 +107,7 @@ bool LoadedApk::WriteToArchive(IAaptContext* context, const TableFlattenerOption
 
     } else {
       uint32_t compression_flags = file->WasCompressed() ? ArchiveEntry::kCompress : 0u;
-      if (!io::CopyFileToArchive(context, file, path, compression_flags, writer)) {
+      if (!CopyFileToArchive(context, file, path, compression_flags, writer)) {
         return false;
       }
     }
@@ -115,4 +115,11 @@ bool LoadedApk::WriteToArchive(IAaptContext* context, const TableFlattenerOption
   return true;
 }
 
+bool LoadedApk::CopyFileToArchive(IAaptContext* context, io::IFile* file,
+                                  const std::string& out_path, uint32_t compression_flags,
+                                  IArchiveWriter* writer) {
+  std::lock_guard<std::mutex> lock(copy_lock_);
+  return io::CopyFileToArchive(context, file, out_path, compression_flags, writer);
+}
+
 }  // namespace aapt
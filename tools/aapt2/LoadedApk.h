@@ -17,6 +17,8 @@
 #ifndef AAPT_LOADEDAPK_H
 #define AAPT_LOADEDAPK_H
 
+#include <mutex>
+
 #include "androidfw/StringPiece.h"
 
 #include "ResourceTable.h"
@@ -49,6 +51,13 @@ class LoadedApk {
   bool WriteToArchive(IAaptContext* context, const TableFlattenerOptions& options,
                       IArchiveWriter* writer);
 
+  /**
+   * Copies a file of this APK to writer. The APK's archive may not be read from several threads
+   * at once, so copies are made one at a time and this can be called from any thread.
+   */
+  bool CopyFileToArchive(IAaptContext* context, io::IFile* file, const std::string& out_path,
+                         uint32_t compression_flags, IArchiveWriter* writer);
+
   static std::unique_ptr<LoadedApk> LoadApkFromPath(IAaptContext* context,
                                                     const android::StringPiece& path);
 
@@ -56,6 +65,7 @@ class LoadedApk {
   Source source_;
   std::unique_ptr<io::IFileCollection> apk_;
   std::unique_ptr<ResourceTable> table_;
+  std::mutex copy_lock_;
 
   DISALLOW_COPY_AND_ASSIGN(LoadedApk);
 };
@@ -15,23 +15,18 @@
  */
 
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include "androidfw/StringPiece.h"
 
 #include "Diagnostics.h"
+#include "util/Util.h"
 
 namespace aapt {
 
-// DO NOT UPDATE, this is more of a marketing version.
-static const char* sMajorVersion = "2";
-
-// Update minor version whenever a feature or flag is added.
-static const char* sMinorVersion = "16";
-
 int PrintVersion() {
-  std::cerr << "Android Asset Packaging Tool (aapt) " << sMajorVersion << "."
-            << sMinorVersion << std::endl;
+  std::cerr << util::GetToolName() << std::endl;
   return 0;
 }
 
@@ -40,6 +35,85 @@ extern int Link(const std::vector<android::StringPiece>& args, IDiagnostics* dia
 extern int Dump(const std::vector<android::StringPiece>& args);
 extern int Diff(const std::vector<android::StringPiece>& args);
 extern int Optimize(const std::vector<android::StringPiece>& args);
+extern void KeepLinkInputsLoaded(bool keep);
+
+static void PrintUsage() {
+  std::cerr << "\nusage: aapt2 [compile|link|dump|diff|optimize|daemon|version] ..."
+            << std::endl;
+}
+
+// Runs a single command. Returns -1 if the command is unknown.
+static int ExecuteCommand(const android::StringPiece& command,
+                          const std::vector<android::StringPiece>& args) {
+  if (command == "compile" || command == "c") {
+    StdErrDiagnostics diagnostics;
+    return Compile(args, &diagnostics);
+  } else if (command == "link" || command == "l") {
+    StdErrDiagnostics diagnostics;
+    return Link(args, &diagnostics);
+  } else if (command == "dump" || command == "d") {
+    return Dump(args);
+  } else if (command == "diff") {
+    return Diff(args);
+  } else if (command == "optimize") {
+    return Optimize(args);
+  } else if (command == "version") {
+    return PrintVersion();
+  }
+  std::cerr << "unknown command '" << command << "'\n";
+  return -1;
+}
+
+// Prefix of the status lines printed by the daemon, which no diagnostic starts with.
+constexpr static const char* kDaemonStatusPrefix = "[aapt2 daemon] ";
+
+// Prints a daemon status line to stderr, after the diagnostics of the command it is about. The
+// output of the command on stdout is flushed first, so that it is complete when the status is read.
+static void PrintDaemonStatus(const char* status) {
+  std::cout.flush();
+  std::cerr << kDaemonStatusPrefix << status << std::endl;
+}
+
+// Runs the commands read from stdin in the same process, so that what links load from the
+// include paths and static libraries stays loaded from one command to the next. Each command is
+// given as its name followed by its arguments, one per line, and ends with an empty line.
+//
+// Status lines go to stderr, prefixed with kDaemonStatusPrefix: "Ready" once commands are read,
+// then for each command "Done" after its diagnostics, preceded by "Error" if it failed. The daemon
+// exits on EOF or on the command "quit".
+static int RunDaemon() {
+  KeepLinkInputsLoaded(true);
+  PrintDaemonStatus("Ready");
+
+  while (true) {
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(std::cin, line) && !line.empty();) {
+      lines.push_back(line);
+    }
+
+    if (lines.empty()) {
+      if (!std::cin) {
+        break;
+      }
+      continue;
+    }
+
+    if (lines[0] == "quit") {
+      break;
+    }
+
+    std::vector<android::StringPiece> args(lines.begin() + 1, lines.end());
+    if (ExecuteCommand(lines[0], args) != 0) {
+      PrintDaemonStatus("Error");
+    }
+    PrintDaemonStatus("Done");
+
+    if (!std::cin) {
+      break;
+    }
+  }
+  return 0;
+}
 
 }  // namespace aapt
 
@@ -54,27 +128,18 @@ int main(int argc, char** argv) {
     }
 
     android::StringPiece command(argv[0]);
-    if (command == "compile" || command == "c") {
-      aapt::StdErrDiagnostics diagnostics;
-      return aapt::Compile(args, &diagnostics);
-    } else if (command == "link" || command == "l") {
-      aapt::StdErrDiagnostics diagnostics;
-      return aapt::Link(args, &diagnostics);
-    } else if (command == "dump" || command == "d") {
-      return aapt::Dump(args);
-    } else if (command == "diff") {
-      return aapt::Diff(args);
-    } else if (command == "optimize") {
-      return aapt::Optimize(args);
-    } else if (command == "version") {
-      return aapt::PrintVersion();
+    if (command == "daemon") {
+      return aapt::RunDaemon();
+    }
+
+    int result = aapt::ExecuteCommand(command, args);
+    if (result != -1) {
+      return result;
     }
-    std::cerr << "unknown command '" << command << "'\n";
   } else {
     std::cerr << "no command specified\n";
   }
 
-  std::cerr << "\nusage: aapt2 [compile|link|dump|diff|optimize|version] ..."
-            << std::endl;
+  aapt::PrintUsage();
   return 1;
 }
@@ -24,6 +24,7 @@
 #include <android-base/logging.h>
 #include <androidfw/ResourceTypes.h>
 #include <algorithm>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -115,6 +116,12 @@ ResourceEntry* ResourceTableType::FindEntry(const StringPiece& name) {
 }
 
 ResourceEntry* ResourceTableType::FindOrCreateEntry(const StringPiece& name) {
+  // Entries are often created in order, when reading a table or merging one.
+  if (entries.empty() || less_than_struct_with_name<ResourceEntry>(entries.back(), name)) {
+    entries.push_back(util::make_unique<ResourceEntry>(name));
+    return entries.back().get();
+  }
+
   auto last = entries.end();
   auto iter =
       std::lower_bound(entries.begin(), last, name, less_than_struct_with_name<ResourceEntry>);
@@ -124,6 +131,24 @@ ResourceEntry* ResourceTableType::FindOrCreateEntry(const StringPiece& name) {
   return entries.emplace(iter, new ResourceEntry(name))->get();
 }
 
+void ResourceTableType::InsertEntries(std::vector<std::unique_ptr<ResourceEntry>>* new_entries) {
+  auto less_than_entry = [](const std::unique_ptr<ResourceEntry>& lhs,
+                            const std::unique_ptr<ResourceEntry>& rhs) -> bool {
+    return lhs->name < rhs->name;
+  };
+
+  if (!std::is_sorted(new_entries->begin(), new_entries->end(), less_than_entry)) {
+    std::sort(new_entries->begin(), new_entries->end(), less_than_entry);
+  }
+
+  const size_t old_size = entries.size();
+  entries.reserve(old_size + new_entries->size());
+  std::move(new_entries->begin(), new_entries->end(), std::back_inserter(entries));
+  new_entries->clear();
+  std::inplace_merge(entries.begin(), entries.begin() + old_size, entries.end(),
+                     less_than_entry);
+}
+
 ResourceConfigValue* ResourceEntry::FindValue(const ConfigDescription& config) {
   return FindValue(config, StringPiece());
 }
@@ -156,6 +181,11 @@ ResourceConfigValue* ResourceEntry::FindValue(const ConfigDescription& config,
 
 ResourceConfigValue* ResourceEntry::FindOrCreateValue(const ConfigDescription& config,
                                                       const StringPiece& product) {
+  if (values.empty() || ltConfigKeyRef(values.back(), ConfigKey{&config, product})) {
+    values.push_back(util::make_unique<ResourceConfigValue>(config, product));
+    return values.back().get();
+  }
+
   auto iter =
       std::lower_bound(values.begin(), values.end(), ConfigKey{&config, product}, ltConfigKeyRef);
   if (iter != values.end()) {
@@ -157,6 +157,14 @@ class ResourceTableType {
   ResourceEntry* FindEntry(const android::StringPiece& name);
   ResourceEntry* FindOrCreateEntry(const android::StringPiece& name);
 
+  /**
+   * Moves new_entries into this type, keeping entries sorted. None of them
+   * may exist in this type already. Adding many entries this way costs a
+   * single merge, instead of shifting the entries after each insertion as
+   * FindOrCreateEntry() does.
+   */
+  void InsertEntries(std::vector<std::unique_ptr<ResourceEntry>>* new_entries);
+
  private:
   DISALLOW_COPY_AND_ASSIGN(ResourceTableType);
 };
@@ -144,4 +144,24 @@ TEST(ResourceTableTest, ProductVaryingValues) {
   EXPECT_EQ(std::string("tablet"), values[1]->product);
 }
 
+TEST(ResourceTableTest, InsertEntriesKeepsEntriesSorted) {
+  ResourceTableType type(ResourceType::kString);
+  type.FindOrCreateEntry("b");
+  type.FindOrCreateEntry("d");
+
+  std::vector<std::unique_ptr<ResourceEntry>> new_entries;
+  new_entries.push_back(util::make_unique<ResourceEntry>("e"));
+  new_entries.push_back(util::make_unique<ResourceEntry>("a"));
+  new_entries.push_back(util::make_unique<ResourceEntry>("c"));
+  type.InsertEntries(&new_entries);
+  EXPECT_TRUE(new_entries.empty());
+
+  std::vector<std::string> names;
+  for (const auto& entry : type.entries) {
+    names.push_back(entry->name);
+  }
+  EXPECT_EQ((std::vector<std::string>{"a", "b", "c", "d", "e"}), names);
+  EXPECT_EQ(type.entries[2].get(), type.FindEntry("c"));
+}
+
 }  // namespace aapt
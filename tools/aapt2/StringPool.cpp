@@ -17,6 +17,7 @@
 #include "StringPool.h"
 
 #include <algorithm>
+#include <map>
 #include <memory>
 #include <string>
 
@@ -170,15 +171,18 @@ StringPool::Ref StringPool::MakeRefImpl(const StringPiece& str,
       return Ref(iter->second);
     }
   }
+  return Ref(NewEntry(str, context));
+}
 
-  Entry* entry = new Entry();
+StringPool::Entry* StringPool::NewEntry(const StringPiece& str, const Context& context) {
+  Entry* entry = entry_arena_.Allocate();
   entry->value = str.to_string();
   entry->context = context;
   entry->index = strings_.size();
   entry->ref_ = 0;
-  strings_.emplace_back(entry);
+  strings_.push_back(entry);
   indexed_strings_.insert(std::make_pair(StringPiece(entry->value), entry));
-  return Ref(entry);
+  return entry;
 }
 
 StringPool::StyleRef StringPool::MakeRef(const StyleString& str) {
@@ -187,54 +191,42 @@ StringPool::StyleRef StringPool::MakeRef(const StyleString& str) {
 
 StringPool::StyleRef StringPool::MakeRef(const StyleString& str,
                                          const Context& context) {
-  Entry* entry = new Entry();
-  entry->value = str.str;
-  entry->context = context;
-  entry->index = strings_.size();
-  entry->ref_ = 0;
-  strings_.emplace_back(entry);
-  indexed_strings_.insert(std::make_pair(StringPiece(entry->value), entry));
+  Entry* entry = NewEntry(str.str, context);
 
-  StyleEntry* style_entry = new StyleEntry();
+  StyleEntry* style_entry = style_arena_.Allocate();
   style_entry->str = Ref(entry);
   for (const aapt::Span& span : str.spans) {
     style_entry->spans.emplace_back(
         Span{MakeRef(span.name), span.first_char, span.last_char});
   }
   style_entry->ref_ = 0;
-  styles_.emplace_back(style_entry);
+  styles_.push_back(style_entry);
   return StyleRef(style_entry);
 }
 
 StringPool::StyleRef StringPool::MakeRef(const StyleRef& ref) {
-  Entry* entry = new Entry();
-  entry->value = *ref.entry_->str;
-  entry->context = ref.entry_->str.entry_->context;
-  entry->index = strings_.size();
-  entry->ref_ = 0;
-  strings_.emplace_back(entry);
-  indexed_strings_.insert(std::make_pair(StringPiece(entry->value), entry));
+  Entry* entry = NewEntry(*ref.entry_->str, ref.entry_->str.entry_->context);
 
-  StyleEntry* style_entry = new StyleEntry();
+  StyleEntry* style_entry = style_arena_.Allocate();
   style_entry->str = Ref(entry);
   for (const Span& span : ref.entry_->spans) {
     style_entry->spans.emplace_back(
         Span{MakeRef(*span.name), span.first_char, span.last_char});
   }
   style_entry->ref_ = 0;
-  styles_.emplace_back(style_entry);
+  styles_.push_back(style_entry);
   return StyleRef(style_entry);
 }
 
 void StringPool::Merge(StringPool&& pool) {
+  entry_arena_.Merge(std::move(pool.entry_arena_));
+  style_arena_.Merge(std::move(pool.style_arena_));
   indexed_strings_.insert(pool.indexed_strings_.begin(),
                           pool.indexed_strings_.end());
   pool.indexed_strings_.clear();
-  std::move(pool.strings_.begin(), pool.strings_.end(),
-            std::back_inserter(strings_));
+  strings_.insert(strings_.end(), pool.strings_.begin(), pool.strings_.end());
   pool.strings_.clear();
-  std::move(pool.styles_.begin(), pool.styles_.end(),
-            std::back_inserter(styles_));
+  styles_.insert(styles_.end(), pool.styles_.begin(), pool.styles_.end());
   pool.styles_.clear();
 
   // Assign the indices.
@@ -261,19 +253,21 @@ void StringPool::Prune() {
   }
 
   auto end_iter2 =
-      std::remove_if(strings_.begin(), strings_.end(),
-                     [](const std::unique_ptr<Entry>& entry) -> bool {
-                       return entry->ref_ <= 0;
-                     });
+      std::stable_partition(strings_.begin(), strings_.end(),
+                     [](const Entry* entry) -> bool { return entry->ref_ > 0; });
 
   auto end_iter3 =
-      std::remove_if(styles_.begin(), styles_.end(),
-                     [](const std::unique_ptr<StyleEntry>& entry) -> bool {
-                       return entry->ref_ <= 0;
-                     });
+      std::stable_partition(styles_.begin(), styles_.end(),
+                     [](const StyleEntry* entry) -> bool { return entry->ref_ > 0; });
 
-  // Remove the entries at the end or else we'll be accessing
-  // a deleted string from the StyleEntry.
+  // Release the styles last. Their strings are still referenced by them, so none of them
+  // were pruned here.
+  for (auto iter = end_iter2; iter != strings_.end(); ++iter) {
+    entry_arena_.Release(*iter);
+  }
+  for (auto iter = end_iter3; iter != styles_.end(); ++iter) {
+    style_arena_.Release(*iter);
+  }
   strings_.erase(end_iter2, strings_.end());
   styles_.erase(end_iter3, styles_.end());
 
@@ -286,11 +280,28 @@ void StringPool::Prune() {
 
 void StringPool::Sort(
     const std::function<bool(const Entry&, const Entry&)>& cmp) {
-  std::sort(
-      strings_.begin(), strings_.end(),
-      [&cmp](const std::unique_ptr<Entry>& a,
-             const std::unique_ptr<Entry>& b) -> bool { return cmp(*a, *b); });
+  std::sort(strings_.begin(), strings_.end(),
+            [&cmp](const Entry* a, const Entry* b) -> bool { return cmp(*a, *b); });
+  AssignIndicesAndSortStyles();
+}
+
+void StringPool::Sort() {
+  std::map<std::pair<uint32_t, ConfigDescription>, std::vector<Entry*>> buckets;
+  for (Entry* entry : strings_) {
+    buckets[std::make_pair(entry->context.priority, entry->context.config)].push_back(entry);
+  }
+
+  strings_.clear();
+  for (auto& bucket : buckets) {
+    std::vector<Entry*>& entries = bucket.second;
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry* a, const Entry* b) -> bool { return a->value < b->value; });
+    strings_.insert(strings_.end(), entries.begin(), entries.end());
+  }
+  AssignIndicesAndSortStyles();
+}
 
+void StringPool::AssignIndicesAndSortStyles() {
   // Assign the indices.
   const size_t len = strings_.size();
   for (size_t index = 0; index < len; index++) {
@@ -299,8 +310,7 @@ void StringPool::Sort(
 
   // Reorder the styles.
   std::sort(styles_.begin(), styles_.end(),
-            [](const std::unique_ptr<StyleEntry>& lhs,
-               const std::unique_ptr<StyleEntry>& rhs) -> bool {
+            [](const StyleEntry* lhs, const StyleEntry* rhs) -> bool {
               return lhs->str.index() < rhs->str.index();
             });
 }
@@ -18,6 +18,7 @@
 #define AAPT_STRING_POOL_H
 
 #include <functional>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -143,7 +144,7 @@ class StringPool {
     int ref_;
   };
 
-  using const_iterator = std::vector<std::unique_ptr<Entry>>::const_iterator;
+  using const_iterator = std::vector<Entry*>::const_iterator;
 
   static bool FlattenUtf8(BigBuffer* out, const StringPool& pool);
   static bool FlattenUtf16(BigBuffer* out, const StringPool& pool);
@@ -204,6 +205,13 @@ class StringPool {
    */
   void Sort(const std::function<bool(const Entry&, const Entry&)>& cmp);
 
+  /**
+   * Sorts the strings by priority, then by configuration, then by value. This is the
+   * order in which resource tables are written. Strings are bucketed by context first,
+   * so configurations are only compared between buckets and values within a bucket.
+   */
+  void Sort();
+
   /**
    * Removes any strings that have no references.
    */
@@ -212,15 +220,50 @@ class StringPool {
  private:
   DISALLOW_COPY_AND_ASSIGN(StringPool);
 
+  /**
+   * Allocates objects in blocks rather than one at a time. Released objects are
+   * reset and handed out again, and all blocks are freed with the arena.
+   */
+  template <typename T>
+  class Arena {
+   public:
+    Arena() = default;
+    Arena(Arena&&) = default;
+    Arena& operator=(Arena&&) = default;
+
+    T* Allocate();
+    void Release(T* object);
+
+    /**
+     * Takes over the blocks of another arena, which must not be used again.
+     */
+    void Merge(Arena&& other);
+
+   private:
+    DISALLOW_COPY_AND_ASSIGN(Arena);
+
+    static constexpr size_t kBlockSize = 256u;
+
+    std::vector<std::unique_ptr<T[]>> blocks_;
+    size_t used_in_last_block_ = kBlockSize;
+    std::vector<T*> released_;
+  };
+
   friend const_iterator begin(const StringPool& pool);
   friend const_iterator end(const StringPool& pool);
 
   static bool Flatten(BigBuffer* out, const StringPool& pool, bool utf8);
 
   Ref MakeRefImpl(const android::StringPiece& str, const Context& context, bool unique);
+  Entry* NewEntry(const android::StringPiece& str, const Context& context);
+  void AssignIndicesAndSortStyles();
 
-  std::vector<std::unique_ptr<Entry>> strings_;
-  std::vector<std::unique_ptr<StyleEntry>> styles_;
+  // Styles hold references to strings, so they must be destroyed first.
+  Arena<Entry> entry_arena_;
+  Arena<StyleEntry> style_arena_;
+
+  std::vector<Entry*> strings_;
+  std::vector<StyleEntry*> styles_;
   std::unordered_multimap<android::StringPiece, Entry*> indexed_strings_;
 };
 
@@ -230,6 +273,42 @@ class StringPool {
 
 inline size_t StringPool::size() const { return strings_.size(); }
 
+template <typename T>
+T* StringPool::Arena<T>::Allocate() {
+  if (!released_.empty()) {
+    T* object = released_.back();
+    released_.pop_back();
+    return object;
+  }
+
+  if (used_in_last_block_ == kBlockSize) {
+    blocks_.emplace_back(new T[kBlockSize]);
+    used_in_last_block_ = 0u;
+  }
+  return &blocks_.back()[used_in_last_block_++];
+}
+
+template <typename T>
+void StringPool::Arena<T>::Release(T* object) {
+  *object = T();
+  released_.push_back(object);
+}
+
+template <typename T>
+void StringPool::Arena<T>::Merge(Arena&& other) {
+  // The other blocks go first, so that the last block, which is the only one with room
+  // left in it, stays the same.
+  if (blocks_.empty()) {
+    used_in_last_block_ = other.used_in_last_block_;
+  }
+  blocks_.insert(blocks_.begin(), std::make_move_iterator(other.blocks_.begin()),
+                 std::make_move_iterator(other.blocks_.end()));
+  released_.insert(released_.end(), other.released_.begin(), other.released_.end());
+  other.blocks_.clear();
+  other.released_.clear();
+  other.used_in_last_block_ = kBlockSize;
+}
+
 inline StringPool::const_iterator begin(const StringPool& pool) {
   return pool.strings_.begin();
 }
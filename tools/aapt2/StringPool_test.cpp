@@ -140,6 +140,49 @@ TEST(StringPoolTest, SortAndStillDedupe) {
   EXPECT_EQ(ref6.index(), ref3.index());
 }
 
+TEST(StringPoolTest, SortByContextThenValue) {
+  StringPool pool;
+
+  const ConfigDescription land = test::ParseConfigOrDie("land");
+  StringPool::Ref ref = pool.MakeRef("b", StringPool::Context(land));
+  StringPool::Ref ref2 = pool.MakeRef("z");
+  StringPool::Ref ref3 = pool.MakeRef("a", StringPool::Context(land));
+  StringPool::Ref ref4 = pool.MakeRef("y", StringPool::Context(StringPool::Context::kHighPriority));
+  StringPool::Ref ref5 = pool.MakeRef("m");
+
+  pool.Sort();
+
+  EXPECT_EQ(0u, ref4.index());
+  EXPECT_EQ(1u, ref5.index());
+  EXPECT_EQ(2u, ref2.index());
+  EXPECT_EQ(3u, ref3.index());
+  EXPECT_EQ(4u, ref.index());
+}
+
+TEST(StringPoolTest, AddStringsAfterPruneAndMerge) {
+  StringPool pool;
+  StringPool::Ref ref = pool.MakeRef("foo");
+  {
+    StringPool::Ref unused = pool.MakeRef("unused");
+  }
+  pool.Prune();
+  EXPECT_EQ(1u, pool.size());
+
+  StringPool other;
+  StringPool::Ref ref2 = other.MakeRef("bar");
+  pool.Merge(std::move(other));
+  EXPECT_EQ(0u, other.size());
+
+  StringPool::Ref ref3 = pool.MakeRef("baz");
+  StringPool::Ref ref4 = pool.MakeRef("bar");
+  EXPECT_EQ(3u, pool.size());
+  EXPECT_EQ(*ref, "foo");
+  EXPECT_EQ(*ref2, "bar");
+  EXPECT_EQ(*ref3, "baz");
+  EXPECT_EQ(ref2.index(), ref4.index());
+  EXPECT_EQ(2u, ref3.index());
+}
+
 TEST(StringPoolTest, AddStyles) {
   StringPool pool;
 
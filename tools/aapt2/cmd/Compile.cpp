@@ -15,7 +15,10 @@
  */
 
 #include <dirent.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
 #include <string>
 
@@ -30,18 +33,22 @@
 #include "Flags.h"
 #include "ResourceParser.h"
 #include "ResourceTable.h"
+#include "compile/CompileManifest.h"
 #include "compile/IdAssigner.h"
 #include "compile/InlineXmlFormatParser.h"
 #include "compile/Png.h"
+#include "compile/PngCrunchCache.h"
 #include "compile/PseudolocaleGenerator.h"
 #include "compile/XmlIdCollector.h"
 #include "flatten/Archive.h"
 #include "flatten/XmlFlattener.h"
 #include "io/BigBufferOutputStream.h"
 #include "io/Util.h"
+#include "io/ZipArchive.h"
 #include "proto/ProtoSerialize.h"
 #include "util/Files.h"
 #include "util/Maybe.h"
+#include "util/Parallel.h"
 #include "util/Util.h"
 #include "xml/XmlDom.h"
 #include "xml/XmlPullParser.h"
@@ -117,6 +124,9 @@ struct CompileOptions {
   bool no_png_crunch = false;
   bool legacy_mode = false;
   bool verbose = false;
+  bool incremental = false;
+  size_t jobs = 1;
+  Maybe<std::string> png_cache_dir;
 };
 
 static std::string BuildIntermediateFilename(const ResourcePathData& data) {
@@ -133,6 +143,19 @@ static std::string BuildIntermediateFilename(const ResourcePathData& data) {
   return name.str();
 }
 
+/**
+ * Returns the name of the file that path_data compiles to.
+ */
+static std::string BuildOutputFilename(const ResourcePathData& path_data) {
+  if (path_data.resource_dir == "values") {
+    // Values files are compiled to a table, whatever their extension.
+    ResourcePathData table_data = path_data;
+    table_data.extension = "arsc";
+    return BuildIntermediateFilename(table_data);
+  }
+  return BuildIntermediateFilename(path_data);
+}
+
 static bool IsHidden(const StringPiece& filename) {
   return util::StartsWith(filename, ".");
 }
@@ -476,15 +499,27 @@ static bool CompilePng(IAaptContext* context, const CompileOptions& options,
   res_file.config = path_data.config;
   res_file.source = path_data.source;
 
-  {
-    std::string content;
-    if (!android::base::ReadFileToString(path_data.source.path, &content,
-                                         true /*follow_symlinks*/)) {
-      context->GetDiagnostics()->Error(DiagMessage(path_data.source)
-                                       << android::base::SystemErrorCodeToString(errno));
-      return false;
-    }
+  std::string content;
+  if (!android::base::ReadFileToString(path_data.source.path, &content,
+                                       true /*follow_symlinks*/)) {
+    context->GetDiagnostics()->Error(DiagMessage(path_data.source)
+                                     << android::base::SystemErrorCodeToString(errno));
+    return false;
+  }
+
+  std::unique_ptr<PngCrunchCache> cache;
+  std::string cache_key;
+  if (options.png_cache_dir) {
+    cache = util::make_unique<PngCrunchCache>(options.png_cache_dir.value());
+    cache_key = PngCrunchCache::MakeKey(content, path_data.extension == "9.png");
+  }
 
+  if (cache && cache->Find(cache_key, &buffer)) {
+    if (context->IsVerbose()) {
+      context->GetDiagnostics()->Note(DiagMessage(path_data.source) << "using cached PNG "
+                                                                    << cache_key);
+    }
+  } else {
     BigBuffer crunched_png_buffer(4096);
     io::BigBufferOutputStream crunched_png_buffer_out(&crunched_png_buffer);
 
@@ -563,6 +598,12 @@ static bool CompilePng(IAaptContext* context, const CompileOptions& options,
                                       << "legacy=" << legacy_buffer.size()
                                       << " new=" << buffer.size());
     }
+
+    if (cache && !cache->Store(cache_key, buffer)) {
+      context->GetDiagnostics()->Warn(DiagMessage(path_data.source)
+                                      << "failed to store crunched PNG in "
+                                      << options.png_cache_dir.value());
+    }
   }
 
   if (!WriteHeaderAndBufferToWriter(output_path, res_file, buffer, writer,
@@ -650,6 +691,132 @@ class CompileContext : public IAaptContext {
   bool verbose_ = false;
 };
 
+/**
+ * Compiles a single input file to writer, reporting problems to context's diagnostics.
+ */
+static bool CompileInput(IAaptContext* context, const CompileOptions& options,
+                         const ResourcePathData& path_data, IArchiveWriter* writer) {
+  if (options.verbose) {
+    context->GetDiagnostics()->Note(DiagMessage(path_data.source) << "processing");
+  }
+
+  if (!IsValidFile(context, path_data.source.path)) {
+    return false;
+  }
+
+  const std::string output_filename = BuildOutputFilename(path_data);
+  if (path_data.resource_dir == "values") {
+    return CompileTable(context, options, path_data, writer, output_filename);
+  }
+
+  if (const ResourceType* type = ParseResourceType(path_data.resource_dir)) {
+    if (*type != ResourceType::kRaw) {
+      if (path_data.extension == "xml") {
+        return CompileXml(context, options, path_data, writer, output_filename);
+      } else if (!options.no_png_crunch &&
+                 (path_data.extension == "png" || path_data.extension == "9.png")) {
+        return CompilePng(context, options, path_data, writer, output_filename);
+      }
+    }
+    return CompileFile(context, options, path_data, writer, output_filename);
+  }
+
+  context->GetDiagnostics()->Error(DiagMessage() << "invalid file path '" << path_data.source
+                                                 << "'");
+  return false;
+}
+
+/**
+ * Hashes the options that change what inputs compile to.
+ */
+static uint64_t HashCompileOptions(const CompileOptions& options) {
+  std::stringstream str;
+  // A different build may compile the same input differently.
+  str << "tool=" << util::GetToolFingerprint() << " pseudolocalize=" << options.pseudolocalize
+      << " no_png_crunch=" << options.no_png_crunch << " legacy_mode=" << options.legacy_mode;
+  const std::string options_str = str.str();
+  return CompileManifest::Hash(options_str.data(), options_str.size());
+}
+
+static Maybe<uint64_t> HashInput(const ResourcePathData& path_data) {
+  Maybe<android::FileMap> f = file::MmapPath(path_data.source.path, nullptr);
+  if (!f) {
+    // Compiling it will report the problem.
+    return {};
+  }
+  return CompileManifest::Hash(f.value().getDataPtr(), f.value().getDataLength());
+}
+
+/**
+ * Writes the input's output from a previous run to writer, instead of compiling it again.
+ */
+static bool ReuseOutput(IAaptContext* context, const ResourcePathData& path_data,
+                        io::IFile* previous_output, IArchiveWriter* writer) {
+  if (context->IsVerbose()) {
+    context->GetDiagnostics()->Note(DiagMessage(path_data.source) << "up to date");
+  }
+  return io::CopyFileToArchive(context, previous_output, BuildOutputFilename(path_data), 0u,
+                               writer);
+}
+
+/**
+ * Compiles independent inputs on options.jobs threads. Each file is compiled into memory with
+ * its own context, and its outputs and diagnostics are then committed in input order, so the
+ * result is identical to compiling the files one after another. Inputs with a previous output
+ * are copied from it while committing.
+ */
+static bool CompileInputsInParallel(CompileContext* context, const CompileOptions& options,
+                                    const std::vector<ResourcePathData>& input_data,
+                                    const std::vector<io::IFile*>& previous_outputs,
+                                    IArchiveWriter* writer) {
+  struct PendingOutput {
+    BufferedDiagnostics diagnostics;
+    BufferedArchiveWriter writer;
+    bool success = false;
+  };
+
+  // Bound how many compiled files are held in memory before being committed.
+  const size_t batch_size = options.jobs * 16;
+
+  bool error = false;
+  for (size_t batch_start = 0; batch_start < input_data.size(); batch_start += batch_size) {
+    const size_t count = std::min(batch_size, input_data.size() - batch_start);
+    std::vector<std::unique_ptr<PendingOutput>> outputs(count);
+    util::ParallelFor(count, options.jobs, [&](size_t i) {
+      if (previous_outputs[batch_start + i]) {
+        return;
+      }
+      std::unique_ptr<PendingOutput> output = util::make_unique<PendingOutput>();
+      CompileContext file_context(&output->diagnostics);
+      file_context.SetVerbose(context->IsVerbose());
+      output->success =
+          CompileInput(&file_context, options, input_data[batch_start + i], &output->writer);
+      outputs[i] = std::move(output);
+    });
+
+    for (size_t i = 0; i < count; i++) {
+      if (io::IFile* previous_output = previous_outputs[batch_start + i]) {
+        if (!ReuseOutput(context, input_data[batch_start + i], previous_output, writer)) {
+          error = true;
+        }
+        continue;
+      }
+
+      std::unique_ptr<PendingOutput>& output = outputs[i];
+      output->diagnostics.Replay(context->GetDiagnostics());
+      if (!output->writer.CommitTo(writer)) {
+        context->GetDiagnostics()->Error(DiagMessage() << "failed to write compiled file: "
+                                                       << writer->GetError());
+        return false;
+      }
+      if (!output->success) {
+        error = true;
+      }
+    }
+  }
+  return !error;
+}
+
 /**
  * Entry point for compilation phase. Parses arguments and dispatches to the
  * correct steps.
@@ -659,6 +826,7 @@ int Compile(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
   CompileOptions options;
 
   bool verbose = false;
+  Maybe<std::string> jobs;
   Flags flags =
       Flags()
           .RequiredFlag("-o", "Output path", &options.output_path)
@@ -670,14 +838,44 @@ int Compile(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
           .OptionalSwitch("--no-crunch", "Disables PNG processing", &options.no_png_crunch)
           .OptionalSwitch("--legacy", "Treat errors that used to be valid in AAPT as warnings",
                           &options.legacy_mode)
+          .OptionalSwitch("--incremental",
+                          "Reuses the outputs of inputs that did not change since the\n"
+                          "previous run with the same options. Requires --dir",
+                          &options.incremental)
+          .OptionalFlag("--png-cache",
+                        "Directory in which to keep crunched PNGs, so that unchanged images\n"
+                        "are not crunched again by later runs. May be shared by several\n"
+                        "projects. Never pruned; clean it up when it grows too large",
+                        &options.png_cache_dir)
+          .OptionalFlag("-j",
+                        "Number of files to compile in parallel. Outputs are identical to\n"
+                        "compiling one file at a time. Defaults to 1",
+                        &jobs)
           .OptionalSwitch("-v", "Enables verbose logging", &verbose);
   if (!flags.Parse("aapt2 compile", args, &std::cerr)) {
     return 1;
   }
 
+  if (jobs && !util::ParseJobCount(jobs.value(), context.GetDiagnostics(), &options.jobs)) {
+    return 1;
+  }
+
   context.SetVerbose(verbose);
 
+  if (options.png_cache_dir && !file::mkdirs(options.png_cache_dir.value())) {
+    context.GetDiagnostics()->Error(DiagMessage(options.png_cache_dir.value())
+                                    << "failed to create PNG cache directory: "
+                                    << android::base::SystemErrorCodeToString(errno));
+    return 1;
+  }
+
   std::unique_ptr<IArchiveWriter> archive_writer;
+  std::string archive_path = options.output_path;
+
+  // Only used by --incremental.
+  const uint64_t options_hash = HashCompileOptions(options);
+  std::unique_ptr<io::ZipFileCollection> previous_archive;
+  CompileManifest previous_manifest(options_hash);
 
   std::vector<ResourcePathData> input_data;
   if (options.res_dir) {
@@ -692,9 +890,28 @@ int Compile(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
       return 1;
     }
 
-    archive_writer = CreateZipFileArchiveWriter(context.GetDiagnostics(), options.output_path);
+    if (options.incremental && file::GetFileType(options.output_path) == file::FileType::kRegular) {
+      // A previous output that can't be opened or has no manifest is replaced in full.
+      previous_archive = io::ZipFileCollection::Create(options.output_path, nullptr);
+      if (previous_archive) {
+        if (io::IFile* manifest_file = previous_archive->FindFile(CompileManifest::kEntryName)) {
+          previous_manifest.Load(manifest_file);
+        }
+      }
+
+      // The previous archive is read while the new one is written, so write it on the side.
+      archive_path = options.output_path + ".tmp";
+    }
+
+    archive_writer = CreateZipFileArchiveWriter(context.GetDiagnostics(), archive_path);
 
   } else {
+    if (options.incremental) {
+      context.GetDiagnostics()->Error(DiagMessage() << "--incremental requires --dir");
+      flags.Usage("aapt2 compile", &std::cerr);
+      return 1;
+    }
+
     input_data.reserve(flags.GetArgs().size());
 
     // Collect data from the path for each input file.
@@ -715,55 +932,75 @@ int Compile(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
     return 1;
   }
 
-  bool error = false;
-  for (ResourcePathData& path_data : input_data) {
-    if (options.verbose) {
-      context.GetDiagnostics()->Note(DiagMessage(path_data.source) << "processing");
-    }
+  // The output each input had in the previous run, if it can be reused.
+  std::vector<io::IFile*> previous_outputs(input_data.size(), nullptr);
+  std::vector<Maybe<uint64_t>> content_hashes;
+  if (options.incremental) {
+    content_hashes.resize(input_data.size());
+    util::ParallelFor(input_data.size(), options.jobs, [&](size_t i) {
+      content_hashes[i] = HashInput(input_data[i]);
+    });
 
-    if (!IsValidFile(&context, path_data.source.path)) {
-      error = true;
-      continue;
+    for (size_t i = 0; i < input_data.size() && previous_manifest.size() > 0; i++) {
+      if (!content_hashes[i]) {
+        continue;
+      }
+      const std::string* output = previous_manifest.FindOutput(input_data[i].source.path,
+                                                               content_hashes[i].value());
+      if (output && *output == BuildOutputFilename(input_data[i])) {
+        previous_outputs[i] = previous_archive->FindFile(*output);
+      }
     }
+  }
 
-    if (path_data.resource_dir == "values") {
-      // Overwrite the extension.
-      path_data.extension = "arsc";
-
-      const std::string output_filename = BuildIntermediateFilename(path_data);
-      if (!CompileTable(&context, options, path_data, archive_writer.get(), output_filename)) {
+  bool error = false;
+  if (options.jobs <= 1) {
+    for (size_t i = 0; i < input_data.size(); i++) {
+      bool result = previous_outputs[i]
+                        ? ReuseOutput(&context, input_data[i], previous_outputs[i],
+                                      archive_writer.get())
+                        : CompileInput(&context, options, input_data[i], archive_writer.get());
+      if (!result) {
         error = true;
       }
+    }
+  } else if (!CompileInputsInParallel(&context, options, input_data, previous_outputs,
+                                      archive_writer.get())) {
+    error = true;
+  }
 
-    } else {
-      const std::string output_filename = BuildIntermediateFilename(path_data);
-      if (const ResourceType* type = ParseResourceType(path_data.resource_dir)) {
-        if (*type != ResourceType::kRaw) {
-          if (path_data.extension == "xml") {
-            if (!CompileXml(&context, options, path_data, archive_writer.get(), output_filename)) {
-              error = true;
-            }
-          } else if (!options.no_png_crunch &&
-                     (path_data.extension == "png" || path_data.extension == "9.png")) {
-            if (!CompilePng(&context, options, path_data, archive_writer.get(), output_filename)) {
-              error = true;
-            }
-          } else {
-            if (!CompileFile(&context, options, path_data, archive_writer.get(), output_filename)) {
-              error = true;
-            }
-          }
-        } else {
-          if (!CompileFile(&context, options, path_data, archive_writer.get(), output_filename)) {
-            error = true;
-          }
-        }
-      } else {
-        context.GetDiagnostics()->Error(DiagMessage() << "invalid file path '" << path_data.source
-                                                      << "'");
-        error = true;
+  if (options.incremental && !error) {
+    CompileManifest manifest(options_hash);
+    for (size_t i = 0; i < input_data.size(); i++) {
+      if (content_hashes[i]) {
+        manifest.AddInput(input_data[i].source.path, content_hashes[i].value(),
+                          BuildOutputFilename(input_data[i]));
       }
     }
+    if (!manifest.WriteToArchive(&context, archive_writer.get())) {
+      error = true;
+    }
+  }
+
+  if (archive_path != options.output_path) {
+    // Finish the new archive and close the previous one before replacing it. Outputs of inputs
+    // that no longer exist are dropped along with it.
+    archive_writer = {};
+    previous_archive = {};
+    if (error) {
+      unlink(archive_path.c_str());
+      return 1;
+    }
+#ifdef _WIN32
+    // rename() does not replace an existing file on Windows.
+    unlink(options.output_path.c_str());
+#endif
+    if (rename(archive_path.c_str(), options.output_path.c_str()) != 0) {
+      context.GetDiagnostics()->Error(DiagMessage(options.output_path)
+                                      << "failed to replace: "
+                                      << android::base::SystemErrorCodeToString(errno));
+      return 1;
+    }
   }
 
   if (error) {
@@ -16,7 +16,13 @@
 
 #include <sys/stat.h>
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <unordered_map>
 #include <vector>
@@ -33,6 +39,7 @@
 #include "Locale.h"
 #include "NameMangler.h"
 #include "ResourceUtils.h"
+#include "cmd/LoadedInputCache.h"
 #include "cmd/Util.h"
 #include "compile/IdAssigner.h"
 #include "filter/ConfigFilter.h"
@@ -59,6 +66,7 @@
 #include "split/TableSplitter.h"
 #include "unflatten/BinaryResourceParser.h"
 #include "util/Files.h"
+#include "util/Parallel.h"
 #include "xml/XmlDom.h"
 
 using android::StringPiece;
@@ -115,6 +123,9 @@ struct LinkOptions {
   // Stable ID options.
   std::unordered_map<ResourceName, ResourceId> stable_id_map;
   Maybe<std::string> resource_id_map_path;
+
+  // Number of threads to link references and flatten files on.
+  size_t jobs = 1;
 };
 
 class LinkContext : public IAaptContext {
@@ -192,6 +203,30 @@ class LinkContext : public IAaptContext {
   int min_sdk_version_ = 0;
 };
 
+// Notes how long a stage of the link took, when verbose logging is enabled.
+class StageTimer {
+ public:
+  StageTimer(IAaptContext* context, const char* stage)
+      : context_(context), stage_(stage), start_(std::chrono::steady_clock::now()) {
+  }
+
+  ~StageTimer() {
+    if (context_->IsVerbose()) {
+      const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - start_);
+      context_->GetDiagnostics()->Note(DiagMessage() << stage_ << " took " << elapsed.count()
+                                                     << "ms");
+    }
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(StageTimer);
+
+  IAaptContext* context_;
+  const char* stage_;
+  std::chrono::steady_clock::time_point start_;
+};
+
 // A custom delegate that generates compatible pre-O IDs for use with feature splits.
 // Feature splits use package IDs > 7f, which in Java (since Java doesn't have unsigned ints)
 // is interpreted as a negative number. Some verification was wrongly assuming negative values
@@ -305,6 +340,7 @@ struct ResourceFileFlattenerOptions {
   bool do_not_compress_anything = false;
   bool update_proguard_spec = false;
   std::unordered_set<std::string> extensions_to_not_compress;
+  size_t jobs = 1;
 };
 
 // A sampling of public framework resource IDs.
@@ -356,12 +392,15 @@ class ResourceFileFlattener {
 
   uint32_t GetCompressionFlags(const StringPiece& str);
 
-  std::vector<std::unique_ptr<xml::XmlResource>> LinkAndVersionXmlFile(ResourceTable* table,
-                                                                       FileOperation* file_op);
+  // Safe to call for several files at once.
+  bool LinkXmlFile(IAaptContext* context, FileOperation* file_op);
+
+  std::vector<std::unique_ptr<xml::XmlResource>> VersionXmlFile(FileOperation* file_op);
 
   ResourceFileFlattenerOptions options_;
   IAaptContext* context_;
   proguard::KeepSet* keep_set_;
+  std::mutex keep_set_lock_;
   XmlCompatVersioner::Rules rules_;
 };
 
@@ -451,30 +490,38 @@ std::vector<T> make_singleton_vec(T&& val) {
   return vec;
 }
 
-std::vector<std::unique_ptr<xml::XmlResource>> ResourceFileFlattener::LinkAndVersionXmlFile(
-    ResourceTable* table, FileOperation* file_op) {
+bool ResourceFileFlattener::LinkXmlFile(IAaptContext* context, FileOperation* file_op) {
   xml::XmlResource* doc = file_op->xml_to_flatten.get();
   const Source& src = doc->file.source;
 
-  if (context_->IsVerbose()) {
-    context_->GetDiagnostics()->Note(DiagMessage() << "linking " << src.path);
+  if (context->IsVerbose()) {
+    context->GetDiagnostics()->Note(DiagMessage() << "linking " << src.path);
   }
 
   XmlReferenceLinker xml_linker;
-  if (!xml_linker.Consume(context_, doc)) {
-    return {};
+  if (!xml_linker.Consume(context, doc)) {
+    return false;
   }
 
-  if (options_.update_proguard_spec && !proguard::CollectProguardRules(src, doc, keep_set_)) {
-    return {};
+  if (options_.update_proguard_spec) {
+    std::lock_guard<std::mutex> lock(keep_set_lock_);
+    if (!proguard::CollectProguardRules(src, doc, keep_set_)) {
+      return false;
+    }
   }
 
   if (options_.no_xml_namespaces) {
     XmlNamespaceRemover namespace_remover;
-    if (!namespace_remover.Consume(context_, doc)) {
-      return {};
+    if (!namespace_remover.Consume(context, doc)) {
+      return false;
     }
   }
+  return true;
+}
+
+std::vector<std::unique_ptr<xml::XmlResource>> ResourceFileFlattener::VersionXmlFile(
+    FileOperation* file_op) {
+  xml::XmlResource* doc = file_op->xml_to_flatten.get();
 
   if (options_.no_auto_version) {
     return make_singleton_vec(std::move(file_op->xml_to_flatten));
@@ -566,14 +613,42 @@ bool ResourceFileFlattener::Flatten(ResourceTable* table, IArchiveWriter* archiv
         }
       }
 
-      // Now flatten the sorted values.
+      std::vector<FileOperation*> sorted_files;
       for (auto& map_entry : config_sorted_files) {
-        const ConfigDescription& config = map_entry.first.first;
-        FileOperation& file_op = map_entry.second;
+        sorted_files.push_back(&map_entry.second);
+      }
+
+      // Link the XML files of this type on options_.jobs threads. Nothing here touches the
+      // table, and diagnostics are replayed below in the sorted order.
+      std::vector<BufferedDiagnostics> link_diagnostics(sorted_files.size());
+      std::vector<char> linked(sorted_files.size(), false);
+      util::ParallelFor(sorted_files.size(), options_.jobs, [&](size_t i) {
+        if (sorted_files[i]->xml_to_flatten) {
+          ContextWithDiagnostics file_context(context_, &link_diagnostics[i]);
+          linked[i] = LinkXmlFile(&file_context, sorted_files[i]);
+        }
+      });
+
+      // Versioning adds new file references to the table, so it happens on this thread, in
+      // order. The flattening of the resulting documents is deferred to the worker threads.
+      struct FlattenOperation {
+        // The document to flatten, or null to copy file_op->file_to_copy as-is.
+        std::unique_ptr<xml::XmlResource> doc;
+        FileOperation* file_op;
+        std::string dst_path;
+      };
+      std::vector<FlattenOperation> flatten_operations;
+
+      for (size_t i = 0; i < sorted_files.size(); i++) {
+        FileOperation& file_op = *sorted_files[i];
+        const ConfigDescription& config = file_op.config;
+        link_diagnostics[i].Replay(context_->GetDiagnostics());
 
         if (file_op.xml_to_flatten) {
-          std::vector<std::unique_ptr<xml::XmlResource>> versioned_docs =
-              LinkAndVersionXmlFile(table, &file_op);
+          std::vector<std::unique_ptr<xml::XmlResource>> versioned_docs;
+          if (linked[i]) {
+            versioned_docs = VersionXmlFile(&file_op);
+          }
           for (std::unique_ptr<xml::XmlResource>& doc : versioned_docs) {
             std::string dst_path = file_op.dst_path;
             if (doc->file.config != file_op.config) {
@@ -593,12 +668,43 @@ bool ResourceFileFlattener::Flatten(ResourceTable* table, IArchiveWriter* archiv
                 return false;
               }
             }
-            error |= !FlattenXml(context_, doc.get(), dst_path, options_.keep_raw_values,
-                                 archive_writer);
+            flatten_operations.push_back(
+                FlattenOperation{std::move(doc), &file_op, std::move(dst_path)});
           }
         } else {
-          error |= !io::CopyFileToArchive(context_, file_op.file_to_copy, file_op.dst_path,
-                                          GetCompressionFlags(file_op.dst_path), archive_writer);
+          flatten_operations.push_back(FlattenOperation{{}, &file_op, file_op.dst_path});
+        }
+      }
+
+      std::vector<BufferedDiagnostics> flatten_diagnostics(flatten_operations.size());
+      std::vector<BufferedArchiveWriter> flattened(flatten_operations.size());
+      std::vector<char> flatten_results(flatten_operations.size(), false);
+      util::ParallelFor(flatten_operations.size(), options_.jobs, [&](size_t i) {
+        FlattenOperation& op = flatten_operations[i];
+        if (op.doc) {
+          ContextWithDiagnostics file_context(context_, &flatten_diagnostics[i]);
+          flatten_results[i] = FlattenXml(&file_context, op.doc.get(), op.dst_path,
+                                          options_.keep_raw_values, &flattened[i]);
+        }
+      });
+
+      // Write everything in the same order as a single threaded link would.
+      for (size_t i = 0; i < flatten_operations.size(); i++) {
+        FlattenOperation& op = flatten_operations[i];
+        if (op.doc) {
+          flatten_diagnostics[i].Replay(context_->GetDiagnostics());
+          if (!flatten_results[i]) {
+            error = true;
+          } else if (!flattened[i].CommitTo(archive_writer)) {
+            context_->GetDiagnostics()->Error(DiagMessage(op.dst_path)
+                                              << "failed to write to archive: "
+                                              << archive_writer->GetError());
+            error = true;
+          }
+        } else {
+          // Files in the archives of other modules may not be read from several threads.
+          error |= !io::CopyFileToArchive(context_, op.file_op->file_to_copy, op.dst_path,
+                                          GetCompressionFlags(op.dst_path), archive_writer);
         }
       }
     }
@@ -678,6 +784,58 @@ static bool LoadStableIdMap(IDiagnostics* diag, const std::string& path,
   return true;
 }
 
+// Set by `aapt2 daemon`, which runs many links in the same process. Inputs that are expensive to
+// load are then kept loaded from one link to the next.
+static bool sKeepInputsLoaded = false;
+
+void KeepLinkInputsLoaded(bool keep) {
+  sKeepInputsLoaded = keep;
+}
+
+// Returns what load() returns, through the cache when inputs are kept loaded.
+template <typename T>
+static std::shared_ptr<T> FindOrLoadInput(LoadedInputCache<T>* cache,
+                                          const std::vector<std::string>& paths,
+                                          const std::function<std::shared_ptr<T>()>& load) {
+  return sKeepInputsLoaded ? cache->FindOrLoad(paths, load) : load();
+}
+
+// Lets a SymbolTable use a symbol source that is kept loaded after the table is gone.
+class SharedSymbolSource : public ISymbolSource {
+ public:
+  explicit SharedSymbolSource(std::shared_ptr<ISymbolSource> source)
+      : source_(std::move(source)) {
+  }
+
+  std::unique_ptr<SymbolTable::Symbol> FindByName(const ResourceName& name) override {
+    return source_->FindByName(name);
+  }
+
+  std::unique_ptr<SymbolTable::Symbol> FindById(ResourceId id) override {
+    return source_->FindById(id);
+  }
+
+  std::unique_ptr<SymbolTable::Symbol> FindByReference(const Reference& ref) override {
+    return source_->FindByReference(ref);
+  }
+
+ private:
+  std::shared_ptr<ISymbolSource> source_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedSymbolSource);
+};
+
+// A static library opened for merging. The table refers to the data, and the merged file
+// references refer to the collection.
+struct LoadedStaticLibrary {
+  std::unique_ptr<io::ZipFileCollection> collection;
+  std::unique_ptr<io::IData> data;
+  std::unique_ptr<LazyResourceTablePb> table;
+};
+
+static LoadedInputCache<AssetManagerSymbolSource> sIncludeCache;
+static LoadedInputCache<LoadedStaticLibrary> sStaticLibraryCache;
+
 class LinkCommand {
  public:
   LinkCommand(LinkContext* context, const LinkOptions& options)
@@ -692,8 +850,6 @@ class LinkCommand {
    * the results for faster lookup.
    */
   bool LoadSymbolsFromIncludePaths() {
-    std::unique_ptr<AssetManagerSymbolSource> asset_source =
-        util::make_unique<AssetManagerSymbolSource>();
     for (const std::string& path : options_.include_paths) {
       if (context_->IsVerbose()) {
         context_->GetDiagnostics()->Note(DiagMessage(path) << "loading include path");
@@ -736,11 +892,24 @@ class LinkCommand {
         context_->GetDiagnostics()->Error(DiagMessage(path) << error_str);
         return false;
       }
+    }
 
-      if (!asset_source->AddAssetPath(path)) {
-        context_->GetDiagnostics()->Error(DiagMessage(path) << "failed to load include path");
-        return false;
-      }
+    // Parsing the resources.arsc of android.jar is the bulk of this, so the AssetManager is kept
+    // loaded between the links of a daemon.
+    auto asset_source = FindOrLoadInput<AssetManagerSymbolSource>(
+        &sIncludeCache, options_.include_paths, [&]() -> std::shared_ptr<AssetManagerSymbolSource> {
+          auto source = std::make_shared<AssetManagerSymbolSource>();
+          for (const std::string& path : options_.include_paths) {
+            if (!source->AddAssetPath(path)) {
+              context_->GetDiagnostics()->Error(DiagMessage(path)
+                                                << "failed to load include path");
+              return {};
+            }
+          }
+          return source;
+        });
+    if (!asset_source) {
+      return false;
     }
 
     // Capture the shared libraries so that the final resource table can be properly flattened
@@ -751,7 +920,8 @@ class LinkCommand {
       }
     }
 
-    context_->GetExternalSymbols()->AppendSource(std::move(asset_source));
+    context_->GetExternalSymbols()->AppendSource(
+        util::make_unique<SharedSymbolSource>(std::move(asset_source)));
     return true;
   }
 
@@ -1064,62 +1234,122 @@ class LinkCommand {
                            context_->GetDiagnostics());
   }
 
+  // Merges the types of a package of a lazily loaded table one at a time, so that no more than
+  // one of them is materialized at any point.
+  bool MergeLazyPackage(LazyResourceTablePb* lazy_table, size_t package_index,
+                        const std::function<bool(ResourceTable*)>& merge) {
+    const LazyResourceTablePb::Package& package = lazy_table->packages()[package_index];
+    if (package.types.empty()) {
+      ResourceTable table;
+      table.CreatePackage(package.name, package.id);
+      return merge(&table);
+    }
+
+    bool error = false;
+    for (size_t i = 0; i < package.types.size(); i++) {
+      std::unique_ptr<ResourceTable> table = lazy_table->LoadType(package_index, i);
+      if (!table) {
+        return false;
+      }
+      error |= !merge(table.get());
+    }
+    return !error;
+  }
+
   bool MergeStaticLibrary(const std::string& input, bool override) {
     if (context_->IsVerbose()) {
       context_->GetDiagnostics()->Note(DiagMessage() << "merging static library " << input);
     }
 
-    std::string error_str;
-    std::unique_ptr<io::ZipFileCollection> collection =
-        io::ZipFileCollection::Create(input, &error_str);
-    if (!collection) {
-      context_->GetDiagnostics()->Error(DiagMessage(input) << error_str);
-      return false;
-    }
+    std::shared_ptr<LoadedStaticLibrary> library = FindOrLoadInput<LoadedStaticLibrary>(
+        &sStaticLibraryCache, {input}, [&]() -> std::shared_ptr<LoadedStaticLibrary> {
+          auto loaded = std::make_shared<LoadedStaticLibrary>();
+          std::string error_str;
+          loaded->collection = io::ZipFileCollection::Create(input, &error_str);
+          if (!loaded->collection) {
+            context_->GetDiagnostics()->Error(DiagMessage(input) << error_str);
+            return {};
+          }
+
+          if (io::IFile* file = loaded->collection->FindFile("resources.arsc.flat")) {
+            loaded->data = file->OpenAsData();
+          }
 
-    std::unique_ptr<ResourceTable> table = LoadTablePbFromCollection(collection.get());
-    if (!table) {
-      context_->GetDiagnostics()->Error(DiagMessage(input) << "invalid static library");
+          loaded->table =
+              util::make_unique<LazyResourceTablePb>(Source(input), context_->GetDiagnostics());
+          if (!loaded->data || !loaded->table->Load(loaded->data->data(), loaded->data->size())) {
+            context_->GetDiagnostics()->Error(DiagMessage(input) << "invalid static library");
+            return {};
+          }
+          return loaded;
+        });
+    if (!library) {
       return false;
     }
 
-    ResourceTablePackage* pkg = table->FindPackageById(kAppPackageId);
-    if (!pkg) {
+    io::ZipFileCollection* collection = library->collection.get();
+    LazyResourceTablePb* lazy_table = library->table.get();
+    lazy_table->SetDiagnostics(context_->GetDiagnostics());
+
+    const std::vector<LazyResourceTablePb::Package>& packages = lazy_table->packages();
+    auto pkg_iter = std::find_if(packages.begin(), packages.end(),
+                                 [](const LazyResourceTablePb::Package& package) -> bool {
+                                   return package.id && package.id.value() == kAppPackageId;
+                                 });
+    if (pkg_iter == packages.end()) {
       context_->GetDiagnostics()->Error(DiagMessage(input) << "static library has no package");
       return false;
     }
 
-    bool result;
+    const size_t pkg_index = pkg_iter - packages.begin();
+    const std::string pkg_name = pkg_iter->name;
+    bool error = false;
     if (options_.no_static_lib_packages) {
       // Merge all resources as if they were in the compilation package. This is
       // the old behavior of aapt.
 
       // Add the package to the set of --extra-packages so we emit an R.java for
       // each library package.
-      if (!pkg->name.empty()) {
-        options_.extra_java_packages.insert(pkg->name);
+      if (!pkg_name.empty()) {
+        options_.extra_java_packages.insert(pkg_name);
       }
 
-      pkg->name = "";
-      if (override) {
-        result = table_merger_->MergeOverlay(Source(input), table.get(), collection.get());
-      } else {
-        result = table_merger_->Merge(Source(input), table.get(), collection.get());
+      for (size_t i = 0; i < packages.size(); i++) {
+        error |= !MergeLazyPackage(lazy_table, i, [&](ResourceTable* table) -> bool {
+          if (i == pkg_index) {
+            table->packages.front()->name = "";
+          }
+
+          if (override) {
+            return table_merger_->MergeOverlay(Source(input), table, collection);
+          }
+          return table_merger_->Merge(Source(input), table, collection);
+        });
       }
 
     } else {
       // This is the proper way to merge libraries, where the package name is
       // preserved and resource names are mangled.
-      result =
-          table_merger_->MergeAndMangle(Source(input), pkg->name, table.get(), collection.get());
+      for (size_t i = 0; i < packages.size(); i++) {
+        if (packages[i].name != pkg_name) {
+          context_->GetDiagnostics()->Warn(DiagMessage(input) << "ignoring package "
+                                                              << packages[i].name);
+          continue;
+        }
+
+        error |= !MergeLazyPackage(lazy_table, i, [&](ResourceTable* table) -> bool {
+          return table_merger_->MergeAndMangle(Source(input), pkg_name, table, collection);
+        });
+      }
     }
 
-    if (!result) {
+    if (error) {
       return false;
     }
 
-    // Make sure to move the collection into the set of IFileCollections.
-    collections_.push_back(std::move(collection));
+    // The merged file references point into the collection, so keep the library loaded until
+    // the link is done.
+    static_libraries_.push_back(std::move(library));
     return true;
   }
 
@@ -1135,19 +1365,21 @@ class LinkCommand {
       return false;
     }
 
-    std::unique_ptr<ResourceTable> table =
-        LoadTableFromPb(file->GetSource(), data->data(), data->size(), context_->GetDiagnostics());
-    if (!table) {
+    LazyResourceTablePb lazy_table(file->GetSource(), context_->GetDiagnostics());
+    if (!lazy_table.Load(data->data(), data->size())) {
       return false;
     }
 
-    bool result = false;
-    if (override) {
-      result = table_merger_->MergeOverlay(file->GetSource(), table.get());
-    } else {
-      result = table_merger_->Merge(file->GetSource(), table.get());
+    bool error = false;
+    for (size_t i = 0; i < lazy_table.packages().size(); i++) {
+      error |= !MergeLazyPackage(&lazy_table, i, [&](ResourceTable* table) -> bool {
+        if (override) {
+          return table_merger_->MergeOverlay(file->GetSource(), table);
+        }
+        return table_merger_->Merge(file->GetSource(), table);
+      });
     }
-    return result;
+    return !error;
   }
 
   bool MergeCompiledFile(io::IFile* file, ResourceFile* file_desc, bool override) {
@@ -1392,9 +1624,11 @@ class LinkCommand {
     file_flattener_options.no_xml_namespaces = options_.no_xml_namespaces;
     file_flattener_options.update_proguard_spec =
         static_cast<bool>(options_.generate_proguard_rules_path);
+    file_flattener_options.jobs = options_.jobs;
 
     ResourceFileFlattener file_flattener(file_flattener_options, context_, keep_set);
 
+    StageTimer timer(context_, "writing APK");
     if (!file_flattener.Flatten(table, writer)) {
       context_->GetDiagnostics()->Error(DiagMessage() << "failed linking file resources");
       return false;
@@ -1471,17 +1705,22 @@ class LinkCommand {
                                                        context_->GetPackageId()));
     }
 
-    for (const std::string& input : input_files) {
-      if (!MergePath(input, false)) {
-        context_->GetDiagnostics()->Error(DiagMessage() << "failed parsing input");
-        return 1;
+    // Merging mutates the final table and the order of inputs decides which definition wins, so
+    // it stays on this thread.
+    {
+      StageTimer timer(context_, "merging");
+      for (const std::string& input : input_files) {
+        if (!MergePath(input, false)) {
+          context_->GetDiagnostics()->Error(DiagMessage() << "failed parsing input");
+          return 1;
+        }
       }
-    }
 
-    for (const std::string& input : options_.overlay_files) {
-      if (!MergePath(input, true)) {
-        context_->GetDiagnostics()->Error(DiagMessage() << "failed parsing overlays");
-        return 1;
+      for (const std::string& input : options_.overlay_files) {
+        if (!MergePath(input, true)) {
+          context_->GetDiagnostics()->Error(DiagMessage() << "failed parsing overlays");
+          return 1;
+        }
       }
     }
 
@@ -1490,6 +1729,7 @@ class LinkCommand {
     }
 
     if (context_->GetPackageType() != PackageType::kStaticLib) {
+      StageTimer timer(context_, "assigning IDs");
       PrivateAttributeMover mover;
       if (!mover.Consume(context_, &final_table_)) {
         context_->GetDiagnostics()->Error(DiagMessage() << "failed moving private attributes");
@@ -1551,10 +1791,13 @@ class LinkCommand {
           util::make_unique<FeatureSplitSymbolTableDelegate>(context_));
     }
 
-    ReferenceLinker linker;
-    if (!linker.Consume(context_, &final_table_)) {
-      context_->GetDiagnostics()->Error(DiagMessage() << "failed linking references");
-      return 1;
+    {
+      StageTimer timer(context_, "linking references");
+      ReferenceLinker linker(options_.jobs);
+      if (!linker.Consume(context_, &final_table_)) {
+        context_->GetDiagnostics()->Error(DiagMessage() << "failed linking references");
+        return 1;
+      }
     }
 
     if (context_->GetPackageType() == PackageType::kStaticLib) {
@@ -1571,6 +1814,7 @@ class LinkCommand {
     }
 
     if (!options_.no_auto_version) {
+      StageTimer timer(context_, "versioning");
       AutoVersioner versioner;
       if (!versioner.Consume(context_, &final_table_)) {
         context_->GetDiagnostics()->Error(DiagMessage() << "failed versioning styles");
@@ -1585,13 +1829,15 @@ class LinkCommand {
                                          << context_->GetMinSdkVersion());
       }
 
-      VersionCollapser collapser;
+      StageTimer timer(context_, "collapsing versions");
+      VersionCollapser collapser(options_.jobs);
       if (!collapser.Consume(context_, &final_table_)) {
         return 1;
       }
     }
 
     if (!options_.no_resource_deduping) {
+      StageTimer timer(context_, "deduping");
       ResourceDeduper deduper;
       if (!deduper.Consume(context_, &final_table_)) {
         context_->GetDiagnostics()->Error(DiagMessage() << "failed deduping resources");
@@ -1816,6 +2062,9 @@ class LinkCommand {
   // collections.
   std::vector<std::unique_ptr<io::IFileCollection>> collections_;
 
+  // The static libraries merged into the final table, which may be kept loaded by later links.
+  std::vector<std::shared_ptr<LoadedStaticLibrary>> static_libraries_;
+
   // A vector of ResourceTables. This is here to retain ownership, so that the
   // SymbolTable can use these.
   std::vector<std::unique_ptr<ResourceTable>> static_table_includes_;
@@ -1840,6 +2089,7 @@ int Link(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
   bool static_lib = false;
   Maybe<std::string> stable_id_file_path;
   std::vector<std::string> split_args;
+  Maybe<std::string> jobs;
   Flags flags =
       Flags()
           .RequiredFlag("-o", "Output path.", &options.output_path)
@@ -1965,7 +2215,12 @@ int Link(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
                             "Syntax: path/to/output.apk:<config>[,<config>[...]].\n"
                             "On Windows, use a semicolon ';' separator instead.",
                             &split_args)
-          .OptionalSwitch("-v", "Enables verbose logging.", &verbose);
+          .OptionalFlag("-j",
+                        "Number of threads to link references and flatten files on. The output\n"
+                        "is identical to linking on a single thread. Defaults to 1.",
+                        &jobs)
+          .OptionalSwitch("-v", "Enables verbose logging and the time taken by each stage.",
+                          &verbose);
 
   if (!flags.Parse("aapt2 link", args, &std::cerr)) {
     return 1;
@@ -2004,6 +2259,10 @@ int Link(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
     context.SetVerbose(verbose);
   }
 
+  if (jobs && !util::ParseJobCount(jobs.value(), context.GetDiagnostics(), &options.jobs)) {
+    return 1;
+  }
+
   if (shared_lib && static_lib) {
     context.GetDiagnostics()->Error(DiagMessage()
                                     << "only one of --shared-lib and --static-lib can be defined");
@@ -2110,6 +2369,9 @@ int Link(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
     options.no_version_transitions = true;
   }
 
+  sIncludeCache.Trim();
+  sStaticLibraryCache.Trim();
+
   LinkCommand cmd(&context, options);
   return cmd.Run(arg_list);
 }
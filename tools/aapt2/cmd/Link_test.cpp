@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include "android-base/file.h"
+#include "android-base/test_utils.h"
+#include "androidfw/StringPiece.h"
+
+#include "test/Test.h"
+#include "util/Files.h"
+
+using android::StringPiece;
+
+namespace aapt {
+
+extern int Compile(const std::vector<StringPiece>& args, IDiagnostics* diagnostics);
+extern int Link(const std::vector<StringPiece>& args, IDiagnostics* diagnostics);
+extern void KeepLinkInputsLoaded(bool keep);
+
+class LinkTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    root_ = dir_.path;
+    ASSERT_TRUE(file::mkdirs(Path("res/values")));
+    ASSERT_TRUE(file::mkdirs(Path("compiled")));
+    ASSERT_TRUE(android::base::WriteStringToFile(
+        R"(<manifest xmlns:android="http://schemas.android.com/apk/res/android"
+                     package="com.example.lib" />)",
+        Path("LibManifest.xml")));
+    ASSERT_TRUE(android::base::WriteStringToFile(
+        R"(<manifest xmlns:android="http://schemas.android.com/apk/res/android"
+                     package="com.example.app" />)",
+        Path("AppManifest.xml")));
+  }
+
+  void TearDown() override {
+    KeepLinkInputsLoaded(false);
+  }
+
+  std::string Path(const std::string& name) const {
+    std::string path = root_;
+    file::AppendPath(&path, name);
+    return path;
+  }
+
+  // Builds lib.apk, a static library with a single string, rewriting the previous one in place.
+  bool BuildLibrary(const std::string& greeting) {
+    if (!android::base::WriteStringToFile(
+            "<resources><string name=\"greeting\">" + greeting + "</string></resources>",
+            Path("res/values/values.xml"))) {
+      return false;
+    }
+
+    const std::string compiled = Path("compiled");
+    const std::string values = Path("res/values/values.xml");
+    if (Compile({"-o", compiled, values}, test::GetDiagnostics()) != 0) {
+      return false;
+    }
+
+    const std::string manifest = Path("LibManifest.xml");
+    const std::string out = Path("lib.apk");
+    const std::string flat = Path("compiled/values_values.arsc.flat");
+    return Link({"--static-lib", "--manifest", manifest, "-o", out, flat},
+                test::GetDiagnostics()) == 0;
+  }
+
+  // Links the app from lib.apk and returns the content of the APK.
+  std::string LinkApp(const std::string& name) {
+    const std::string manifest = Path("AppManifest.xml");
+    const std::string out = Path(name);
+    const std::string lib = Path("lib.apk");
+    std::string content;
+    if (Link({"--manifest", manifest, "-o", out, lib}, test::GetDiagnostics()) != 0 ||
+        !android::base::ReadFileToString(out, &content)) {
+      return {};
+    }
+    return content;
+  }
+
+ private:
+  TemporaryDir dir_;
+  std::string root_;
+};
+
+TEST_F(LinkTest, DaemonLinksMatchOneShotLinks) {
+  // Same-sized strings, so that the library is rewritten with the same size, most likely within
+  // the same second.
+  ASSERT_TRUE(BuildLibrary("one"));
+  const std::string expected_one = LinkApp("one-shot-one.apk");
+  ASSERT_FALSE(expected_one.empty());
+  ASSERT_TRUE(BuildLibrary("two"));
+  const std::string expected_two = LinkApp("one-shot-two.apk");
+  ASSERT_FALSE(expected_two.empty());
+  ASSERT_NE(expected_one, expected_two);
+
+  KeepLinkInputsLoaded(true);
+  ASSERT_TRUE(BuildLibrary("one"));
+  EXPECT_EQ(expected_one, LinkApp("daemon-one.apk"));
+  EXPECT_EQ(expected_one, LinkApp("daemon-one-again.apk"));
+  ASSERT_TRUE(BuildLibrary("two"));
+  EXPECT_EQ(expected_two, LinkApp("daemon-two.apk"));
+}
+
+}  // namespace aapt
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AAPT_CMD_LOADEDINPUTCACHE_H
+#define AAPT_CMD_LOADEDINPUTCACHE_H
+
+#include <sys/stat.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace aapt {
+
+// What identifies the content of a file on disk without reading it. Timestamps are compared to the
+// nanosecond where the platform has them, since a file rewritten within the same second often
+// keeps its size. The inode and status change time also catch a file replaced by another one,
+// e.g. renamed over it, that has an older modification time.
+struct FileStamp {
+  off_t size;
+  ino_t inode;
+  time_t mtime_sec;
+  long mtime_nsec;
+  time_t ctime_sec;
+  long ctime_nsec;
+
+  explicit FileStamp(const struct stat& st)
+      : size(st.st_size), inode(st.st_ino), mtime_sec(st.st_mtime), ctime_sec(st.st_ctime) {
+#if defined(__APPLE__)
+    mtime_nsec = st.st_mtimespec.tv_nsec;
+    ctime_nsec = st.st_ctimespec.tv_nsec;
+#elif defined(_WIN32)
+    mtime_nsec = 0;
+    ctime_nsec = 0;
+#else
+    mtime_nsec = st.st_mtim.tv_nsec;
+    ctime_nsec = st.st_ctim.tv_nsec;
+#endif
+  }
+
+  bool operator==(const FileStamp& o) const {
+    return std::tie(size, inode, mtime_sec, mtime_nsec, ctime_sec, ctime_nsec) ==
+           std::tie(o.size, o.inode, o.mtime_sec, o.mtime_nsec, o.ctime_sec, o.ctime_nsec);
+  }
+};
+
+// Loaded inputs keyed by the files they were loaded from, which `aapt2 daemon` keeps from one link
+// to the next. A value is loaded again when the FileStamp of one of its files changed, and is
+// dropped once a whole link went by without using it.
+template <typename T>
+class LoadedInputCache {
+ public:
+  // Returns the value loaded from paths, calling load() unless it is cached and none of the files
+  // changed since. A null value from load() is returned but not cached.
+  std::shared_ptr<T> FindOrLoad(const std::vector<std::string>& paths,
+                                const std::function<std::shared_ptr<T>()>& load) {
+    // Stat the files before loading them, so that a file changed while it is being loaded is
+    // loaded again by the next link.
+    std::vector<FileStamp> stamps;
+    for (const std::string& path : paths) {
+      struct stat st;
+      if (stat(path.c_str(), &st) != 0) {
+        entries_.erase(paths);
+        return load();
+      }
+      stamps.push_back(FileStamp(st));
+    }
+
+    auto iter = entries_.find(paths);
+    if (iter != entries_.end() && iter->second.stamps == stamps) {
+      iter->second.used = true;
+      return iter->second.value;
+    }
+
+    std::shared_ptr<T> value = load();
+    if (value) {
+      entries_[paths] = Entry{std::move(stamps), value, true};
+    } else {
+      entries_.erase(paths);
+    }
+    return value;
+  }
+
+  // Drops the values that were not used since the last call.
+  void Trim() {
+    for (auto iter = entries_.begin(); iter != entries_.end();) {
+      if (!iter->second.used) {
+        iter = entries_.erase(iter);
+      } else {
+        iter->second.used = false;
+        ++iter;
+      }
+    }
+  }
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+ private:
+  struct Entry {
+    std::vector<FileStamp> stamps;
+    std::shared_ptr<T> value;
+    bool used;
+  };
+
+  std::map<std::vector<std::string>, Entry> entries_;
+};
+
+}  // namespace aapt
+
+#endif /* AAPT_CMD_LOADEDINPUTCACHE_H */
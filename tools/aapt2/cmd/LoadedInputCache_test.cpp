@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cmd/LoadedInputCache.h"
+
+#include <utime.h>
+
+#include "android-base/file.h"
+#include "android-base/test_utils.h"
+
+#include "test/Test.h"
+
+namespace aapt {
+
+// Returns a loader that reads path and counts how many times it was called.
+static std::function<std::shared_ptr<std::string>()> MakeLoader(const std::string& path,
+                                                                int* loads) {
+  return [path, loads]() -> std::shared_ptr<std::string> {
+    (*loads)++;
+    auto content = std::make_shared<std::string>();
+    if (!android::base::ReadFileToString(path, content.get())) {
+      return {};
+    }
+    return content;
+  };
+}
+
+TEST(LoadedInputCacheTest, ReusesUnchangedFile) {
+  TemporaryDir dir;
+  const std::string path = std::string(dir.path) + "/input";
+  ASSERT_TRUE(android::base::WriteStringToFile("one", path));
+
+  LoadedInputCache<std::string> cache;
+  int loads = 0;
+  std::shared_ptr<std::string> first = cache.FindOrLoad({path}, MakeLoader(path, &loads));
+  ASSERT_NE(nullptr, first);
+  EXPECT_EQ(first, cache.FindOrLoad({path}, MakeLoader(path, &loads)));
+  EXPECT_EQ(1, loads);
+}
+
+TEST(LoadedInputCacheTest, ReloadsFileRewrittenWithinTheSameSecond) {
+  TemporaryDir dir;
+  const std::string path = std::string(dir.path) + "/input";
+  ASSERT_TRUE(android::base::WriteStringToFile("one", path));
+  struct stat st;
+  ASSERT_EQ(0, stat(path.c_str(), &st));
+
+  LoadedInputCache<std::string> cache;
+  int loads = 0;
+  std::shared_ptr<std::string> content = cache.FindOrLoad({path}, MakeLoader(path, &loads));
+  ASSERT_NE(nullptr, content);
+  EXPECT_EQ("one", *content);
+
+  // Rewrite the file in place with the same size, and put its modification time back to the
+  // second it had, as a build that regenerates an input right away would leave it.
+  ASSERT_TRUE(android::base::WriteStringToFile("two", path));
+  struct utimbuf times = {st.st_atime, st.st_mtime};
+  ASSERT_EQ(0, utime(path.c_str(), &times));
+
+  content = cache.FindOrLoad({path}, MakeLoader(path, &loads));
+  ASSERT_NE(nullptr, content);
+  EXPECT_EQ("two", *content);
+  EXPECT_EQ(2, loads);
+}
+
+TEST(LoadedInputCacheTest, TrimDropsUnusedInputs) {
+  TemporaryDir dir;
+  const std::string path_a = std::string(dir.path) + "/a";
+  const std::string path_b = std::string(dir.path) + "/b";
+  ASSERT_TRUE(android::base::WriteStringToFile("a", path_a));
+  ASSERT_TRUE(android::base::WriteStringToFile("b", path_b));
+
+  LoadedInputCache<std::string> cache;
+  int loads_a = 0;
+  int loads_b = 0;
+
+  // The first link uses both inputs.
+  cache.FindOrLoad({path_a}, MakeLoader(path_a, &loads_a));
+  cache.FindOrLoad({path_b}, MakeLoader(path_b, &loads_b));
+  cache.Trim();
+  EXPECT_EQ(2u, cache.size());
+
+  // The second link only uses a, so the next one drops b.
+  cache.FindOrLoad({path_a}, MakeLoader(path_a, &loads_a));
+  cache.Trim();
+  EXPECT_EQ(1u, cache.size());
+
+  cache.FindOrLoad({path_a}, MakeLoader(path_a, &loads_a));
+  cache.FindOrLoad({path_b}, MakeLoader(path_b, &loads_b));
+  EXPECT_EQ(1, loads_a);
+  EXPECT_EQ(2, loads_b);
+}
+
+TEST(LoadedInputCacheTest, MissingFileIsNotCached) {
+  TemporaryDir dir;
+  const std::string path = std::string(dir.path) + "/missing";
+
+  LoadedInputCache<std::string> cache;
+  int loads = 0;
+  EXPECT_EQ(nullptr, cache.FindOrLoad({path}, MakeLoader(path, &loads)));
+  EXPECT_EQ(0u, cache.size());
+}
+
+}  // namespace aapt
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <sys/stat.h>
+
+#include <chrono>
 #include <memory>
 #include <vector>
 
@@ -33,6 +36,7 @@
 #include "optimize/ResourceDeduper.h"
 #include "optimize/VersionCollapser.h"
 #include "split/TableSplitter.h"
+#include "util/Parallel.h"
 
 using android::StringPiece;
 
@@ -55,6 +59,9 @@ struct OptimizeOptions {
   std::vector<SplitConstraints> split_constraints;
 
   TableFlattenerOptions table_flattener_options;
+
+  // Number of APKs to write at the same time.
+  size_t jobs = 1;
 };
 
 class OptimizeContext : public IAaptContext {
@@ -149,51 +156,99 @@ class OptimizeCommand {
     }
     splitter.SplitTable(apk->GetResourceTable());
 
-    auto path_iter = options_.split_paths.begin();
-    auto split_constraints_iter = options_.split_constraints.begin();
-    for (std::unique_ptr<ResourceTable>& split_table : splitter.splits()) {
-      if (context_->IsVerbose()) {
-        context_->GetDiagnostics()->Note(
-            DiagMessage(*path_iter) << "generating split with configurations '"
-                                    << util::Joiner(split_constraints_iter->configs, ", ") << "'");
+    // Once the table is split, the splits and the base APK share no mutable state: each one is
+    // flattened from its own table into its own file. They are written on options_.jobs threads,
+    // each logging to its own diagnostics. Files are copied from the input APK one at a time, as
+    // its archive may not be read from several threads (link copies them on the main thread).
+    std::vector<std::unique_ptr<ResourceTable>>& split_tables = splitter.splits();
+    const size_t output_count = split_tables.size() + 1;
+    std::vector<BufferedDiagnostics> diagnostics(output_count);
+    std::vector<OutputSummary> summaries(output_count);
+    util::ParallelFor(output_count, options_.jobs, [&](size_t i) {
+      ContextWithDiagnostics context(context_, &diagnostics[i]);
+      const auto start = std::chrono::steady_clock::now();
+      if (i < split_tables.size()) {
+        summaries[i].path = options_.split_paths[i];
+        summaries[i].written = WriteSplit(&context, apk.get(), split_tables[i].get(),
+                                          options_.split_constraints[i], options_.split_paths[i]);
+      } else {
+        summaries[i].path = options_.output_path;
+        summaries[i].written = WriteBase(&context, apk.get());
       }
+      summaries[i].elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - start);
+    });
+
+    bool error = false;
+    for (size_t i = 0; i < output_count; i++) {
+      diagnostics[i].Replay(context_->GetDiagnostics());
+      error |= !summaries[i].written;
+    }
 
-      // Generate an AndroidManifest.xml for each split.
-      std::unique_ptr<xml::XmlResource> split_manifest =
-          GenerateSplitManifest(options_.app_info, *split_constraints_iter);
-      std::unique_ptr<IArchiveWriter> split_writer =
-          CreateZipFileArchiveWriter(context_->GetDiagnostics(), *path_iter);
-      if (!split_writer) {
-        return 1;
-      }
+    if (error) {
+      return 1;
+    }
 
-      if (!WriteSplitApk(split_table.get(), split_manifest.get(), split_writer.get())) {
-        return 1;
+    if (context_->IsVerbose()) {
+      for (const OutputSummary& summary : summaries) {
+        DiagMessage message(summary.path);
+        message << "written in " << summary.elapsed.count() << "ms";
+        struct stat st;
+        if (stat(summary.path.c_str(), &st) == 0) {
+          message << ", " << static_cast<uint64_t>(st.st_size) << " bytes";
+        }
+        context_->GetDiagnostics()->Note(message);
       }
+    }
+    return 0;
+  }
 
-      ++path_iter;
-      ++split_constraints_iter;
+ private:
+  // What happened to one of the APKs being written, for the summary printed with -v.
+  struct OutputSummary {
+    std::string path;
+    bool written = false;
+    std::chrono::milliseconds elapsed{0};
+  };
+
+  bool WriteSplit(IAaptContext* context, LoadedApk* apk, ResourceTable* split_table,
+                  const SplitConstraints& split_constraints, const std::string& path) {
+    if (context->IsVerbose()) {
+      context->GetDiagnostics()->Note(DiagMessage(path)
+                                      << "generating split with configurations '"
+                                      << util::Joiner(split_constraints.configs, ", ") << "'");
     }
 
-    std::unique_ptr<IArchiveWriter> writer =
-        CreateZipFileArchiveWriter(context_->GetDiagnostics(), options_.output_path);
-    if (!apk->WriteToArchive(context_, options_.table_flattener_options, writer.get())) {
-      return 1;
+    // Generate an AndroidManifest.xml for each split.
+    std::unique_ptr<xml::XmlResource> split_manifest =
+        GenerateSplitManifest(options_.app_info, split_constraints);
+    std::unique_ptr<IArchiveWriter> split_writer =
+        CreateZipFileArchiveWriter(context->GetDiagnostics(), path);
+    if (!split_writer) {
+      return false;
     }
+    return WriteSplitApk(context, apk, split_table, split_manifest.get(), split_writer.get());
+  }
 
-    return 0;
+  bool WriteBase(IAaptContext* context, LoadedApk* apk) {
+    std::unique_ptr<IArchiveWriter> writer =
+        CreateZipFileArchiveWriter(context->GetDiagnostics(), options_.output_path);
+    if (!writer) {
+      return false;
+    }
+    return apk->WriteToArchive(context, options_.table_flattener_options, writer.get());
   }
 
- private:
-  bool WriteSplitApk(ResourceTable* table, xml::XmlResource* manifest, IArchiveWriter* writer) {
+  bool WriteSplitApk(IAaptContext* context, LoadedApk* apk, ResourceTable* table,
+                     xml::XmlResource* manifest, IArchiveWriter* writer) {
     BigBuffer manifest_buffer(4096);
     XmlFlattener xml_flattener(&manifest_buffer, {});
-    if (!xml_flattener.Consume(context_, manifest)) {
+    if (!xml_flattener.Consume(context, manifest)) {
       return false;
     }
 
     io::BigBufferInputStream manifest_buffer_in(&manifest_buffer);
-    if (!io::CopyInputStreamToArchive(context_, &manifest_buffer_in, "AndroidManifest.xml",
+    if (!io::CopyInputStreamToArchive(context, &manifest_buffer_in, "AndroidManifest.xml",
                                       ArchiveEntry::kCompress, writer)) {
       return false;
     }
@@ -213,9 +268,9 @@ class OptimizeCommand {
 
             if (file_ref->file == nullptr) {
               ResourceNameRef name(pkg->name, type->type, entry->name);
-              context_->GetDiagnostics()->Warn(DiagMessage(file_ref->GetSource())
-                                                << "file for resource " << name << " with config '"
-                                                << config_value->config << "' not found");
+              context->GetDiagnostics()->Warn(DiagMessage(file_ref->GetSource())
+                                               << "file for resource " << name << " with config '"
+                                               << config_value->config << "' not found");
               continue;
             }
 
@@ -228,8 +283,8 @@ class OptimizeCommand {
           FileReference* file_ref = entry.second;
           uint32_t compression_flags =
               file_ref->file->WasCompressed() ? ArchiveEntry::kCompress : 0u;
-          if (!io::CopyFileToArchive(context_, file_ref->file, *file_ref->path, compression_flags,
-                                     writer)) {
+          if (!apk->CopyFileToArchive(context, file_ref->file, *file_ref->path,
+                                      compression_flags, writer)) {
             return false;
           }
         }
@@ -238,12 +293,12 @@ class OptimizeCommand {
 
     BigBuffer table_buffer(4096);
     TableFlattener table_flattener(options_.table_flattener_options, &table_buffer);
-    if (!table_flattener.Consume(context_, table)) {
+    if (!table_flattener.Consume(context, table)) {
       return false;
     }
 
     io::BigBufferInputStream table_buffer_in(&table_buffer);
-    if (!io::CopyInputStreamToArchive(context_, &table_buffer_in, "resources.arsc",
+    if (!io::CopyInputStreamToArchive(context, &table_buffer_in, "resources.arsc",
                                       ArchiveEntry::kAlign, writer)) {
       return false;
     }
@@ -296,6 +351,7 @@ int Optimize(const std::vector<StringPiece>& args) {
   Maybe<std::string> target_densities;
   std::vector<std::string> configs;
   std::vector<std::string> split_args;
+  Maybe<std::string> jobs;
   bool verbose = false;
   Flags flags =
       Flags()
@@ -319,12 +375,20 @@ int Optimize(const std::vector<StringPiece>& args) {
                           "Enables encoding sparse entries using a binary search tree.\n"
                           "This decreases APK size at the cost of resource retrieval performance.",
                           &options.table_flattener_options.use_sparse_entries)
+          .OptionalFlag("-j",
+                        "Number of APKs to write in parallel. Outputs are identical to\n"
+                        "writing one APK at a time. Defaults to 1",
+                        &jobs)
           .OptionalSwitch("-v", "Enables verbose logging", &verbose);
 
   if (!flags.Parse("aapt2 optimize", args, &std::cerr)) {
     return 1;
   }
 
+  if (jobs && !util::ParseJobCount(jobs.value(), context.GetDiagnostics(), &options.jobs)) {
+    return 1;
+  }
+
   if (flags.GetArgs().size() != 1u) {
     std::cerr << "must have one APK as argument.\n\n";
     flags.Usage("aapt2 optimize", &std::cerr);
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compile/CompileManifest.h"
+
+#include "Format.pb.h"
+#include "io/Util.h"
+
+namespace aapt {
+
+// Bump whenever the format of compiled files changes, so that outputs of an older aapt2 are
+// never reused.
+constexpr static uint32_t kManifestVersion = 1;
+
+constexpr const char* CompileManifest::kEntryName;
+
+bool CompileManifest::Load(io::IFile* file) {
+  inputs_.clear();
+
+  std::unique_ptr<io::IData> data = file->OpenAsData();
+  if (!data) {
+    return false;
+  }
+
+  pb::CompileManifest pb_manifest;
+  if (!pb_manifest.ParseFromArray(data->data(), static_cast<int>(data->size()))) {
+    return false;
+  }
+
+  if (pb_manifest.version() != kManifestVersion || pb_manifest.options_hash() != options_hash_) {
+    return false;
+  }
+
+  for (const pb::CompileManifest_Input& pb_input : pb_manifest.inputs()) {
+    AddInput(pb_input.source_path(), pb_input.content_hash(), pb_input.output_path());
+  }
+  return true;
+}
+
+bool CompileManifest::WriteToArchive(IAaptContext* context, IArchiveWriter* writer) const {
+  pb::CompileManifest pb_manifest;
+  pb_manifest.set_version(kManifestVersion);
+  pb_manifest.set_options_hash(options_hash_);
+  for (const auto& entry : inputs_) {
+    pb::CompileManifest_Input* pb_input = pb_manifest.add_inputs();
+    pb_input->set_source_path(entry.first);
+    pb_input->set_content_hash(entry.second.content_hash);
+    pb_input->set_output_path(entry.second.output_path);
+  }
+  return io::CopyProtoToArchive(context, &pb_manifest, kEntryName, 0u, writer);
+}
+
+void CompileManifest::AddInput(const std::string& source_path, uint64_t content_hash,
+                               const std::string& output_path) {
+  inputs_[source_path] = Input{content_hash, output_path};
+}
+
+const std::string* CompileManifest::FindOutput(const std::string& source_path,
+                                               uint64_t content_hash) const {
+  auto iter = inputs_.find(source_path);
+  if (iter == inputs_.end() || iter->second.content_hash != content_hash) {
+    return nullptr;
+  }
+  return &iter->second.output_path;
+}
+
+uint64_t CompileManifest::Hash(const void* data, size_t len) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  uint64_t hash = 0xcbf29ce484222325u;
+  for (size_t i = 0; i < len; i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3u;
+  }
+  return hash;
+}
+
+}  // namespace aapt
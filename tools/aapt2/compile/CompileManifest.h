@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AAPT_COMPILE_COMPILEMANIFEST_H
+#define AAPT_COMPILE_COMPILEMANIFEST_H
+
+#include <map>
+#include <string>
+
+#include "android-base/macros.h"
+
+#include "flatten/Archive.h"
+#include "io/File.h"
+#include "process/IResourceTableConsumer.h"
+
+namespace aapt {
+
+// Records which output each input of `aapt2 compile --dir` was compiled to, along with a hash of
+// the input's content and of the options that affect outputs. It is stored in the output archive
+// so the next run can copy the outputs of unchanged inputs instead of compiling them again.
+class CompileManifest {
+ public:
+  // Name of the manifest in the output archive. aapt2 link ignores entries not ending in .flat.
+  static constexpr const char* kEntryName = "compile.manifest";
+
+  explicit CompileManifest(uint64_t options_hash) : options_hash_(options_hash) {}
+
+  // Replaces the content of this manifest with the one in file. Returns false, leaving this
+  // manifest empty, if file can't be read or was written by another version or other options.
+  bool Load(io::IFile* file);
+
+  bool WriteToArchive(IAaptContext* context, IArchiveWriter* writer) const;
+
+  void AddInput(const std::string& source_path, uint64_t content_hash,
+                const std::string& output_path);
+
+  // Returns the output recorded for source_path if its content had the same hash, nullptr if the
+  // input has to be compiled.
+  const std::string* FindOutput(const std::string& source_path, uint64_t content_hash) const;
+
+  size_t size() const {
+    return inputs_.size();
+  }
+
+  // 64-bit FNV-1a. Stable across hosts and builds, unlike std::hash.
+  static uint64_t Hash(const void* data, size_t len);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(CompileManifest);
+
+  struct Input {
+    uint64_t content_hash;
+    std::string output_path;
+  };
+
+  uint64_t options_hash_;
+  std::map<std::string, Input> inputs_;
+};
+
+}  // namespace aapt
+
+#endif /* AAPT_COMPILE_COMPILEMANIFEST_H */
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compile/CompileManifest.h"
+
+#include <cstring>
+
+#include "io/Data.h"
+#include "test/Test.h"
+
+namespace aapt {
+
+namespace {
+
+// Keeps the content of the last entry written to it.
+class StringArchiveWriter : public IArchiveWriter {
+ public:
+  bool WriteFile(const android::StringPiece& path, uint32_t flags, io::InputStream* in) override {
+    return false;
+  }
+
+  bool StartEntry(const android::StringPiece& path, uint32_t flags) override {
+    path_ = path.to_string();
+    data_.clear();
+    return true;
+  }
+
+  bool FinishEntry() override {
+    return true;
+  }
+
+  bool Write(const void* data, int len) override {
+    data_.append(static_cast<const char*>(data), len);
+    return true;
+  }
+
+  bool HadError() const override {
+    return false;
+  }
+
+  std::string GetError() const override {
+    return {};
+  }
+
+  std::string path_;
+  std::string data_;
+};
+
+class StringFile : public io::IFile {
+ public:
+  explicit StringFile(const std::string& data) : data_(data), source_("manifest") {}
+
+  std::unique_ptr<io::IData> OpenAsData() override {
+    std::unique_ptr<uint8_t[]> copy(new uint8_t[data_.size()]);
+    memcpy(copy.get(), data_.data(), data_.size());
+    return util::make_unique<io::MallocData>(std::move(copy), data_.size());
+  }
+
+  const Source& GetSource() const override {
+    return source_;
+  }
+
+ private:
+  std::string data_;
+  Source source_;
+};
+
+}  // namespace
+
+TEST(CompileManifestTest, FindOutputMatchesContentHash) {
+  CompileManifest manifest(1u);
+  manifest.AddInput("res/values/strings.xml", 42u, "values_strings.arsc.flat");
+
+  const std::string* output = manifest.FindOutput("res/values/strings.xml", 42u);
+  ASSERT_NE(nullptr, output);
+  EXPECT_EQ("values_strings.arsc.flat", *output);
+
+  EXPECT_EQ(nullptr, manifest.FindOutput("res/values/strings.xml", 43u));
+  EXPECT_EQ(nullptr, manifest.FindOutput("res/values/colors.xml", 42u));
+}
+
+TEST(CompileManifestTest, WriteAndLoad) {
+  std::unique_ptr<IAaptContext> context = test::ContextBuilder().Build();
+
+  CompileManifest manifest(1u);
+  manifest.AddInput("res/values/strings.xml", 42u, "values_strings.arsc.flat");
+  manifest.AddInput("res/layout/main.xml", 7u, "layout_main.xml.flat");
+
+  StringArchiveWriter writer;
+  ASSERT_TRUE(manifest.WriteToArchive(context.get(), &writer));
+  EXPECT_EQ(CompileManifest::kEntryName, writer.path_);
+
+  StringFile file(writer.data_);
+  CompileManifest loaded(1u);
+  ASSERT_TRUE(loaded.Load(&file));
+  EXPECT_EQ(2u, loaded.size());
+  const std::string* output = loaded.FindOutput("res/layout/main.xml", 7u);
+  ASSERT_NE(nullptr, output);
+  EXPECT_EQ("layout_main.xml.flat", *output);
+
+  // Outputs compiled with other options can't be reused.
+  CompileManifest other_options(2u);
+  EXPECT_FALSE(other_options.Load(&file));
+  EXPECT_EQ(0u, other_options.size());
+}
+
+TEST(CompileManifestTest, LoadRejectsCorruptManifest) {
+  StringFile file("not a manifest");
+  CompileManifest manifest(1u);
+  EXPECT_FALSE(manifest.Load(&file));
+  EXPECT_EQ(0u, manifest.size());
+}
+
+TEST(CompileManifestTest, HashIsStable) {
+  EXPECT_EQ(0xcbf29ce484222325u, CompileManifest::Hash("", 0u));
+  EXPECT_EQ(0xaf63dc4c8601ec8cu, CompileManifest::Hash("a", 1u));
+  EXPECT_NE(CompileManifest::Hash("ab", 2u), CompileManifest::Hash("ba", 2u));
+}
+
+}  // namespace aapt
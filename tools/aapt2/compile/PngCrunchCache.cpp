@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compile/PngCrunchCache.h"
+
+#include <inttypes.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#include "android-base/file.h"
+#include "android-base/stringprintf.h"
+
+#include "compile/CompileManifest.h"
+#include "util/Files.h"
+#include "util/Util.h"
+
+using android::StringPiece;
+using android::base::StringPrintf;
+
+namespace aapt {
+
+std::string PngCrunchCache::MakeKey(const StringPiece& content, bool nine_patch) {
+  // Any other version of aapt2 may crunch differently, so it never uses our PNGs.
+  static const uint64_t tool_hash = [] {
+    const std::string fingerprint = util::GetToolFingerprint();
+    return CompileManifest::Hash(fingerprint.data(), fingerprint.size());
+  }();
+  const uint64_t content_hash = CompileManifest::Hash(content.data(), content.size());
+  return StringPrintf("%08" PRIx32 "-%016" PRIx64 "-%zx%s.png", static_cast<uint32_t>(tool_hash),
+                      content_hash, content.size(), nine_patch ? ".9" : "");
+}
+
+bool PngCrunchCache::Find(const std::string& key, BigBuffer* out) const {
+  std::string path = dir_;
+  file::AppendPath(&path, key);
+
+  std::string content;
+  if (!android::base::ReadFileToString(path, &content) || content.empty()) {
+    return false;
+  }
+  memcpy(out->NextBlock<char>(content.size()), content.data(), content.size());
+  return true;
+}
+
+bool PngCrunchCache::Store(const std::string& key, const BigBuffer& png) const {
+  std::string content;
+  content.reserve(png.size());
+  for (const auto& block : png) {
+    content.append(reinterpret_cast<const char*>(block.buffer.get()), block.size);
+  }
+
+  // Write to a name nobody else uses, then rename it into place, so that other threads and
+  // processes never see a partially written PNG.
+  static std::atomic<uint32_t> next_temp_id(0);
+  std::string path = dir_;
+  file::AppendPath(&path, key);
+  const std::string temp_path =
+      StringPrintf("%s.%d.%u.tmp", path.c_str(), getpid(), next_temp_id++);
+  if (!android::base::WriteStringToFile(content, temp_path)) {
+    unlink(temp_path.c_str());
+    return false;
+  }
+
+  if (rename(temp_path.c_str(), path.c_str()) != 0) {
+    // On Windows, rename fails when the PNG was already stored by someone else.
+    unlink(temp_path.c_str());
+    return file::GetFileType(path) == file::FileType::kRegular;
+  }
+  return true;
+}
+
+}  // namespace aapt
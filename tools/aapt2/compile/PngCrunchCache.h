@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AAPT_COMPILE_PNGCRUNCHCACHE_H
+#define AAPT_COMPILE_PNGCRUNCHCACHE_H
+
+#include <string>
+
+#include "android-base/macros.h"
+#include "androidfw/StringPiece.h"
+
+#include "util/BigBuffer.h"
+
+namespace aapt {
+
+// A directory of crunched PNGs, keyed by the content of the original PNG and the options it was
+// crunched with, so that images that did not change are not re-encoded by later builds. The
+// directory can be shared by several threads and several aapt2 processes.
+//
+// Nothing is ever removed from the directory: PNGs that are no longer built, or that were crunched
+// by another version of aapt2, stay there until whoever owns the directory cleans it up.
+class PngCrunchCache {
+ public:
+  explicit PngCrunchCache(const std::string& dir) : dir_(dir) {}
+
+  // Returns the key of a PNG with the given content. It also covers the crunch options and the
+  // version of aapt2, so that cached PNGs are never used for another kind of output.
+  static std::string MakeKey(const android::StringPiece& content, bool nine_patch);
+
+  // Appends the crunched PNG stored for key to out. Returns false if there is none.
+  bool Find(const std::string& key, BigBuffer* out) const;
+
+  // Stores the crunched PNG for key. A failure is not an error: the PNG is crunched again the
+  // next time it is needed.
+  bool Store(const std::string& key, const BigBuffer& png) const;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(PngCrunchCache);
+
+  std::string dir_;
+};
+
+}  // namespace aapt
+
+#endif /* AAPT_COMPILE_PNGCRUNCHCACHE_H */
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compile/PngCrunchCache.h"
+
+#include <cstring>
+
+#include "android-base/test_utils.h"
+
+#include "test/Test.h"
+
+namespace aapt {
+
+static std::string ToString(const BigBuffer& buffer) {
+  std::string str;
+  for (const auto& block : buffer) {
+    str.append(reinterpret_cast<const char*>(block.buffer.get()), block.size);
+  }
+  return str;
+}
+
+TEST(PngCrunchCacheTest, KeyDependsOnContentAndOptions) {
+  const std::string key = PngCrunchCache::MakeKey("png", false /*nine_patch*/);
+  EXPECT_EQ(key, PngCrunchCache::MakeKey("png", false /*nine_patch*/));
+  EXPECT_NE(key, PngCrunchCache::MakeKey("pnG", false /*nine_patch*/));
+  EXPECT_NE(key, PngCrunchCache::MakeKey("png", true /*nine_patch*/));
+}
+
+TEST(PngCrunchCacheTest, StoreAndFind) {
+  TemporaryDir dir;
+  PngCrunchCache cache(dir.path);
+  const std::string key = PngCrunchCache::MakeKey("original", false /*nine_patch*/);
+
+  BigBuffer found(16);
+  EXPECT_FALSE(cache.Find(key, &found));
+
+  BigBuffer crunched(4);
+  const char kCrunched[] = "crunched png";
+  memcpy(crunched.NextBlock<char>(sizeof(kCrunched)), kCrunched, sizeof(kCrunched));
+  ASSERT_TRUE(cache.Store(key, crunched));
+
+  ASSERT_TRUE(cache.Find(key, &found));
+  EXPECT_EQ(ToString(crunched), ToString(found));
+
+  // Storing the same PNG again, as another build would, is fine.
+  EXPECT_TRUE(cache.Store(key, crunched));
+}
+
+}  // namespace aapt
@@ -16,15 +16,19 @@
 
 #include "flatten/Archive.h"
 
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include <unistd.h>
+#include <zlib.h>
+
 #include "android-base/errors.h"
 #include "android-base/macros.h"
 #include "androidfw/StringPiece.h"
-#include "ziparchive/zip_writer.h"
 
 #include "util/Files.h"
 
@@ -116,6 +120,59 @@ class DirectoryWriter : public IArchiveWriter {
   std::string error_;
 };
 
+// Deflates the content of buffer the way zip archives store it, and computes its CRC-32.
+bool Deflate(const BigBuffer& buffer, std::string* out_deflated, uint32_t* out_crc32) {
+  z_stream stream = {};
+  if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) !=
+      Z_OK) {
+    return false;
+  }
+
+  uint32_t crc = crc32(0u, nullptr, 0u);
+  out_deflated->clear();
+  uint8_t chunk[16 * 1024];
+  auto block_iter = buffer.begin();
+  int flush = Z_NO_FLUSH;
+  int result = Z_OK;
+  while (result != Z_STREAM_END) {
+    if (stream.avail_in == 0 && flush == Z_NO_FLUSH) {
+      if (block_iter != buffer.end()) {
+        stream.next_in = block_iter->buffer.get();
+        stream.avail_in = static_cast<uInt>(block_iter->size);
+        crc = crc32(crc, block_iter->buffer.get(), static_cast<uInt>(block_iter->size));
+        ++block_iter;
+      } else {
+        flush = Z_FINISH;
+      }
+    }
+
+    stream.next_out = chunk;
+    stream.avail_out = sizeof(chunk);
+    result = deflate(&stream, flush);
+    if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+      deflateEnd(&stream);
+      return false;
+    }
+    out_deflated->append(reinterpret_cast<const char*>(chunk), sizeof(chunk) - stream.avail_out);
+  }
+  deflateEnd(&stream);
+  *out_crc32 = crc;
+  return true;
+}
+
+void PutUint16(std::string* out, uint16_t value) {
+  out->push_back(static_cast<char>(value & 0xff));
+  out->push_back(static_cast<char>(value >> 8));
+}
+
+void PutUint32(std::string* out, uint32_t value) {
+  PutUint16(out, static_cast<uint16_t>(value & 0xffff));
+  PutUint16(out, static_cast<uint16_t>(value >> 16));
+}
+
+// Writes a zip archive one entry at a time. Entry data goes straight to the file, deflated on the
+// fly if requested, and the checksum and sizes in the entry's local header are filled in once it
+// is finished. Entries that were deflated elsewhere are copied byte-for-byte.
 class ZipFileWriter : public IArchiveWriter {
  public:
   ZipFileWriter() = default;
@@ -126,45 +183,96 @@ class ZipFileWriter : public IArchiveWriter {
       error_ = android::base::SystemErrorCodeToString(errno);
       return false;
     }
-    writer_ = util::make_unique<ZipWriter>(file_.get());
     return true;
   }
 
   bool StartEntry(const StringPiece& path, uint32_t flags) override {
-    if (!writer_) {
+    if (!file_) {
       return false;
     }
 
-    size_t zip_flags = 0;
-    if (flags & ArchiveEntry::kCompress) {
-      zip_flags |= ZipWriter::kCompress;
+    if (in_entry_) {
+      error_ = "entry already started";
+      return false;
     }
 
-    if (flags & ArchiveEntry::kAlign) {
-      zip_flags |= ZipWriter::kAlign32;
+    uint16_t method = kCompressStored;
+    if (flags & ArchiveEntry::kCompress) {
+      stream_ = {};
+      if (deflateInit2(&stream_, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                       Z_DEFAULT_STRATEGY) != Z_OK) {
+        error_ = "failed to deflate " + path.to_string();
+        return false;
+      }
+      method = kCompressDeflated;
     }
 
-    int32_t result = writer_->StartEntry(path.data(), zip_flags);
-    if (result != 0) {
-      error_ = ZipWriter::ErrorCodeString(result);
+    // The checksum and sizes are filled in by FinishEntry().
+    if (!WriteHeader(path.to_string(), method, 0u, 0u, 0u, flags)) {
+      if (method == kCompressDeflated) {
+        deflateEnd(&stream_);
+      }
       return false;
     }
+
+    in_entry_ = true;
+    entry_data_offset_ = offset_;
+    entry_crc32_ = crc32(0u, nullptr, 0u);
+    entry_uncompressed_size_ = 0u;
     return true;
   }
 
   bool Write(const void* data, int len) override {
-    int32_t result = writer_->WriteBytes(data, len);
-    if (result != 0) {
-      error_ = ZipWriter::ErrorCodeString(result);
+    if (!in_entry_) {
+      error_ = "no entry started";
       return false;
     }
-    return true;
+
+    entry_crc32_ = crc32(entry_crc32_, static_cast<const Bytef*>(data), static_cast<uInt>(len));
+    entry_uncompressed_size_ += len;
+    if (records_.back().method == kCompressStored) {
+      return WriteBytes(data, len);
+    }
+
+    // zlib doesn't write to its input, but not all versions declare it const.
+    stream_.next_in = static_cast<Bytef*>(const_cast<void*>(data));
+    stream_.avail_in = static_cast<uInt>(len);
+    return WriteDeflated(Z_NO_FLUSH);
   }
 
   bool FinishEntry() override {
-    int32_t result = writer_->FinishEntry();
-    if (result != 0) {
-      error_ = ZipWriter::ErrorCodeString(result);
+    if (!in_entry_) {
+      error_ = "no entry started";
+      return false;
+    }
+    in_entry_ = false;
+
+    Record& record = records_.back();
+    if (record.method == kCompressDeflated) {
+      const bool deflated = WriteDeflated(Z_FINISH);
+      deflateEnd(&stream_);
+      if (!deflated) {
+        return false;
+      }
+    }
+
+    const size_t compressed_size = offset_ - entry_data_offset_;
+    if (compressed_size > UINT32_MAX || entry_uncompressed_size_ > UINT32_MAX) {
+      error_ = "archive too large for the zip format";
+      return false;
+    }
+    record.crc32 = entry_crc32_;
+    record.compressed_size = static_cast<uint32_t>(compressed_size);
+    record.uncompressed_size = static_cast<uint32_t>(entry_uncompressed_size_);
+
+    std::string fields;
+    PutUint32(&fields, record.crc32);
+    PutUint32(&fields, record.compressed_size);
+    PutUint32(&fields, record.uncompressed_size);
+    if (fseeko(file_.get(), record.offset + kLocalHeaderCrc32Offset, SEEK_SET) != 0 ||
+        fwrite(fields.data(), 1, fields.size(), file_.get()) != fields.size() ||
+        fseeko(file_.get(), offset_, SEEK_SET) != 0) {
+      error_ = android::base::SystemErrorCodeToString(errno);
       return false;
     }
     return true;
@@ -185,6 +293,7 @@ class ZipFileWriter : public IArchiveWriter {
       }
 
       if (in->HadError()) {
+        error_ = in->GetError();
         return false;
       }
 
@@ -193,27 +302,19 @@ class ZipFileWriter : public IArchiveWriter {
       }
 
       // Check to see if the file was compressed enough. This is preserving behavior of AAPT.
-      if ((flags & ArchiveEntry::kCompress) != 0 && in->CanRewind()) {
-        ZipWriter::FileEntry last_entry;
-        int32_t result = writer_->GetLastEntry(&last_entry);
-        CHECK(result == 0);
-        if (last_entry.compressed_size + (last_entry.compressed_size / 10) >
-            last_entry.uncompressed_size) {
-          // The file was not compressed enough, rewind and store it uncompressed.
-          if (!in->Rewind()) {
-            // Well we tried, may as well keep what we had.
-            return true;
-          }
-
-          int32_t result = writer_->DiscardLastEntry();
-          if (result != 0) {
-            error_ = ZipWriter::ErrorCodeString(result);
-            return false;
-          }
-          flags &= ~ArchiveEntry::kCompress;
-
-          continue;
+      const Record& record = records_.back();
+      if ((flags & ArchiveEntry::kCompress) && in->CanRewind() &&
+          !IsWorthDeflating(record.compressed_size, record.uncompressed_size)) {
+        if (!in->Rewind()) {
+          // Well we tried, may as well keep what we had.
+          return true;
+        }
+
+        if (!DiscardLastEntry()) {
+          return false;
         }
+        flags &= ~ArchiveEntry::kCompress;
+        continue;
       }
       return true;
     }
@@ -223,22 +324,292 @@ class ZipFileWriter : public IArchiveWriter {
 
   std::string GetError() const override { return error_; }
 
+  bool SupportsDeflatedData() const override { return true; }
+
+  bool WriteDeflatedFile(const StringPiece& path, const DeflatedData& data) override {
+    if (!file_ || in_entry_) {
+      error_ = "can't write a deflated file while an entry is started";
+      return false;
+    }
+
+    if (!WriteHeader(path.to_string(), kCompressDeflated, data.crc32, data.size,
+                     data.uncompressed_size, 0u /*flags*/)) {
+      return false;
+    }
+    return WriteBytes(data.data, data.size);
+  }
+
   virtual ~ZipFileWriter() {
-    if (writer_) {
-      writer_->Finish();
+    if (in_entry_ && records_.back().method == kCompressDeflated) {
+      deflateEnd(&stream_);
+    }
+    if (file_) {
+      WriteCentralDirectory();
     }
   }
 
  private:
   DISALLOW_COPY_AND_ASSIGN(ZipFileWriter);
 
+  enum : uint16_t {
+    kCompressStored = 0,
+    kCompressDeflated = 8,
+  };
+
+  // What the central directory records about each entry.
+  struct Record {
+    std::string path;
+    uint16_t method;
+    uint32_t crc32;
+    uint32_t compressed_size;
+    uint32_t uncompressed_size;
+    uint32_t offset;
+  };
+
+  // Deflates the pending input of the current entry and writes out what is produced. With
+  // Z_FINISH, also flushes the end of the stream.
+  bool WriteDeflated(int flush) {
+    uint8_t chunk[16 * 1024];
+    do {
+      stream_.next_out = chunk;
+      stream_.avail_out = sizeof(chunk);
+      if (deflate(&stream_, flush) == Z_STREAM_ERROR) {
+        error_ = "failed to deflate " + records_.back().path;
+        return false;
+      }
+      if (!WriteBytes(chunk, sizeof(chunk) - stream_.avail_out)) {
+        return false;
+      }
+    } while (stream_.avail_out == 0);
+    return true;
+  }
+
+  // Rewinds the file to the start of the last entry, which later writes overwrite.
+  bool DiscardLastEntry() {
+    offset_ = records_.back().offset;
+    records_.pop_back();
+    if (fseeko(file_.get(), offset_, SEEK_SET) != 0) {
+      error_ = android::base::SystemErrorCodeToString(errno);
+      return false;
+    }
+    return true;
+  }
+
+  // Writes the local file header of an entry, padded so that its data starts on a 4 byte boundary
+  // if flags has ArchiveEntry::kAlign, and records it for the central directory.
+  bool WriteHeader(const std::string& path, uint16_t method, uint32_t crc32,
+                   size_t compressed_size, size_t uncompressed_size, uint32_t flags) {
+    if (compressed_size > UINT32_MAX || uncompressed_size > UINT32_MAX || offset_ > UINT32_MAX ||
+        records_.size() >= UINT16_MAX || path.size() > UINT16_MAX) {
+      error_ = "archive too large for the zip format";
+      return false;
+    }
+
+    const size_t header_size = kLocalHeaderSize + path.size();
+    size_t padding = 0u;
+    if (flags & ArchiveEntry::kAlign) {
+      padding = (4u - ((offset_ + header_size) % 4u)) % 4u;
+    }
+
+    records_.push_back(Record{path, method, crc32, static_cast<uint32_t>(compressed_size),
+                              static_cast<uint32_t>(uncompressed_size),
+                              static_cast<uint32_t>(offset_)});
+
+    std::string header;
+    PutUint32(&header, kLocalHeaderSignature);
+    PutUint16(&header, kVersion);
+    PutUint16(&header, 0u);  // General purpose flags.
+    PutUint16(&header, method);
+    PutUint16(&header, kDosTime);
+    PutUint16(&header, kDosDate);
+    PutUint32(&header, crc32);
+    PutUint32(&header, static_cast<uint32_t>(compressed_size));
+    PutUint32(&header, static_cast<uint32_t>(uncompressed_size));
+    PutUint16(&header, static_cast<uint16_t>(path.size()));
+    PutUint16(&header, static_cast<uint16_t>(padding));
+    header += path;
+    header.append(padding, '\0');
+    return WriteBytes(header.data(), header.size());
+  }
+
+  bool WriteBytes(const void* data, size_t len) {
+    if (fwrite(data, 1, len, file_.get()) != len) {
+      error_ = android::base::SystemErrorCodeToString(errno);
+      return false;
+    }
+    offset_ += len;
+    return true;
+  }
+
+  void WriteCentralDirectory() {
+    const size_t directory_offset = offset_;
+    std::string directory;
+    for (const Record& record : records_) {
+      PutUint32(&directory, kCentralHeaderSignature);
+      PutUint16(&directory, kVersion);  // Version made by.
+      PutUint16(&directory, kVersion);  // Version needed to extract.
+      PutUint16(&directory, 0u);        // General purpose flags.
+      PutUint16(&directory, record.method);
+      PutUint16(&directory, kDosTime);
+      PutUint16(&directory, kDosDate);
+      PutUint32(&directory, record.crc32);
+      PutUint32(&directory, record.compressed_size);
+      PutUint32(&directory, record.uncompressed_size);
+      PutUint16(&directory, static_cast<uint16_t>(record.path.size()));
+      PutUint16(&directory, 0u);  // Extra field length.
+      PutUint16(&directory, 0u);  // Comment length.
+      PutUint16(&directory, 0u);  // Disk number.
+      PutUint16(&directory, 0u);  // Internal attributes.
+      PutUint32(&directory, 0u);  // External attributes.
+      PutUint32(&directory, record.offset);
+      directory += record.path;
+    }
+
+    const size_t directory_size = directory.size();
+    PutUint32(&directory, kEndOfCentralDirectorySignature);
+    PutUint16(&directory, 0u);  // Disk number.
+    PutUint16(&directory, 0u);  // Disk with the central directory.
+    PutUint16(&directory, static_cast<uint16_t>(records_.size()));
+    PutUint16(&directory, static_cast<uint16_t>(records_.size()));
+    PutUint32(&directory, static_cast<uint32_t>(directory_size));
+    PutUint32(&directory, static_cast<uint32_t>(directory_offset));
+    PutUint16(&directory, 0u);  // Comment length.
+    if (!WriteBytes(directory.data(), directory.size())) {
+      return;
+    }
+
+    // A discarded entry may have left data past the new end.
+    fflush(file_.get());
+    if (ftruncate(fileno(file_.get()), offset_) != 0) {
+      error_ = android::base::SystemErrorCodeToString(errno);
+    }
+  }
+
+  static constexpr uint32_t kLocalHeaderSignature = 0x04034b50u;
+  static constexpr uint32_t kCentralHeaderSignature = 0x02014b50u;
+  static constexpr uint32_t kEndOfCentralDirectorySignature = 0x06054b50u;
+  static constexpr size_t kLocalHeaderSize = 30u;
+  static constexpr size_t kLocalHeaderCrc32Offset = 14u;
+  static constexpr uint16_t kVersion = 20u;
+
+  // Entries are all dated 1980-01-01 00:00, the earliest date a zip archive can hold, so that
+  // the same inputs always produce the same archive.
+  static constexpr uint16_t kDosTime = 0u;
+  static constexpr uint16_t kDosDate = (1u << 5) | 1u;
+
   std::unique_ptr<FILE, decltype(fclose)*> file_ = {nullptr, fclose};
-  std::unique_ptr<ZipWriter> writer_;
+  size_t offset_ = 0u;
+  std::vector<Record> records_;
+
+  // The entry being written, whose record is the last one.
+  bool in_entry_ = false;
+  z_stream stream_ = {};
+  size_t entry_data_offset_ = 0u;
+  uint32_t entry_crc32_ = 0u;
+  size_t entry_uncompressed_size_ = 0u;
+
   std::string error_;
 };
 
 }  // namespace
 
+bool BufferedArchiveWriter::WriteFile(const StringPiece& path, uint32_t flags,
+                                      io::InputStream* in) {
+  if (!StartEntry(path, flags)) {
+    return false;
+  }
+
+  const void* data = nullptr;
+  size_t len = 0;
+  while (in->Next(&data, &len)) {
+    if (!Write(data, static_cast<int>(len))) {
+      return false;
+    }
+  }
+
+  if (in->HadError()) {
+    error_ = in->GetError();
+    return false;
+  }
+  return FinishEntry(in->CanRewind());
+}
+
+bool BufferedArchiveWriter::StartEntry(const StringPiece& path, uint32_t flags) {
+  if (in_entry_) {
+    error_ = "entry already started";
+    return false;
+  }
+  entries_.push_back(Entry{path.to_string(), flags, BigBuffer(4096), {}, 0u});
+  in_entry_ = true;
+  return true;
+}
+
+bool BufferedArchiveWriter::Write(const void* data, int len) {
+  if (!in_entry_) {
+    error_ = "no entry started";
+    return false;
+  }
+  memcpy(entries_.back().buffer.NextBlock<uint8_t>(len), data, len);
+  return true;
+}
+
+bool BufferedArchiveWriter::FinishEntry() {
+  return FinishEntry(false /*check_compression*/);
+}
+
+bool BufferedArchiveWriter::FinishEntry(bool check_compression) {
+  if (!in_entry_) {
+    error_ = "no entry started";
+    return false;
+  }
+  in_entry_ = false;
+
+  // Deflate here, so that entries written on several threads are also deflated on them.
+  Entry& entry = entries_.back();
+  if (entry.flags & ArchiveEntry::kCompress) {
+    if (!Deflate(entry.buffer, &entry.deflated, &entry.crc32)) {
+      error_ = "failed to deflate " + entry.path;
+      return false;
+    }
+
+    if (check_compression && !IsWorthDeflating(entry.deflated.size(), entry.buffer.size())) {
+      entry.deflated.clear();
+      entry.flags &= ~ArchiveEntry::kCompress;
+    }
+  }
+  return true;
+}
+
+bool BufferedArchiveWriter::CommitTo(IArchiveWriter* writer) const {
+  // Only complete entries are committed, the same as if they had been written to writer
+  // directly and the unfinished one had failed.
+  const size_t count = in_entry_ ? entries_.size() - 1 : entries_.size();
+  for (size_t i = 0; i < count; i++) {
+    const Entry& entry = entries_[i];
+    if ((entry.flags & ArchiveEntry::kCompress) && writer->SupportsDeflatedData()) {
+      const DeflatedData data = {entry.deflated.data(), entry.deflated.size(), entry.buffer.size(),
+                                 entry.crc32};
+      if (!writer->WriteDeflatedFile(entry.path, data)) {
+        return false;
+      }
+      continue;
+    }
+
+    if (!writer->StartEntry(entry.path, entry.flags)) {
+      return false;
+    }
+    for (const BigBuffer::Block& block : entry.buffer) {
+      if (!writer->Write(block.buffer.get(), static_cast<int>(block.size))) {
+        return false;
+      }
+    }
+    if (!writer->FinishEntry()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 std::unique_ptr<IArchiveWriter> CreateDirectoryArchiveWriter(IDiagnostics* diag,
                                                              const StringPiece& path) {
   std::unique_ptr<DirectoryWriter> writer = util::make_unique<DirectoryWriter>();
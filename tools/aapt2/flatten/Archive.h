@@ -22,6 +22,7 @@
 #include <string>
 #include <vector>
 
+#include "android-base/macros.h"
 #include "androidfw/StringPiece.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 
@@ -43,6 +44,22 @@ struct ArchiveEntry {
   size_t uncompressed_size;
 };
 
+// Data that was already deflated, either when it was stored in another zip archive or on another
+// thread, along with what a zip archive records about its content.
+struct DeflatedData {
+  const void* data;
+  size_t size;
+  size_t uncompressed_size;
+  uint32_t crc32;
+};
+
+// Whether deflating data of uncompressed_size down to deflated_size saved enough to be worth
+// inflating it again at runtime. Entries that shrink by less than 10% are stored uncompressed,
+// preserving the behavior of AAPT.
+inline bool IsWorthDeflating(size_t deflated_size, size_t uncompressed_size) {
+  return deflated_size + (deflated_size / 10) <= uncompressed_size;
+}
+
 class IArchiveWriter : public ::google::protobuf::io::CopyingOutputStream {
  public:
   virtual ~IArchiveWriter() = default;
@@ -68,6 +85,64 @@ class IArchiveWriter : public ::google::protobuf::io::CopyingOutputStream {
 
   // Returns the error message if HadError() returns true.
   virtual std::string GetError() const = 0;
+
+  // Returns true if this writer can take entries that were already deflated, through
+  // WriteDeflatedFile().
+  virtual bool SupportsDeflatedData() const {
+    return false;
+  }
+
+  // Writes a compressed entry from data that was already deflated, byte-for-byte. Only valid if
+  // SupportsDeflatedData() returns true.
+  virtual bool WriteDeflatedFile(const android::StringPiece& path, const DeflatedData& data) {
+    return false;
+  }
+};
+
+// Keeps the entries written to it in memory, so that files can be produced on worker threads
+// and written to the real archive later, in a deterministic order.
+class BufferedArchiveWriter : public IArchiveWriter {
+ public:
+  BufferedArchiveWriter() = default;
+
+  bool WriteFile(const android::StringPiece& path, uint32_t flags, io::InputStream* in) override;
+  bool StartEntry(const android::StringPiece& path, uint32_t flags) override;
+  bool FinishEntry() override;
+  bool Write(const void* data, int len) override;
+
+  bool HadError() const override {
+    return !error_.empty();
+  }
+
+  std::string GetError() const override {
+    return error_;
+  }
+
+  // Writes every finished entry to writer, in the order they were started. Compressed entries
+  // were deflated as they were finished, on the thread that wrote them, and are committed as-is
+  // to writers that support deflated data. On failure the error is available from
+  // writer->GetError().
+  bool CommitTo(IArchiveWriter* writer) const;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(BufferedArchiveWriter);
+
+  bool FinishEntry(bool check_compression);
+
+  struct Entry {
+    std::string path;
+    uint32_t flags;
+
+    BigBuffer buffer;
+
+    // The deflated content and its checksum, set once a compressed entry is finished.
+    std::string deflated;
+    uint32_t crc32;
+  };
+
+  std::vector<Entry> entries_;
+  bool in_entry_ = false;
+  std::string error_;
 };
 
 std::unique_ptr<IArchiveWriter> CreateDirectoryArchiveWriter(IDiagnostics* diag,
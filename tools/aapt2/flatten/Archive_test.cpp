@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flatten/Archive.h"
+
+#include "android-base/test_utils.h"
+
+#include "io/BigBufferInputStream.h"
+#include "io/Util.h"
+#include "io/ZipArchive.h"
+#include "test/Test.h"
+
+namespace aapt {
+
+// Compresses very well, unlike random data.
+static std::string MakeText() {
+  std::string text;
+  for (int i = 0; i < 1000; i++) {
+    text += "line " + std::to_string(i % 10) + "\n";
+  }
+  return text;
+}
+
+static bool WriteString(IArchiveWriter* writer, const std::string& path, uint32_t flags,
+                        const std::string& content) {
+  BigBuffer buffer(1024);
+  memcpy(buffer.NextBlock<char>(content.size()), content.data(), content.size());
+  io::BigBufferInputStream in(&buffer);
+  return writer->WriteFile(path, flags, &in);
+}
+
+static std::string ReadString(io::IFile* file) {
+  std::unique_ptr<io::IData> data = file->OpenAsData();
+  if (!data) {
+    return {};
+  }
+  return std::string(static_cast<const char*>(data->data()), data->size());
+}
+
+TEST(ArchiveTest, WriteZipFile) {
+  TemporaryDir dir;
+  const std::string path = std::string(dir.path) + "/out.zip";
+  const std::string text = MakeText();
+  {
+    std::unique_ptr<IArchiveWriter> writer =
+        CreateZipFileArchiveWriter(test::GetDiagnostics(), path);
+    ASSERT_NE(nullptr, writer);
+    ASSERT_TRUE(WriteString(writer.get(), "text", ArchiveEntry::kCompress, text));
+    ASSERT_TRUE(WriteString(writer.get(), "stored", 0u, text));
+    ASSERT_TRUE(WriteString(writer.get(), "tiny", ArchiveEntry::kCompress, "x"));
+  }
+
+  std::unique_ptr<io::ZipFileCollection> collection =
+      io::ZipFileCollection::Create(path, nullptr);
+  ASSERT_NE(nullptr, collection);
+
+  io::IFile* file = collection->FindFile("text");
+  ASSERT_NE(nullptr, file);
+  EXPECT_TRUE(file->WasCompressed());
+  EXPECT_EQ(text, ReadString(file));
+
+  file = collection->FindFile("stored");
+  ASSERT_NE(nullptr, file);
+  EXPECT_FALSE(file->WasCompressed());
+  EXPECT_EQ(text, ReadString(file));
+
+  // Deflating a single byte doesn't make it smaller, so it is stored instead.
+  file = collection->FindFile("tiny");
+  ASSERT_NE(nullptr, file);
+  EXPECT_FALSE(file->WasCompressed());
+  EXPECT_EQ("x", ReadString(file));
+}
+
+TEST(ArchiveTest, WriteZipFileEntryInParts) {
+  TemporaryDir dir;
+  const std::string path = std::string(dir.path) + "/out.zip";
+  const std::string text = MakeText();
+  {
+    std::unique_ptr<IArchiveWriter> writer =
+        CreateZipFileArchiveWriter(test::GetDiagnostics(), path);
+    ASSERT_NE(nullptr, writer);
+    ASSERT_TRUE(writer->StartEntry("text", ArchiveEntry::kCompress | ArchiveEntry::kAlign));
+    for (int i = 0; i < 10; i++) {
+      ASSERT_TRUE(writer->Write(text.data(), static_cast<int>(text.size())));
+    }
+    ASSERT_TRUE(writer->FinishEntry());
+    ASSERT_TRUE(WriteString(writer.get(), "next", 0u, "x"));
+  }
+
+  std::unique_ptr<io::ZipFileCollection> collection =
+      io::ZipFileCollection::Create(path, nullptr);
+  ASSERT_NE(nullptr, collection);
+
+  io::IFile* file = collection->FindFile("text");
+  ASSERT_NE(nullptr, file);
+  EXPECT_TRUE(file->WasCompressed());
+  std::string expected;
+  for (int i = 0; i < 10; i++) {
+    expected += text;
+  }
+  EXPECT_EQ(expected, ReadString(file));
+
+  file = collection->FindFile("next");
+  ASSERT_NE(nullptr, file);
+  EXPECT_EQ("x", ReadString(file));
+}
+
+TEST(ArchiveTest, CopyDeflatedFileAsIs) {
+  std::unique_ptr<IAaptContext> context = test::ContextBuilder().Build();
+  TemporaryDir dir;
+  const std::string in_path = std::string(dir.path) + "/in.zip";
+  const std::string out_path = std::string(dir.path) + "/out.zip";
+  const std::string text = MakeText();
+  {
+    std::unique_ptr<IArchiveWriter> writer =
+        CreateZipFileArchiveWriter(test::GetDiagnostics(), in_path);
+    ASSERT_NE(nullptr, writer);
+    ASSERT_TRUE(WriteString(writer.get(), "text", ArchiveEntry::kCompress, text));
+  }
+
+  std::unique_ptr<io::ZipFileCollection> in = io::ZipFileCollection::Create(in_path, nullptr);
+  ASSERT_NE(nullptr, in);
+  io::IFile* in_file = in->FindFile("text");
+  ASSERT_NE(nullptr, in_file);
+  {
+    std::unique_ptr<IArchiveWriter> writer =
+        CreateZipFileArchiveWriter(test::GetDiagnostics(), out_path);
+    ASSERT_NE(nullptr, writer);
+    ASSERT_TRUE(io::CopyFileToArchive(context.get(), in_file, "copy", ArchiveEntry::kCompress,
+                                      writer.get()));
+  }
+
+  std::unique_ptr<io::ZipFileCollection> out = io::ZipFileCollection::Create(out_path, nullptr);
+  ASSERT_NE(nullptr, out);
+  io::IFile* out_file = out->FindFile("copy");
+  ASSERT_NE(nullptr, out_file);
+  EXPECT_EQ(text, ReadString(out_file));
+
+  uint32_t in_crc32 = 0u;
+  uint32_t out_crc32 = 0u;
+  size_t in_size = 0u;
+  size_t out_size = 0u;
+  std::unique_ptr<io::IData> in_data = in_file->OpenAsDeflatedData(&in_crc32, &in_size);
+  std::unique_ptr<io::IData> out_data = out_file->OpenAsDeflatedData(&out_crc32, &out_size);
+  ASSERT_NE(nullptr, in_data);
+  ASSERT_NE(nullptr, out_data);
+  EXPECT_EQ(in_crc32, out_crc32);
+  EXPECT_EQ(text.size(), out_size);
+  ASSERT_EQ(in_data->size(), out_data->size());
+  EXPECT_EQ(0, memcmp(in_data->data(), out_data->data(), in_data->size()));
+}
+
+TEST(ArchiveTest, BufferedWriterCommitsDeflatedEntries) {
+  TemporaryDir dir;
+  const std::string path = std::string(dir.path) + "/out.zip";
+  const std::string text = MakeText();
+
+  BufferedArchiveWriter buffered;
+  ASSERT_TRUE(WriteString(&buffered, "a", ArchiveEntry::kCompress, text));
+  ASSERT_TRUE(WriteString(&buffered, "b", 0u, text));
+  {
+    std::unique_ptr<IArchiveWriter> writer =
+        CreateZipFileArchiveWriter(test::GetDiagnostics(), path);
+    ASSERT_NE(nullptr, writer);
+    ASSERT_TRUE(buffered.CommitTo(writer.get()));
+  }
+
+  std::unique_ptr<io::ZipFileCollection> collection =
+      io::ZipFileCollection::Create(path, nullptr);
+  ASSERT_NE(nullptr, collection);
+
+  io::IFile* file = collection->FindFile("a");
+  ASSERT_NE(nullptr, file);
+  EXPECT_TRUE(file->WasCompressed());
+  EXPECT_EQ(text, ReadString(file));
+
+  file = collection->FindFile("b");
+  ASSERT_NE(nullptr, file);
+  EXPECT_FALSE(file->WasCompressed());
+  EXPECT_EQ(text, ReadString(file));
+}
+
+}  // namespace aapt
@@ -55,6 +55,15 @@ class IFile {
     return false;
   }
 
+  // Returns the data of this file as it was deflated in its ZIP archive, without inflating it, so
+  // that it can be copied to another archive as-is. The CRC-32 and size of the content are
+  // written to out_crc32 and out_uncompressed_size.
+  // Returns nullptr if the file was not deflated or on failure.
+  virtual std::unique_ptr<IData> OpenAsDeflatedData(uint32_t* out_crc32,
+                                                    size_t* out_uncompressed_size) {
+    return {};
+  }
+
  private:
   // Any segments created from this IFile need to be owned by this IFile, so
   // keep them
@@ -37,6 +37,30 @@ bool CopyInputStreamToArchive(IAaptContext* context, InputStream* in, const std:
 
 bool CopyFileToArchive(IAaptContext* context, io::IFile* file, const std::string& out_path,
                        uint32_t compression_flags, IArchiveWriter* writer) {
+  if ((compression_flags & ArchiveEntry::kCompress) != 0 && writer->SupportsDeflatedData()) {
+    // Copy files that are already deflated byte-for-byte, rather than inflating them only to
+    // deflate them again. Files that did not compress well enough are stored instead, as when
+    // deflating them here.
+    DeflatedData deflated = {};
+    std::unique_ptr<io::IData> deflated_data =
+        file->OpenAsDeflatedData(&deflated.crc32, &deflated.uncompressed_size);
+    if (deflated_data && IsWorthDeflating(deflated_data->size(), deflated.uncompressed_size)) {
+      if (context->IsVerbose()) {
+        context->GetDiagnostics()->Note(DiagMessage() << "copying " << out_path
+                                                      << " to archive");
+      }
+
+      deflated.data = deflated_data->data();
+      deflated.size = deflated_data->size();
+      if (!writer->WriteDeflatedFile(out_path, deflated)) {
+        context->GetDiagnostics()->Error(DiagMessage() << "failed to write " << out_path
+                                                       << " to archive: " << writer->GetError());
+        return false;
+      }
+      return true;
+    }
+  }
+
   std::unique_ptr<io::IData> data = file->OpenAsData();
   if (!data) {
     context->GetDiagnostics()->Error(DiagMessage(file->GetSource()) << "failed to open file");
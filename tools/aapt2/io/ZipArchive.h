@@ -41,6 +41,8 @@ class ZipFile : public IFile {
   std::unique_ptr<IData> OpenAsData() override;
   const Source& GetSource() const override;
   bool WasCompressed() override;
+  std::unique_ptr<IData> OpenAsDeflatedData(uint32_t* out_crc32,
+                                            size_t* out_uncompressed_size) override;
 
  private:
   ZipArchiveHandle zip_handle_;
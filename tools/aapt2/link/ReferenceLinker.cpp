@@ -16,6 +16,8 @@
 
 #include "link/ReferenceLinker.h"
 
+#include <mutex>
+
 #include "android-base/logging.h"
 #include "androidfw/ResourceTypes.h"
 
@@ -27,6 +29,7 @@
 #include "link/Linkers.h"
 #include "process/IResourceTableConsumer.h"
 #include "process/SymbolTable.h"
+#include "util/Parallel.h"
 #include "util/Util.h"
 #include "xml/XmlUtil.h"
 
@@ -52,12 +55,14 @@ class ReferenceLinkerVisitor : public ValueVisitor {
   using ValueVisitor::Visit;
 
   ReferenceLinkerVisitor(const CallSite& callsite, IAaptContext* context, SymbolTable* symbols,
-                         StringPool* string_pool, xml::IPackageDeclStack* decl)
+                         StringPool* string_pool, std::mutex* string_pool_lock,
+                         xml::IPackageDeclStack* decl)
       : callsite_(callsite),
         context_(context),
         symbols_(symbols),
         package_decls_(decl),
-        string_pool_(string_pool) {}
+        string_pool_(string_pool),
+        string_pool_lock_(string_pool_lock) {}
 
   void Visit(Reference* ref) override {
     if (!ReferenceLinker::LinkReference(callsite_, ref, context_, symbols_, package_decls_)) {
@@ -102,8 +107,12 @@ class ReferenceLinkerVisitor : public ValueVisitor {
         entry.key.id = symbol->id;
 
         // Try to convert the value to a more specific, typed value based on the
-        // attribute it is set to.
-        entry.value = ParseValueWithAttribute(std::move(entry.value), symbol->attribute.get());
+        // attribute it is set to. This adds and releases references to the
+        // table's StringPool, which other entries may be using on other threads.
+        {
+          std::lock_guard<std::mutex> lock(*string_pool_lock_);
+          entry.value = ParseValueWithAttribute(std::move(entry.value), symbol->attribute.get());
+        }
 
         // Link/resolve the final value (mostly if it's a reference).
         entry.value->Accept(this);
@@ -174,6 +183,7 @@ class ReferenceLinkerVisitor : public ValueVisitor {
   SymbolTable* symbols_;
   xml::IPackageDeclStack* package_decls_;
   StringPool* string_pool_;
+  std::mutex* string_pool_lock_;
   bool error_ = false;
 };
 
@@ -323,36 +333,103 @@ bool ReferenceLinker::LinkReference(const CallSite& callsite, Reference* referen
   return false;
 }
 
-bool ReferenceLinker::Consume(IAaptContext* context, ResourceTable* table) {
+namespace {
+
+// A slice of a type's entries, the unit of work when linking on several threads.
+struct EntryRange {
+  ResourceTablePackage* package;
+  ResourceTableType* type;
+  size_t begin;
+  size_t end;
+};
+
+}  // namespace
+
+static bool LinkEntries(IAaptContext* context, const EntryRange& range, StringPool* string_pool,
+                        std::mutex* string_pool_lock) {
   EmptyDeclStack decl_stack;
   bool error = false;
+  for (size_t i = range.begin; i < range.end; i++) {
+    ResourceEntry* entry = range.type->entries[i].get();
+
+    // Symbol state information may be lost if there is no value for the
+    // resource.
+    if (entry->symbol_status.state != SymbolState::kUndefined && entry->values.empty()) {
+      context->GetDiagnostics()->Error(
+          DiagMessage(entry->symbol_status.source)
+          << "no definition for declared symbol '"
+          << ResourceNameRef(range.package->name, range.type->type, entry->name) << "'");
+      error = true;
+    }
+
+    CallSite callsite = {ResourceNameRef(range.package->name, range.type->type, entry->name)};
+    ReferenceLinkerVisitor visitor(callsite, context, context->GetExternalSymbols(), string_pool,
+                                   string_pool_lock, &decl_stack);
+
+    for (auto& config_value : entry->values) {
+      config_value->value->Accept(&visitor);
+    }
+
+    if (visitor.HasError()) {
+      error = true;
+    }
+  }
+  return !error;
+}
+
+bool ReferenceLinker::Consume(IAaptContext* context, ResourceTable* table) {
+  // Small enough to spread large types (strings, styles) over all threads.
+  constexpr size_t kEntriesPerRange = 256;
+
+  std::vector<EntryRange> ranges;
   for (auto& package : table->packages) {
     for (auto& type : package->types) {
-      for (auto& entry : type->entries) {
-        // Symbol state information may be lost if there is no value for the
-        // resource.
-        if (entry->symbol_status.state != SymbolState::kUndefined &&
-            entry->values.empty()) {
-          context->GetDiagnostics()->Error(
-              DiagMessage(entry->symbol_status.source)
-              << "no definition for declared symbol '"
-              << ResourceNameRef(package->name, type->type, entry->name)
-              << "'");
-          error = true;
-        }
+      for (size_t begin = 0; begin < type->entries.size(); begin += kEntriesPerRange) {
+        const size_t end = std::min(begin + kEntriesPerRange, type->entries.size());
+        ranges.push_back(EntryRange{package.get(), type.get(), begin, end});
+      }
+    }
+  }
+
+  std::mutex string_pool_lock;
+  bool error = false;
+  if (jobs_ <= 1) {
+    for (const EntryRange& range : ranges) {
+      if (!LinkEntries(context, range, &table->string_pool, &string_pool_lock)) {
+        error = true;
+      }
+    }
+    return !error;
+  }
 
-        CallSite callsite = {ResourceNameRef(package->name, type->type, entry->name)};
-        ReferenceLinkerVisitor visitor(callsite, context, context->GetExternalSymbols(),
-                                       &table->string_pool, &decl_stack);
+  // Linking a style copies the Attribute of each of its keys out of the table, so attributes are
+  // linked before anything else rather than alongside it.
+  std::vector<size_t> attr_ranges;
+  std::vector<size_t> other_ranges;
+  for (size_t i = 0; i < ranges.size(); i++) {
+    const ResourceType type = ranges[i].type->type;
+    if (type == ResourceType::kAttr || type == ResourceType::kAttrPrivate) {
+      attr_ranges.push_back(i);
+    } else {
+      other_ranges.push_back(i);
+    }
+  }
 
-        for (auto& config_value : entry->values) {
-          config_value->value->Accept(&visitor);
-        }
+  std::vector<BufferedDiagnostics> diagnostics(ranges.size());
+  std::vector<char> results(ranges.size(), false);
+  for (const std::vector<size_t>* phase : {&attr_ranges, &other_ranges}) {
+    util::ParallelFor(phase->size(), jobs_, [&](size_t i) {
+      const size_t range_index = (*phase)[i];
+      ContextWithDiagnostics range_context(context, &diagnostics[range_index]);
+      results[range_index] = LinkEntries(&range_context, ranges[range_index],
+                                         &table->string_pool, &string_pool_lock);
+    });
+  }
 
-        if (visitor.HasError()) {
-          error = true;
-        }
-      }
+  for (size_t i = 0; i < ranges.size(); i++) {
+    diagnostics[i].Replay(context->GetDiagnostics());
+    if (!results[i]) {
+      error = true;
     }
   }
   return !error;
@@ -293,4 +293,50 @@ TEST(ReferenceLinkerTest, AppsWithDifferentPackageCanNotUseEachOthersAttribute)
   EXPECT_TRUE(error.empty());
 }
 
+TEST(ReferenceLinkerTest, LinkOnSeveralThreads) {
+  test::ResourceTableBuilder builder;
+  builder.SetPackageId("com.app.test", 0x7f)
+      .AddValue("com.app.test:attr/color", ResourceId(0x7f010000),
+                test::AttributeBuilder().SetTypeMask(ResTable_map::TYPE_COLOR).Build())
+      .AddValue("com.app.test:style/Theme", ResourceId(0x7f030000),
+                test::StyleBuilder().AddItem("com.app.test:attr/color", {}).Build());
+
+  // Enough entries to be split across the threads.
+  const size_t kStringCount = 1000;
+  for (size_t i = 0; i < kStringCount; i++) {
+    builder.AddReference("com.app.test:string/s" + std::to_string(i),
+                         ResourceId(0x7f020000 | i),
+                         "string/s" + std::to_string((i + 1) % kStringCount));
+  }
+  std::unique_ptr<ResourceTable> table = builder.Build();
+
+  Style* style = test::GetValue<Style>(table.get(), "com.app.test:style/Theme");
+  ASSERT_NE(nullptr, style);
+  style->entries.back().value =
+      util::make_unique<RawString>(table->string_pool.MakeRef("#ff00ff"));
+
+  std::unique_ptr<IAaptContext> context =
+      test::ContextBuilder()
+          .SetCompilationPackage("com.app.test")
+          .SetPackageId(0x7f)
+          .SetNameManglerPolicy(NameManglerPolicy{"com.app.test"})
+          .AddSymbolSource(util::make_unique<ResourceTableSymbolSource>(table.get()))
+          .Build();
+
+  ReferenceLinker linker(4u);
+  ASSERT_TRUE(linker.Consume(context.get(), table.get()));
+
+  for (size_t i = 0; i < kStringCount; i++) {
+    Reference* ref =
+        test::GetValue<Reference>(table.get(), "com.app.test:string/s" + std::to_string(i));
+    ASSERT_NE(nullptr, ref);
+    AAPT_ASSERT_TRUE(ref->id);
+    EXPECT_EQ(ResourceId(0x7f020000 | ((i + 1) % kStringCount)), ref->id.value());
+  }
+
+  // The attribute was linked before the style that uses it.
+  ASSERT_EQ(1u, style->entries.size());
+  EXPECT_NE(nullptr, ValueCast<BinaryPrimitive>(style->entries.front().value.get()));
+}
+
 }  // namespace aapt
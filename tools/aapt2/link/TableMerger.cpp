@@ -254,17 +254,20 @@ bool TableMerger::DoMerge(const Source& src, ResourceTable* src_table,
       continue;
     }
 
+    // New entries are added to the destination type once all of them are known, in a single
+    // merge, rather than inserted one at a time into the middle of its sorted entries.
+    std::vector<std::unique_ptr<ResourceEntry>> new_entries;
+
     for (auto& src_entry : src_type->entries) {
       std::string entry_name = src_entry->name;
       if (mangle_package) {
         entry_name = NameMangler::MangleEntry(src_package->name, src_entry->name);
       }
 
-      ResourceEntry* dst_entry;
-      if (allow_new_resources || src_entry->symbol_status.allow_new) {
-        dst_entry = dst_type->FindOrCreateEntry(entry_name);
-      } else {
-        dst_entry = dst_type->FindEntry(entry_name);
+      ResourceEntry* dst_entry = dst_type->FindEntry(entry_name);
+      if (!dst_entry && (allow_new_resources || src_entry->symbol_status.allow_new)) {
+        new_entries.push_back(util::make_unique<ResourceEntry>(entry_name));
+        dst_entry = new_entries.back().get();
       }
 
       const ResourceNameRef res_name(src_package->name, src_type->type, src_entry->name);
@@ -328,6 +331,7 @@ bool TableMerger::DoMerge(const Source& src, ResourceTable* src_table,
         }
       }
     }
+    dst_type->InsertEntries(&new_entries);
   }
   return !error;
 }
@@ -365,4 +365,42 @@ TEST_F(TableMergerTest, OverlaidStyleablesAndStylesShouldBeMerged) {
               Eq(make_value(Reference(test::ParseNameOrDie("com.app.a:style/OverlayParent")))));
 }
 
+TEST_F(TableMergerTest, MergeInterleavedTables) {
+  // Each table holds every fourth entry, so that all entries but the first table's are inserted
+  // between existing ones.
+  const size_t kTableCount = 4;
+  const size_t kEntryCount = 1000;
+  std::vector<std::unique_ptr<ResourceTable>> tables;
+  for (size_t t = 0; t < kTableCount; t++) {
+    test::ResourceTableBuilder builder;
+    builder.SetPackageId("com.app.a", 0x7f);
+    for (size_t i = t; i < kEntryCount; i += kTableCount) {
+      builder.AddSimple("com.app.a:id/entry_" + std::to_string(i));
+    }
+    tables.push_back(builder.Build());
+  }
+
+  ResourceTable final_table;
+  TableMerger merger(context_.get(), &final_table, TableMergerOptions{});
+  for (auto& table : tables) {
+    ASSERT_TRUE(merger.Merge({}, table.get()));
+  }
+
+  ResourceTablePackage* package = final_table.FindPackage("com.app.a");
+  ASSERT_THAT(package, NotNull());
+  ResourceTableType* type = package->FindType(ResourceType::kId);
+  ASSERT_THAT(type, NotNull());
+  ASSERT_EQ(kEntryCount, type->entries.size());
+  EXPECT_TRUE(std::is_sorted(type->entries.begin(), type->entries.end(),
+                             [](const std::unique_ptr<ResourceEntry>& a,
+                                const std::unique_ptr<ResourceEntry>& b) -> bool {
+                               return a->name < b->name;
+                             }));
+
+  for (size_t i = 0; i < kEntryCount; i++) {
+    EXPECT_THAT(test::GetValue<Id>(&final_table, "com.app.a:id/entry_" + std::to_string(i)),
+                NotNull());
+  }
+}
+
 }  // namespace aapt
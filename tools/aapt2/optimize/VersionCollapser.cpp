@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "ResourceTable.h"
+#include "util/Parallel.h"
 
 namespace aapt {
 
@@ -68,8 +69,11 @@ FilterIterator<Iterator, Pred> make_filter_iterator(Iterator begin,
  * The exception is when there is no exact matching resource for the minSdk. The
  * next smallest
  * one will be kept.
+ * The values removed are moved into `removed`, so that the caller decides on
+ * which thread they are destroyed.
  */
-static void CollapseVersions(int min_sdk, ResourceEntry* entry) {
+static void CollapseVersions(int min_sdk, ResourceEntry* entry,
+                             std::vector<std::unique_ptr<ResourceConfigValue>>* removed) {
   // First look for all sdks less than minSdk.
   for (auto iter = entry->values.rbegin(); iter != entry->values.rend();
        ++iter) {
@@ -103,7 +107,7 @@ static void CollapseVersions(int min_sdk, ResourceEntry* entry) {
       auto filter_iter =
           make_filter_iterator(iter + 1, entry->values.rend(), pred);
       while (filter_iter.HasNext()) {
-        filter_iter.Next() = {};
+        removed->push_back(std::move(filter_iter.Next()));
       }
     }
   }
@@ -149,13 +153,21 @@ static void CollapseVersions(int min_sdk, ResourceEntry* entry) {
 
 bool VersionCollapser::Consume(IAaptContext* context, ResourceTable* table) {
   const int min_sdk = context->GetMinSdkVersion();
+  std::vector<ResourceTableType*> types;
   for (auto& package : table->packages) {
     for (auto& type : package->types) {
-      for (auto& entry : type->entries) {
-        CollapseVersions(min_sdk, entry.get());
-      }
+      types.push_back(type.get());
     }
   }
+
+  // Destroying a value releases its references into the table's StringPool, which is not
+  // thread-safe, so removed values are kept until all types are collapsed.
+  std::vector<std::vector<std::unique_ptr<ResourceConfigValue>>> removed(types.size());
+  util::ParallelFor(types.size(), jobs_, [&](size_t i) {
+    for (auto& entry : types[i]->entries) {
+      CollapseVersions(min_sdk, entry.get(), &removed[i]);
+    }
+  });
   return true;
 }
 
@@ -29,10 +29,15 @@ class VersionCollapser : public IResourceTableConsumer {
  public:
   VersionCollapser() = default;
 
+  // Collapses the types of the table on up to `jobs` threads.
+  explicit VersionCollapser(size_t jobs) : jobs_(jobs) {}
+
   bool Consume(IAaptContext* context, ResourceTable* table) override;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(VersionCollapser);
+
+  size_t jobs_ = 1;
 };
 
 } // namespace aapt
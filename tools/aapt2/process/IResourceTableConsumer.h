@@ -52,6 +52,27 @@ struct IAaptContext {
   virtual int GetMinSdkVersion() = 0;
 };
 
+// Forwards everything to another context, except for diagnostics. Work split across threads
+// reports to its own diagnostics, which are replayed in a deterministic order afterwards.
+class ContextWithDiagnostics : public IAaptContext {
+ public:
+  ContextWithDiagnostics(IAaptContext* context, IDiagnostics* diagnostics)
+      : context_(context), diagnostics_(diagnostics) {}
+
+  PackageType GetPackageType() override { return context_->GetPackageType(); }
+  SymbolTable* GetExternalSymbols() override { return context_->GetExternalSymbols(); }
+  IDiagnostics* GetDiagnostics() override { return diagnostics_; }
+  const std::string& GetCompilationPackage() override { return context_->GetCompilationPackage(); }
+  uint8_t GetPackageId() override { return context_->GetPackageId(); }
+  NameMangler* GetNameMangler() override { return context_->GetNameMangler(); }
+  bool IsVerbose() override { return context_->IsVerbose(); }
+  int GetMinSdkVersion() override { return context_->GetMinSdkVersion(); }
+
+ private:
+  IAaptContext* context_;
+  IDiagnostics* diagnostics_;
+};
+
 struct IResourceTableConsumer {
   virtual ~IResourceTableConsumer() = default;
 
@@ -64,6 +64,24 @@ void SymbolTable::PrependSource(std::unique_ptr<ISymbolSource> source) {
   cache_.clear();
 }
 
+// Number of the symbols each thread looked up last that are kept alive after the cache evicted
+// them. Callers use a result right away, but may look up a few more symbols before they are done
+// with it, and with several threads sharing the cache any of them may evict it meanwhile.
+constexpr size_t kPinnedSymbolCount = 16;
+
+static const SymbolTable::Symbol* PinSymbol(std::shared_ptr<SymbolTable::Symbol> symbol) {
+  struct PinnedSymbols {
+    std::shared_ptr<SymbolTable::Symbol> symbols[kPinnedSymbolCount];
+    size_t next = 0;
+  };
+  static thread_local PinnedSymbols pinned;
+
+  const SymbolTable::Symbol* result = symbol.get();
+  pinned.symbols[pinned.next] = std::move(symbol);
+  pinned.next = (pinned.next + 1) % kPinnedSymbolCount;
+  return result;
+}
+
 const SymbolTable::Symbol* SymbolTable::FindByName(const ResourceName& name) {
   const ResourceName* name_with_package = &name;
 
@@ -76,12 +94,17 @@ const SymbolTable::Symbol* SymbolTable::FindByName(const ResourceName& name) {
     name_with_package = &name_with_package_impl.value();
   }
 
-  // We store the name unmangled in the cache, so look it up as-is.
-  if (const std::shared_ptr<Symbol>& s = cache_.get(*name_with_package)) {
-    return s.get();
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    // We store the name unmangled in the cache, so look it up as-is.
+    if (std::shared_ptr<Symbol> s = cache_.get(*name_with_package)) {
+      return PinSymbol(std::move(s));
+    }
   }
 
-  // The name was not found in the cache. Mangle it (if necessary) and find it in our sources.
+  // The name was not found in the cache. Mangle it (if necessary) and find it in our sources,
+  // without holding the lock so that other threads can keep using the cache meanwhile.
   // Again, here we use a Maybe<> object to reserve storage if we need to mangle.
   const ResourceName* mangled_name = name_with_package;
   Maybe<ResourceName> mangled_name_impl;
@@ -99,23 +122,32 @@ const SymbolTable::Symbol* SymbolTable::FindByName(const ResourceName& name) {
   // LruCache doesn't support unique_ptr.
   std::shared_ptr<Symbol> shared_symbol(std::move(symbol));
 
-  // Since we look in the cache with the unmangled, but package prefixed
-  // name, we must put the same name into the cache.
-  cache_.put(*name_with_package, shared_symbol);
+  {
+    // Another thread may have cached the same symbol meanwhile, in which case put() keeps its
+    // copy. Both were found in the same sources.
+    std::lock_guard<std::mutex> lock(lock_);
 
-  if (shared_symbol->id) {
-    // The symbol has an ID, so we can also cache this!
-    id_cache_.put(shared_symbol->id.value(), shared_symbol);
+    // Since we look in the cache with the unmangled, but package prefixed
+    // name, we must put the same name into the cache.
+    cache_.put(*name_with_package, shared_symbol);
+
+    if (shared_symbol->id) {
+      // The symbol has an ID, so we can also cache this!
+      id_cache_.put(shared_symbol->id.value(), shared_symbol);
+    }
   }
 
   // Returns the raw pointer. Callers are not expected to hold on to this
   // between calls to Find*.
-  return shared_symbol.get();
+  return PinSymbol(std::move(shared_symbol));
 }
 
 const SymbolTable::Symbol* SymbolTable::FindById(const ResourceId& id) {
-  if (const std::shared_ptr<Symbol>& s = id_cache_.get(id)) {
-    return s.get();
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (std::shared_ptr<Symbol> s = id_cache_.get(id)) {
+      return PinSymbol(std::move(s));
+    }
   }
 
   // We did not find it in the cache, so look through the sources.
@@ -127,11 +159,14 @@ const SymbolTable::Symbol* SymbolTable::FindById(const ResourceId& id) {
   // Take ownership of the symbol into a shared_ptr. We do this because LruCache
   // doesn't support unique_ptr.
   std::shared_ptr<Symbol> shared_symbol(std::move(symbol));
-  id_cache_.put(id, shared_symbol);
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    id_cache_.put(id, shared_symbol);
+  }
 
   // Returns the raw pointer. Callers are not expected to hold on to this
   // between calls to Find*.
-  return shared_symbol.get();
+  return PinSymbol(std::move(shared_symbol));
 }
 
 const SymbolTable::Symbol* SymbolTable::FindByReference(const Reference& ref) {
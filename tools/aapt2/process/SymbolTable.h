@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "android-base/macros.h"
@@ -50,6 +51,9 @@ class ISymbolSource;
 class ISymbolTableDelegate;
 class NameMangler;
 
+// Lookups are thread-safe, so a table can be shared by linkers running on several threads. The
+// sources and the delegate are searched concurrently, outside of the lock that guards the caches.
+// Adding sources or changing the delegate is not thread-safe.
 class SymbolTable {
  public:
   struct Symbol {
@@ -86,6 +90,8 @@ class SymbolTable {
 
   // NOTE: Never hold on to the result between calls to FindByXXX. The
   // results are stored in a cache which may evict entries on subsequent calls.
+  // A result stays valid until the calling thread made a few more lookups,
+  // whatever other threads look up in the meantime.
   const Symbol* FindByName(const ResourceName& name);
 
   // NOTE: Never hold on to the result between calls to FindByXXX. The
@@ -103,6 +109,9 @@ class SymbolTable {
   std::unique_ptr<ISymbolTableDelegate> delegate_;
   std::vector<std::unique_ptr<ISymbolSource>> sources_;
 
+  // Guards the caches, which are shared by all threads.
+  std::mutex lock_;
+
   // We use shared_ptr because unique_ptr is not supported and
   // we need automatic deletion.
   android::LruCache<ResourceName, std::shared_ptr<Symbol>> cache_;
@@ -18,6 +18,7 @@
 #define AAPT_FLATTEN_TABLEPROTOSERIALIZER_H
 
 #include "android-base/macros.h"
+#include "androidfw/ResourceTypes.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 
@@ -67,6 +68,54 @@ std::unique_ptr<pb::ResourceTable> SerializeTableToPb(ResourceTable* table);
 std::unique_ptr<ResourceTable> DeserializeTableFromPb(
     const pb::ResourceTable& pbTable, const Source& source, IDiagnostics* diag);
 
+// A serialized pb::ResourceTable whose types are deserialized on demand. Loading it only decodes
+// the string pools and the names and IDs of the entries; the values of a type are materialized
+// when LoadType() is called, into a table the caller can drop as soon as it is done with it.
+// The serialized data is not copied and must outlive this object.
+class LazyResourceTablePb {
+ public:
+  struct Package {
+    Maybe<uint8_t> id;
+    std::string name;
+
+    // The serialized pb::Type messages of the package, in the order they were written.
+    std::vector<android::StringPiece> types;
+  };
+
+  LazyResourceTablePb(const Source& source, IDiagnostics* diag);
+
+  bool Load(const void* data, size_t len);
+
+  // Reports the errors of later calls to LoadType() to diag, for a table that is kept loaded
+  // longer than the diagnostics it was created with.
+  void SetDiagnostics(IDiagnostics* diag) {
+    diag_ = diag;
+  }
+
+  const std::vector<Package>& packages() const {
+    return packages_;
+  }
+
+  // Returns a table that only contains the given type of the given package.
+  std::unique_ptr<ResourceTable> LoadType(size_t package_index, size_t type_index);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(LazyResourceTablePb);
+
+  bool IndexPackage(const android::StringPiece& pb_package);
+
+  Source source_;
+  IDiagnostics* diag_;
+  android::ResStringPool value_pool_;
+  android::ResStringPool source_pool_;
+  android::ResStringPool symbol_pool_;
+  std::vector<Package> packages_;
+
+  // Names of the entries that have an ID, used to name references that only carry an ID.
+  std::map<ResourceId, ResourceName> names_;
+  std::map<ResourceId, ResourceNameRef> id_index_;
+};
+
 std::unique_ptr<pb::CompiledFile> SerializeCompiledFileToPb(
     const ResourceFile& file);
 std::unique_ptr<ResourceFile> DeserializeCompiledFileFromPb(
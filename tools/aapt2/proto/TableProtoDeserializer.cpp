@@ -18,12 +18,17 @@
 
 #include "android-base/logging.h"
 #include "androidfw/ResourceTypes.h"
+#include "google/protobuf/wire_format_lite.h"
 
 #include "ResourceTable.h"
 #include "ResourceUtils.h"
 #include "ValueVisitor.h"
 #include "proto/ProtoHelpers.h"
 
+using android::StringPiece;
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::internal::WireFormatLite;
+
 namespace aapt {
 
 namespace {
@@ -76,86 +81,97 @@ class PackagePbDeserializer {
 
     ResourceTablePackage* pkg = table->CreatePackage(pbPackage.package_name(), id);
     for (const pb::Type& pbType : pbPackage.types()) {
-      const ResourceType* resType = ParseResourceType(pbType.name());
-      if (!resType) {
-        diag_->Error(DiagMessage(source_) << "unknown type '" << pbType.name() << "'");
+      if (!DeserializeTypeFromPb(pbPackage.package_id(), pbType, table, pkg, &idIndex)) {
         return {};
       }
+    }
+
+    ReferenceIdToNameVisitor visitor(&idIndex);
+    VisitAllValuesInPackage(pkg, &visitor);
+    return true;
+  }
 
-      ResourceTableType* type = pkg->FindOrCreateType(*resType);
+  // Deserializes a single type of a package. The name of each entry with a valid ID is added
+  // to idIndex, if it is not null.
+  bool DeserializeTypeFromPb(uint32_t packageId, const pb::Type& pbType, ResourceTable* table,
+                             ResourceTablePackage* pkg,
+                             std::map<ResourceId, ResourceNameRef>* idIndex) {
+    const ResourceType* resType = ParseResourceType(pbType.name());
+    if (!resType) {
+      diag_->Error(DiagMessage(source_) << "unknown type '" << pbType.name() << "'");
+      return {};
+    }
 
-      for (const pb::Entry& pbEntry : pbType.entries()) {
-        ResourceEntry* entry = type->FindOrCreateEntry(pbEntry.name());
+    ResourceTableType* type = pkg->FindOrCreateType(*resType);
 
-        // Deserialize the symbol status (public/private with source and
-        // comments).
-        if (pbEntry.has_symbol_status()) {
-          const pb::SymbolStatus& pbStatus = pbEntry.symbol_status();
-          if (pbStatus.has_source()) {
-            DeserializeSourceFromPb(pbStatus.source(), *source_pool_, &entry->symbol_status.source);
-          }
+    for (const pb::Entry& pbEntry : pbType.entries()) {
+      ResourceEntry* entry = type->FindOrCreateEntry(pbEntry.name());
 
-          if (pbStatus.has_comment()) {
-            entry->symbol_status.comment = pbStatus.comment();
-          }
+      // Deserialize the symbol status (public/private with source and
+      // comments).
+      if (pbEntry.has_symbol_status()) {
+        const pb::SymbolStatus& pbStatus = pbEntry.symbol_status();
+        if (pbStatus.has_source()) {
+          DeserializeSourceFromPb(pbStatus.source(), *source_pool_, &entry->symbol_status.source);
+        }
 
-          entry->symbol_status.allow_new = pbStatus.allow_new();
+        if (pbStatus.has_comment()) {
+          entry->symbol_status.comment = pbStatus.comment();
+        }
 
-          SymbolState visibility = DeserializeVisibilityFromPb(pbStatus.visibility());
-          entry->symbol_status.state = visibility;
+        entry->symbol_status.allow_new = pbStatus.allow_new();
 
-          if (visibility == SymbolState::kPublic) {
-            // This is a public symbol, we must encode the ID now if there is one.
-            if (pbEntry.has_id()) {
-              entry->id = static_cast<uint16_t>(pbEntry.id());
-            }
+        SymbolState visibility = DeserializeVisibilityFromPb(pbStatus.visibility());
+        entry->symbol_status.state = visibility;
 
-            if (type->symbol_status.state != SymbolState::kPublic) {
-              // If the type has not been made public, do so now.
-              type->symbol_status.state = SymbolState::kPublic;
-              if (pbType.has_id()) {
-                type->id = static_cast<uint8_t>(pbType.id());
-              }
-            }
-          } else if (visibility == SymbolState::kPrivate) {
-            if (type->symbol_status.state == SymbolState::kUndefined) {
-              type->symbol_status.state = SymbolState::kPrivate;
+        if (visibility == SymbolState::kPublic) {
+          // This is a public symbol, we must encode the ID now if there is one.
+          if (pbEntry.has_id()) {
+            entry->id = static_cast<uint16_t>(pbEntry.id());
+          }
+
+          if (type->symbol_status.state != SymbolState::kPublic) {
+            // If the type has not been made public, do so now.
+            type->symbol_status.state = SymbolState::kPublic;
+            if (pbType.has_id()) {
+              type->id = static_cast<uint8_t>(pbType.id());
             }
           }
+        } else if (visibility == SymbolState::kPrivate) {
+          if (type->symbol_status.state == SymbolState::kUndefined) {
+            type->symbol_status.state = SymbolState::kPrivate;
+          }
         }
+      }
 
-        ResourceId resId(pbPackage.package_id(), pbType.id(), pbEntry.id());
-        if (resId.is_valid()) {
-          idIndex[resId] = ResourceNameRef(pkg->name, type->type, entry->name);
-        }
+      ResourceId resId(packageId, pbType.id(), pbEntry.id());
+      if (idIndex && resId.is_valid()) {
+        (*idIndex)[resId] = ResourceNameRef(pkg->name, type->type, entry->name);
+      }
 
-        for (const pb::ConfigValue& pbConfigValue : pbEntry.config_values()) {
-          const pb::ConfigDescription& pbConfig = pbConfigValue.config();
+      for (const pb::ConfigValue& pbConfigValue : pbEntry.config_values()) {
+        const pb::ConfigDescription& pbConfig = pbConfigValue.config();
 
-          ConfigDescription config;
-          if (!DeserializeConfigDescriptionFromPb(pbConfig, &config)) {
-            diag_->Error(DiagMessage(source_) << "invalid configuration");
-            return {};
-          }
+        ConfigDescription config;
+        if (!DeserializeConfigDescriptionFromPb(pbConfig, &config)) {
+          diag_->Error(DiagMessage(source_) << "invalid configuration");
+          return {};
+        }
 
-          ResourceConfigValue* configValue = entry->FindOrCreateValue(config, pbConfig.product());
-          if (configValue->value) {
-            // Duplicate config.
-            diag_->Error(DiagMessage(source_) << "duplicate configuration");
-            return {};
-          }
+        ResourceConfigValue* configValue = entry->FindOrCreateValue(config, pbConfig.product());
+        if (configValue->value) {
+          // Duplicate config.
+          diag_->Error(DiagMessage(source_) << "duplicate configuration");
+          return {};
+        }
 
-          configValue->value =
-              DeserializeValueFromPb(pbConfigValue.value(), config, &table->string_pool);
-          if (!configValue->value) {
-            return {};
-          }
+        configValue->value =
+            DeserializeValueFromPb(pbConfigValue.value(), config, &table->string_pool);
+        if (!configValue->value) {
+          return {};
         }
       }
     }
-
-    ReferenceIdToNameVisitor visitor(&idIndex);
-    VisitAllValuesInPackage(pkg, &visitor);
     return true;
   }
 
@@ -474,4 +490,216 @@ std::unique_ptr<ResourceFile> DeserializeCompiledFileFromPb(
   return file;
 }
 
+// Visits the fields of a serialized message without deserializing it. Length-delimited fields are
+// passed as a view into the message and varint fields as a number; other fields are skipped.
+static bool ScanPbFields(
+    const StringPiece& message,
+    const std::function<bool(int field, uint32_t number, const StringPiece& bytes)>& func) {
+  CodedInputStream in(reinterpret_cast<const uint8_t*>(message.data()),
+                      static_cast<int>(message.size()));
+  uint32_t tag;
+  while ((tag = in.ReadTag()) != 0) {
+    const int field = WireFormatLite::GetTagFieldNumber(tag);
+    switch (WireFormatLite::GetTagWireType(tag)) {
+      case WireFormatLite::WIRETYPE_VARINT: {
+        uint32_t number;
+        if (!in.ReadVarint32(&number) || !func(field, number, {})) {
+          return false;
+        }
+        break;
+      }
+
+      case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+        uint32_t len;
+        if (!in.ReadVarint32(&len)) {
+          return false;
+        }
+        const int offset = in.CurrentPosition();
+        if (!in.Skip(static_cast<int>(len)) ||
+            !func(field, 0u, StringPiece(message.data() + offset, len))) {
+          return false;
+        }
+        break;
+      }
+
+      default:
+        if (!WireFormatLite::SkipField(&in, tag)) {
+          return false;
+        }
+        break;
+    }
+  }
+  return in.ConsumedEntireMessage();
+}
+
+static bool LoadStringPoolFromPb(const StringPiece& pb_pool, android::ResStringPool* out_pool) {
+  bool loaded = false;
+  bool result = ScanPbFields(pb_pool, [&](int field, uint32_t, const StringPiece& bytes) {
+    if (field == 1) {
+      // The pool is copied, since the bytes in the message may not be aligned.
+      loaded = out_pool->setTo(bytes.data(), bytes.size(), true) == android::NO_ERROR;
+    }
+    return true;
+  });
+  return result && loaded;
+}
+
+LazyResourceTablePb::LazyResourceTablePb(const Source& source, IDiagnostics* diag)
+    : source_(source), diag_(diag) {}
+
+bool LazyResourceTablePb::Load(const void* data, size_t len) {
+  bool has_string_pool = false;
+  bool field_error = false;
+  bool result = ScanPbFields(
+      StringPiece(static_cast<const char*>(data), len),
+      [&](int field, uint32_t, const StringPiece& bytes) -> bool {
+        field_error = true;
+        switch (field) {
+          case 1:
+            has_string_pool = true;
+            if (!LoadStringPoolFromPb(bytes, &value_pool_)) {
+              diag_->Error(DiagMessage(source_) << "invalid string pool");
+              return false;
+            }
+            break;
+
+          case 2:
+            if (!LoadStringPoolFromPb(bytes, &source_pool_)) {
+              diag_->Error(DiagMessage(source_) << "invalid source pool");
+              return false;
+            }
+            break;
+
+          case 3:
+            if (!LoadStringPoolFromPb(bytes, &symbol_pool_)) {
+              diag_->Error(DiagMessage(source_) << "invalid symbol pool");
+              return false;
+            }
+            break;
+
+          case 4:
+            if (!IndexPackage(bytes)) {
+              return false;
+            }
+            break;
+        }
+        field_error = false;
+        return true;
+      });
+
+  if (!result) {
+    if (!field_error) {
+      diag_->Error(DiagMessage(source_) << "invalid compiled table");
+    }
+    return false;
+  }
+
+  if (!has_string_pool) {
+    diag_->Error(DiagMessage(source_) << "no string pool found");
+    return false;
+  }
+
+  for (const auto& entry : names_) {
+    id_index_[entry.first] = entry.second;
+  }
+  return true;
+}
+
+bool LazyResourceTablePb::IndexPackage(const StringPiece& pb_package) {
+  Package package;
+  uint32_t package_id = 0u;
+  bool result = ScanPbFields(pb_package, [&](int field, uint32_t number, const StringPiece& bytes) {
+    if (field == 1) {
+      package_id = number;
+      package.id = static_cast<uint8_t>(number);
+    } else if (field == 2) {
+      package.name = bytes.to_string();
+    } else if (field == 3) {
+      package.types.push_back(bytes);
+    }
+    return true;
+  });
+  if (!result) {
+    diag_->Error(DiagMessage(source_) << "invalid compiled table");
+    return false;
+  }
+
+  // Only the names and IDs of the entries are read here, the rest of each type is left for
+  // LoadType().
+  for (const StringPiece& pb_type : package.types) {
+    uint32_t type_id = 0u;
+    StringPiece type_name;
+    std::vector<StringPiece> pb_entries;
+    result = ScanPbFields(pb_type, [&](int field, uint32_t number, const StringPiece& bytes) {
+      if (field == 1) {
+        type_id = number;
+      } else if (field == 2) {
+        type_name = bytes;
+      } else if (field == 3) {
+        pb_entries.push_back(bytes);
+      }
+      return true;
+    });
+    if (!result) {
+      diag_->Error(DiagMessage(source_) << "invalid compiled table");
+      return false;
+    }
+
+    const ResourceType* type = ParseResourceType(type_name);
+    if (!type) {
+      diag_->Error(DiagMessage(source_) << "unknown type '" << type_name << "'");
+      return false;
+    }
+
+    for (const StringPiece& pb_entry : pb_entries) {
+      uint32_t entry_id = 0u;
+      StringPiece entry_name;
+      result = ScanPbFields(pb_entry, [&](int field, uint32_t number, const StringPiece& bytes) {
+        if (field == 1) {
+          entry_id = number;
+        } else if (field == 2) {
+          entry_name = bytes;
+        }
+        return true;
+      });
+      if (!result) {
+        diag_->Error(DiagMessage(source_) << "invalid compiled table");
+        return false;
+      }
+
+      ResourceId res_id(package_id, type_id, entry_id);
+      if (res_id.is_valid()) {
+        names_[res_id] = ResourceName(package.name, *type, entry_name);
+      }
+    }
+  }
+  packages_.push_back(std::move(package));
+  return true;
+}
+
+std::unique_ptr<ResourceTable> LazyResourceTablePb::LoadType(size_t package_index,
+                                                             size_t type_index) {
+  const Package& package = packages_[package_index];
+  const StringPiece& type_data = package.types[type_index];
+
+  pb::Type pb_type;
+  if (!pb_type.ParseFromArray(type_data.data(), static_cast<int>(type_data.size()))) {
+    diag_->Error(DiagMessage(source_) << "invalid compiled table");
+    return {};
+  }
+
+  std::unique_ptr<ResourceTable> table = util::make_unique<ResourceTable>();
+  ResourceTablePackage* pkg = table->CreatePackage(package.name, package.id);
+  PackagePbDeserializer package_pb_deserializer(&value_pool_, &source_pool_, &symbol_pool_,
+                                                source_, diag_);
+  if (!package_pb_deserializer.DeserializeTypeFromPb(package.id ? package.id.value() : 0u,
+                                                     pb_type, table.get(), pkg, nullptr)) {
+    return {};
+  }
+
+  ReferenceIdToNameVisitor visitor(&id_index_);
+  VisitAllValuesInPackage(pkg, &visitor);
+  return table;
+}
+
 }  // namespace aapt
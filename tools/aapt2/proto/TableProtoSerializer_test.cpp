@@ -117,6 +117,58 @@ TEST(TableProtoSerializer, SerializeSinglePackage) {
   EXPECT_EQ(expected_ref.id.value(), actual_ref->id.value());
 }
 
+TEST(TableProtoSerializer, LoadTypesLazily) {
+  std::unique_ptr<IAaptContext> context = test::ContextBuilder().Build();
+  std::unique_ptr<ResourceTable> table =
+      test::ResourceTableBuilder()
+          .SetPackageId("com.app.a", 0x7f)
+          .AddFileReference("com.app.a:layout/main", ResourceId(0x7f020000), "res/layout/main.xml")
+          .AddString("com.app.a:string/text", ResourceId(0x7f030000), "hi")
+          .AddValue("com.app.a:string/ref", ResourceId(0x7f030001),
+                    util::make_unique<Reference>(ResourceId(0x7f020000)))
+          .Build();
+
+  std::unique_ptr<pb::ResourceTable> pb_table = SerializeTableToPb(table.get());
+  ASSERT_NE(nullptr, pb_table);
+  std::string data;
+  ASSERT_TRUE(pb_table->SerializeToString(&data));
+
+  LazyResourceTablePb lazy_table(Source{"test"}, context->GetDiagnostics());
+  ASSERT_TRUE(lazy_table.Load(data.data(), data.size()));
+  ASSERT_EQ(1u, lazy_table.packages().size());
+
+  const LazyResourceTablePb::Package& package = lazy_table.packages()[0];
+  EXPECT_EQ("com.app.a", package.name);
+  AAPT_ASSERT_TRUE(package.id);
+  EXPECT_EQ(0x7f, package.id.value());
+  ASSERT_EQ(2u, package.types.size());
+
+  // Each type is loaded into a table of its own.
+  std::unique_ptr<ResourceTable> layouts = lazy_table.LoadType(0, 0);
+  ASSERT_NE(nullptr, layouts);
+  EXPECT_NE(nullptr, test::GetValue<FileReference>(layouts.get(), "com.app.a:layout/main"));
+  EXPECT_EQ(nullptr, test::GetValue<String>(layouts.get(), "com.app.a:string/text"));
+
+  std::unique_ptr<ResourceTable> strings = lazy_table.LoadType(0, 1);
+  ASSERT_NE(nullptr, strings);
+  String* str = test::GetValue<String>(strings.get(), "com.app.a:string/text");
+  ASSERT_NE(nullptr, str);
+  EXPECT_EQ("hi", *str->value);
+
+  // References by ID are named after entries of the other types.
+  Reference* ref = test::GetValue<Reference>(strings.get(), "com.app.a:string/ref");
+  ASSERT_NE(nullptr, ref);
+  AAPT_ASSERT_TRUE(ref->name);
+  EXPECT_EQ(test::ParseNameOrDie("com.app.a:layout/main"), ref->name.value());
+}
+
+TEST(TableProtoSerializer, LazyLoadRejectsCorruptTable) {
+  std::unique_ptr<IAaptContext> context = test::ContextBuilder().Build();
+  const std::string data = "not a table";
+  LazyResourceTablePb lazy_table(Source{"test"}, context->GetDiagnostics());
+  EXPECT_FALSE(lazy_table.Load(data.data(), data.size()));
+}
+
 TEST(TableProtoSerializer, SerializeFileHeader) {
   std::unique_ptr<IAaptContext> context = test::ContextBuilder().Build();
 
@@ -0,0 +1,128 @@
+#!/usr/bin/env python
+
+"""
+Generates a synthetic res/ tree and times `aapt2 compile --dir` on it with
+a single job and with several, checking that both produce the same output.
+Then times --incremental runs with no change and with one changed file, and
+a clean build that finds its PNGs in a --png-cache filled by a previous one.
+
+usage: compile_benchmark.py <path to aapt2> [jobs] [files per directory]
+"""
+
+from __future__ import print_function
+
+import filecmp
+import os
+import os.path
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+import zlib
+
+def write_png(file_path, size, seed):
+    """Writes a size x size RGBA PNG with a pattern that depends on seed."""
+    def chunk(tag, data):
+        crc = zlib.crc32(tag + data) & 0xffffffff
+        return struct.pack(">I", len(data)) + tag + data + struct.pack(">I", crc)
+
+    rows = []
+    for y in range(size):
+        row = bytearray([0])
+        for x in range(size):
+            row.extend([(x * seed) & 0xff, (y * seed) & 0xff, (x ^ y) & 0xff, 0xff])
+        rows.append(bytes(row))
+    header = struct.pack(">IIBBBBB", size, size, 8, 6, 0, 0, 0)
+    with open(file_path, "wb") as f:
+        f.write(b"\x89PNG\r\n\x1a\n")
+        f.write(chunk(b"IHDR", header))
+        f.write(chunk(b"IDAT", zlib.compress(b"".join(rows))))
+        f.write(chunk(b"IEND", b""))
+
+def write_values(file_path, index, count):
+    with open(file_path, "w") as f:
+        f.write("<resources>\n")
+        for i in range(count):
+            f.write("  <string name=\"string_{0}_{1}\">Text {0} {1}</string>\n".format(index, i))
+            f.write("  <dimen name=\"dimen_{0}_{1}\">{1}dp</dimen>\n".format(index, i))
+        f.write("</resources>\n")
+
+def write_layout(file_path, index):
+    with open(file_path, "w") as f:
+        f.write("<LinearLayout xmlns:android=\"http://schemas.android.com/apk/res/android\"\n"
+                "    android:layout_width=\"match_parent\"\n"
+                "    android:layout_height=\"match_parent\">\n")
+        for i in range(20):
+            f.write("  <TextView android:id=\"@+id/text_{0}_{1}\"\n"
+                    "      android:layout_width=\"wrap_content\"\n"
+                    "      android:layout_height=\"wrap_content\"/>\n".format(index, i))
+        f.write("</LinearLayout>\n")
+
+def generate(res_path, files_per_dir):
+    for d in ["values", "values-fr", "layout", "drawable-mdpi", "drawable-xhdpi"]:
+        os.makedirs(os.path.join(res_path, d))
+    for i in range(files_per_dir):
+        write_values(os.path.join(res_path, "values", "values_{0}.xml".format(i)), i, 50)
+        write_values(os.path.join(res_path, "values-fr", "values_{0}.xml".format(i)), i, 50)
+        write_layout(os.path.join(res_path, "layout", "layout_{0}.xml".format(i)), i)
+        write_png(os.path.join(res_path, "drawable-mdpi", "image_{0}.png".format(i)), 48, i + 1)
+        write_png(os.path.join(res_path, "drawable-xhdpi", "image_{0}.png".format(i)), 96, i + 1)
+
+def compile_res(aapt2, res_path, out_path, jobs, extra_args=[]):
+    start = time.time()
+    subprocess.check_call([aapt2, "compile", "--dir", res_path, "-o", out_path, "-j", str(jobs)] +
+                          extra_args)
+    return time.time() - start
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__.strip(), file=sys.stderr)
+        return 1
+    aapt2 = sys.argv[1]
+    jobs = int(sys.argv[2]) if len(sys.argv) > 2 else 8
+    files_per_dir = int(sys.argv[3]) if len(sys.argv) > 3 else 200
+
+    work_path = tempfile.mkdtemp()
+    try:
+        res_path = os.path.join(work_path, "res")
+        generate(res_path, files_per_dir)
+
+        serial_out = os.path.join(work_path, "serial.zip")
+        parallel_out = os.path.join(work_path, "parallel.zip")
+        serial_time = compile_res(aapt2, res_path, serial_out, 1)
+        parallel_time = compile_res(aapt2, res_path, parallel_out, jobs)
+
+        print("{0} files".format(files_per_dir * 5))
+        print("-j 1: {0:.2f}s".format(serial_time))
+        print("-j {0}: {1:.2f}s ({2:.2f}x)".format(jobs, parallel_time,
+                                                  serial_time / parallel_time))
+        if not filecmp.cmp(serial_out, parallel_out, shallow=False):
+            print("error: outputs differ", file=sys.stderr)
+            return 1
+
+        incremental_out = os.path.join(work_path, "incremental.zip")
+        compile_res(aapt2, res_path, incremental_out, jobs, ["--incremental"])
+        unchanged_time = compile_res(aapt2, res_path, incremental_out, jobs, ["--incremental"])
+        write_layout(os.path.join(res_path, "layout", "layout_0.xml"), files_per_dir)
+        changed_time = compile_res(aapt2, res_path, incremental_out, jobs, ["--incremental"])
+        print("--incremental, no change: {0:.2f}s".format(unchanged_time))
+        print("--incremental, one file changed: {0:.2f}s".format(changed_time))
+
+        png_cache_path = os.path.join(work_path, "png-cache")
+        cold_out = os.path.join(work_path, "cold.zip")
+        warm_out = os.path.join(work_path, "warm.zip")
+        cold_time = compile_res(aapt2, res_path, cold_out, jobs, ["--png-cache", png_cache_path])
+        warm_time = compile_res(aapt2, res_path, warm_out, jobs, ["--png-cache", png_cache_path])
+        print("--png-cache, empty: {0:.2f}s".format(cold_time))
+        print("--png-cache, filled: {0:.2f}s".format(warm_time))
+        if not filecmp.cmp(cold_out, warm_out, shallow=False):
+            print("error: outputs with a filled PNG cache differ", file=sys.stderr)
+            return 1
+    finally:
+        shutil.rmtree(work_path)
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
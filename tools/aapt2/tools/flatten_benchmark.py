@@ -0,0 +1,75 @@
+#!/usr/bin/env python
+
+"""
+Compiles framework-res, then links it several times with `aapt2 link -v` and
+reports how long each stage took, in particular writing the APK, where the
+resource table and its string pools are sorted and flattened.
+
+usage: flatten_benchmark.py <path to aapt2> [runs] [path to core/res]
+"""
+
+from __future__ import print_function
+
+import os
+import os.path
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+def default_res_path():
+    # This script lives in frameworks/base/tools/aapt2/tools.
+    script_path = os.path.dirname(os.path.abspath(__file__))
+    return os.path.normpath(os.path.join(script_path, "..", "..", "..", "core", "res"))
+
+def link(aapt2, core_res_path, compiled_path, out_path):
+    proc = subprocess.Popen([aapt2, "link", "-v", "-x", "--no-auto-version",
+                             "--private-symbols", "com.android.internal",
+                             "--manifest", os.path.join(core_res_path, "AndroidManifest.xml"),
+                             "-o", out_path, compiled_path],
+                            stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    _, err = proc.communicate()
+    err = err.decode("utf-8", "replace")
+    if proc.returncode != 0:
+        sys.stderr.write(err)
+        return None
+
+    stages = {}
+    for line in err.splitlines():
+        match = re.search(r"(\w[\w ]*) took (\d+)ms", line)
+        if match:
+            stages[match.group(1)] = int(match.group(2))
+    return stages
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__.strip(), file=sys.stderr)
+        return 1
+    aapt2 = sys.argv[1]
+    runs = int(sys.argv[2]) if len(sys.argv) > 2 else 5
+    core_res_path = sys.argv[3] if len(sys.argv) > 3 else default_res_path()
+
+    work_path = tempfile.mkdtemp()
+    try:
+        compiled_path = os.path.join(work_path, "compiled.zip")
+        subprocess.check_call([aapt2, "compile", "--dir", os.path.join(core_res_path, "res"),
+                               "-o", compiled_path, "-j", "8"])
+
+        results = []
+        for run in range(runs):
+            stages = link(aapt2, core_res_path, compiled_path,
+                          os.path.join(work_path, "framework-res.apk"))
+            if stages is None:
+                return 1
+            results.append(stages)
+
+        print("framework-res, best of {0} runs".format(runs))
+        for stage in results[0]:
+            print("  {0}: {1}ms".format(stage, min(r.get(stage, 0) for r in results)))
+    finally:
+        shutil.rmtree(work_path)
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,88 @@
+#!/usr/bin/env python
+
+"""
+Generates compiled tables with a synthetic set of entries interleaved across
+them, then times how long `aapt2 link` takes to merge them. Every table but
+the first inserts its entries between existing ones, which is the worst case
+for keeping the merged table's entries sorted.
+
+usage: merge_benchmark.py <path to aapt2> [entries] [tables]
+"""
+
+from __future__ import print_function
+
+import os
+import os.path
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+MANIFEST = """<manifest xmlns:android="http://schemas.android.com/apk/res/android"
+    package="com.example.benchmark">
+  <application/>
+</manifest>
+"""
+
+def write_values(file_path, table, entries, tables):
+    with open(file_path, "w") as f:
+        f.write("<resources>\n")
+        for i in range(table, entries, tables):
+            # Alternate types, so that both strings and ids grow large.
+            if i % 2 == 0:
+                f.write("  <string name=\"entry_{0:07d}\">Text {0}</string>\n".format(i))
+            else:
+                f.write("  <item type=\"id\" name=\"entry_{0:07d}\"/>\n".format(i))
+        f.write("</resources>\n")
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__.strip(), file=sys.stderr)
+        return 1
+    aapt2 = sys.argv[1]
+    entries = int(sys.argv[2]) if len(sys.argv) > 2 else 200000
+    tables = int(sys.argv[3]) if len(sys.argv) > 3 else 20
+
+    work_path = tempfile.mkdtemp()
+    try:
+        values_path = os.path.join(work_path, "res", "values")
+        compiled_path = os.path.join(work_path, "compiled")
+        os.makedirs(values_path)
+        os.makedirs(compiled_path)
+
+        flat_files = []
+        for table in range(tables):
+            values_file = os.path.join(values_path, "values_{0}.xml".format(table))
+            write_values(values_file, table, entries, tables)
+            subprocess.check_call([aapt2, "compile", "-o", compiled_path, values_file])
+            flat_files.append(os.path.join(compiled_path,
+                                           "values_values_{0}.arsc.flat".format(table)))
+
+        manifest_path = os.path.join(work_path, "AndroidManifest.xml")
+        with open(manifest_path, "w") as f:
+            f.write(MANIFEST)
+
+        start = time.time()
+        proc = subprocess.Popen([aapt2, "link", "-v", "--manifest", manifest_path,
+                                 "-o", os.path.join(work_path, "out.apk")] + flat_files,
+                                stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        _, err = proc.communicate()
+        link_time = time.time() - start
+        if proc.returncode != 0:
+            sys.stderr.write(err.decode("utf-8", "replace"))
+            return 1
+
+        print("{0} entries in {1} tables".format(entries, tables))
+        print("link: {0:.2f}s".format(link_time))
+        for line in err.decode("utf-8", "replace").splitlines():
+            match = re.search(r"(\w[\w ]*) took (\d+)ms", line)
+            if match:
+                print("  {0}: {1}ms".format(match.group(1), match.group(2)))
+    finally:
+        shutil.rmtree(work_path)
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "util/Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <limits>
+#include <vector>
+
+using android::StringPiece;
+
+namespace aapt {
+namespace util {
+
+bool ParseJobCount(const StringPiece& str, IDiagnostics* diag, size_t* out_jobs) {
+  // Anything above the number of threads the process may create is as good as a typo.
+  constexpr size_t kMaxJobs = std::numeric_limits<uint16_t>::max();
+  size_t jobs = 0;
+  for (char c : str) {
+    if (c < '0' || c > '9' || (jobs = jobs * 10 + (c - '0')) > kMaxJobs) {
+      jobs = 0;
+      break;
+    }
+  }
+
+  if (jobs == 0) {
+    diag->Error(DiagMessage() << "invalid job count '" << str << "'");
+    return false;
+  }
+  *out_jobs = jobs;
+  return true;
+}
+
+size_t GetDefaultJobCount() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ParallelFor(size_t count, size_t jobs, const std::function<void(size_t)>& func) {
+  jobs = std::min(jobs, count);
+  if (jobs <= 1) {
+    for (size_t i = 0; i < count; i++) {
+      func(i);
+    }
+    return;
+  }
+
+  // Work is handed out one index at a time, since the cost of each can vary wildly
+  // (a large PNG next to a tiny XML file).
+  std::atomic<size_t> next_index(0);
+  auto worker = [&]() {
+    for (size_t i = next_index++; i < count; i = next_index++) {
+      func(i);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(jobs - 1);
+  for (size_t i = 0; i < jobs - 1; i++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace util
+}  // namespace aapt
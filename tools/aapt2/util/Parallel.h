@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AAPT_UTIL_PARALLEL_H
+#define AAPT_UTIL_PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+#include "androidfw/StringPiece.h"
+
+#include "Diagnostics.h"
+
+namespace aapt {
+namespace util {
+
+// Parses the value of a -j flag, a positive decimal number, into out_jobs. Reports an error and
+// returns false if str is not one.
+bool ParseJobCount(const android::StringPiece& str, IDiagnostics* diag, size_t* out_jobs);
+
+// Returns the number of jobs to use when none was requested: the number of CPUs, or 1 if
+// that is unknown.
+size_t GetDefaultJobCount();
+
+// Calls func(i) for every i in [0, count), on up to `jobs` threads including the calling
+// thread, and returns once every call has returned. Indices are handed out in increasing
+// order, but calls may run and complete in any order, so func must only touch state that
+// belongs to index i or is safe to share between threads.
+//
+// With jobs <= 1 everything runs on the calling thread, in order.
+void ParallelFor(size_t count, size_t jobs, const std::function<void(size_t)>& func);
+
+}  // namespace util
+}  // namespace aapt
+
+#endif /* AAPT_UTIL_PARALLEL_H */
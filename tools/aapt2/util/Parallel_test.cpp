@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "util/Parallel.h"
+
+#include <atomic>
+#include <vector>
+
+#include "test/Test.h"
+
+namespace aapt {
+namespace util {
+
+TEST(ParallelTest, VisitsEveryIndexOnce) {
+  std::vector<std::atomic<int>> visits(1000);
+  for (std::atomic<int>& count : visits) {
+    count = 0;
+  }
+
+  ParallelFor(visits.size(), 4u, [&](size_t i) { visits[i]++; });
+
+  for (size_t i = 0; i < visits.size(); i++) {
+    EXPECT_EQ(1, visits[i].load()) << "index " << i;
+  }
+}
+
+TEST(ParallelTest, SingleJobRunsInOrder) {
+  std::vector<size_t> order;
+  ParallelFor(5u, 1u, [&](size_t i) { order.push_back(i); });
+  EXPECT_EQ((std::vector<size_t>{0u, 1u, 2u, 3u, 4u}), order);
+}
+
+TEST(ParallelTest, NoWork) {
+  ParallelFor(0u, 4u, [](size_t) { ADD_FAILURE(); });
+}
+
+TEST(ParallelTest, DefaultJobCountIsPositive) {
+  EXPECT_LT(0u, GetDefaultJobCount());
+}
+
+TEST(ParallelTest, ParseJobCount) {
+  std::unique_ptr<IAaptContext> context = test::ContextBuilder().Build();
+  size_t jobs = 0;
+  ASSERT_TRUE(ParseJobCount("1", context->GetDiagnostics(), &jobs));
+  EXPECT_EQ(1u, jobs);
+  ASSERT_TRUE(ParseJobCount("16", context->GetDiagnostics(), &jobs));
+  EXPECT_EQ(16u, jobs);
+
+  EXPECT_FALSE(ParseJobCount("", context->GetDiagnostics(), &jobs));
+  EXPECT_FALSE(ParseJobCount("0", context->GetDiagnostics(), &jobs));
+  EXPECT_FALSE(ParseJobCount("-1", context->GetDiagnostics(), &jobs));
+  EXPECT_FALSE(ParseJobCount("4x", context->GetDiagnostics(), &jobs));
+  EXPECT_FALSE(ParseJobCount("99999999999999999999", context->GetDiagnostics(), &jobs));
+  EXPECT_EQ(16u, jobs);
+}
+
+}  // namespace util
+}  // namespace aapt
@@ -33,6 +33,20 @@ using android::StringPiece16;
 namespace aapt {
 namespace util {
 
+// DO NOT UPDATE, this is more of a marketing version.
+static const char* sMajorVersion = "2";
+
+// Update minor version whenever a feature or flag is added, or the output changes.
+static const char* sMinorVersion = "17";
+
+std::string GetToolName() {
+  return std::string("Android Asset Packaging Tool (aapt) ") + sMajorVersion + "." + sMinorVersion;
+}
+
+std::string GetToolFingerprint() {
+  return std::string("aapt2 ") + sMajorVersion + "." + sMinorVersion;
+}
+
 static std::vector<std::string> SplitAndTransform(
     const StringPiece& str, char sep, const std::function<char(char)>& f) {
   std::vector<std::string> parts;
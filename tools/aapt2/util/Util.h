@@ -44,6 +44,13 @@
 namespace aapt {
 namespace util {
 
+// Returns the name and version of aapt2, as printed by `aapt2 version`.
+std::string GetToolName();
+
+// Returns a string identifying the version of aapt2 whose outputs can be reused. Outputs cached
+// by a previous run are only reused by a tool with the same fingerprint.
+std::string GetToolFingerprint();
+
 template <typename T>
 struct Range {
   T start;